@@ -219,3 +219,14 @@ typedef struct aas_predictroute_s
 	int numareas;			//number of areas predicted ahead
 	int time;				//time predicted ahead (in hundredths of a sec)
 } aas_predictroute_t;
+
+//maximum number of different travel flags the routes are prepared for each frame
+#define MAX_PREPAREDTRAVELFLAGS		4
+
+//route a bot is expected to look up, areanum is 0 when it can start anywhere
+typedef struct aas_routerequest_s
+{
+	int areanum;			//start area
+	int goalareanum;		//goal area
+	int travelflags;		//travel flags used
+} aas_routerequest_t;
@@ -130,6 +130,7 @@ typedef struct aas_settings_s
 typedef struct aas_routingcache_s
 {
 	byte type;									//portal or area cache
+	byte mapped;								//travel times are used in place from the route cache file
 	float time;									//last time accessed or updated
 	int size;									//size of the routing cache
 	int cluster;								//cluster the cache is for
@@ -140,9 +141,33 @@ typedef struct aas_routingcache_s
 	struct aas_routingcache_s *prev, *next;
 	struct aas_routingcache_s *time_prev, *time_next;
 	unsigned char *reachabilities;				//reachabilities used for routing
-	unsigned short int traveltimes[1];			//travel time for every area (variable sized)
+	unsigned short int *traveltimes;			//travel time for every area
+	struct aas_routingslab_s *slab;				//slab the cache is allocated from
 } aas_routingcache_t;
 
+//uniform grid over the world that stores for every cell the deepest
+//node of the bsp tree with the whole cell at one side of all its parents
+typedef struct aas_samplegrid_s
+{
+	vec3_t mins;								//mins of the first cell
+	float cellsize;								//size of a cell along every axis
+	float invcellsize;
+	int size[3];								//number of cells along every axis
+	int *nodes;									//start node for every cell
+} aas_samplegrid_t;
+
+//route cache file index entry, the entries are sorted on type, cluster,
+//area number and travel flags, portal caches are stored with cluster 0
+typedef struct aas_routecacheindex_s
+{
+	int type;									//portal or area cache
+	int cluster;								//cluster the cache is for
+	int areanum;								//area the cache is created for
+	int travelflags;							//combinations of the travel flags
+	int numtraveltimes;							//number of travel times and reachabilities
+	int ofs;									//offset of the travel times in the file, followed by the reachabilities
+} aas_routecacheindex_t;
+
 //fields for the routing algorithm
 typedef struct aas_routingupdate_s
 {
@@ -152,6 +177,7 @@ typedef struct aas_routingupdate_s
 	unsigned short int tmptraveltime;			//temporary travel time
 	unsigned short int *areatraveltimes;		//travel times within the area
 	bool inlist;							//true if the update is in the list
+	int bucket;									//radix heap bucket the update is in
 	struct aas_routingupdate_s *next;
 	struct aas_routingupdate_s *prev;
 } aas_routingupdate_t;
@@ -183,6 +209,8 @@ typedef struct aas_s
 	int initialized;							//true when AAS has been initialized
 	int savefile;								//set true when file should be saved
 	int bspchecksum;
+	const byte *aasfile;						//mapped aas file the lumps are used from
+	int aasfilesize;
 	//current time
 	float time;
 	int numframes;
@@ -222,6 +250,7 @@ typedef struct aas_s
 	//nodes of the bsp tree
 	int numnodes;
 	aas_node_t *nodes;
+	aas_samplegrid_t samplegrid;				//start nodes for point and trace queries
 	//cluster portals
 	int numportals;
 	aas_portal_t *portals;
@@ -262,6 +291,16 @@ typedef struct aas_s
 	//cache list sorted on time
 	aas_routingcache_t *oldestcache;		// start of cache list sorted on time
 	aas_routingcache_t *newestcache;		// end of cache list sorted on time
+	//route cache file used in place
+	const byte *routecachefile;
+	int routecachefilesize;
+	int routecachefilemapped;					//mapped instead of read into memory
+	int numroutecacheindex;
+	const aas_routecacheindex_t *routecacheindex;
+	aas_routingcache_t *routecacheheaders;		//cache for every index entry while in use
+	const byte *routecachedisabled;				//areas that were disabled when the file was written
+	int *routecacheclusterchanges;				//areas per cluster disabled differently than in the file
+	int routecachechanges;						//areas disabled differently than in the file
 	//maximum travel time through portal areas
 	int *portalmaxtraveltimes;
 	//areas the reachabilities go through
@@ -174,6 +174,21 @@ static void AAS_SwapAASData(void)
 	} //end for
 } //end of the function AAS_SwapAASData
 //===========================================================================
+// free a lump of the loaded aas file, lumps used in place from the
+// mapped file are released when the file is unmapped
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_FreeAASLump(void *ptr)
+{
+	if (!ptr) return;
+	if (aasworld.aasfile && (byte *) ptr >= aasworld.aasfile &&
+			(byte *) ptr < aasworld.aasfile + aasworld.aasfilesize) return;
+	FreeMemory(ptr);
+} //end of the function AAS_FreeAASLump
+//===========================================================================
 // dump the current loaded aas file
 //
 // Parameter:				-
@@ -183,49 +198,53 @@ static void AAS_SwapAASData(void)
 void AAS_DumpAASData(void)
 {
 	aasworld.numbboxes = 0;
-	if (aasworld.bboxes) FreeMemory(aasworld.bboxes);
+	AAS_FreeAASLump(aasworld.bboxes);
 	aasworld.bboxes = NULL;
 	aasworld.numvertexes = 0;
-	if (aasworld.vertexes) FreeMemory(aasworld.vertexes);
+	AAS_FreeAASLump(aasworld.vertexes);
 	aasworld.vertexes = NULL;
 	aasworld.numplanes = 0;
-	if (aasworld.planes) FreeMemory(aasworld.planes);
+	AAS_FreeAASLump(aasworld.planes);
 	aasworld.planes = NULL;
 	aasworld.numedges = 0;
-	if (aasworld.edges) FreeMemory(aasworld.edges);
+	AAS_FreeAASLump(aasworld.edges);
 	aasworld.edges = NULL;
 	aasworld.edgeindexsize = 0;
-	if (aasworld.edgeindex) FreeMemory(aasworld.edgeindex);
+	AAS_FreeAASLump(aasworld.edgeindex);
 	aasworld.edgeindex = NULL;
 	aasworld.numfaces = 0;
-	if (aasworld.faces) FreeMemory(aasworld.faces);
+	AAS_FreeAASLump(aasworld.faces);
 	aasworld.faces = NULL;
 	aasworld.faceindexsize = 0;
-	if (aasworld.faceindex) FreeMemory(aasworld.faceindex);
+	AAS_FreeAASLump(aasworld.faceindex);
 	aasworld.faceindex = NULL;
 	aasworld.numareas = 0;
-	if (aasworld.areas) FreeMemory(aasworld.areas);
+	AAS_FreeAASLump(aasworld.areas);
 	aasworld.areas = NULL;
 	aasworld.numareasettings = 0;
-	if (aasworld.areasettings) FreeMemory(aasworld.areasettings);
+	AAS_FreeAASLump(aasworld.areasettings);
 	aasworld.areasettings = NULL;
 	aasworld.reachabilitysize = 0;
-	if (aasworld.reachability) FreeMemory(aasworld.reachability);
+	AAS_FreeAASLump(aasworld.reachability);
 	aasworld.reachability = NULL;
 	aasworld.numnodes = 0;
-	if (aasworld.nodes) FreeMemory(aasworld.nodes);
+	AAS_FreeAASLump(aasworld.nodes);
 	aasworld.nodes = NULL;
 	aasworld.numportals = 0;
-	if (aasworld.portals) FreeMemory(aasworld.portals);
+	AAS_FreeAASLump(aasworld.portals);
 	aasworld.portals = NULL;
 	aasworld.numportals = 0;
-	if (aasworld.portalindex) FreeMemory(aasworld.portalindex);
+	AAS_FreeAASLump(aasworld.portalindex);
 	aasworld.portalindex = NULL;
 	aasworld.portalindexsize = 0;
-	if (aasworld.clusters) FreeMemory(aasworld.clusters);
+	AAS_FreeAASLump(aasworld.clusters);
 	aasworld.clusters = NULL;
 	aasworld.numclusters = 0;
 	//
+	if (aasworld.aasfile) botimport.FS_UnmapFile(aasworld.aasfile, aasworld.aasfilesize);
+	aasworld.aasfile = NULL;
+	aasworld.aasfilesize = 0;
+	//
 	aasworld.loaded = false;
 	aasworld.initialized = false;
 	aasworld.savefile = false;
@@ -296,6 +315,11 @@ static char *AAS_LoadAASLump(fileHandle_t fp, int offset, int length, int *lasto
 		//just alloc a dummy
 		return (char *) GetClearedHunkMemory(size+1);
 	} //end if
+	//use the lump right from the mapped file
+	if (aasworld.aasfile)
+	{
+		return (char *) aasworld.aasfile + offset;
+	} //end if
 	//seek to the data
 	if (offset != *lastoffset)
 	{
@@ -334,6 +358,57 @@ static void AAS_DData(unsigned char *data, int size)
 	} //end for
 } //end of the function AAS_DData
 //===========================================================================
+// map the aas file so the lumps can be used in place instead of being
+// copied, only possible when the data doesn't need to be byte swapped
+// and won't be recalculated or written back
+// FS_MapFile maps loose files and files stored uncompressed in a pk3,
+// a stored file in a pk3 can start at any offset so the lumps are only
+// used in place when the mapping itself is aligned
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_MapAASFile(char *filename, aas_header_t *fileheader, aas_header_t *header)
+{
+#ifdef Q3_LITTLE_ENDIAN
+	const byte *file;
+	int i, length, offset, filesize;
+
+	if (!botimport.FS_MapFile) return;
+	if ((int)LibVarGetValue("forceclustering") ||
+		(int)LibVarGetValue("forcereachability") ||
+		(int)LibVarGetValue("forcewrite")) return;
+	//the reachability and clustering is calculated when missing
+	if (!header->lumps[AASLUMP_REACHABILITY].filelen ||
+		!header->lumps[AASLUMP_CLUSTERS].filelen) return;
+	//
+	file = (const byte *) botimport.FS_MapFile(filename, &filesize);
+	if (!file) return;
+	//make sure the same file is mapped that was opened and the lumps are aligned
+	if (((intptr_t) file & 3) || filesize < (int) sizeof(aas_header_t) ||
+			memcmp(file, fileheader, sizeof(aas_header_t)))
+	{
+		botimport.FS_UnmapFile(file, filesize);
+		return;
+	} //end if
+	for (i = 0; i < AAS_LUMPS; i++)
+	{
+		offset = header->lumps[i].fileofs;
+		length = header->lumps[i].filelen;
+		if (!length) continue;
+		if (offset < (int) sizeof(aas_header_t) || (offset & 3) ||
+				length < 0 || length > filesize - offset)
+		{
+			botimport.FS_UnmapFile(file, filesize);
+			return;
+		} //end if
+	} //end for
+	aasworld.aasfile = file;
+	aasworld.aasfilesize = filesize;
+#endif //Q3_LITTLE_ENDIAN
+} //end of the function AAS_MapAASFile
+//===========================================================================
 // load an aas file
 //
 // Parameter:			-
@@ -343,8 +418,9 @@ static void AAS_DData(unsigned char *data, int size)
 int AAS_LoadAASFile(char *filename)
 {
 	fileHandle_t fp;
-	aas_header_t header;
+	aas_header_t header, fileheader;
 	int offset, length, lastoffset;
+	aas_areasettings_t *areasettings;
 
 	botimport.Print(PRT_MESSAGE, "trying to load %s\n", filename);
 	//dump current loaded aas file
@@ -359,6 +435,7 @@ int AAS_LoadAASFile(char *filename)
 	//read the header
 	botimport.FS_Read(&header, sizeof(aas_header_t), fp );
 	lastoffset = sizeof(aas_header_t);
+	Com_Memcpy(&fileheader, &header, sizeof(aas_header_t));
 	//check header identification
 	header.ident = LittleLong(header.ident);
 	if (header.ident != AASID)
@@ -389,6 +466,13 @@ int AAS_LoadAASFile(char *filename)
 		botimport.FS_FCloseFile(fp);
 		return BLERR_WRONGAASFILEVERSION;
 	} //end if
+	//try to use the lumps in place
+	AAS_MapAASFile(filename, &fileheader, &header);
+	if (aasworld.aasfile)
+	{
+		botimport.FS_FCloseFile(fp);
+		fp = 0;
+	} //end if
 	//load the lumps:
 	//bounding boxes
 	offset = LittleLong(header.lumps[AASLUMP_BBOXES].fileofs);
@@ -474,12 +558,23 @@ int AAS_LoadAASFile(char *filename)
 	aasworld.clusters = (aas_cluster_t *) AAS_LoadAASLump(fp, offset, length, &lastoffset, sizeof(aas_cluster_t));
 	aasworld.numclusters = length / sizeof(aas_cluster_t);
 	if (aasworld.numclusters && !aasworld.clusters) return BLERR_CANNOTREADAASLUMP;
-	//swap everything
-	AAS_SwapAASData();
+	//
+	if (aasworld.aasfile)
+	{
+		//area settings are changed at run time so they can't stay in the mapped file
+		areasettings = (aas_areasettings_t *) GetHunkMemory(aasworld.numareasettings * sizeof(aas_areasettings_t) + 1);
+		Com_Memcpy(areasettings, aasworld.areasettings, aasworld.numareasettings * sizeof(aas_areasettings_t));
+		aasworld.areasettings = areasettings;
+	} //end if
+	else
+	{
+		//swap everything
+		AAS_SwapAASData();
+		//close the file
+		botimport.FS_FCloseFile(fp);
+	} //end else
 	//aas file is loaded
 	aasworld.loaded = true;
-	//close the file
-	botimport.FS_FCloseFile(fp);
 	//
 #ifdef AASFILEDEBUG
 	AAS_FileInfo();
@@ -525,6 +620,12 @@ bool AAS_WriteAASFile(char *filename)
 	aas_header_t header;
 	fileHandle_t fp;
 
+	//the mapped file can't be swapped in place
+	if (aasworld.aasfile)
+	{
+		botimport.Print(PRT_ERROR, "can't write %s, the aas data is read only\n", filename);
+		return false;
+	} //end if
 	botimport.Print(PRT_MESSAGE, "writing %s\n", filename);
 	//swap the aas data
 	AAS_SwapAASData();
@@ -182,6 +182,24 @@ int AAS_StartFrame(float time)
 		LibVarSet("saveroutingcache", "0");
 	} //end if
 	//
+	if (LibVarGetValue("routingbenchmark"))
+	{
+		AAS_RoutingBenchmark();
+		LibVarSet("routingbenchmark", "0");
+	} //end if
+	//
+	if (LibVarGetValue("samplebenchmark"))
+	{
+		AAS_SampleBenchmark();
+		LibVarSet("samplebenchmark", "0");
+	} //end if
+	//
+	if (LibVarGetValue("routingcachestats"))
+	{
+		AAS_RoutingCacheStats();
+		LibVarSet("routingcachestats", "0");
+	} //end if
+	//
 	aasworld.numframes++;
 	return BLERR_NOERROR;
 } //end of the function AAS_StartFrame
@@ -276,6 +294,8 @@ int AAS_LoadMap(const char *mapname)
 	AAS_InitAASLinkHeap();
 	//initialize the AAS linked entities for the new map
 	AAS_InitAASLinkedEntities();
+	//initialize the start nodes for point and trace queries
+	AAS_InitSampleGrid();
 	//initialize reachability for the new map
 	AAS_InitReachability();
 	//initialize the alternative routing
@@ -324,6 +344,8 @@ void AAS_Shutdown(void)
 	AAS_FreeAASLinkHeap();
 	//free aas linked entities
 	AAS_FreeAASLinkedEntities();
+	//free the sample grid
+	AAS_FreeSampleGrid();
 	//free the aas data
 	AAS_DumpAASData();
 	//free the entities
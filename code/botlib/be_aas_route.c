@@ -58,6 +58,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 //maximum number of routing updates each frame
 #define MAX_FRAMEROUTINGUPDATES		10
 
+//routing cache size above which the oldest caches are freed
+#define DEFAULT_ROUTINGCACHELIMIT	(12 * 1024 * 1024)
+
+//memory allocated at once for routing caches of the same size
+#define ROUTINGSLAB_SIZE			(64 * 1024)
+#define MAX_ROUTINGSLAB_BLOCKS		64
+
 
 /*
 
@@ -76,13 +83,92 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 */
 
+/*
+
+  routing cache memory:
+  all routing caches with the same number of travel times have the same
+  size, there's a size class for the number of reachability areas of
+  every cluster and one for the number of portals
+  caches are allocated as fixed size blocks from slabs of the size class
+  instead of one memory block each, a slab is released when all blocks
+  are free again except for one empty slab kept per size class
+  the routing cache budget counts the bytes of all blocks in use, caches
+  are freed oldest first while it's exceeded
+
+*/
+
+/*
+
+  routing updates:
+  the travel times are propagated backwards from the goal area over the
+  reversed reachability links, every area that gets a shorter travel time
+  is (re)queued to propagate it further
+  by default the queue is first in first out, which re-relaxes areas many
+  times on large clusters
+  with the "routingheap" libvar set the queue is a radix heap keyed on the
+  travel time, areas are then popped in travel time order and usually
+  relaxed only once, because the travel time through an area depends on
+  the reachability the area was entered with the results may differ
+  slightly from the first in first out order
+
+*/
+
+//one bucket for the last travel time popped from the heap and one per travel time bit
+#define ROUTINGQUEUE_BUCKETS		17
+
+typedef struct aas_routingqueue_s
+{
+	int heap;									//radix heap instead of first in first out
+	unsigned short int last;					//last travel time popped from the heap
+	aas_routingupdate_t *buckets[ROUTINGQUEUE_BUCKETS];
+	aas_routingupdate_t *tail;					//end of the first in first out list
+} aas_routingqueue_t;
+
 #ifdef ROUTING_DEBUG
 int numareacacheupdates;
 int numportalcacheupdates;
 #endif //ROUTING_DEBUG
 
-int routingcachesize;
-int max_routingcachesize;
+typedef struct aas_routingslab_s
+{
+	struct aas_routingslabclass_s *slabclass;	//size class of the blocks
+	struct aas_routingslab_s *prev, *next;		//slabs of the class with free blocks
+	aas_routingcache_t *freeblocks;				//free blocks linked through next
+	int numused;								//number of blocks in use
+	int size;									//allocated size of the slab
+} aas_routingslab_t;
+
+typedef struct aas_routingslabclass_s
+{
+	int numtraveltimes;							//number of travel times of the caches
+	int blocksize;								//size of a cache block
+	int numblocks;								//number of blocks per slab
+	int numslabs;								//number of allocated slabs
+	aas_routingslab_t *partial;					//slabs with free blocks
+	aas_routingslab_t *empty;					//empty slab kept for reuse
+} aas_routingslabclass_t;
+
+typedef struct aas_routingcachestats_s
+{
+	int hits;									//caches found in memory
+	int filehits;								//caches found in the route cache file
+	int misses;									//caches that had to be calculated
+	int evictions;								//caches freed because of the budget
+	int peaksize;								//largest size of the caches in use
+} aas_routingcachestats_t;
+
+int routingcachesize;					//bytes of routing cache blocks in use
+
+static int routingheap;
+static int prepareroutes;				//calculate the routing caches bots will need on the worker threads
+static int routingcachelimit;			//older caches are freed above this size
+
+static aas_routingslabclass_t *routingslabclasses;
+static int numroutingslabclasses;
+static int routingslabsize;				//bytes allocated for routing cache slabs
+static aas_routingcachestats_t routingcachestats;
+
+static void AAS_FreeRoutingJobs(void);
 
 //===========================================================================
 //
@@ -233,11 +319,214 @@ static void AAS_LinkCache(aas_routingcache_t *cache)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+static void AAS_LinkRoutingSlab(aas_routingslab_t *slab)
+{
+	aas_routingslabclass_t *slabclass = slab->slabclass;
+
+	slab->prev = NULL;
+	slab->next = slabclass->partial;
+	if (slabclass->partial) slabclass->partial->prev = slab;
+	slabclass->partial = slab;
+} //end of the function AAS_LinkRoutingSlab
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_UnlinkRoutingSlab(aas_routingslab_t *slab)
+{
+	aas_routingslabclass_t *slabclass = slab->slabclass;
+
+	if (slab->prev) slab->prev->next = slab->next;
+	else slabclass->partial = slab->next;
+	if (slab->next) slab->next->prev = slab->prev;
+	slab->prev = NULL;
+	slab->next = NULL;
+} //end of the function AAS_UnlinkRoutingSlab
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_FreeRoutingSlab(aas_routingslab_t *slab)
+{
+	slab->slabclass->numslabs--;
+	routingslabsize -= slab->size;
+	FreeMemory(slab);
+} //end of the function AAS_FreeRoutingSlab
+//===========================================================================
+// allocates a slab with free blocks for the size class
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static aas_routingslab_t *AAS_NewRoutingSlab(aas_routingslabclass_t *slabclass)
+{
+	int i, headersize, size;
+	aas_routingslab_t *slab;
+	aas_routingcache_t *block;
+
+	headersize = (sizeof(aas_routingslab_t) + 15) & ~15;
+	size = headersize + slabclass->numblocks * slabclass->blocksize;
+	slab = (aas_routingslab_t *) GetMemory(size);
+	slab->slabclass = slabclass;
+	slab->prev = NULL;
+	slab->next = NULL;
+	slab->numused = 0;
+	slab->size = size;
+	slab->freeblocks = NULL;
+	for (i = slabclass->numblocks - 1; i >= 0; i--)
+	{
+		block = (aas_routingcache_t *) ((byte *) slab + headersize + i * slabclass->blocksize);
+		block->next = slab->freeblocks;
+		slab->freeblocks = block;
+	} //end for
+	slabclass->numslabs++;
+	routingslabsize += size;
+	return slab;
+} //end of the function AAS_NewRoutingSlab
+//===========================================================================
+// returns the size class for caches with the given number of travel times
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static aas_routingslabclass_t *AAS_RoutingSlabClass(int numtraveltimes)
+{
+	int low, high, mid;
+
+	low = 0;
+	high = numroutingslabclasses - 1;
+	while (low <= high)
+	{
+		mid = (low + high) >> 1;
+		if (routingslabclasses[mid].numtraveltimes == numtraveltimes) return &routingslabclasses[mid];
+		if (routingslabclasses[mid].numtraveltimes < numtraveltimes) low = mid + 1;
+		else high = mid - 1;
+	} //end while
+	AAS_Error("no routing cache size class for %d travel times\n", numtraveltimes);
+	return NULL;
+} //end of the function AAS_RoutingSlabClass
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_FreeRoutingCacheBlock(aas_routingcache_t *cache)
+{
+	aas_routingslab_t *slab;
+	aas_routingslabclass_t *slabclass;
+
+	slab = cache->slab;
+	slabclass = slab->slabclass;
+	routingcachesize -= slabclass->blocksize;
+	//a full slab gets free blocks again
+	if (!slab->freeblocks) AAS_LinkRoutingSlab(slab);
+	cache->next = slab->freeblocks;
+	slab->freeblocks = cache;
+	slab->numused--;
+	if (slab->numused > 0) return;
+	//keep one empty slab to avoid allocating and freeing one over and over
+	AAS_UnlinkRoutingSlab(slab);
+	if (!slabclass->empty) slabclass->empty = slab;
+	else AAS_FreeRoutingSlab(slab);
+} //end of the function AAS_FreeRoutingCacheBlock
+//===========================================================================
+// creates a size class for every number of travel times a routing cache
+// can have on this map
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_InitRoutingSlabs(void)
+{
+	int i, j, n, numtraveltimes, *sizes;
+	aas_routingslabclass_t *slabclass;
+
+	sizes = (int *) GetClearedMemory((aasworld.numclusters + 1) * sizeof(int));
+	n = 0;
+	sizes[n++] = aasworld.numportals;
+	for (i = 0; i < aasworld.numclusters; i++)
+	{
+		numtraveltimes = aasworld.clusters[i].numreachabilityareas;
+		//insertion sort without duplicates
+		for (j = n; j > 0 && sizes[j-1] > numtraveltimes; j--) sizes[j] = sizes[j-1];
+		if (j > 0 && sizes[j-1] == numtraveltimes)
+		{
+			for (; j < n; j++) sizes[j] = sizes[j+1];
+			continue;
+		} //end if
+		sizes[j] = numtraveltimes;
+		n++;
+	} //end for
+	routingslabclasses = (aas_routingslabclass_t *) GetClearedMemory(n * sizeof(aas_routingslabclass_t));
+	numroutingslabclasses = n;
+	for (i = 0; i < n; i++)
+	{
+		slabclass = &routingslabclasses[i];
+		slabclass->numtraveltimes = sizes[i];
+		slabclass->blocksize = (sizeof(aas_routingcache_t)
+							+ sizes[i] * sizeof(unsigned short int)
+							+ sizes[i] * sizeof(unsigned char) + 15) & ~15;
+		slabclass->numblocks = ROUTINGSLAB_SIZE / slabclass->blocksize;
+		if (slabclass->numblocks < 1) slabclass->numblocks = 1;
+		if (slabclass->numblocks > MAX_ROUTINGSLAB_BLOCKS) slabclass->numblocks = MAX_ROUTINGSLAB_BLOCKS;
+	} //end for
+	FreeMemory(sizes);
+	routingslabsize = 0;
+	Com_Memset(&routingcachestats, 0, sizeof(aas_routingcachestats_t));
+} //end of the function AAS_InitRoutingSlabs
+//===========================================================================
+// all routing caches have to be freed already
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_FreeRoutingSlabs(void)
+{
+	int i;
+	aas_routingslab_t *slab, *nextslab;
+	aas_routingslabclass_t *slabclass;
+
+	for (i = 0; i < numroutingslabclasses; i++)
+	{
+		slabclass = &routingslabclasses[i];
+		for (slab = slabclass->partial; slab; slab = nextslab)
+		{
+			nextslab = slab->next;
+			AAS_FreeRoutingSlab(slab);
+		} //end for
+		slabclass->partial = NULL;
+		if (slabclass->empty) AAS_FreeRoutingSlab(slabclass->empty);
+		slabclass->empty = NULL;
+	} //end for
+	if (routingslabclasses) FreeMemory(routingslabclasses);
+	routingslabclasses = NULL;
+	numroutingslabclasses = 0;
+} //end of the function AAS_FreeRoutingSlabs
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 void AAS_FreeRoutingCache(aas_routingcache_t *cache)
 {
 	AAS_UnlinkCache(cache);
-	routingcachesize -= cache->size;
-	FreeMemory(cache);
+	//the travel times of mapped caches stay in the route cache file
+	if (cache->mapped)
+	{
+		cache->mapped = false;
+		return;
+	} //end if
+	AAS_FreeRoutingCacheBlock(cache);
 } //end of the function AAS_FreeRoutingCache
 //===========================================================================
 //
@@ -300,6 +589,32 @@ static void AAS_RemoveRoutingCacheUsingArea( int areanum )
 	} //end for
 } //end of the function AAS_RemoveRoutingCacheUsingArea
 //===========================================================================
+// keeps track of the number of areas that are disabled differently than
+// when the route cache file was written, area caches from the file can
+// only be used while nothing changed in their cluster and portal caches
+// while nothing changed at all
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_RouteCacheAreaChanged(int areanum, int change)
+{
+	int clusternum;
+
+	clusternum = aasworld.areasettings[areanum].cluster;
+	if (clusternum > 0)
+	{
+		aasworld.routecacheclusterchanges[clusternum] += change;
+	} //end if
+	else
+	{
+		aasworld.routecacheclusterchanges[aasworld.portals[-clusternum].frontcluster] += change;
+		aasworld.routecacheclusterchanges[aasworld.portals[-clusternum].backcluster] += change;
+	} //end else
+	aasworld.routecachechanges += change;
+} //end of the function AAS_RouteCacheAreaChanged
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -330,6 +645,14 @@ int AAS_EnableRoutingArea(int areanum, int enable)
 	{
 		//remove all routing cache involving this area
 		AAS_RemoveRoutingCacheUsingArea( areanum );
+		//
+		if (aasworld.routecachedisabled)
+		{
+			if (aasworld.routecachedisabled[areanum] != (aasworld.areasettings[areanum].areaflags & AREA_DISABLED ? 1 : 0))
+				AAS_RouteCacheAreaChanged(areanum, 1);
+			else
+				AAS_RouteCacheAreaChanged(areanum, -1);
+		} //end if
 	} //end if
 	return !flags;
 } //end of the function AAS_EnableRoutingArea
@@ -705,6 +1028,10 @@ static int AAS_FreeOldestCache(void)
 		if (cache->type == CACHETYPE_AREA && aasworld.areasettings[cache->areanum].cluster < 0) {
 			continue;
 		}
+		// caches in the route cache file don't count towards the routing cache size
+		if (cache->mapped) {
+			continue;
+		}
 		break;
 	}
 	if (cache) {
@@ -724,6 +1051,7 @@ static int AAS_FreeOldestCache(void)
 			if (cache->next) cache->next->prev = cache->prev;
 		}
 		AAS_FreeRoutingCache(cache);
+		routingcachestats.evictions++;
 		return true;
 	}
 	return false;
@@ -737,19 +1065,32 @@ static int AAS_FreeOldestCache(void)
 static aas_routingcache_t *AAS_AllocRoutingCache(int numtraveltimes)
 {
 	aas_routingcache_t *cache;
-	int size;
+	aas_routingslab_t *slab;
+	aas_routingslabclass_t *slabclass;
 
+	slabclass = AAS_RoutingSlabClass(numtraveltimes);
+	slab = slabclass->partial;
+	if (!slab)
+	{
+		slab = slabclass->empty;
+		slabclass->empty = NULL;
+		if (!slab) slab = AAS_NewRoutingSlab(slabclass);
+		AAS_LinkRoutingSlab(slab);
+	} //end if
+	cache = slab->freeblocks;
+	slab->freeblocks = cache->next;
+	slab->numused++;
+	if (!slab->freeblocks) AAS_UnlinkRoutingSlab(slab);
 	//
-	size = sizeof(aas_routingcache_t)
-						+ numtraveltimes * sizeof(unsigned short int)
-						+ numtraveltimes * sizeof(unsigned char);
-	//
-	routingcachesize += size;
+	routingcachesize += slabclass->blocksize;
+	if (routingcachesize > routingcachestats.peaksize) routingcachestats.peaksize = routingcachesize;
 	//
-	cache = (aas_routingcache_t *) GetClearedMemory(size);
+	Com_Memset(cache, 0, slabclass->blocksize);
+	cache->slab = slab;
+	cache->traveltimes = (unsigned short int *) ((unsigned char *) cache + sizeof(aas_routingcache_t));
 	cache->reachabilities = (unsigned char *) cache + sizeof(aas_routingcache_t)
 								+ numtraveltimes * sizeof(unsigned short int);
-	cache->size = size;
+	cache->size = slabclass->blocksize;
 	return cache;
 } //end of the function AAS_AllocRoutingCache
 //===========================================================================
@@ -889,24 +1230,10 @@ static void AAS_InitRoutingUpdate(void)
 //===========================================================================
 void AAS_CreateAllRoutingCache(void)
 {
-	int i, j;
-	//int t;
-
-	aasworld.initialized = true;
 	botimport.Print(PRT_MESSAGE, "AAS_CreateAllRoutingCache\n");
-	for (i = 1; i < aasworld.numareas; i++)
-	{
-		if (!AAS_AreaReachability(i)) continue;
-		for (j = 1; j < aasworld.numareas; j++)
-		{
-			if (i == j) continue;
-			if (!AAS_AreaReachability(j)) continue;
-			AAS_AreaTravelTimeToGoalArea(i, aasworld.areas[i].center, j, TFL_DEFAULT);
-			//t = AAS_AreaTravelTimeToGoalArea(i, aasworld.areas[i].center, j, TFL_DEFAULT);
-			//Log_Write("traveltime from %d to %d is %d", i, j, t);
-		} //end for
-	} //end for
-	aasworld.initialized = false;
+	//creates the same caches as looking up the travel times between all
+	//reachable areas with the default travel flags
+	AAS_PrecomputeRoutingCache();
 } //end of the function AAS_CreateAllRoutingCache
 //===========================================================================
 //
@@ -915,9 +1242,12 @@ void AAS_CreateAllRoutingCache(void)
 // Changes Globals:		-
 //===========================================================================
 
-//the route cache header
-//this header is followed by numportalcache + numareacache aas_routingcache_t
-//structures that store routing cache
+//the route cache file
+//the header is followed by a byte for every area that is set when the
+//area was disabled at the time the file was written, then comes an index
+//entry for every routing cache sorted on type, cluster, area and travel
+//flags and finally the travel times and reachabilities of every cache,
+//the file is mapped into memory and the travel times are used in place
 typedef struct routecacheheader_s
 {
 	int ident;
@@ -926,34 +1256,175 @@ typedef struct routecacheheader_s
 	int numclusters;
 	int areacrc;
 	int clustercrc;
-	int numportalcache;
-	int numareacache;
+	int numindex;				//number of aas_routecacheindex_t
+	int disabledofs;			//offset of the disabled area flags
+	int indexofs;				//offset of the index
+	int filesize;				//size of the whole file
 } routecacheheader_t;
 
 #define RCID						(('C'<<24)+('R'<<16)+('E'<<8)+'M')
-#define RCVERSION					2
+#define RCVERSION					3
 
 //void AAS_DecompressVis(byte *in, int numareas, byte *decompressed);
 //int AAS_CompressVis(byte *vis, int numareas, byte *dest);
 
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RouteCacheNumTravelTimes(int type, int clusternum)
+{
+	if (type == CACHETYPE_PORTAL) return aasworld.numportals;
+	return aasworld.clusters[clusternum].numreachabilityareas;
+} //end of the function AAS_RouteCacheNumTravelTimes
+//===========================================================================
+// size of the travel times and reachabilities of a cache in the file
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RouteCacheDataSize(int numtraveltimes)
+{
+	return (numtraveltimes * (sizeof(unsigned short int) + sizeof(unsigned char)) + 3) & ~3;
+} //end of the function AAS_RouteCacheDataSize
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_CompareRouteCacheIndex(const void *arg1, const void *arg2)
+{
+	const aas_routecacheindex_t *index1 = (const aas_routecacheindex_t *) arg1;
+	const aas_routecacheindex_t *index2 = (const aas_routecacheindex_t *) arg2;
+
+	if (index1->type != index2->type) return index1->type - index2->type;
+	if (index1->cluster != index2->cluster) return index1->cluster - index2->cluster;
+	if (index1->areanum != index2->areanum) return index1->areanum - index2->areanum;
+	if (index1->travelflags != index2->travelflags) return index1->travelflags < index2->travelflags ? -1 : 1;
+	return 0;
+} //end of the function AAS_CompareRouteCacheIndex
+//===========================================================================
+// replaces a cache in the cluster area or portal cache list and in the
+// cache list sorted on time with another cache
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_ReplaceRoutingCache(aas_routingcache_t *cache, aas_routingcache_t *newcache)
+{
+	newcache->prev = cache->prev;
+	newcache->next = cache->next;
+	if (newcache->next) newcache->next->prev = newcache;
+	if (newcache->prev) newcache->prev->next = newcache;
+	else if (cache->type == CACHETYPE_AREA)
+		aasworld.clusterareacache[cache->cluster][AAS_ClusterAreaNum(cache->cluster, cache->areanum)] = newcache;
+	else
+		aasworld.portalcache[cache->areanum] = newcache;
+	//
+	newcache->time_prev = cache->time_prev;
+	newcache->time_next = cache->time_next;
+	if (newcache->time_prev) newcache->time_prev->time_next = newcache;
+	else aasworld.oldestcache = newcache;
+	if (newcache->time_next) newcache->time_next->time_prev = newcache;
+	else aasworld.newestcache = newcache;
+	//
+	cache->prev = cache->next = NULL;
+	cache->time_prev = cache->time_next = NULL;
+} //end of the function AAS_ReplaceRoutingCache
+//===========================================================================
+// gives every cache that is used in place from the route cache file its
+// own copy of the travel times so the file can be released
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_CopyMappedRoutingCaches(void)
+{
+	int i, numtraveltimes;
+	aas_routingcache_t *cache, *newcache;
+
+	for (i = 0; i < aasworld.numroutecacheindex; i++)
+	{
+		cache = &aasworld.routecacheheaders[i];
+		if (!cache->mapped) continue;
+		numtraveltimes = aasworld.routecacheindex[i].numtraveltimes;
+		newcache = AAS_AllocRoutingCache(numtraveltimes);
+		newcache->type = cache->type;
+		newcache->time = cache->time;
+		newcache->cluster = cache->cluster;
+		newcache->areanum = cache->areanum;
+		VectorCopy(cache->origin, newcache->origin);
+		newcache->starttraveltime = cache->starttraveltime;
+		newcache->travelflags = cache->travelflags;
+		Com_Memcpy(newcache->traveltimes, cache->traveltimes, numtraveltimes * sizeof(unsigned short int));
+		Com_Memcpy(newcache->reachabilities, cache->reachabilities, numtraveltimes * sizeof(unsigned char));
+		AAS_ReplaceRoutingCache(cache, newcache);
+		cache->mapped = false;
+	} //end for
+} //end of the function AAS_CopyMappedRoutingCaches
+//===========================================================================
+// releases the route cache file, none of the caches may still use it
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_FreeRouteCacheFile(void)
+{
+	if (!aasworld.routecachefile) return;
+	if (aasworld.routecachefilemapped)
+		botimport.FS_UnmapFile(aasworld.routecachefile, aasworld.routecachefilesize);
+	else
+		FreeMemory((void *) aasworld.routecachefile);
+	if (aasworld.routecacheheaders) FreeMemory(aasworld.routecacheheaders);
+	if (aasworld.routecacheclusterchanges) FreeMemory(aasworld.routecacheclusterchanges);
+	aasworld.routecachefile = NULL;
+	aasworld.routecachefilesize = 0;
+	aasworld.routecachefilemapped = false;
+	aasworld.numroutecacheindex = 0;
+	aasworld.routecacheindex = NULL;
+	aasworld.routecacheheaders = NULL;
+	aasworld.routecachedisabled = NULL;
+	aasworld.routecacheclusterchanges = NULL;
+	aasworld.routecachechanges = 0;
+} //end of the function AAS_FreeRouteCacheFile
+//===========================================================================
+// the file is written under a temporary name and then renamed so another
+// server that has the old file mapped keeps using that one
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 void AAS_WriteRouteCache(void)
 {
-	int i, j, numportalcache, numareacache, totalsize;
-	aas_routingcache_t *cache;
+	int i, j, numcaches, ofs, totalsize, numtraveltimes, pad;
+	aas_routingcache_t *cache, **caches, **sorted;
+	aas_routecacheindex_t *index;
 	aas_cluster_t *cluster;
 	fileHandle_t fp;
-	char filename[MAX_QPATH];
+	char filename[MAX_QPATH], tmpfilename[MAX_QPATH];
 	routecacheheader_t routecacheheader;
+	byte *disabled;
 
-	numportalcache = 0;
+	//the file being replaced may be the one the caches are used from
+	AAS_CopyMappedRoutingCaches();
+	AAS_FreeRouteCacheFile();
+	//
+	numcaches = 0;
 	for (i = 0; i < aasworld.numareas; i++)
 	{
 		for (cache = aasworld.portalcache[i]; cache; cache = cache->next)
 		{
-			numportalcache++;
+			numcaches++;
 		} //end for
 	} //end for
-	numareacache = 0;
 	for (i = 0; i < aasworld.numclusters; i++)
 	{
 		cluster = &aasworld.clusters[i];
@@ -961,38 +1432,18 @@ void AAS_WriteRouteCache(void)
 		{
 			for (cache = aasworld.clusterareacache[i][j]; cache; cache = cache->next)
 			{
-				numareacache++;
+				numcaches++;
 			} //end for
 		} //end for
 	} //end for
-	// open the file for writing
-	Com_sprintf(filename, MAX_QPATH, "maps/%s.rcd", aasworld.mapname);
-	botimport.FS_FOpenFile( filename, &fp, FS_WRITE );
-	if (!fp)
-	{
-		AAS_Error("Unable to open file: %s\n", filename);
-		return;
-	} //end if
-	//create the header
-	routecacheheader.ident = RCID;
-	routecacheheader.version = RCVERSION;
-	routecacheheader.numareas = aasworld.numareas;
-	routecacheheader.numclusters = aasworld.numclusters;
-	routecacheheader.areacrc = CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas );
-	routecacheheader.clustercrc = CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters );
-	routecacheheader.numportalcache = numportalcache;
-	routecacheheader.numareacache = numareacache;
-	//write the header
-	botimport.FS_Write(&routecacheheader, sizeof(routecacheheader_t), fp);
-	//
-	totalsize = 0;
-	//write all the cache
+	caches = (aas_routingcache_t **) GetClearedMemory(numcaches * sizeof(aas_routingcache_t *) + 1);
+	index = (aas_routecacheindex_t *) GetClearedMemory(numcaches * sizeof(aas_routecacheindex_t) + 1);
+	numcaches = 0;
 	for (i = 0; i < aasworld.numareas; i++)
 	{
 		for (cache = aasworld.portalcache[i]; cache; cache = cache->next)
 		{
-			botimport.FS_Write(cache, cache->size, fp);
-			totalsize += cache->size;
+			caches[numcaches++] = cache;
 		} //end for
 	} //end for
 	for (i = 0; i < aasworld.numclusters; i++)
@@ -1002,11 +1453,77 @@ void AAS_WriteRouteCache(void)
 		{
 			for (cache = aasworld.clusterareacache[i][j]; cache; cache = cache->next)
 			{
-				botimport.FS_Write(cache, cache->size, fp);
-				totalsize += cache->size;
+				caches[numcaches++] = cache;
 			} //end for
 		} //end for
 	} //end for
+	//the index temporarily stores the number of the cache as offset
+	for (i = 0; i < numcaches; i++)
+	{
+		cache = caches[i];
+		index[i].type = cache->type;
+		index[i].cluster = cache->type == CACHETYPE_PORTAL ? 0 : cache->cluster;
+		index[i].areanum = cache->areanum;
+		index[i].travelflags = cache->travelflags;
+		index[i].numtraveltimes = AAS_RouteCacheNumTravelTimes(cache->type, cache->cluster);
+		index[i].ofs = i;
+	} //end for
+	qsort(index, numcaches, sizeof(aas_routecacheindex_t), AAS_CompareRouteCacheIndex);
+	//create the header
+	Com_Memset(&routecacheheader, 0, sizeof(routecacheheader_t));
+	routecacheheader.ident = RCID;
+	routecacheheader.version = RCVERSION;
+	routecacheheader.numareas = aasworld.numareas;
+	routecacheheader.numclusters = aasworld.numclusters;
+	routecacheheader.areacrc = CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas );
+	routecacheheader.clustercrc = CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters );
+	routecacheheader.numindex = numcaches;
+	routecacheheader.disabledofs = sizeof(routecacheheader_t);
+	routecacheheader.indexofs = routecacheheader.disabledofs + ((aasworld.numareas + 3) & ~3);
+	//the travel times and reachabilities follow the index, in index order
+	sorted = (aas_routingcache_t **) GetClearedMemory(numcaches * sizeof(aas_routingcache_t *) + 1);
+	ofs = routecacheheader.indexofs + numcaches * sizeof(aas_routecacheindex_t);
+	totalsize = 0;
+	for (i = 0; i < numcaches; i++)
+	{
+		sorted[i] = caches[index[i].ofs];
+		index[i].ofs = ofs;
+		ofs += AAS_RouteCacheDataSize(index[i].numtraveltimes);
+		totalsize += sorted[i]->size;
+	} //end for
+	routecacheheader.filesize = ofs;
+	//the areas that are disabled right now
+	disabled = (byte *) GetClearedMemory(routecacheheader.indexofs - routecacheheader.disabledofs);
+	for (i = 0; i < aasworld.numareas; i++)
+	{
+		disabled[i] = (aasworld.areasettings[i].areaflags & AREA_DISABLED) ? 1 : 0;
+	} //end for
+	// open the file for writing
+	Com_sprintf(filename, MAX_QPATH, "maps/%s.rcd", aasworld.mapname);
+	Com_sprintf(tmpfilename, MAX_QPATH, "maps/%s.rcd.tmp", aasworld.mapname);
+	botimport.FS_FOpenFile( tmpfilename, &fp, FS_WRITE );
+	if (!fp)
+	{
+		FreeMemory(disabled);
+		FreeMemory(index);
+		FreeMemory(sorted);
+		FreeMemory(caches);
+		AAS_Error("Unable to open file: %s\n", tmpfilename);
+		return;
+	} //end if
+	//write the header, disabled areas and index
+	botimport.FS_Write(&routecacheheader, sizeof(routecacheheader_t), fp);
+	botimport.FS_Write(disabled, routecacheheader.indexofs - routecacheheader.disabledofs, fp);
+	botimport.FS_Write(index, numcaches * sizeof(aas_routecacheindex_t), fp);
+	//write all the cache
+	for (i = 0; i < numcaches; i++)
+	{
+		numtraveltimes = index[i].numtraveltimes;
+		botimport.FS_Write(sorted[i]->traveltimes, numtraveltimes * sizeof(unsigned short int), fp);
+		botimport.FS_Write(sorted[i]->reachabilities, numtraveltimes * sizeof(unsigned char), fp);
+		pad = AAS_RouteCacheDataSize(numtraveltimes) - numtraveltimes * (sizeof(unsigned short int) + sizeof(unsigned char));
+		if (pad) botimport.FS_Write("\0\0\0", pad, fp);
+	} //end for
 	// write the visareas
 	/*
 	for (i = 0; i < aasworld.numareas; i++)
@@ -1024,120 +1541,260 @@ void AAS_WriteRouteCache(void)
 	*/
 	//
 	botimport.FS_FCloseFile(fp);
+	botimport.FS_Rename(tmpfilename, filename);
+	FreeMemory(disabled);
+	FreeMemory(index);
+	FreeMemory(sorted);
+	FreeMemory(caches);
 	botimport.Print(PRT_MESSAGE, "\nroute cache written to %s\n", filename);
 	botimport.Print(PRT_MESSAGE, "written %d bytes of routing cache\n", totalsize);
 } //end of the function AAS_WriteRouteCache
 //===========================================================================
+// checks everything in the route cache file that is used without
+// checking later on
 //
 // Parameter:			-
-// Returns:				-
-// Changes Globals:		-
-//===========================================================================
-static aas_routingcache_t *AAS_ReadCache(fileHandle_t fp)
-{
-	int size;
-	aas_routingcache_t *cache;
-
-	botimport.FS_Read(&size, sizeof(size), fp);
-	cache = (aas_routingcache_t *) GetMemory(size);
-	cache->size = size;
-	botimport.FS_Read((unsigned char *)cache + sizeof(size), size - sizeof(size), fp);
-	cache->reachabilities = (unsigned char *) cache + sizeof(aas_routingcache_t) - sizeof(unsigned short) +
-		(size - sizeof(aas_routingcache_t) + sizeof(unsigned short)) / 3 * 2;
-	return cache;
-} //end of the function AAS_ReadCache
-//===========================================================================
-//
-// Parameter:			-
-// Returns:				-
+// Returns:				true if the route cache file can be used
 // Changes Globals:		-
 //===========================================================================
-static int AAS_ReadRouteCache(void)
+static int AAS_CheckRouteCache(const char *filename, const byte *file, int length)
 {
-	int i, clusterareanum;//, size;
-	fileHandle_t fp;
-	char filename[MAX_QPATH];
-	routecacheheader_t routecacheheader;
-	aas_routingcache_t *cache;
+	int i, dataofs, clusternum, areacluster;
+	const routecacheheader_t *routecacheheader;
+	const aas_routecacheindex_t *index;
+	const aas_portal_t *portal;
 
-	Com_sprintf(filename, MAX_QPATH, "maps/%s.rcd", aasworld.mapname);
-	botimport.FS_FOpenFile( filename, &fp, FS_READ );
-	if (!fp)
-	{
-		return false;
-	} //end if
-	botimport.FS_Read(&routecacheheader, sizeof(routecacheheader_t), fp );
-	if (routecacheheader.ident != RCID)
+	if (length < (int) sizeof(routecacheheader_t)) return false;
+	routecacheheader = (const routecacheheader_t *) file;
+	if (routecacheheader->ident != RCID)
 	{
-		AAS_Error("%s is not a route cache dump\n", filename);
+		botimport.Print(PRT_WARNING, "%s is not a route cache dump\n", filename);
 		return false;
 	} //end if
-	if (routecacheheader.version != RCVERSION)
+	if (routecacheheader->version != RCVERSION)
 	{
-		AAS_Error("route cache dump has wrong version %d, should be %d\n", routecacheheader.version, RCVERSION);
+		botimport.Print(PRT_WARNING, "route cache dump has wrong version %d, should be %d\n", routecacheheader->version, RCVERSION);
 		return false;
 	} //end if
-	if (routecacheheader.numareas != aasworld.numareas)
+	if (routecacheheader->numareas != aasworld.numareas)
 	{
 		//AAS_Error("route cache dump has wrong number of areas\n");
 		return false;
 	} //end if
-	if (routecacheheader.numclusters != aasworld.numclusters)
+	if (routecacheheader->numclusters != aasworld.numclusters)
 	{
 		//AAS_Error("route cache dump has wrong number of clusters\n");
 		return false;
 	} //end if
-	if (routecacheheader.areacrc !=
+	if (routecacheheader->areacrc !=
 		CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas ))
 	{
 		//AAS_Error("route cache dump area CRC incorrect\n");
 		return false;
 	} //end if
-	if (routecacheheader.clustercrc !=
+	if (routecacheheader->clustercrc !=
 		CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters ))
 	{
 		//AAS_Error("route cache dump cluster CRC incorrect\n");
 		return false;
 	} //end if
-	//read all the portal cache
-	for (i = 0; i < routecacheheader.numportalcache; i++)
-	{
-		cache = AAS_ReadCache(fp);
-		cache->next = aasworld.portalcache[cache->areanum];
-		cache->prev = NULL;
-		if (aasworld.portalcache[cache->areanum])
-			aasworld.portalcache[cache->areanum]->prev = cache;
-		aasworld.portalcache[cache->areanum] = cache;
-	} //end for
-	//read all the cluster area cache
-	for (i = 0; i < routecacheheader.numareacache; i++)
-	{
-		cache = AAS_ReadCache(fp);
-		clusterareanum = AAS_ClusterAreaNum(cache->cluster, cache->areanum);
-		cache->next = aasworld.clusterareacache[cache->cluster][clusterareanum];
-		cache->prev = NULL;
-		if (aasworld.clusterareacache[cache->cluster][clusterareanum])
-			aasworld.clusterareacache[cache->cluster][clusterareanum]->prev = cache;
-		aasworld.clusterareacache[cache->cluster][clusterareanum] = cache;
-	} //end for
-	// read the visareas
-	/*
-	aasworld.areavisibility = (byte **) GetClearedMemory(aasworld.numareas * sizeof(byte *));
-	aasworld.decompressedvis = (byte *) GetClearedMemory(aasworld.numareas * sizeof(byte));
-	for (i = 0; i < aasworld.numareas; i++)
-	{
-		botimport.FS_Read(&size, sizeof(size), fp );
-		if (size) {
-			aasworld.areavisibility[i] = (byte *) GetMemory(size);
-			botimport.FS_Read(aasworld.areavisibility[i], size, fp );
-		}
-	}
-	*/
 	//
-	botimport.FS_FCloseFile(fp);
+	if (routecacheheader->filesize != length ||
+		routecacheheader->disabledofs != sizeof(routecacheheader_t) ||
+		routecacheheader->indexofs != routecacheheader->disabledofs + ((aasworld.numareas + 3) & ~3) ||
+		routecacheheader->indexofs > length ||
+		routecacheheader->numindex < 0 ||
+		routecacheheader->numindex > (length - routecacheheader->indexofs) / (int) sizeof(aas_routecacheindex_t))
+	{
+		botimport.Print(PRT_WARNING, "%s is damaged\n", filename);
+		return false;
+	} //end if
+	dataofs = routecacheheader->indexofs + routecacheheader->numindex * sizeof(aas_routecacheindex_t);
+	index = (const aas_routecacheindex_t *) (file + routecacheheader->indexofs);
+	for (i = 0; i < routecacheheader->numindex; i++, index++)
+	{
+		if (index->areanum <= 0 || index->areanum >= aasworld.numareas) break;
+		if (index->type == CACHETYPE_PORTAL)
+		{
+			if (index->cluster != 0) break;
+		} //end if
+		else if (index->type == CACHETYPE_AREA)
+		{
+			clusternum = index->cluster;
+			if (clusternum <= 0 || clusternum >= aasworld.numclusters) break;
+			//the area has to be part of the cluster
+			areacluster = aasworld.areasettings[index->areanum].cluster;
+			if (areacluster < 0)
+			{
+				portal = &aasworld.portals[-areacluster];
+				if (portal->frontcluster != clusternum && portal->backcluster != clusternum) break;
+			} //end if
+			else if (areacluster != clusternum) break;
+		} //end else if
+		else break;
+		if (index->numtraveltimes != AAS_RouteCacheNumTravelTimes(index->type, index->cluster)) break;
+		if (index->ofs < dataofs || (index->ofs & 3)) break;
+		if (index->ofs > length - AAS_RouteCacheDataSize(index->numtraveltimes)) break;
+		//the index is searched with a binary search
+		if (i > 0 && AAS_CompareRouteCacheIndex(index - 1, index) >= 0) break;
+	} //end for
+	if (i < routecacheheader->numindex)
+	{
+		botimport.Print(PRT_WARNING, "%s is damaged\n", filename);
+		return false;
+	} //end if
+	return true;
+} //end of the function AAS_CheckRouteCache
+//===========================================================================
+// maps the route cache file into memory, or reads it when it can't be
+// mapped, the caches are used from the file once they're looked up
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_ReadRouteCache(void)
+{
+	int i, length, mapped;
+	fileHandle_t fp;
+	char filename[MAX_QPATH];
+	const routecacheheader_t *routecacheheader;
+	const byte *file;
+	byte *buffer;
+
+	Com_sprintf(filename, MAX_QPATH, "maps/%s.rcd", aasworld.mapname);
+	file = (const byte *) botimport.FS_MapFile(filename, &length);
+	mapped = (file != NULL);
+	if (!mapped)
+	{
+		//the file is in a pk3 or couldn't be mapped
+		length = botimport.FS_FOpenFile( filename, &fp, FS_READ );
+		if (!fp)
+		{
+			return false;
+		} //end if
+		if (length < (int) sizeof(routecacheheader_t))
+		{
+			botimport.FS_FCloseFile(fp);
+			return false;
+		} //end if
+		buffer = (byte *) GetMemory(length);
+		if (botimport.FS_Read(buffer, length, fp) != length)
+		{
+			botimport.FS_FCloseFile(fp);
+			FreeMemory(buffer);
+			return false;
+		} //end if
+		botimport.FS_FCloseFile(fp);
+		file = buffer;
+	} //end if
+	if (!AAS_CheckRouteCache(filename, file, length))
+	{
+		if (mapped) botimport.FS_UnmapFile(file, length);
+		else FreeMemory((void *) file);
+		return false;
+	} //end if
+	routecacheheader = (const routecacheheader_t *) file;
+	aasworld.routecachefile = file;
+	aasworld.routecachefilesize = length;
+	aasworld.routecachefilemapped = mapped;
+	aasworld.numroutecacheindex = routecacheheader->numindex;
+	aasworld.routecacheindex = (const aas_routecacheindex_t *) (file + routecacheheader->indexofs);
+	aasworld.routecacheheaders = (aas_routingcache_t *) GetClearedMemory(
+										routecacheheader->numindex * sizeof(aas_routingcache_t) + 1);
+	aasworld.routecachedisabled = file + routecacheheader->disabledofs;
+	aasworld.routecacheclusterchanges = (int *) GetClearedMemory(aasworld.numclusters * sizeof(int));
+	aasworld.routecachechanges = 0;
+	//areas that are disabled differently than when the file was written
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		if (aasworld.routecachedisabled[i] != ((aasworld.areasettings[i].areaflags & AREA_DISABLED) ? 1 : 0))
+		{
+			AAS_RouteCacheAreaChanged(i, 1);
+		} //end if
+	} //end for
+	botimport.Print(PRT_MESSAGE, "%s route cache with %d caches (%d KB)\n",
+					mapped ? "mapped" : "loaded", aasworld.numroutecacheindex, length >> 10);
 	return true;
 } //end of the function AAS_ReadRouteCache
 //===========================================================================
+// finds the index entry of a cache in the route cache file
+//
+// Parameter:			-
+// Returns:				the index entry or NULL if the cache isn't in the file
+// Changes Globals:		-
+//===========================================================================
+static const aas_routecacheindex_t *AAS_FindRouteCacheIndex(int type, int clusternum, int areanum, int travelflags)
+{
+	aas_routecacheindex_t key;
+
+	key.type = type;
+	key.cluster = type == CACHETYPE_PORTAL ? 0 : clusternum;
+	key.areanum = areanum;
+	key.travelflags = travelflags;
+	return (const aas_routecacheindex_t *) bsearch(&key, aasworld.routecacheindex,
+					aasworld.numroutecacheindex, sizeof(aas_routecacheindex_t), AAS_CompareRouteCacheIndex);
+} //end of the function AAS_FindRouteCacheIndex
+//===========================================================================
+// looks up a cache in the route cache file and links it into the cache
+// lists, the travel times and reachabilities are used in place
+//
+// Parameter:			-
+// Returns:				the cache or NULL if not in the file or not valid
+// Changes Globals:		-
+//===========================================================================
+static aas_routingcache_t *AAS_MapRoutingCache(int type, int clusternum, int areanum, int travelflags)
+{
+	int clusterareanum;
+	const aas_routecacheindex_t *index;
+	aas_routingcache_t *cache;
+
+	if (!aasworld.numroutecacheindex) return NULL;
+	//the cache is only valid while the areas are enabled and disabled
+	//the same way as when the file was written
+	if (type == CACHETYPE_PORTAL)
+	{
+		if (aasworld.routecachechanges) return NULL;
+	} //end if
+	else
+	{
+		if (aasworld.routecacheclusterchanges[clusternum]) return NULL;
+	} //end else
+	//
+	index = AAS_FindRouteCacheIndex(type, clusternum, areanum, travelflags);
+	if (!index) return NULL;
+	//
+	cache = &aasworld.routecacheheaders[index - aasworld.routecacheindex];
+	Com_Memset(cache, 0, sizeof(aas_routingcache_t));
+	cache->type = type;
+	cache->mapped = true;
+	cache->cluster = clusternum;
+	cache->areanum = areanum;
+	VectorCopy(aasworld.areas[areanum].center, cache->origin);
+	cache->starttraveltime = 1;
+	cache->travelflags = travelflags;
+	cache->traveltimes = (unsigned short int *) (aasworld.routecachefile + index->ofs);
+	cache->reachabilities = (unsigned char *) (aasworld.routecachefile + index->ofs)
+									+ index->numtraveltimes * sizeof(unsigned short int);
+	//add the cache to the cache list
+	if (type == CACHETYPE_PORTAL)
+	{
+		cache->next = aasworld.portalcache[areanum];
+		if (cache->next) cache->next->prev = cache;
+		aasworld.portalcache[areanum] = cache;
+	} //end if
+	else
+	{
+		clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
+		cache->next = aasworld.clusterareacache[clusternum][clusterareanum];
+		if (cache->next) cache->next->prev = cache;
+		aasworld.clusterareacache[clusternum][clusterareanum] = cache;
+	} //end else
+	cache->time = AAS_RoutingTime();
+	AAS_LinkCache(cache);
+	return cache;
+} //end of the function AAS_MapRoutingCache
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -1243,9 +1900,15 @@ void AAS_InitRouting(void)
 #endif //ROUTING_DEBUG
 	//
 	routingcachesize = 0;
-	max_routingcachesize = 1024 * (int) LibVarValue("max_routingcache", "4096");
+	routingcachelimit = (int) LibVarValue("routingcachebudget", va("%d", DEFAULT_ROUTINGCACHELIMIT));
+	if (routingcachelimit <= 0) routingcachelimit = DEFAULT_ROUTINGCACHELIMIT;
+	AAS_InitRoutingSlabs();
+	routingheap = (int) LibVarValue("routingheap", "0");
+	prepareroutes = (int) LibVarValue("prepareroutes", "1");
 	// read any routing cache if available
 	AAS_ReadRouteCache();
+	// create the remaining default routing caches on the worker threads
+	if ((int) LibVarValue("precomputeroutingcache", "0")) AAS_PrecomputeRoutingCache();
 } //end of the function AAS_InitRouting
 //===========================================================================
 //
@@ -1259,6 +1922,12 @@ void AAS_FreeRoutingCaches(void)
 	AAS_FreeAllClusterAreaCache();
 	// free all the existing portal cache
 	AAS_FreeAllPortalCache();
+	// release the route cache file after the caches that used it
+	AAS_FreeRouteCacheFile();
+	// free the routing update fields of the worker threads
+	AAS_FreeRoutingJobs();
+	// free the memory the caches were allocated from
+	AAS_FreeRoutingSlabs();
 	// free cached travel times within areas
 	if (aasworld.areatraveltimes) FreeMemory(aasworld.areatraveltimes);
 	aasworld.areatraveltimes = NULL;
@@ -1284,29 +1953,152 @@ void AAS_FreeRoutingCaches(void)
 	aasworld.areacontentstravelflags = NULL;
 } //end of the function AAS_FreeRoutingCaches
 //===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_InitRoutingQueue(aas_routingqueue_t *queue, int heap)
+{
+	Com_Memset(queue, 0, sizeof(aas_routingqueue_t));
+	queue->heap = heap;
+} //end of the function AAS_InitRoutingQueue
+//===========================================================================
+// returns the radix heap bucket for the travel time, this is the number
+// of the highest bit in which the travel time differs from the last
+// travel time popped from the heap
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE int AAS_RoutingHeapBucket(unsigned short int traveltime, unsigned short int last)
+{
+	unsigned int diff;
+	int bucket;
+
+	for (bucket = 0, diff = traveltime ^ last; diff; diff >>= 1) bucket++;
+	return bucket;
+} //end of the function AAS_RoutingHeapBucket
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE void AAS_RoutingHeapLink(aas_routingqueue_t *queue, aas_routingupdate_t *update)
+{
+	update->bucket = AAS_RoutingHeapBucket(update->tmptraveltime, queue->last);
+	update->prev = NULL;
+	update->next = queue->buckets[update->bucket];
+	if (update->next) update->next->prev = update;
+	queue->buckets[update->bucket] = update;
+} //end of the function AAS_RoutingHeapLink
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE void AAS_RoutingHeapUnlink(aas_routingqueue_t *queue, aas_routingupdate_t *update)
+{
+	if (update->prev) update->prev->next = update->next;
+	else queue->buckets[update->bucket] = update->next;
+	if (update->next) update->next->prev = update->prev;
+} //end of the function AAS_RoutingHeapUnlink
+//===========================================================================
+// queues an update, or moves it to the right bucket after its
+// travel time decreased
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE void AAS_RoutingQueueUpdate(aas_routingqueue_t *queue, aas_routingupdate_t *update)
+{
+	if (queue->heap)
+	{
+		if (update->inlist) AAS_RoutingHeapUnlink(queue, update);
+		AAS_RoutingHeapLink(queue, update);
+	} //end if
+	else if (!update->inlist)
+	{
+		//add the update to the end of the list
+		update->next = NULL;
+		update->prev = queue->tail;
+		if (queue->tail) queue->tail->next = update;
+		else queue->buckets[0] = update;
+		queue->tail = update;
+	} //end else if
+	update->inlist = true;
+} //end of the function AAS_RoutingQueueUpdate
+//===========================================================================
+// returns the next update to propagate or NULL if the queue is empty
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static aas_routingupdate_t *AAS_RoutingQueuePop(aas_routingqueue_t *queue)
+{
+	int i;
+	aas_routingupdate_t *update, *next;
+
+	if (queue->heap && !queue->buckets[0])
+	{
+		for (i = 1; i < ROUTINGQUEUE_BUCKETS; i++)
+		{
+			if (queue->buckets[i]) break;
+		} //end for
+		if (i >= ROUTINGQUEUE_BUCKETS) return NULL;
+		//the smallest travel time in the first non-empty bucket becomes the new base
+		update = queue->buckets[i];
+		queue->last = update->tmptraveltime;
+		for (update = update->next; update; update = update->next)
+		{
+			if (update->tmptraveltime < queue->last) queue->last = update->tmptraveltime;
+		} //end for
+		//redistribute the bucket, all updates end up in lower buckets
+		update = queue->buckets[i];
+		queue->buckets[i] = NULL;
+		for (; update; update = next)
+		{
+			next = update->next;
+			AAS_RoutingHeapLink(queue, update);
+		} //end for
+	} //end if
+	update = queue->buckets[0];
+	if (!update) return NULL;
+	//remove the update from the queue
+	queue->buckets[0] = update->next;
+	if (update->next) update->next->prev = NULL;
+	else if (!queue->heap) queue->tail = NULL;
+	update->inlist = false;
+	return update;
+} //end of the function AAS_RoutingQueuePop
+//===========================================================================
 // update the given routing cache
+// only reads the shared routing data, so caches can be updated on several
+// threads at the same time as long as every thread uses its own areaupdate
 //
-// Parameter:			areacache		: routing cache to update
+// Parameter:			areaupdate		: routing update fields for every reachability area
+//						areacache		: routing cache to update
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-static void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
+static void AAS_UpdateAreaRoutingCache(aas_routingupdate_t *areaupdate, aas_routingcache_t *areacache)
 {
 	int i, nextareanum, cluster, badtravelflags, clusterareanum, linknum;
 	int numreachabilityareas;
 	unsigned short int t, startareatraveltimes[128]; //NOTE: not more than 128 reachabilities per area allowed
-	aas_routingupdate_t *updateliststart, *updatelistend, *curupdate, *nextupdate;
+	aas_routingqueue_t queue;
+	aas_routingupdate_t *curupdate, *nextupdate;
 	aas_reachability_t *reach;
 	const aas_reversedreachability_t *revreach;
 	const aas_reversedlink_t *revlink;
 
-#ifdef ROUTING_DEBUG
-	numareacacheupdates++;
-#endif //ROUTING_DEBUG
 	//number of reachability areas within this cluster
 	numreachabilityareas = aasworld.clusters[areacache->cluster].numreachabilityareas;
-	//
-	aasworld.frameroutingupdates++;
 	//clear the routing update fields
 //	Com_Memset(aasworld.areaupdate, 0, aasworld.numareas * sizeof(aas_routingupdate_t));
 	//
@@ -1317,28 +2109,19 @@ static void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 	//
 	Com_Memset(startareatraveltimes, 0, sizeof(startareatraveltimes));
 	//
-	curupdate = &aasworld.areaupdate[clusterareanum];
+	curupdate = &areaupdate[clusterareanum];
 	curupdate->areanum = areacache->areanum;
 	//VectorCopy(areacache->origin, curupdate->start);
 	curupdate->areatraveltimes = startareatraveltimes;
 	curupdate->tmptraveltime = areacache->starttraveltime;
 	//
 	areacache->traveltimes[clusterareanum] = areacache->starttraveltime;
-	//put the area to start with in the current read list
-	curupdate->next = NULL;
-	curupdate->prev = NULL;
-	updateliststart = curupdate;
-	updatelistend = curupdate;
-	//while there are updates in the current list
-	while (updateliststart)
+	//put the area to start with in the queue
+	AAS_InitRoutingQueue(&queue, routingheap);
+	AAS_RoutingQueueUpdate(&queue, curupdate);
+	//while there are updates in the queue
+	while ((curupdate = AAS_RoutingQueuePop(&queue)) != NULL)
 	{
-		curupdate = updateliststart;
-		//
-		if (curupdate->next) curupdate->next->prev = NULL;
-		else updatelistend = NULL;
-		updateliststart = curupdate->next;
-		//
-		curupdate->inlist = false;
 		//check all reversed reachability links
 		revreach = &aasworld.reversedreachability[curupdate->areanum];
 		//
@@ -1373,24 +2156,13 @@ static void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 			{
 				areacache->traveltimes[clusterareanum] = t;
 				areacache->reachabilities[clusterareanum] = linknum - aasworld.areasettings[nextareanum].firstreachablearea;
-				nextupdate = &aasworld.areaupdate[clusterareanum];
+				nextupdate = &areaupdate[clusterareanum];
 				nextupdate->areanum = nextareanum;
 				nextupdate->tmptraveltime = t;
 				//VectorCopy(reach->start, nextupdate->start);
 				nextupdate->areatraveltimes = aasworld.areatraveltimes[nextareanum][linknum -
 													aasworld.areasettings[nextareanum].firstreachablearea];
-				if (!nextupdate->inlist)
-				{
-					// we add the update to the end of the list
-					// we could also use a B+ tree to have a real sorted list
-					// on travel time which makes for faster routing updates
-					nextupdate->next = NULL;
-					nextupdate->prev = updatelistend;
-					if (updatelistend) updatelistend->next = nextupdate;
-					else updateliststart = nextupdate;
-					updatelistend = nextupdate;
-					nextupdate->inlist = true;
-				} //end if
+				AAS_RoutingQueueUpdate(&queue, nextupdate);
 			} //end if
 		} //end for
 	} //end while
@@ -1401,35 +2173,82 @@ static void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-static aas_routingcache_t *AAS_GetAreaRoutingCache(int clusternum, int areanum, int travelflags)
+static aas_routingcache_t *AAS_FindAreaRoutingCache(int clusternum, int areanum, int travelflags)
 {
 	int clusterareanum;
-	aas_routingcache_t *cache, *clustercache;
+	aas_routingcache_t *cache;
 
 	//number of the area in the cluster
 	clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
-	//pointer to the cache for the area in the cluster
-	clustercache = aasworld.clusterareacache[clusternum][clusterareanum];
 	//find the cache without undesired travel flags
-	for (cache = clustercache; cache; cache = cache->next)
+	for (cache = aasworld.clusterareacache[clusternum][clusterareanum]; cache; cache = cache->next)
 	{
 		//if there aren't used any undesired travel types for the cache
 		if (cache->travelflags == travelflags) break;
 	} //end for
+	return cache;
+} //end of the function AAS_FindAreaRoutingCache
+//===========================================================================
+// allocates a new area routing cache and adds it to the cluster area
+// cache, the travel times still have to be calculated
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static aas_routingcache_t *AAS_NewAreaRoutingCache(int clusternum, int areanum, int travelflags)
+{
+	int clusterareanum;
+	aas_routingcache_t *cache, *clustercache;
+
+	//number of the area in the cluster
+	clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
+	//pointer to the cache for the area in the cluster
+	clustercache = aasworld.clusterareacache[clusternum][clusterareanum];
+	//
+	cache = AAS_AllocRoutingCache(aasworld.clusters[clusternum].numreachabilityareas);
+	cache->cluster = clusternum;
+	cache->areanum = areanum;
+	VectorCopy(aasworld.areas[areanum].center, cache->origin);
+	cache->starttraveltime = 1;
+	cache->travelflags = travelflags;
+	cache->prev = NULL;
+	cache->next = clustercache;
+	if (clustercache) clustercache->prev = cache;
+	aasworld.clusterareacache[clusternum][clusterareanum] = cache;
+	return cache;
+} //end of the function AAS_NewAreaRoutingCache
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static aas_routingcache_t *AAS_GetAreaRoutingCache(int clusternum, int areanum, int travelflags)
+{
+	aas_routingcache_t *cache;
+
+	cache = AAS_FindAreaRoutingCache(clusternum, areanum, travelflags);
+	//use the cache from the route cache file if available
+	if (!cache)
+	{
+		cache = AAS_MapRoutingCache(CACHETYPE_AREA, clusternum, areanum, travelflags);
+		if (cache) routingcachestats.filehits++;
+	} //end if
+	else
+	{
+		routingcachestats.hits++;
+	} //end else
 	//if there was no cache
 	if (!cache)
 	{
-		cache = AAS_AllocRoutingCache(aasworld.clusters[clusternum].numreachabilityareas);
-		cache->cluster = clusternum;
-		cache->areanum = areanum;
-		VectorCopy(aasworld.areas[areanum].center, cache->origin);
-		cache->starttraveltime = 1;
-		cache->travelflags = travelflags;
-		cache->prev = NULL;
-		cache->next = clustercache;
-		if (clustercache) clustercache->prev = cache;
-		aasworld.clusterareacache[clusternum][clusterareanum] = cache;
-		AAS_UpdateAreaRoutingCache(cache);
+		cache = AAS_NewAreaRoutingCache(clusternum, areanum, travelflags);
+		routingcachestats.misses++;
+#ifdef ROUTING_DEBUG
+		numareacacheupdates++;
+#endif //ROUTING_DEBUG
+		aasworld.frameroutingupdates++;
+		AAS_UpdateAreaRoutingCache(aasworld.areaupdate, cache);
 	} //end if
 	else
 	{
@@ -1442,27 +2261,33 @@ static aas_routingcache_t *AAS_GetAreaRoutingCache(int clusternum, int areanum,
 	return cache;
 } //end of the function AAS_GetAreaRoutingCache
 //===========================================================================
+// update the given portal routing cache
+// with lookuponly set the area routing caches towards the portals are only
+// looked up instead of created, they must all exist already, then the
+// update doesn't change any shared data and caches can be updated on
+// several threads at the same time as long as every thread uses its own
+// portalupdate
 //
-// Parameter:			-
+// Parameter:			portalupdate	: routing update fields for every portal
+//						portalcache		: portal routing cache to update
+//						lookuponly		: only look up area routing caches
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-static void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
+static void AAS_UpdatePortalRoutingCache(aas_routingupdate_t *portalupdate, aas_routingcache_t *portalcache, int lookuponly)
 {
 	int i, portalnum, clusterareanum, clusternum;
 	unsigned short int t;
 	aas_portal_t *portal;
 	aas_cluster_t *cluster;
 	aas_routingcache_t *cache;
-	aas_routingupdate_t *updateliststart, *updatelistend, *curupdate, *nextupdate;
+	aas_routingqueue_t queue;
+	aas_routingupdate_t *curupdate, *nextupdate;
 
-#ifdef ROUTING_DEBUG
-	numportalcacheupdates++;
-#endif //ROUTING_DEBUG
 	//clear the routing update fields
 //	Com_Memset(aasworld.portalupdate, 0, (aasworld.numportals+1) * sizeof(aas_routingupdate_t));
 	//
-	curupdate = &aasworld.portalupdate[aasworld.numportals];
+	curupdate = &portalupdate[aasworld.numportals];
 	curupdate->cluster = portalcache->cluster;
 	curupdate->areanum = portalcache->areanum;
 	curupdate->tmptraveltime = portalcache->starttraveltime;
@@ -1472,26 +2297,25 @@ static void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 	{
 		portalcache->traveltimes[-clusternum] = portalcache->starttraveltime;
 	} //end if
-	//put the area to start with in the current read list
-	curupdate->next = NULL;
-	curupdate->prev = NULL;
-	updateliststart = curupdate;
-	updatelistend = curupdate;
-	//while there are updates in the current list
-	while (updateliststart)
+	//put the area to start with in the queue
+	AAS_InitRoutingQueue(&queue, routingheap);
+	AAS_RoutingQueueUpdate(&queue, curupdate);
+	//while there are updates in the queue
+	while ((curupdate = AAS_RoutingQueuePop(&queue)) != NULL)
 	{
-		curupdate = updateliststart;
-		//remove the current update from the list
-		if (curupdate->next) curupdate->next->prev = NULL;
-		else updatelistend = NULL;
-		updateliststart = curupdate->next;
-		//current update is removed from the list
-		curupdate->inlist = false;
-		//
 		cluster = &aasworld.clusters[curupdate->cluster];
 		//
-		cache = AAS_GetAreaRoutingCache(curupdate->cluster,
+		if (lookuponly)
+		{
+			cache = AAS_FindAreaRoutingCache(curupdate->cluster,
+								curupdate->areanum, portalcache->travelflags);
+			if (!cache) continue;
+		} //end if
+		else
+		{
+			cache = AAS_GetAreaRoutingCache(curupdate->cluster,
 								curupdate->areanum, portalcache->travelflags);
+		} //end else
 		//take all portals of the cluster
 		for (i = 0; i < cluster->numportals; i++)
 		{
@@ -1511,7 +2335,7 @@ static void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 					portalcache->traveltimes[portalnum] > t)
 			{
 				portalcache->traveltimes[portalnum] = t;
-				nextupdate = &aasworld.portalupdate[portalnum];
+				nextupdate = &portalupdate[portalnum];
 				if (portal->frontcluster == curupdate->cluster)
 				{
 					nextupdate->cluster = portal->backcluster;
@@ -1523,18 +2347,7 @@ static void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 				nextupdate->areanum = portal->areanum;
 				//add travel time through the actual portal area for the next update
 				nextupdate->tmptraveltime = t + aasworld.portalmaxtraveltimes[portalnum];
-				if (!nextupdate->inlist)
-				{
-					// we add the update to the end of the list
-					// we could also use a B+ tree to have a real sorted list
-					// on travel time which makes for faster routing updates
-					nextupdate->next = NULL;
-					nextupdate->prev = updatelistend;
-					if (updatelistend) updatelistend->next = nextupdate;
-					else updateliststart = nextupdate;
-					updatelistend = nextupdate;
-					nextupdate->inlist = true;
-				} //end if
+				AAS_RoutingQueueUpdate(&queue, nextupdate);
 			} //end if
 		} //end for
 	} //end while
@@ -1545,7 +2358,7 @@ static void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-static aas_routingcache_t *AAS_GetPortalRoutingCache(int clusternum, int areanum, int travelflags)
+static aas_routingcache_t *AAS_FindPortalRoutingCache(int areanum, int travelflags)
 {
 	aas_routingcache_t *cache;
 
@@ -1554,22 +2367,64 @@ static aas_routingcache_t *AAS_GetPortalRoutingCache(int clusternum, int areanum
 	{
 		if (cache->travelflags == travelflags) break;
 	} //end for
+	return cache;
+} //end of the function AAS_FindPortalRoutingCache
+//===========================================================================
+// allocates a new portal routing cache and adds it to the portal cache,
+// the travel times still have to be calculated
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static aas_routingcache_t *AAS_NewPortalRoutingCache(int clusternum, int areanum, int travelflags)
+{
+	aas_routingcache_t *cache;
+
+	cache = AAS_AllocRoutingCache(aasworld.numportals);
+	cache->cluster = clusternum;
+	cache->areanum = areanum;
+	VectorCopy(aasworld.areas[areanum].center, cache->origin);
+	cache->starttraveltime = 1;
+	cache->travelflags = travelflags;
+	//add the cache to the cache list
+	cache->prev = NULL;
+	cache->next = aasworld.portalcache[areanum];
+	if (aasworld.portalcache[areanum]) aasworld.portalcache[areanum]->prev = cache;
+	aasworld.portalcache[areanum] = cache;
+	return cache;
+} //end of the function AAS_NewPortalRoutingCache
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static aas_routingcache_t *AAS_GetPortalRoutingCache(int clusternum, int areanum, int travelflags)
+{
+	aas_routingcache_t *cache;
+
+	cache = AAS_FindPortalRoutingCache(areanum, travelflags);
+	//use the cache from the route cache file if available
+	if (!cache)
+	{
+		cache = AAS_MapRoutingCache(CACHETYPE_PORTAL, clusternum, areanum, travelflags);
+		if (cache) routingcachestats.filehits++;
+	} //end if
+	else
+	{
+		routingcachestats.hits++;
+	} //end else
 	//if the portal routing isn't cached
 	if (!cache)
 	{
-		cache = AAS_AllocRoutingCache(aasworld.numportals);
-		cache->cluster = clusternum;
-		cache->areanum = areanum;
-		VectorCopy(aasworld.areas[areanum].center, cache->origin);
-		cache->starttraveltime = 1;
-		cache->travelflags = travelflags;
-		//add the cache to the cache list
-		cache->prev = NULL;
-		cache->next = aasworld.portalcache[areanum];
-		if (aasworld.portalcache[areanum]) aasworld.portalcache[areanum]->prev = cache;
-		aasworld.portalcache[areanum] = cache;
+		cache = AAS_NewPortalRoutingCache(clusternum, areanum, travelflags);
+		routingcachestats.misses++;
 		//update the cache
-		AAS_UpdatePortalRoutingCache(cache);
+#ifdef ROUTING_DEBUG
+		numportalcacheupdates++;
+#endif //ROUTING_DEBUG
+		AAS_UpdatePortalRoutingCache(aasworld.portalupdate, cache, false);
 	} //end if
 	else
 	{
@@ -1582,6 +2437,578 @@ static aas_routingcache_t *AAS_GetPortalRoutingCache(int clusternum, int areanum
 	return cache;
 } //end of the function AAS_GetPortalRoutingCache
 //===========================================================================
+// shared by the routing cache jobs, the routing update fields are kept
+// between frames
+//===========================================================================
+typedef struct aas_routingjobs_s
+{
+	aas_routingcache_t **caches;				//caches to update
+	int numcaches;
+	int maxcaches;
+	int numthreads;								//threads the update fields are allocated for
+	int numareaupdates;							//routing update fields per thread
+	aas_routingupdate_t *areaupdate;			//area update fields for every thread
+	aas_routingupdate_t *portalupdate;			//portal update fields for every thread
+} aas_routingjobs_t;
+
+static aas_routingjobs_t routingjobs;
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_AreaRoutingCacheJob(void *data, int index, int thread)
+{
+	aas_routingjobs_t *jobs = (aas_routingjobs_t *) data;
+
+	AAS_UpdateAreaRoutingCache(jobs->areaupdate + thread * jobs->numareaupdates, jobs->caches[index]);
+} //end of the function AAS_AreaRoutingCacheJob
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_PortalRoutingCacheJob(void *data, int index, int thread)
+{
+	aas_routingjobs_t *jobs = (aas_routingjobs_t *) data;
+
+	AAS_UpdatePortalRoutingCache(jobs->portalupdate + thread * (aasworld.numportals+1), jobs->caches[index], true);
+} //end of the function AAS_PortalRoutingCacheJob
+//===========================================================================
+// allocates the routing update fields for every thread
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_InitRoutingJobs(void)
+{
+	int i;
+
+	if (routingjobs.areaupdate) return;
+	routingjobs.numthreads = botimport.JobWorkers() + 1;
+	routingjobs.numareaupdates = 0;
+	for (i = 0; i < aasworld.numclusters; i++)
+	{
+		if (aasworld.clusters[i].numreachabilityareas > routingjobs.numareaupdates)
+		{
+			routingjobs.numareaupdates = aasworld.clusters[i].numreachabilityareas;
+		} //end if
+	} //end for
+	routingjobs.areaupdate = (aas_routingupdate_t *) GetClearedMemory(
+							routingjobs.numthreads * routingjobs.numareaupdates * sizeof(aas_routingupdate_t) + 1);
+	routingjobs.portalupdate = (aas_routingupdate_t *) GetClearedMemory(
+							routingjobs.numthreads * (aasworld.numportals+1) * sizeof(aas_routingupdate_t));
+	routingjobs.numcaches = 0;
+} //end of the function AAS_InitRoutingJobs
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_FreeRoutingJobs(void)
+{
+	if (routingjobs.caches) FreeMemory(routingjobs.caches);
+	if (routingjobs.areaupdate) FreeMemory(routingjobs.areaupdate);
+	if (routingjobs.portalupdate) FreeMemory(routingjobs.portalupdate);
+	Com_Memset(&routingjobs, 0, sizeof(aas_routingjobs_t));
+} //end of the function AAS_FreeRoutingJobs
+//===========================================================================
+// adds a new cache to the caches that will be calculated by the jobs
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_AddRoutingJob(aas_routingcache_t *cache, int type)
+{
+	aas_routingcache_t **caches;
+
+	cache->time = AAS_RoutingTime();
+	cache->type = type;
+	AAS_LinkCache(cache);
+	routingcachestats.misses++;
+	//
+	if (routingjobs.numcaches >= routingjobs.maxcaches)
+	{
+		routingjobs.maxcaches = routingjobs.maxcaches ? routingjobs.maxcaches * 2 : 256;
+		caches = (aas_routingcache_t **) GetMemory(routingjobs.maxcaches * sizeof(aas_routingcache_t *));
+		if (routingjobs.caches)
+		{
+			Com_Memcpy(caches, routingjobs.caches, routingjobs.numcaches * sizeof(aas_routingcache_t *));
+			FreeMemory(routingjobs.caches);
+		} //end if
+		routingjobs.caches = caches;
+	} //end if
+	routingjobs.caches[routingjobs.numcaches++] = cache;
+} //end of the function AAS_AddRoutingJob
+//===========================================================================
+// calculates the travel times of all added area caches on the worker threads
+//
+// Parameter:			-
+// Returns:				number of updated caches
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RunAreaRoutingJobs(void)
+{
+	int numcaches;
+
+	numcaches = routingjobs.numcaches;
+	botimport.ParallelFor(numcaches, AAS_AreaRoutingCacheJob, &routingjobs);
+	routingjobs.numcaches = 0;
+#ifdef ROUTING_DEBUG
+	numareacacheupdates += numcaches;
+#endif //ROUTING_DEBUG
+	return numcaches;
+} //end of the function AAS_RunAreaRoutingJobs
+//===========================================================================
+// calculates the travel times of all added portal caches on the worker
+// threads, all area caches towards the portals have to exist already
+//
+// Parameter:			-
+// Returns:				number of updated caches
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RunPortalRoutingJobs(void)
+{
+	int numcaches;
+
+	numcaches = routingjobs.numcaches;
+	botimport.ParallelFor(numcaches, AAS_PortalRoutingCacheJob, &routingjobs);
+	routingjobs.numcaches = 0;
+#ifdef ROUTING_DEBUG
+	numportalcacheupdates += numcaches;
+#endif //ROUTING_DEBUG
+	return numcaches;
+} //end of the function AAS_RunPortalRoutingJobs
+//===========================================================================
+// adds the area caches towards the area for every cluster the area is in
+// that don't exist yet
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_AddAreaRoutingJobs(int areanum, int travelflags)
+{
+	int i, numclusters, clusters[2];
+	aas_portal_t *portal;
+
+	numclusters = 0;
+	if (aasworld.areasettings[areanum].cluster < 0)
+	{
+		portal = &aasworld.portals[-aasworld.areasettings[areanum].cluster];
+		clusters[numclusters++] = portal->frontcluster;
+		clusters[numclusters++] = portal->backcluster;
+	} //end if
+	else if (aasworld.areasettings[areanum].cluster > 0)
+	{
+		clusters[numclusters++] = aasworld.areasettings[areanum].cluster;
+	} //end else if
+	for (i = 0; i < numclusters; i++)
+	{
+		if (AAS_FindAreaRoutingCache(clusters[i], areanum, travelflags)) continue;
+		if (AAS_MapRoutingCache(CACHETYPE_AREA, clusters[i], areanum, travelflags)) continue;
+		AAS_AddRoutingJob(AAS_NewAreaRoutingCache(clusters[i], areanum, travelflags), CACHETYPE_AREA);
+	} //end for
+} //end of the function AAS_AddAreaRoutingJobs
+//===========================================================================
+// adds the portal cache towards the area if it doesn't exist yet
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_AddPortalRoutingJob(int areanum, int travelflags)
+{
+	int clusternum;
+
+	if (AAS_FindPortalRoutingCache(areanum, travelflags)) return;
+	//portal goal areas are assumed to be part of the front cluster
+	clusternum = aasworld.areasettings[areanum].cluster;
+	if (clusternum < 0) clusternum = aasworld.portals[-clusternum].frontcluster;
+	if (AAS_MapRoutingCache(CACHETYPE_PORTAL, clusternum, areanum, travelflags)) return;
+	AAS_AddRoutingJob(AAS_NewPortalRoutingCache(clusternum, areanum, travelflags), CACHETYPE_PORTAL);
+} //end of the function AAS_AddPortalRoutingJob
+//===========================================================================
+// creates the area routing caches towards every area and the portal
+// routing caches towards every reachable area for the default travel
+// flags, so bots don't have to calculate them during the game
+// stops adding caches once the routing cache budget is used up
+// all caches are allocated on the calling thread, the travel times are
+// then calculated on the worker threads with separate routing update
+// fields for every thread, first for all area caches and then for the
+// portal caches which only read the area caches
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_PrecomputeRoutingCache(void)
+{
+	int i, numareacaches, numportalcaches, starttime;
+
+	starttime = Sys_MilliSeconds();
+	AAS_InitRoutingJobs();
+	//the area caches towards all areas that don't have one yet
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		if (routingcachesize >= routingcachelimit) break;
+		AAS_AddAreaRoutingJobs(i, TFL_DEFAULT);
+	} //end for
+	numareacaches = AAS_RunAreaRoutingJobs();
+	//the portal caches towards all reachable areas
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		if (routingcachesize >= routingcachelimit) break;
+		if (!AAS_AreaReachability(i)) continue;
+		AAS_AddPortalRoutingJob(i, TFL_DEFAULT);
+	} //end for
+	numportalcaches = AAS_RunPortalRoutingJobs();
+	//
+	if (i < aasworld.numareas)
+	{
+		botimport.Print(PRT_MESSAGE, "routing cache budget of %d KB reached, not all routing caches precomputed\n",
+						routingcachelimit >> 10);
+	} //end if
+	botimport.Print(PRT_MESSAGE, "%d area and %d portal routing caches (%d KB) in %d msec on %d threads\n",
+					numareacaches, numportalcaches, routingcachesize >> 10, Sys_MilliSeconds() - starttime, routingjobs.numthreads);
+} //end of the function AAS_PrecomputeRoutingCache
+//===========================================================================
+// calculates the routing caches needed for the given routes on the worker
+// threads, the bots then find them when they look up their routes one
+// after the other
+// routes to a goal area in another cluster use the portal cache towards
+// the goal area, which can only be calculated on the worker threads once
+// the area caches towards all portals exist for the travel flags
+// nothing more is prepared once the routing cache budget is used up, the
+// caches would only push out older ones before the bots get to use them
+//
+// Parameter:			requests		: routes to prepare
+//						numrequests		: number of routes
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_PrepareRoutes(const aas_routerequest_t *requests, int numrequests)
+{
+	int i, j, travelflags, clusternum, goalclusternum, numportalflags;
+	int portalflags[MAX_PREPAREDTRAVELFLAGS];
+	const aas_routerequest_t *request;
+	aas_portal_t *portal;
+
+	if (!aasworld.initialized || !prepareroutes || numrequests <= 0) return;
+	if (routingcachesize >= routingcachelimit) return;
+	AAS_InitRoutingJobs();
+	//the area caches towards the goal areas
+	numportalflags = 0;
+	for (i = 0, request = requests; i < numrequests; i++, request++)
+	{
+		if (routingcachesize >= routingcachelimit) break;
+		if (request->goalareanum <= 0 || request->goalareanum >= aasworld.numareas) continue;
+		if (request->areanum < 0 || request->areanum >= aasworld.numareas) continue;
+		if (!aasworld.areasettings[request->goalareanum].numreachableareas) continue;
+		//same travel flags as AAS_AreaRouteToGoalArea
+		travelflags = request->travelflags;
+		if ((request->areanum && AAS_AreaDoNotEnter(request->areanum)) || AAS_AreaDoNotEnter(request->goalareanum))
+		{
+			travelflags |= TFL_DONOTENTER;
+		} //end if
+		AAS_AddAreaRoutingJobs(request->goalareanum, travelflags);
+		//check if the route stays within one cluster
+		if (request->areanum)
+		{
+			clusternum = aasworld.areasettings[request->areanum].cluster;
+			goalclusternum = aasworld.areasettings[request->goalareanum].cluster;
+			if (clusternum < 0 && goalclusternum > 0)
+			{
+				portal = &aasworld.portals[-clusternum];
+				if (portal->frontcluster == goalclusternum || portal->backcluster == goalclusternum) continue;
+			} //end if
+			else if (clusternum > 0 && goalclusternum < 0)
+			{
+				portal = &aasworld.portals[-goalclusternum];
+				if (portal->frontcluster == clusternum || portal->backcluster == clusternum) continue;
+			} //end else if
+			else if (clusternum == goalclusternum) continue;
+		} //end if
+		if (AAS_FindPortalRoutingCache(request->goalareanum, travelflags)) continue;
+		//the portal cache needs the area caches towards all portals
+		for (j = 0; j < numportalflags; j++)
+		{
+			if (portalflags[j] == travelflags) break;
+		} //end for
+		if (j >= numportalflags && numportalflags < MAX_PREPAREDTRAVELFLAGS)
+		{
+			portalflags[numportalflags++] = travelflags;
+			for (j = 1; j < aasworld.numportals; j++)
+			{
+				AAS_AddAreaRoutingJobs(aasworld.portals[j].areanum, travelflags);
+			} //end for
+		} //end if
+	} //end for
+	AAS_RunAreaRoutingJobs();
+	if (!numportalflags) return;
+	//the portal caches towards the goal areas in other clusters
+	for (i = 0, request = requests; i < numrequests; i++, request++)
+	{
+		if (routingcachesize >= routingcachelimit) break;
+		if (request->goalareanum <= 0 || request->goalareanum >= aasworld.numareas) continue;
+		if (request->areanum < 0 || request->areanum >= aasworld.numareas) continue;
+		if (!aasworld.areasettings[request->goalareanum].numreachableareas) continue;
+		travelflags = request->travelflags;
+		if ((request->areanum && AAS_AreaDoNotEnter(request->areanum)) || AAS_AreaDoNotEnter(request->goalareanum))
+		{
+			travelflags |= TFL_DONOTENTER;
+		} //end if
+		//only when the area caches towards the portals were created
+		for (j = 0; j < numportalflags; j++)
+		{
+			if (portalflags[j] == travelflags) break;
+		} //end for
+		if (j >= numportalflags) continue;
+		AAS_AddPortalRoutingJob(request->goalareanum, travelflags);
+	} //end for
+	AAS_RunPortalRoutingJobs();
+} //end of the function AAS_PrepareRoutes
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static unsigned int AAS_RoutingCacheHash(const aas_routingcache_t *cache, int numtraveltimes)
+{
+	int i;
+	unsigned int hash;
+
+	hash = 2166136261u;
+	for (i = 0; i < numtraveltimes; i++)
+	{
+		hash = (hash ^ cache->traveltimes[i]) * 16777619u;
+		hash = (hash ^ cache->reachabilities[i]) * 16777619u;
+	} //end for
+	return hash;
+} //end of the function AAS_RoutingCacheHash
+//===========================================================================
+// compares a cache in memory with the same cache in the route cache file
+//
+// Parameter:			-
+// Returns:				true if the file has the same travel times and reachabilities
+// Changes Globals:		-
+//===========================================================================
+static int AAS_CompareFileRoutingCache(const aas_routingcache_t *cache)
+{
+	int numtraveltimes;
+	const aas_routecacheindex_t *index;
+	const byte *data;
+
+	index = AAS_FindRouteCacheIndex(cache->type, cache->cluster, cache->areanum, cache->travelflags);
+	if (!index) return false;
+	numtraveltimes = AAS_RouteCacheNumTravelTimes(cache->type, cache->cluster);
+	if (index->numtraveltimes != numtraveltimes) return false;
+	data = aasworld.routecachefile + index->ofs;
+	if (memcmp(data, cache->traveltimes, numtraveltimes * sizeof(unsigned short int))) return false;
+	data += numtraveltimes * sizeof(unsigned short int);
+	if (memcmp(data, cache->reachabilities, numtraveltimes * sizeof(unsigned char))) return false;
+	return true;
+} //end of the function AAS_CompareFileRoutingCache
+//===========================================================================
+// writes the route cache file, reads it back and compares every cache in
+// memory with the one in the file, which is then used as the route cache
+// file from here on
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_VerifyRouteCache(void)
+{
+	int i, j, numcaches, numdiff;
+	aas_routingcache_t *cache;
+	aas_cluster_t *cluster;
+
+	AAS_WriteRouteCache();
+	if (!AAS_ReadRouteCache())
+	{
+		botimport.Print(PRT_ERROR, "route cache file couldn't be read back\n");
+		return;
+	} //end if
+	numcaches = 0;
+	numdiff = 0;
+	for (i = 0; i < aasworld.numareas; i++)
+	{
+		for (cache = aasworld.portalcache[i]; cache; cache = cache->next)
+		{
+			numcaches++;
+			if (!AAS_CompareFileRoutingCache(cache)) numdiff++;
+		} //end for
+	} //end for
+	for (i = 0; i < aasworld.numclusters; i++)
+	{
+		cluster = &aasworld.clusters[i];
+		for (j = 0; j < cluster->numareas; j++)
+		{
+			for (cache = aasworld.clusterareacache[i][j]; cache; cache = cache->next)
+			{
+				numcaches++;
+				if (!AAS_CompareFileRoutingCache(cache)) numdiff++;
+			} //end for
+		} //end for
+	} //end for
+	if (numdiff || numcaches != aasworld.numroutecacheindex)
+	{
+		botimport.Print(PRT_ERROR, "%d of %d caches differ in the route cache file with %d caches\n",
+						numdiff, numcaches, aasworld.numroutecacheindex);
+	} //end if
+	else
+	{
+		botimport.Print(PRT_MESSAGE, "all %d caches read back from the route cache file\n", numcaches);
+	} //end else
+} //end of the function AAS_VerifyRouteCache
+//===========================================================================
+// builds the area and portal routing caches towards every reachable area,
+// once with the first in first out routing updates and once with the
+// radix heap, and prints the build times and the number of caches that
+// came out different, the last caches are then written to the route
+// cache file and compared with what is read back
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_RoutingBenchmark(void)
+{
+	int i, j, pass, numclusters, clusters[2], numcaches, numdiff;
+	int starttime, areatime, portaltime, heap, numroutecacheindex;
+	unsigned int *hashes, hash;
+	aas_routingcache_t *cache;
+	aas_portal_t *portal;
+
+	if (!aasworld.initialized) return;
+	//an area cache for every cluster the area is in and a portal cache per area
+	hashes = (unsigned int *) GetClearedMemory(aasworld.numareas * 3 * sizeof(unsigned int));
+	heap = routingheap;
+	//build every cache instead of using the route cache file
+	numroutecacheindex = aasworld.numroutecacheindex;
+	aasworld.numroutecacheindex = 0;
+	for (pass = 0; pass < 2; pass++)
+	{
+		routingheap = pass;
+		//start without any cache
+		AAS_FreeAllClusterAreaCache();
+		AAS_InitClusterAreaCache();
+		AAS_FreeAllPortalCache();
+		AAS_InitPortalCache();
+#ifdef ROUTING_DEBUG
+		numareacacheupdates = 0;
+		numportalcacheupdates = 0;
+#endif //ROUTING_DEBUG
+		numcaches = 0;
+		numdiff = 0;
+		//area caches
+		starttime = Sys_MilliSeconds();
+		for (i = 1; i < aasworld.numareas; i++)
+		{
+			if (!AAS_AreaReachability(i)) continue;
+			numclusters = 0;
+			if (aasworld.areasettings[i].cluster < 0)
+			{
+				portal = &aasworld.portals[-aasworld.areasettings[i].cluster];
+				clusters[numclusters++] = portal->frontcluster;
+				clusters[numclusters++] = portal->backcluster;
+			} //end if
+			else
+			{
+				clusters[numclusters++] = aasworld.areasettings[i].cluster;
+			} //end else
+			for (j = 0; j < numclusters; j++)
+			{
+				cache = AAS_GetAreaRoutingCache(clusters[j], i, TFL_DEFAULT);
+				hash = AAS_RoutingCacheHash(cache, aasworld.clusters[clusters[j]].numreachabilityareas);
+				if (pass && hashes[numcaches] != hash) numdiff++;
+				hashes[numcaches++] = hash;
+				//same limit as AAS_AreaTravelTimeToGoalArea
+				while (routingcachesize > routingcachelimit)
+				{
+					if (!AAS_FreeOldestCache()) break;
+				} //end while
+			} //end for
+		} //end for
+		areatime = Sys_MilliSeconds() - starttime;
+		//portal caches
+		starttime = Sys_MilliSeconds();
+		for (i = 1; i < aasworld.numareas; i++)
+		{
+			if (!AAS_AreaReachability(i)) continue;
+			//portal goal areas are assumed to be part of the front cluster
+			clusters[0] = aasworld.areasettings[i].cluster;
+			if (clusters[0] < 0) clusters[0] = aasworld.portals[-clusters[0]].frontcluster;
+			cache = AAS_GetPortalRoutingCache(clusters[0], i, TFL_DEFAULT);
+			hash = AAS_RoutingCacheHash(cache, aasworld.numportals);
+			if (pass && hashes[numcaches] != hash) numdiff++;
+			hashes[numcaches++] = hash;
+			while (routingcachesize > routingcachelimit)
+			{
+				if (!AAS_FreeOldestCache()) break;
+			} //end while
+		} //end for
+		portaltime = Sys_MilliSeconds() - starttime;
+		//
+		botimport.Print(PRT_MESSAGE, "%s: %d msec area caches, %d msec portal caches\n",
+							pass ? "radix heap" : "fifo", areatime, portaltime);
+#ifdef ROUTING_DEBUG
+		botimport.Print(PRT_MESSAGE, "%d area cache updates, %d portal cache updates\n",
+							numareacacheupdates, numportalcacheupdates);
+#endif //ROUTING_DEBUG
+		if (pass) botimport.Print(PRT_MESSAGE, "%d of %d caches differ\n", numdiff, numcaches);
+	} //end for
+	routingheap = heap;
+	FreeMemory(hashes);
+	aasworld.numroutecacheindex = numroutecacheindex;
+	//make sure the caches come back from the route cache file unchanged
+	AAS_VerifyRouteCache();
+	//don't keep the caches built with the other routing update
+	AAS_FreeAllClusterAreaCache();
+	AAS_InitClusterAreaCache();
+	AAS_FreeAllPortalCache();
+	AAS_InitPortalCache();
+	if ((int) LibVarValue("precomputeroutingcache", "0")) AAS_PrecomputeRoutingCache();
+} //end of the function AAS_RoutingBenchmark
+//===========================================================================
+// prints the routing cache lookups and memory use
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_RoutingCacheStats(void)
+{
+	int i, numslabs, lookups;
+	aas_routingslabclass_t *slabclass;
+
+	if (!aasworld.initialized) return;
+	lookups = routingcachestats.hits + routingcachestats.filehits + routingcachestats.misses;
+	botimport.Print(PRT_MESSAGE, "%d routing cache lookups: %d hits, %d from the route cache file, %d misses\n",
+					lookups, routingcachestats.hits, routingcachestats.filehits, routingcachestats.misses);
+	botimport.Print(PRT_MESSAGE, "%d evictions\n", routingcachestats.evictions);
+	numslabs = 0;
+	for (i = 0; i < numroutingslabclasses; i++)
+	{
+		slabclass = &routingslabclasses[i];
+		numslabs += slabclass->numslabs;
+		if (!slabclass->numslabs) continue;
+		botimport.Print(PRT_MESSAGE, "%6d byte blocks: %d slabs of %d blocks\n",
+						slabclass->blocksize, slabclass->numslabs, slabclass->numblocks);
+	} //end for
+	botimport.Print(PRT_MESSAGE, "%d bytes in use, %d peak, %d budget\n",
+					routingcachesize, routingcachestats.peaksize, routingcachelimit);
+	botimport.Print(PRT_MESSAGE, "%d bytes in %d slabs of %d size classes\n",
+					routingslabsize, numslabs, numroutingslabclasses);
+} //end of the function AAS_RoutingCacheStats
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -1627,7 +3054,7 @@ static int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum,
 	} //end if
 
 	// make sure the routing cache doesn't grow to large
-	while ( routingcachesize > 12 * 1024 * 1024 ) {
+	while ( routingcachesize > routingcachelimit ) {
 		if ( !AAS_FreeOldestCache() ) {
 			break;
 		}
@@ -39,6 +39,12 @@ unsigned short int AAS_AreaTravelTime(int areanum, vec3_t start, vec3_t end);
 //
 void AAS_CreateAllRoutingCache(void);
 void AAS_WriteRouteCache(void);
+//times building all routing caches with both routing update queues
+void AAS_RoutingBenchmark(void);
+//prints the routing cache lookups and memory use
+void AAS_RoutingCacheStats(void);
+//creates all default routing caches on the worker threads
+void AAS_PrecomputeRoutingCache(void);
 //
 void AAS_RoutingInfo(void);
 #endif //AASINTERN
@@ -57,6 +63,8 @@ int AAS_RandomGoalArea(int areanum, int travelflags, int *goalareanum, vec3_t go
 int AAS_EnableRoutingArea(int areanum, int enable);
 //returns the travel time within the given area from start to end
 unsigned short int AAS_AreaTravelTime(int areanum, vec3_t start, vec3_t end);
+//calculates the routing caches for the given routes on the worker threads
+void AAS_PrepareRoutes(const aas_routerequest_t *requests, int numrequests);
 //returns the travel time from the area to the goal area using the given travel flags
 int AAS_AreaTravelTimeToGoalArea(int areanum, vec3_t origin, int goalareanum, int travelflags);
 //predict a route up to a stop event
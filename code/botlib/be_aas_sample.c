@@ -53,6 +53,15 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #define TRACEPLANE_EPSILON			0.125
 
+#define SAMPLEGRID_CELLSIZE			128
+#define MAX_SAMPLEGRID_CELLS		(1<<18)
+//cells are grown this much while building so points rounded into a
+//neighbouring cell are still at the same side of all the parent planes
+#define SAMPLEGRID_EPSILON			1
+
+#define SAMPLEBENCH_PASSES			8
+#define SAMPLEBENCH_POINTSPERAREA	4
+
 typedef struct aas_tracestack_s
 {
 	vec3_t start;		//start point of the piece of line to trace
@@ -203,6 +212,192 @@ void AAS_FreeAASLinkedEntities(void)
 	aasworld.arealinkedentities = NULL;
 } //end of the function AAS_InitAASLinkedEntities
 //===========================================================================
+// returns the deepest node with the whole box at one side of the planes
+// of all the nodes above it
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_BoxStartNode(vec3_t mins, vec3_t maxs)
+{
+	int nodenum, i;
+	float front, back;
+	aas_node_t *node;
+	aas_plane_t *plane;
+
+	//start with node 1 because node zero is a dummy used for solid leafs
+	nodenum = 1;
+	while (nodenum > 0)
+	{
+		node = &aasworld.nodes[nodenum];
+		plane = &aasworld.planes[node->planenum];
+		//largest and smallest distance of the box corners to the plane
+		front = back = -plane->dist;
+		for (i = 0; i < 3; i++)
+		{
+			if (plane->normal[i] >= 0)
+			{
+				front += plane->normal[i] * maxs[i];
+				back += plane->normal[i] * mins[i];
+			} //end if
+			else
+			{
+				front += plane->normal[i] * mins[i];
+				back += plane->normal[i] * maxs[i];
+			} //end else
+		} //end for
+		//strictly at one side so both point and trace queries take this child
+		if (back > 0) nodenum = node->children[0];
+		else if (front < 0) nodenum = node->children[1];
+		else break;
+	} //end while
+	return nodenum;
+} //end of the function AAS_BoxStartNode
+//===========================================================================
+// fills in the start nodes of one horizontal slice of grid cells
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_SampleGridJob(void *data, int index, int thread)
+{
+	aas_samplegrid_t *grid = (aas_samplegrid_t *) data;
+	int x, y, *nodes;
+	vec3_t mins, maxs;
+
+	nodes = grid->nodes + index * grid->size[0] * grid->size[1];
+	mins[2] = grid->mins[2] + index * grid->cellsize - SAMPLEGRID_EPSILON;
+	maxs[2] = mins[2] + grid->cellsize + 2 * SAMPLEGRID_EPSILON;
+	for (y = 0; y < grid->size[1]; y++)
+	{
+		mins[1] = grid->mins[1] + y * grid->cellsize - SAMPLEGRID_EPSILON;
+		maxs[1] = mins[1] + grid->cellsize + 2 * SAMPLEGRID_EPSILON;
+		for (x = 0; x < grid->size[0]; x++)
+		{
+			mins[0] = grid->mins[0] + x * grid->cellsize - SAMPLEGRID_EPSILON;
+			maxs[0] = mins[0] + grid->cellsize + 2 * SAMPLEGRID_EPSILON;
+			*nodes++ = AAS_BoxStartNode(mins, maxs);
+		} //end for
+	} //end for
+} //end of the function AAS_SampleGridJob
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_FreeSampleGrid(void)
+{
+	if (aasworld.samplegrid.nodes) FreeMemory(aasworld.samplegrid.nodes);
+	Com_Memset(&aasworld.samplegrid, 0, sizeof(aas_samplegrid_t));
+} //end of the function AAS_FreeSampleGrid
+//===========================================================================
+// builds a uniform grid over the world with a start node in the bsp tree
+// for every cell so point and trace queries can skip the top of the tree
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_InitSampleGrid(void)
+{
+	aas_samplegrid_t *grid;
+	vec3_t mins, maxs;
+	int i, numcells, starttime;
+
+	AAS_FreeSampleGrid();
+	if (!aasworld.loaded || aasworld.numnodes < 2) return;
+	if (!(int)LibVarValue("samplegrid", "1")) return;
+	//
+	ClearBounds(mins, maxs);
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		AddPointToBounds(aasworld.areas[i].mins, mins, maxs);
+		AddPointToBounds(aasworld.areas[i].maxs, mins, maxs);
+	} //end for
+	if (mins[0] > maxs[0]) return;
+	//
+	starttime = Sys_MilliSeconds();
+	grid = &aasworld.samplegrid;
+	VectorCopy(mins, grid->mins);
+	//use larger cells for huge maps
+	for (grid->cellsize = SAMPLEGRID_CELLSIZE; ; grid->cellsize *= 2)
+	{
+		numcells = 1;
+		for (i = 0; i < 3; i++)
+		{
+			grid->size[i] = (int) ((maxs[i] - mins[i]) / grid->cellsize) + 1;
+			numcells *= grid->size[i];
+		} //end for
+		if (numcells <= MAX_SAMPLEGRID_CELLS) break;
+	} //end for
+	grid->invcellsize = 1.0f / grid->cellsize;
+	grid->nodes = (int *) GetMemory(numcells * sizeof(int));
+	//every slice only reads the tree so they're built on the workers
+	botimport.ParallelFor(grid->size[2], AAS_SampleGridJob, grid);
+	//
+	botimport.Print(PRT_MESSAGE, "sample grid %d x %d x %d cells of %d units in %d msec\n",
+						grid->size[0], grid->size[1], grid->size[2], (int) grid->cellsize,
+						Sys_MilliSeconds() - starttime);
+} //end of the function AAS_InitSampleGrid
+//===========================================================================
+// returns the grid cell the point is in or -1 if outside the grid
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_SampleGridCell(vec3_t point)
+{
+	aas_samplegrid_t *grid = &aasworld.samplegrid;
+	int i, cell[3];
+	float f;
+
+	if (!grid->nodes) return -1;
+	for (i = 0; i < 3; i++)
+	{
+		f = (point[i] - grid->mins[i]) * grid->invcellsize;
+		//also fails for NaN
+		if (!(f >= 0 && f < grid->size[i])) return -1;
+		cell[i] = (int) f;
+	} //end for
+	return (cell[2] * grid->size[1] + cell[1]) * grid->size[0] + cell[0];
+} //end of the function AAS_SampleGridCell
+//===========================================================================
+// returns the node to start a point query at
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_PointStartNode(vec3_t point)
+{
+	int cell;
+
+	cell = AAS_SampleGridCell(point);
+	//start with node 1 because node zero is a dummy used for solid leafs
+	if (cell < 0) return 1;
+	return aasworld.samplegrid.nodes[cell];
+} //end of the function AAS_PointStartNode
+//===========================================================================
+// returns the node to start a trace at, the whole line has to be in
+// one cell because it is not split above the start node
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_TraceStartNode(vec3_t start, vec3_t end)
+{
+	int cell;
+
+	cell = AAS_SampleGridCell(start);
+	if (cell < 0 || cell != AAS_SampleGridCell(end)) return 1;
+	return aasworld.samplegrid.nodes[cell];
+} //end of the function AAS_TraceStartNode
+//===========================================================================
 // returns the AAS area the point is in
 //
 // Parameter:				-
@@ -222,8 +417,8 @@ int AAS_PointAreaNum(vec3_t point)
 		return 0;
 	} //end if
 
-	//start with node 1 because node zero is a dummy used for solid leafs
-	nodenum = 1;
+	//start below the nodes the whole grid cell is at one side of
+	nodenum = AAS_PointStartNode(point);
 	while (nodenum > 0)
 	{
 //		botimport.Print(PRT_MESSAGE, "[%d]", nodenum);
@@ -257,6 +452,40 @@ int AAS_PointAreaNum(vec3_t point)
 	return -nodenum;
 } //end of the function AAS_PointAreaNum
 //===========================================================================
+// returns true if the point is at least epsilon inside all the faces of
+// the area, the area then also is the one AAS_PointAreaNum returns
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+bool AAS_PointInsideArea(int areanum, vec3_t point, float epsilon)
+{
+	int i, facenum, side;
+	aas_area_t *area;
+	aas_face_t *face;
+	aas_plane_t *plane;
+
+	if (!aasworld.loaded) return false;
+	if (areanum <= 0 || areanum >= aasworld.numareas) return false;
+	area = &aasworld.areas[areanum];
+	for (i = 0; i < 3; i++)
+	{
+		if (point[i] < area->mins[i] + epsilon) return false;
+		if (point[i] > area->maxs[i] - epsilon) return false;
+	} //end for
+	for (i = 0; i < area->numfaces; i++)
+	{
+		facenum = abs(aasworld.faceindex[area->firstface + i]);
+		face = &aasworld.faces[facenum];
+		//the area is at the back of the plane facing away from it
+		side = face->backarea != areanum;
+		plane = &aasworld.planes[face->planenum ^ side];
+		if (DotProduct(point, plane->normal) - plane->dist > -epsilon) return false;
+	} //end for
+	return true;
+} //end of the function AAS_PointInsideArea
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -419,8 +648,9 @@ aas_trace_t AAS_TraceClientBBox(vec3_t start, vec3_t end, int presencetype,
 	VectorCopy(start, tstack_p->start);
 	VectorCopy(end, tstack_p->end);
 	tstack_p->planenum = 0;
-	//start with node 1 because node zero is a dummy for a solid leaf
-	tstack_p->nodenum = 1;		//starting at the root of the tree
+	//start with the node the line isn't split above, node 1 is the root
+	//of the tree because node zero is a dummy for a solid leaf
+	tstack_p->nodenum = AAS_TraceStartNode(start, end);
 	tstack_p++;
 	
 	while (1)
@@ -694,8 +924,9 @@ int AAS_TraceAreas(vec3_t start, vec3_t end, int *areas, vec3_t *points, int max
 	VectorCopy(start, tstack_p->start);
 	VectorCopy(end, tstack_p->end);
 	tstack_p->planenum = 0;
-	//start with node 1 because node zero is a dummy for a solid leaf
-	tstack_p->nodenum = 1;		//starting at the root of the tree
+	//start with the node the line isn't split above, node 1 is the root
+	//of the tree because node zero is a dummy for a solid leaf
+	tstack_p->nodenum = AAS_TraceStartNode(start, end);
 	tstack_p++;
 
 	while (1)
@@ -1295,3 +1526,116 @@ aas_plane_t *AAS_PlaneFromNum(int planenum)
 
 	return &aasworld.planes[planenum];
 } //end of the function AAS_PlaneFromNum
+//===========================================================================
+// times point and trace queries through the whole tree and from the
+// sample grid, and checking the last area, with points in all the areas
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_SampleBenchmark(void)
+{
+	int i, j, pass, numpoints, seed, starttime, mismatches, hits, wrong;
+	int pointtime[2], tracetime[2], insidetime;
+	int *gridnodes, *pointareas, areanum, numtraceareas[2], traceareas[2][32];
+	vec3_t *points, *ends;
+	aas_area_t *area;
+
+	if (!aasworld.loaded)
+	{
+		botimport.Print(PRT_MESSAGE, "no aas file loaded\n");
+		return;
+	} //end if
+	numpoints = (aasworld.numareas - 1) * SAMPLEBENCH_POINTSPERAREA;
+	if (numpoints <= 0) return;
+	points = (vec3_t *) GetMemory(numpoints * sizeof(vec3_t));
+	ends = (vec3_t *) GetMemory(numpoints * sizeof(vec3_t));
+	pointareas = (int *) GetMemory(numpoints * sizeof(int));
+	//random points in the area bounds with short lines from them
+	seed = 1;
+	for (i = 0; i < numpoints; i++)
+	{
+		area = &aasworld.areas[1 + i / SAMPLEBENCH_POINTSPERAREA];
+		for (j = 0; j < 3; j++)
+		{
+			seed = seed * 1103515245 + 12345;
+			points[i][j] = area->mins[j] + (area->maxs[j] - area->mins[j]) * ((seed >> 16) & 0x7fff) / 32767.0f;
+			seed = seed * 1103515245 + 12345;
+			ends[i][j] = points[i][j] + (((seed >> 16) & 0x7fff) / 16383.5f - 1) * 64;
+		} //end for
+	} //end for
+	//
+	gridnodes = aasworld.samplegrid.nodes;
+	for (pass = 0; pass < 2; pass++)
+	{
+		aasworld.samplegrid.nodes = pass ? gridnodes : NULL;
+		if (pass && !gridnodes) break;
+		//
+		starttime = Sys_MilliSeconds();
+		for (j = 0; j < SAMPLEBENCH_PASSES; j++)
+		{
+			for (i = 0; i < numpoints; i++)
+			{
+				pointareas[i] = AAS_PointAreaNum(points[i]);
+			} //end for
+		} //end for
+		pointtime[pass] = Sys_MilliSeconds() - starttime;
+		//
+		starttime = Sys_MilliSeconds();
+		for (j = 0; j < SAMPLEBENCH_PASSES; j++)
+		{
+			for (i = 0; i < numpoints; i++)
+			{
+				AAS_TraceAreas(points[i], ends[i], traceareas[0], NULL, 32);
+			} //end for
+		} //end for
+		tracetime[pass] = Sys_MilliSeconds() - starttime;
+	} //end for
+	aasworld.samplegrid.nodes = gridnodes;
+	//make sure the grid doesn't change any of the results
+	mismatches = 0;
+	for (i = 0; gridnodes && i < numpoints; i++)
+	{
+		aasworld.samplegrid.nodes = NULL;
+		areanum = AAS_PointAreaNum(points[i]);
+		numtraceareas[0] = AAS_TraceAreas(points[i], ends[i], traceareas[0], NULL, 32);
+		aasworld.samplegrid.nodes = gridnodes;
+		numtraceareas[1] = AAS_TraceAreas(points[i], ends[i], traceareas[1], NULL, 32);
+		if (AAS_PointAreaNum(points[i]) != areanum ||
+				numtraceareas[0] != numtraceareas[1] ||
+				memcmp(traceareas[0], traceareas[1], numtraceareas[0] * sizeof(int)))
+		{
+			mismatches++;
+		} //end if
+	} //end for
+	//check the area of the previous point like a bot checks its last area
+	hits = wrong = 0;
+	starttime = Sys_MilliSeconds();
+	for (j = 0; j < SAMPLEBENCH_PASSES; j++)
+	{
+		for (i = 1; i < numpoints; i++)
+		{
+			if (AAS_PointInsideArea(pointareas[i-1], points[i], 1))
+			{
+				hits++;
+				if (pointareas[i] != pointareas[i-1]) wrong++;
+			} //end if
+		} //end for
+	} //end for
+	insidetime = Sys_MilliSeconds() - starttime;
+	//
+	botimport.Print(PRT_MESSAGE, "%d points, %d passes\n", numpoints, SAMPLEBENCH_PASSES);
+	botimport.Print(PRT_MESSAGE, "tree: %d msec point areas, %d msec trace areas\n", pointtime[0], tracetime[0]);
+	if (gridnodes)
+	{
+		botimport.Print(PRT_MESSAGE, "grid: %d msec point areas, %d msec trace areas, %d mismatches\n",
+							pointtime[1], tracetime[1], mismatches);
+	} //end if
+	botimport.Print(PRT_MESSAGE, "last area: %d msec, %d of %d hits, %d wrong\n",
+						insidetime, hits, (numpoints - 1) * SAMPLEBENCH_PASSES, wrong);
+	//
+	FreeMemory(points);
+	FreeMemory(ends);
+	FreeMemory(pointareas);
+} //end of the function AAS_SampleBenchmark
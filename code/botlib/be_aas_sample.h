@@ -34,6 +34,9 @@ void AAS_InitAASLinkHeap(void);
 void AAS_InitAASLinkedEntities(void);
 void AAS_FreeAASLinkHeap(void);
 void AAS_FreeAASLinkedEntities(void);
+void AAS_InitSampleGrid(void);
+void AAS_FreeSampleGrid(void);
+void AAS_SampleBenchmark(void);
 
 aas_face_t *AAS_TraceEndFace(aas_trace_t *trace);
 aas_plane_t *AAS_PlaneFromNum(int planenum);
@@ -61,5 +64,7 @@ int AAS_BBoxAreas(vec3_t absmins, vec3_t absmaxs, int *areas, int maxareas);
 int AAS_AreaInfo( int areanum, aas_areainfo_t *info );
 //returns the area the point is in
 int AAS_PointAreaNum(vec3_t point);
+//returns true if the point is well inside the area
+bool AAS_PointInsideArea(int areanum, vec3_t point, float epsilon);
 //
 int AAS_PointReachabilityAreaIndex( vec3_t point );
@@ -112,6 +112,7 @@ typedef struct bot_synonym_s
 {
 	char *string;
 	float weight;
+	int pattern;						//string number in the match automaton
 	struct bot_synonym_s *next;
 } bot_synonym_t;
 //list with synonyms
@@ -127,6 +128,7 @@ typedef struct bot_synonymlist_s
 typedef struct bot_matchstring_s
 {
 	char *string;
+	int pattern;						//string number in the match automaton
 	struct bot_matchstring_s *next;
 } bot_matchstring_t;
 
@@ -190,6 +192,28 @@ typedef struct bot_chatstate_s
 	bot_chat_t *chat;
 } bot_chatstate_t;
 
+//node of the match automaton
+typedef struct bot_matchnode_s
+{
+	int character;						//lower case character leading to this node
+	int depth;							//length of the string ending at this node
+	int child;							//first child node, 0 if none
+	int sibling;						//next child of the parent node, 0 if none
+	int fail;							//node of the longest proper suffix in the automaton
+	int output;							//first node on the fail path that ends a string, 0 if none
+	int pattern;						//string ending at this node, -1 if none
+} bot_matchnode_t;
+//automaton with all match template and synonym strings
+typedef struct bot_matchautomaton_s
+{
+	int numnodes;
+	bot_matchnode_t *nodes;				//node 0 is the root
+	int numpatterns;
+	int *patternpos;					//position of the first occurrence of each string
+	int *patternscan;					//scan the position was found in
+	int scan;							//current scan
+} bot_matchautomaton_t;
+
 typedef struct {
 	bot_chat_t	*chat;
 	char		filename[MAX_QPATH];
@@ -210,6 +234,8 @@ static bot_synonymlist_t *synonyms = NULL;
 static bot_randomlist_t *randomstrings = NULL;
 //reply chats
 static bot_replychat_t *replychats = NULL;
+//automaton to find the match and synonym strings in a message
+static bot_matchautomaton_t *matchautomaton = NULL;
 
 //========================================================================
 //
@@ -549,15 +575,16 @@ static const char *StringContainsWord( const char *str1, const char *str2 )
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-static void StringReplaceWords( char *string, int size, const char *synonym, const char *replacement )
+static int StringReplaceWords( char *string, int size, const char *synonym, const char *replacement )
 {
 	char *str;
 	const char *str2, *endp;
-	int replen, synlen;
+	int replen, synlen, numreplaced;
 
 	synlen = (int) strlen( synonym );
 	replen = (int) strlen( replacement );
 	endp = string + size;
+	numreplaced = 0;
 
 	//find the synonym in the string
 	str = (char *) StringContainsWord( string, synonym );
@@ -580,12 +607,237 @@ static void StringReplaceWords( char *string, int size, const char *synonym, con
 			memmove( str + replen, str + synlen, strlen( str + synlen ) + 1 );
 			//append the synonym replacement
 			Com_Memcpy( str, replacement, replen );
+			numreplaced++;
 		}
 
 		//find the next synonym in the string
 		str = (char *) StringContainsWord( str + replen, synonym );
 	} //end if
+	return numreplaced;
 } //end of the function StringReplaceWords
+//===========================================================================
+// returns the child of the automaton node reached with the given
+// lower case character, 0 if there is no such child
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int BotMatchNodeChild( const bot_matchautomaton_t *ma, int node, int c )
+{
+	int child;
+
+	for ( child = ma->nodes[node].child; child; child = ma->nodes[child].sibling )
+	{
+		if ( ma->nodes[child].character == c )
+			return child;
+	} //end for
+	return 0;
+} //end of the function BotMatchNodeChild
+//===========================================================================
+// adds a string to the automaton and returns the string number,
+// strings that only differ in case share the same number
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int BotAddMatchString( bot_matchautomaton_t *ma, const char *string )
+{
+	int node, child, c;
+
+	if ( !*string )
+		return -1;
+
+	node = 0;
+	for ( ; *string; string++ )
+	{
+		c = locase[(byte) *string];
+		child = BotMatchNodeChild( ma, node, c );
+		if ( !child )
+		{
+			child = ma->numnodes++;
+			ma->nodes[child].character = c;
+			ma->nodes[child].depth = ma->nodes[node].depth + 1;
+			ma->nodes[child].pattern = -1;
+			ma->nodes[child].sibling = ma->nodes[node].child;
+			ma->nodes[node].child = child;
+		} //end if
+		node = child;
+	} //end for
+	if ( ma->nodes[node].pattern < 0 )
+		ma->nodes[node].pattern = ma->numpatterns++;
+	return ma->nodes[node].pattern;
+} //end of the function BotAddMatchString
+//===========================================================================
+// number of characters in all the strings of the automaton
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int BotMatchStringsLength( void )
+{
+	bot_matchtemplate_t *mt;
+	bot_matchpiece_t *mp;
+	bot_matchstring_t *ms;
+	bot_synonymlist_t *syn;
+	bot_synonym_t *synonym;
+	int length;
+
+	length = 0;
+	for ( mt = matchtemplates; mt; mt = mt->next )
+	{
+		for ( mp = mt->first; mp; mp = mp->next )
+		{
+			if ( mp->type != MT_STRING )
+				continue;
+			for ( ms = mp->firststring; ms; ms = ms->next )
+				length += strlen( ms->string );
+		} //end for
+	} //end for
+	for ( syn = synonyms; syn; syn = syn->next )
+	{
+		for ( synonym = syn->firstsynonym; synonym; synonym = synonym->next )
+			length += strlen( synonym->string );
+	} //end for
+	return length;
+} //end of the function BotMatchStringsLength
+//===========================================================================
+// compiles the match template and synonym strings into an Aho-Corasick
+// automaton, one pass over a message then tells which of the strings occur
+// in the message and where they first occur
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static bot_matchautomaton_t *BotBuildMatchAutomaton( void )
+{
+	bot_matchautomaton_t *ma;
+	bot_matchtemplate_t *mt;
+	bot_matchpiece_t *mp;
+	bot_matchstring_t *ms;
+	bot_synonymlist_t *syn;
+	bot_synonym_t *synonym;
+	int maxnodes, *queue, head, tail, node, child, fail, next;
+
+	maxnodes = BotMatchStringsLength() + 1;
+	ma = (bot_matchautomaton_t *) GetClearedMemory( sizeof( bot_matchautomaton_t ) + maxnodes * sizeof( bot_matchnode_t ) );
+	ma->nodes = (bot_matchnode_t *) ( ma + 1 );
+	ma->nodes[0].pattern = -1;
+	ma->numnodes = 1;
+	//add all the strings to the trie
+	for ( mt = matchtemplates; mt; mt = mt->next )
+	{
+		for ( mp = mt->first; mp; mp = mp->next )
+		{
+			if ( mp->type != MT_STRING )
+				continue;
+			for ( ms = mp->firststring; ms; ms = ms->next )
+				ms->pattern = BotAddMatchString( ma, ms->string );
+		} //end for
+	} //end for
+	for ( syn = synonyms; syn; syn = syn->next )
+	{
+		for ( synonym = syn->firstsynonym; synonym; synonym = synonym->next )
+			synonym->pattern = BotAddMatchString( ma, synonym->string );
+	} //end for
+	//set the fail and output links breadth first
+	queue = (int *) GetMemory( ma->numnodes * sizeof( int ) );
+	head = tail = 0;
+	for ( child = ma->nodes[0].child; child; child = ma->nodes[child].sibling )
+		queue[tail++] = child;
+	while ( head < tail )
+	{
+		node = queue[head++];
+		for ( child = ma->nodes[node].child; child; child = ma->nodes[child].sibling )
+		{
+			fail = ma->nodes[node].fail;
+			while ( 1 )
+			{
+				next = BotMatchNodeChild( ma, fail, ma->nodes[child].character );
+				if ( next || !fail )
+					break;
+				fail = ma->nodes[fail].fail;
+			} //end while
+			ma->nodes[child].fail = next;
+			if ( ma->nodes[next].pattern >= 0 )
+				ma->nodes[child].output = next;
+			else
+				ma->nodes[child].output = ma->nodes[next].output;
+			queue[tail++] = child;
+		} //end for
+	} //end while
+	FreeMemory( queue );
+	//
+	ma->patternpos = (int *) GetClearedMemory( ma->numpatterns * 2 * sizeof( int ) + 1 );
+	ma->patternscan = ma->patternpos + ma->numpatterns;
+	return ma;
+} //end of the function BotBuildMatchAutomaton
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void BotFreeMatchAutomaton( bot_matchautomaton_t *ma )
+{
+	FreeMemory( ma->patternpos );
+	FreeMemory( ma );
+} //end of the function BotFreeMatchAutomaton
+//===========================================================================
+// finds all the automaton strings in the given string in one pass
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void BotScanMatchStrings( bot_matchautomaton_t *ma, const char *string )
+{
+	int i, c, node, next, out, pattern;
+
+	ma->scan++;
+	node = 0;
+	for ( i = 0; string[i]; i++ )
+	{
+		c = locase[(byte) string[i]];
+		while ( 1 )
+		{
+			next = BotMatchNodeChild( ma, node, c );
+			if ( next || !node )
+				break;
+			node = ma->nodes[node].fail;
+		} //end while
+		node = next;
+		//the strings ending here, the first time a string is found is its first occurrence
+		out = ( ma->nodes[node].pattern >= 0 ) ? node : ma->nodes[node].output;
+		for ( ; out; out = ma->nodes[out].output )
+		{
+			pattern = ma->nodes[out].pattern;
+			if ( ma->patternscan[pattern] == ma->scan )
+				continue;
+			ma->patternscan[pattern] = ma->scan;
+			ma->patternpos[pattern] = i + 1 - ma->nodes[out].depth;
+		} //end for
+	} //end for
+} //end of the function BotScanMatchStrings
+//===========================================================================
+// returns the position of the first occurrence of the string in the last
+// scanned string, -1 if it doesn't occur, empty strings occur at 0
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int BotMatchStringPosition( const bot_matchautomaton_t *ma, int pattern )
+{
+	if ( pattern < 0 )
+		return 0;
+	if ( ma->patternscan[pattern] != ma->scan )
+		return -1;
+	return ma->patternpos[pattern];
+} //end of the function BotMatchStringPosition
 
 //===========================================================================
 //
@@ -700,6 +952,7 @@ static bot_synonymlist_t *BotLoadSynonyms( const char *filename )
 							synonym->string = ptr;
 							ptr += len;
 							strcpy(synonym->string, token.string);
+							synonym->pattern = -1;
 							//
 							if (lastsynonym) lastsynonym->next = synonym;
 							else syn->firstsynonym = synonym;
@@ -767,6 +1020,11 @@ void BotReplaceSynonyms( char *string, int size, unsigned long int context )
 	const bot_synonymlist_t *syn;
 	const bot_synonym_t *synonym;
 
+	//find all the synonyms in the string at once, the string only has
+	//to be scanned again after a replacement changed it
+	if ( matchautomaton )
+		BotScanMatchStrings( matchautomaton, string );
+
 	for ( syn = synonyms; syn; syn = syn->next )
 	{
 		if ( (syn->context & context) == 0 )
@@ -774,7 +1032,10 @@ void BotReplaceSynonyms( char *string, int size, unsigned long int context )
 
 		for ( synonym = syn->firstsynonym->next; synonym; synonym = synonym->next )
 		{
-			StringReplaceWords( string, size, synonym->string, syn->firstsynonym->string );
+			if ( matchautomaton && BotMatchStringPosition( matchautomaton, synonym->pattern ) < 0 )
+				continue;
+			if ( StringReplaceWords( string, size, synonym->string, syn->firstsynonym->string ) && matchautomaton )
+				BotScanMatchStrings( matchautomaton, string );
 		} //end for
 	} //end for
 } //end of the function BotReplaceSynonyms
@@ -790,6 +1051,9 @@ static void BotReplaceWeightedSynonyms( char *string, int size, unsigned long in
 	bot_synonym_t *synonym, *replacement;
 	float weight, curweight;
 
+	if ( matchautomaton )
+		BotScanMatchStrings( matchautomaton, string );
+
 	for ( syn = synonyms; syn; syn = syn->next )
 	{
 		if ( ( syn->context & context ) == 0 )
@@ -815,7 +1079,10 @@ static void BotReplaceWeightedSynonyms( char *string, int size, unsigned long in
 		{
 			if ( synonym == replacement )
 				continue;
-			StringReplaceWords( string, size, synonym->string, replacement->string );
+			if ( matchautomaton && BotMatchStringPosition( matchautomaton, synonym->pattern ) < 0 )
+				continue;
+			if ( StringReplaceWords( string, size, synonym->string, replacement->string ) && matchautomaton )
+				BotScanMatchStrings( matchautomaton, string );
 		} //end for
 	} //end for
 } //end of the function BotReplaceWeightedSynonyms
@@ -835,6 +1102,9 @@ static void BotReplaceReplySynonyms( char *string, int size, unsigned long int c
 
 	endp = string + size;
 
+	if ( matchautomaton )
+		BotScanMatchStrings( matchautomaton, string );
+
 	for ( str1 = string; *str1 != '\0'; )
 	{
 		//go to the start of the next word
@@ -850,6 +1120,9 @@ static void BotReplaceReplySynonyms( char *string, int size, unsigned long int c
 
 			for ( synonym = syn->firstsynonym->next; synonym; synonym = synonym->next )
 			{
+				//if the synonym isn't anywhere in the string it can't be at the front
+				if ( matchautomaton && BotMatchStringPosition( matchautomaton, synonym->pattern ) < 0 )
+					continue;
 				//if the synonym is not at the front of the string continue
 				str2 = StringContainsWord( str1, synonym->string );
 				if ( !str2 || str2 != str1 )
@@ -868,6 +1141,8 @@ static void BotReplaceReplySynonyms( char *string, int size, unsigned long int c
 				memmove( str1 + replen, str1 + strlen( synonym->string ), strlen( str1 + strlen( synonym->string ) ) + 1 );
 				//append the synonym replacement
 				Com_Memcpy( str1, replacement, replen );
+				if ( matchautomaton )
+					BotScanMatchStrings( matchautomaton, string );
 				break;
 			}
 
@@ -1197,6 +1472,7 @@ static bot_matchpiece_t *BotLoadMatchPieces(source_t *source, char *endtoken)
 				matchstring = (bot_matchstring_t *) GetClearedHunkMemory(sizeof(bot_matchstring_t) + strlen(token.string) + 1);
 				matchstring->string = (char *) matchstring + sizeof(bot_matchstring_t);
 				strcpy(matchstring->string, token.string);
+				matchstring->pattern = -1;
 				if (!strlen(token.string)) emptystring = true;
 				matchstring->next = NULL;
 				if (lastmatchstring) lastmatchstring->next = matchstring;
@@ -1417,6 +1693,34 @@ static int StringsMatch(bot_matchpiece_t *pieces, bot_match_t *match)
 	return false;
 } //end of the function StringsMatch
 //===========================================================================
+// returns false if the last scanned string can't match the pieces because
+// a string piece doesn't occur in it or the pieces must start the string
+// with a string that doesn't start it, StringsMatch does the actual match
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int BotMatchPiecesPossible(bot_matchpiece_t *pieces)
+{
+	int first, pos;
+	bot_matchpiece_t *mp;
+	bot_matchstring_t *ms;
+
+	first = true;
+	for (mp = pieces; mp; mp = mp->next, first = false)
+	{
+		if (mp->type != MT_STRING) continue;
+		for (ms = mp->firststring; ms; ms = ms->next)
+		{
+			pos = BotMatchStringPosition(matchautomaton, ms->pattern);
+			if (pos == 0 || (pos > 0 && !first)) break;
+		} //end for
+		if (!ms) return false;
+	} //end for
+	return true;
+} //end of the function BotMatchPiecesPossible
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -1434,10 +1738,14 @@ int BotFindMatch(const char *str, bot_match_t *match, unsigned long int context)
 	{
 		match->string[strlen(match->string)-1] = '\0';
 	} //end while
+	//find all the match strings in the string in one pass
+	if (matchautomaton) BotScanMatchStrings(matchautomaton, match->string);
 	//compare the string with all the match strings
 	for (ms = matchtemplates; ms; ms = ms->next)
 	{
 		if (!(ms->context & context)) continue;
+		//skip templates with strings that don't occur in the string
+		if (matchautomaton && !BotMatchPiecesPossible(ms->first)) continue;
 		//reset the match variable offsets
 		for (i = 0; i < MAX_MATCHVARIABLES; i++) match->variables[i].offset = -1;
 		//
@@ -2893,6 +3201,7 @@ int BotSetupChatAI(void)
 	randomstrings = BotLoadRandomStrings(file);
 	file = LibVarString("matchfile", "match.c");
 	matchtemplates = BotLoadMatchTemplates(file);
+	matchautomaton = BotBuildMatchAutomaton();
 	//
 	if (!LibVarValue("nochat", "0"))
 	{
@@ -2937,6 +3246,8 @@ void BotShutdownChatAI(void)
 	} //end for
 	if (consolemessageheap) FreeMemory(consolemessageheap);
 	consolemessageheap = NULL;
+	if (matchautomaton) BotFreeMatchAutomaton(matchautomaton);
+	matchautomaton = NULL;
 	if (matchtemplates) BotFreeMatchTemplates(matchtemplates);
 	matchtemplates = NULL;
 	if (randomstrings) FreeMemory(randomstrings);
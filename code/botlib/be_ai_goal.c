@@ -179,6 +179,10 @@ static levelitem_t *levelitemheap = NULL;
 static levelitem_t *freelevelitems = NULL;
 static levelitem_t *levelitems = NULL;
 static int numlevelitems = 0;
+//level items with their weights while choosing a goal
+static levelitem_t **weighteditems = NULL;
+static int *weighteditemnums = NULL;
+static float *weighteditemweights = NULL;
 //map locations
 static maplocation_t *maplocations = NULL;
 //camp spots
@@ -373,9 +377,14 @@ static void InitLevelItemHeap(void)
 	int i, max_levelitems;
 
 	if (levelitemheap) FreeMemory(levelitemheap);
+	if (weighteditems) FreeMemory(weighteditems);
 
 	max_levelitems = (int) LibVarValue("max_levelitems", "256");
 	levelitemheap = (levelitem_t *) GetClearedMemory(max_levelitems * sizeof(levelitem_t));
+	//every level item is weighted at most once per goal choice
+	weighteditems = (levelitem_t **) GetMemory(max_levelitems * (sizeof(levelitem_t *) + sizeof(int) + sizeof(float)));
+	weighteditemnums = (int *) (weighteditems + max_levelitems);
+	weighteditemweights = (float *) (weighteditemnums + max_levelitems);
 
 	for (i = 0; i < max_levelitems-1; i++)
 	{
@@ -848,6 +857,26 @@ void BotSetAvoidGoalTime(int goalstate, int number, float avoidtime)
 	} //end else
 } //end of the function BotSetAvoidGoalTime
 //===========================================================================
+// returns the goal areas of the level items
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+int BotLevelItemGoalAreas(int *areas, int maxareas)
+{
+	int numareas;
+	levelitem_t *li;
+
+	numareas = 0;
+	for (li = levelitems; li && numareas < maxareas; li = li->next)
+	{
+		if (li->goalareanum <= 0) continue;
+		areas[numareas++] = li->goalareanum;
+	} //end for
+	return numareas;
+} //end of the function BotLevelItemGoalAreas
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -1224,6 +1253,72 @@ int BotGetTopGoal(int goalstate, bot_goal_t *goal)
 	return true;
 } //end of the function BotGetTopGoal
 //===========================================================================
+// returns the fuzzy weight number of the level item, -1 if the bot
+// can't go for the item
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int BotLevelItemWeightNum(bot_goalstate_t *gs, levelitem_t *li)
+{
+	iteminfo_t *iteminfo;
+
+	if (g_gametype == GT_SINGLE_PLAYER) {
+		if (li->flags & IFL_NOTSINGLE)
+			return -1;
+	}
+	else if (g_gametype >= GT_TEAM) {
+		if (li->flags & IFL_NOTTEAM)
+			return -1;
+	}
+	else {
+		if (li->flags & IFL_NOTFREE)
+			return -1;
+	}
+	if (li->flags & IFL_NOTBOT)
+		return -1;
+	//if the item is not in a possible goal area
+	if (!li->goalareanum)
+		return -1;
+	//FIXME: is this a good thing? added this for items that never spawned into the game (f.i. CTF flags in obelisk)
+	if (!li->entitynum && !(li->flags & IFL_ROAM))
+		return -1;
+	//get the fuzzy weight function for this item
+	iteminfo = &itemconfig->iteminfo[li->iteminfo];
+	return gs->itemweightindex[iteminfo->number];
+} //end of the function BotLevelItemWeightNum
+//===========================================================================
+// evaluates the weights of all the level items the bot can go for at
+// once, in level item order so the undecided weights stay the same
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int BotLevelItemWeights(bot_goalstate_t *gs, int *inventory)
+{
+	int numitems, weightnum;
+	levelitem_t *li;
+
+	numitems = 0;
+	for (li = levelitems; li; li = li->next)
+	{
+		weightnum = BotLevelItemWeightNum(gs, li);
+		if (weightnum < 0)
+			continue;
+		weighteditems[numitems] = li;
+		weighteditemnums[numitems] = weightnum;
+		numitems++;
+	} //end for
+#ifdef UNDECIDEDFUZZY
+	FuzzyWeightsUndecided(inventory, gs->itemweightconfig, weighteditemnums, weighteditemweights, numitems);
+#else
+	FuzzyWeights(inventory, gs->itemweightconfig, weighteditemnums, weighteditemweights, numitems);
+#endif //UNDECIDEDFUZZY
+	return numitems;
+} //end of the function BotLevelItemWeights
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -1248,7 +1343,7 @@ int BotGetSecondGoal(int goalstate, bot_goal_t *goal)
 //===========================================================================
 int BotChooseLTGItem(int goalstate, vec3_t origin, int *inventory, int travelflags)
 {
-	int areanum, t, weightnum;
+	int areanum, t, i, numitems;
 	float weight, bestweight, avoidtime;
 	iteminfo_t *iteminfo;
 	itemconfig_t *ic;
@@ -1282,40 +1377,13 @@ int BotChooseLTGItem(int goalstate, vec3_t origin, int *inventory, int travelfla
 	bestweight = 0;
 	bestitem = NULL;
 	Com_Memset(&goal, 0, sizeof(bot_goal_t));
+	//evaluate the weights of all the items in the level at once
+	numitems = BotLevelItemWeights(gs, inventory);
 	//go through the items in the level
-	for (li = levelitems; li; li = li->next)
+	for (i = 0; i < numitems; i++)
 	{
-		if (g_gametype == GT_SINGLE_PLAYER) {
-			if (li->flags & IFL_NOTSINGLE)
-				continue;
-		}
-		else if (g_gametype >= GT_TEAM) {
-			if (li->flags & IFL_NOTTEAM)
-				continue;
-		}
-		else {
-			if (li->flags & IFL_NOTFREE)
-				continue;
-		}
-		if (li->flags & IFL_NOTBOT)
-			continue;
-		//if the item is not in a possible goal area
-		if (!li->goalareanum)
-			continue;
-		//FIXME: is this a good thing? added this for items that never spawned into the game (f.i. CTF flags in obelisk)
-		if (!li->entitynum && !(li->flags & IFL_ROAM))
-			continue;
-		//get the fuzzy weight function for this item
-		iteminfo = &ic->iteminfo[li->iteminfo];
-		weightnum = gs->itemweightindex[iteminfo->number];
-		if (weightnum < 0)
-			continue;
-
-#ifdef UNDECIDEDFUZZY
-		weight = FuzzyWeightUndecided(inventory, gs->itemweightconfig, weightnum);
-#else
-		weight = FuzzyWeight(inventory, gs->itemweightconfig, weightnum);
-#endif //UNDECIDEDFUZZY
+		li = weighteditems[i];
+		weight = weighteditemweights[i];
 #ifdef DROPPEDWEIGHT
 		//HACK: to make dropped items more attractive
 		if (li->timeout)
@@ -1416,7 +1484,7 @@ int BotChooseLTGItem(int goalstate, vec3_t origin, int *inventory, int travelfla
 int BotChooseNBGItem(int goalstate, vec3_t origin, int *inventory, int travelflags,
 														bot_goal_t *ltg, float maxtime)
 {
-	int areanum, t, weightnum, ltg_time;
+	int areanum, t, i, numitems, ltg_time;
 	float weight, bestweight, avoidtime;
 	iteminfo_t *iteminfo;
 	itemconfig_t *ic;
@@ -1453,40 +1521,13 @@ int BotChooseNBGItem(int goalstate, vec3_t origin, int *inventory, int travelfla
 	bestweight = 0;
 	bestitem = NULL;
 	Com_Memset(&goal, 0, sizeof(bot_goal_t));
+	//evaluate the weights of all the items in the level at once
+	numitems = BotLevelItemWeights(gs, inventory);
 	//go through the items in the level
-	for (li = levelitems; li; li = li->next)
+	for (i = 0; i < numitems; i++)
 	{
-		if (g_gametype == GT_SINGLE_PLAYER) {
-			if (li->flags & IFL_NOTSINGLE)
-				continue;
-		}
-		else if (g_gametype >= GT_TEAM) {
-			if (li->flags & IFL_NOTTEAM)
-				continue;
-		}
-		else {
-			if (li->flags & IFL_NOTFREE)
-				continue;
-		}
-		if (li->flags & IFL_NOTBOT)
-			continue;
-		//if the item is in a possible goal area
-		if (!li->goalareanum)
-			continue;
-		//FIXME: is this a good thing? added this for items that never spawned into the game (f.i. CTF flags in obelisk)
-		if (!li->entitynum && !(li->flags & IFL_ROAM))
-			continue;
-		//get the fuzzy weight function for this item
-		iteminfo = &ic->iteminfo[li->iteminfo];
-		weightnum = gs->itemweightindex[iteminfo->number];
-		if (weightnum < 0)
-			continue;
-		//
-#ifdef UNDECIDEDFUZZY
-		weight = FuzzyWeightUndecided(inventory, gs->itemweightconfig, weightnum);
-#else
-		weight = FuzzyWeight(inventory, gs->itemweightconfig, weightnum);
-#endif //UNDECIDEDFUZZY
+		li = weighteditems[i];
+		weight = weighteditemweights[i];
 #ifdef DROPPEDWEIGHT
 		//HACK: to make dropped items more attractive
 		if (li->timeout)
@@ -1770,6 +1811,10 @@ void BotShutdownGoalAI(void)
 	itemconfig = NULL;
 	if (levelitemheap) FreeMemory(levelitemheap);
 	levelitemheap = NULL;
+	if (weighteditems) FreeMemory(weighteditems);
+	weighteditems = NULL;
+	weighteditemnums = NULL;
+	weighteditemweights = NULL;
 	freelevelitems = NULL;
 	levelitems = NULL;
 	numlevelitems = 0;
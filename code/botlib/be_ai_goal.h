@@ -86,6 +86,8 @@ int BotItemGoalInVisButNotVisible(int viewer, vec3_t eye, vec3_t viewangles, bot
 //search for a goal for the given classname, the index can be used
 //as a start point for the search when multiple goals are available with that same classname
 int BotGetLevelItemGoal(int index, const char *classname, bot_goal_t *goal);
+//returns the goal areas of the level items
+int BotLevelItemGoalAreas(int *areas, int maxareas);
 //get the next camp spot in the map
 int BotGetNextCampSpotGoal(int num, bot_goal_t *goal);
 //get the map location with the given name
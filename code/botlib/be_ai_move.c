@@ -69,6 +69,7 @@ typedef struct bot_movestate_s
 	int areanum;								//area the bot is in
 	int lastareanum;							//last area the bot was in
 	int lastgoalareanum;						//last goal area number
+	int lasttravelflags;						//travel flags used towards the last goal
 	int lastreachnum;							//last reachability number
 	vec3_t lastorigin;							//origin previous cycle
 	int reachareanum;							//area number of the reachabilty
@@ -96,6 +97,9 @@ typedef struct bot_movestate_s
 #define WEAPONINDEX_ROCKET_LAUNCHER		5
 #define WEAPONINDEX_BFG					9
 
+//distance the bot must be inside its last area to keep it
+#define AREA_INSIDE_EPSILON		1
+
 #define MODELTYPE_FUNC_PLAT		1
 #define MODELTYPE_FUNC_BOB		2
 #define MODELTYPE_FUNC_DOOR		3
@@ -291,6 +295,23 @@ int BotFuzzyPointReachabilityArea(vec3_t origin)
 	return firstareanum;
 } //end of the function BotFuzzyPointReachabilityArea
 //===========================================================================
+// the area the bot was in during the last frame is kept as long as the
+// bot is still well inside it, which gives the same area as the lookup
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int BotMoveStateReachabilityArea(bot_movestate_t *ms)
+{
+	if (AAS_PointInsideArea(ms->areanum, ms->origin, AREA_INSIDE_EPSILON) &&
+			AAS_AreaReachability(ms->areanum))
+	{
+		return ms->areanum;
+	} //end if
+	return BotFuzzyPointReachabilityArea(ms->origin);
+} //end of the function BotMoveStateReachabilityArea
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -2956,6 +2977,7 @@ void BotMoveToGoal(bot_moveresult_t *result, int movestate, bot_goal_t *goal, in
 	//
 	ms = BotMoveStateFromHandle(movestate);
 	if (!ms) return;
+	ms->lasttravelflags = travelflags;
 	//reset the grapple before testing if the bot has a valid goal
 	//because the bot could lose all its goals when stuck to a wall
 	BotResetGrapple(ms);
@@ -3051,7 +3073,7 @@ void BotMoveToGoal(bot_moveresult_t *result, int movestate, bot_goal_t *goal, in
 				else if (modeltype == MODELTYPE_FUNC_STATIC || modeltype == MODELTYPE_FUNC_DOOR)
 				{
 					// check if ontop of a door bridge ?
-					ms->areanum = BotFuzzyPointReachabilityArea(ms->origin);
+					ms->areanum = BotMoveStateReachabilityArea(ms);
 					// if not in a reachability area
 					if (!AAS_AreaReachability(ms->areanum))
 					{
@@ -3083,7 +3105,7 @@ void BotMoveToGoal(bot_moveresult_t *result, int movestate, bot_goal_t *goal, in
 		AAS_ReachabilityFromNum(ms->lastreachnum, &lastreach);
 		//reachability area the bot is in
 		//ms->areanum = BotReachabilityArea(ms->origin, ((lastreach.traveltype & TRAVELTYPE_MASK) != TRAVEL_ELEVATOR));
-		ms->areanum = BotFuzzyPointReachabilityArea(ms->origin);
+		ms->areanum = BotMoveStateReachabilityArea(ms);
 		//
 		if ( !ms->areanum )
 		{
@@ -3454,6 +3476,61 @@ void BotResetMoveState(int movestate)
 	Com_Memset(ms, 0, sizeof(bot_movestate_t));
 } //end of the function BotResetMoveState
 //===========================================================================
+// calculates the routing caches the bots are expected to need this frame
+// on the worker threads before the bots think one after the other, these
+// are the routes towards the last movement goals and towards the level
+// items with the travel flags the bots move with
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+#define MAX_PREPAREDITEMAREAS		256
+
+void BotPrepareMoveRoutes(void)
+{
+	static aas_routerequest_t requests[MAX_CLIENTS + MAX_PREPAREDTRAVELFLAGS * MAX_PREPAREDITEMAREAS];
+	int i, j, numrequests, numitemareas, numtravelflags;
+	int itemareas[MAX_PREPAREDITEMAREAS], travelflags[MAX_PREPAREDTRAVELFLAGS];
+	bot_movestate_t *ms;
+
+	numrequests = 0;
+	numtravelflags = 0;
+	for (i = 1; i <= MAX_CLIENTS; i++)
+	{
+		ms = botmovestates[i];
+		if (!ms || !ms->lasttravelflags) continue;
+		if (ms->areanum > 0 && ms->lastgoalareanum > 0)
+		{
+			requests[numrequests].areanum = ms->areanum;
+			requests[numrequests].goalareanum = ms->lastgoalareanum;
+			requests[numrequests].travelflags = ms->lasttravelflags;
+			numrequests++;
+		} //end if
+		for (j = 0; j < numtravelflags; j++)
+		{
+			if (travelflags[j] == ms->lasttravelflags) break;
+		} //end for
+		if (j >= numtravelflags && numtravelflags < MAX_PREPAREDTRAVELFLAGS)
+		{
+			travelflags[numtravelflags++] = ms->lasttravelflags;
+		} //end if
+	} //end for
+	//the bots evaluate the travel times towards the items from anywhere
+	numitemareas = BotLevelItemGoalAreas(itemareas, MAX_PREPAREDITEMAREAS);
+	for (i = 0; i < numtravelflags; i++)
+	{
+		for (j = 0; j < numitemareas; j++)
+		{
+			requests[numrequests].areanum = 0;
+			requests[numrequests].goalareanum = itemareas[j];
+			requests[numrequests].travelflags = travelflags[i];
+			numrequests++;
+		} //end for
+	} //end for
+	AAS_PrepareRoutes(requests, numrequests);
+} //end of the function BotPrepareMoveRoutes
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -135,6 +135,8 @@ void BotInitMoveState(int handle, bot_initmove_t *initmove);
 void BotAddAvoidSpot(int movestate, const vec3_t origin, float radius, int type);
 //must be called every map change
 void BotSetBrushModelTypes(void);
+//calculates the routes the bots will need on the worker threads
+void BotPrepareMoveRoutes(void);
 //setup movement AI
 int BotSetupMoveAI(void);
 //shutdown movement AI
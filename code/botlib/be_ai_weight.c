@@ -50,6 +50,25 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define MAX_WEIGHT_FILES			128
 static weightconfig_t	*weightFileList[MAX_WEIGHT_FILES];
 
+//maximum nesting of switches in compiled weights
+#define MAX_FUZZYDEPTH				32
+
+//state of a switch being evaluated
+#define FUZZY_CASE					0		//looking for the case
+#define FUZZY_FIRST					1		//waiting for the first weight
+#define FUZZY_NEXT					2		//first weight known
+#define FUZZY_SECOND				3		//waiting for the second weight
+
+typedef struct fuzzyframe_s
+{
+	int node;
+	int state;
+	int undecided;
+	float w1;
+} fuzzyframe_t;
+
+static void CompileWeightConfig(weightconfig_t *config);
+
 //===========================================================================
 //
 // Parameter:				-
@@ -138,6 +157,7 @@ static void FreeWeightConfig2(weightconfig_t *config)
 		FreeFuzzySeperators_r(config->weights[i].firstseperator);
 		if (config->weights[i].name) FreeMemory(config->weights[i].name);
 	} //end for
+	if (config->nodes) FreeMemory(config->nodes);
 	FreeMemory(config);
 } //end of the function FreeWeightConfig2
 //===========================================================================
@@ -425,6 +445,8 @@ weightconfig_t *ReadWeightConfig(const char *filename)
 	} //end while
 	//free the source at the end of a pass
 	FreeSource(source);
+	//
+	CompileWeightConfig(config);
 	//if the file was located in a pak file
 	botimport.Print(PRT_MESSAGE, "loaded %s\n", filename);
 #ifdef DEBUG
@@ -536,6 +558,220 @@ static float FuzzyWeightUndecided_r(int *inventory, fuzzyseperator_t *fs)
 	return fs->weight;
 } //end of the function FuzzyWeightUndecided_r
 //===========================================================================
+// returns the nesting depth of the switches
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int FuzzySeperatorDepth_r(fuzzyseperator_t *fs)
+{
+	int depth, childdepth;
+
+	depth = 0;
+	for (; fs; fs = fs->next)
+	{
+		if (!fs->child) continue;
+		childdepth = FuzzySeperatorDepth_r(fs->child) + 1;
+		if (childdepth > depth) depth = childdepth;
+	} //end for
+	return depth;
+} //end of the function FuzzySeperatorDepth_r
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int NumFuzzySeperators_r(fuzzyseperator_t *fs)
+{
+	int num;
+
+	for (num = 0; fs; fs = fs->next)
+	{
+		num++;
+		if (fs->child) num += NumFuzzySeperators_r(fs->child);
+	} //end for
+	return num;
+} //end of the function NumFuzzySeperators_r
+//===========================================================================
+// stores the cases of the switch one after another followed by the
+// cases of the child switches, returns the first case
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int CompileFuzzySeperators_r(weightconfig_t *config, fuzzyseperator_t *fs)
+{
+	int first, i;
+	fuzzyseperator_t *s;
+	fuzzynode_t *node;
+
+	first = config->numnodes;
+	for (s = fs; s; s = s->next) config->numnodes++;
+	for (i = first, s = fs; s; s = s->next, i++)
+	{
+		node = &config->nodes[i];
+		node->index = s->index;
+		node->value = s->value;
+		node->weight = s->weight;
+		node->minweight = s->minweight;
+		node->maxweight = s->maxweight;
+		node->next = s->next ? i + 1 : -1;
+		node->child = s->child ? CompileFuzzySeperators_r(config, s->child) : -1;
+	} //end for
+	return first;
+} //end of the function CompileFuzzySeperators_r
+//===========================================================================
+// stores the separators of all weights in one array that is evaluated
+// without recursion, has to be called again when weights change
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void CompileWeightConfig(weightconfig_t *config)
+{
+	int i, numnodes;
+	weight_t *w;
+
+	if (config->nodes) FreeMemory(config->nodes);
+	config->nodes = NULL;
+	config->numnodes = 0;
+	numnodes = 0;
+	for (i = 0; i < config->numweights; i++)
+	{
+		w = &config->weights[i];
+		w->firstnode = -1;
+		//too deep switches are evaluated recursively
+		if (FuzzySeperatorDepth_r(w->firstseperator) >= MAX_FUZZYDEPTH) return;
+		numnodes += NumFuzzySeperators_r(w->firstseperator);
+	} //end for
+	if (!numnodes) return;
+	config->nodes = (fuzzynode_t *) GetMemory(numnodes * sizeof(fuzzynode_t));
+	for (i = 0; i < config->numweights; i++)
+	{
+		w = &config->weights[i];
+		if (w->firstseperator) w->firstnode = CompileFuzzySeperators_r(config, w->firstseperator);
+	} //end for
+} //end of the function CompileWeightConfig
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static float FuzzyNodeWeight(const fuzzynode_t *fs, int undecided)
+{
+	if (undecided) return fs->minweight + random() * (fs->maxweight - fs->minweight);
+	return fs->weight;
+} //end of the function FuzzyNodeWeight
+//===========================================================================
+// scale between the weight of the case and the weight of the next case
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static float FuzzyNodeInterpolate(int *inventory, const fuzzynode_t *nodes, const fuzzyframe_t *frame, float w2)
+{
+	const fuzzynode_t *fs, *next;
+	float scale;
+
+	fs = &nodes[frame->node];
+	next = &nodes[fs->next];
+	//can't interpolate with the default case, return the default weight
+	if (next->value == MAX_INVENTORYVALUE) return w2;
+	scale = (float) (inventory[fs->index] - fs->value) / (next->value - fs->value);
+	return (1 - scale) * frame->w1 + scale * w2;
+} //end of the function FuzzyNodeInterpolate
+//===========================================================================
+// evaluates the compiled separators in the same order as FuzzyWeight_r
+// and FuzzyWeightUndecided_r so even the random weights are the same
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static float FuzzyWeightNodes(int *inventory, const fuzzynode_t *nodes, int firstnode, int undecided)
+{
+	fuzzyframe_t stack[MAX_FUZZYDEPTH], *frame;
+	const fuzzynode_t *fs, *next;
+	float w;
+
+	frame = stack;
+	frame->node = firstnode;
+	frame->state = FUZZY_CASE;
+	frame->undecided = undecided;
+	while(1)
+	{
+		fs = &nodes[frame->node];
+		if (frame->state == FUZZY_CASE)
+		{
+			if (inventory[fs->index] < fs->value)
+			{
+				if (fs->child >= 0)
+				{
+					frame->node = fs->child;
+					continue;
+				} //end if
+				w = FuzzyNodeWeight(fs, frame->undecided);
+			} //end if
+			else if (fs->next < 0)
+			{
+				w = fs->weight;
+			} //end else if
+			else if (inventory[fs->index] >= nodes[fs->next].value)
+			{
+				frame->node = fs->next;
+				continue;
+			} //end else if
+			else if (fs->child >= 0)
+			{
+				//evaluate the first weight of the interpolation
+				frame->state = FUZZY_FIRST;
+				frame++;
+				frame->node = fs->child;
+				frame->state = FUZZY_CASE;
+				frame->undecided = frame[-1].undecided;
+				continue;
+			} //end else if
+			else
+			{
+				frame->w1 = FuzzyNodeWeight(fs, frame->undecided);
+				frame->state = FUZZY_NEXT;
+				continue;
+			} //end else
+		} //end if
+		else
+		{
+			next = &nodes[fs->next];
+			if (next->child >= 0)
+			{
+				//the second weight is never undecided
+				frame->state = FUZZY_SECOND;
+				frame++;
+				frame->node = next->child;
+				frame->state = FUZZY_CASE;
+				frame->undecided = false;
+				continue;
+			} //end if
+			w = FuzzyNodeInterpolate(inventory, nodes, frame, FuzzyNodeWeight(next, frame->undecided));
+		} //end else
+		//pass the weight to the switches waiting for it
+		while (frame > stack && frame[-1].state == FUZZY_SECOND)
+		{
+			frame--;
+			w = FuzzyNodeInterpolate(inventory, nodes, frame, w);
+		} //end while
+		if (frame == stack) return w;
+		frame--;
+		frame->w1 = w;
+		frame->state = FUZZY_NEXT;
+	} //end while
+} //end of the function FuzzyWeightNodes
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -544,6 +780,11 @@ static float FuzzyWeightUndecided_r(int *inventory, fuzzyseperator_t *fs)
 float FuzzyWeight(int *inventory, weightconfig_t *wc, int weightnum)
 {
 #ifdef EVALUATERECURSIVELY
+	if (wc->nodes)
+	{
+		if (wc->weights[weightnum].firstnode < 0) return 0;
+		return FuzzyWeightNodes(inventory, wc->nodes, wc->weights[weightnum].firstnode, false);
+	} //end if
 	return FuzzyWeight_r(inventory, wc->weights[weightnum].firstseperator);
 #else
 	fuzzyseperator_t *s;
@@ -575,6 +816,11 @@ float FuzzyWeight(int *inventory, weightconfig_t *wc, int weightnum)
 float FuzzyWeightUndecided(int *inventory, weightconfig_t *wc, int weightnum)
 {
 #ifdef EVALUATERECURSIVELY
+	if (wc->nodes)
+	{
+		if (wc->weights[weightnum].firstnode < 0) return 0;
+		return FuzzyWeightNodes(inventory, wc->nodes, wc->weights[weightnum].firstnode, true);
+	} //end if
 	return FuzzyWeightUndecided_r(inventory, wc->weights[weightnum].firstseperator);
 #else
 	fuzzyseperator_t *s;
@@ -598,6 +844,48 @@ float FuzzyWeightUndecided(int *inventory, weightconfig_t *wc, int weightnum)
 #endif
 } //end of the function FuzzyWeightUndecided
 //===========================================================================
+// evaluates many weights with the same inventory, every weight is only
+// evaluated once
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void FuzzyWeights(int *inventory, weightconfig_t *wc, const int *weightnums, float *weights, int count)
+{
+	int i, evaluated[MAX_WEIGHTS];
+
+	Com_Memset(evaluated, 0, wc->numweights * sizeof(int));
+	for (i = 0; i < count; i++)
+	{
+		//the index of the weight evaluated first plus one
+		if (evaluated[weightnums[i]])
+		{
+			weights[i] = weights[evaluated[weightnums[i]] - 1];
+			continue;
+		} //end if
+		weights[i] = FuzzyWeight(inventory, wc, weightnums[i]);
+		evaluated[weightnums[i]] = i + 1;
+	} //end for
+} //end of the function FuzzyWeights
+//===========================================================================
+// evaluates many weights with the same inventory, in the given order
+// because every evaluation uses new random weights
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void FuzzyWeightsUndecided(int *inventory, weightconfig_t *wc, const int *weightnums, float *weights, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		weights[i] = FuzzyWeightUndecided(inventory, wc, weightnums[i]);
+	} //end for
+} //end of the function FuzzyWeightsUndecided
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -634,6 +922,7 @@ void EvolveWeightConfig(weightconfig_t *config)
 	{
 		EvolveFuzzySeperator_r(config->weights[i].firstseperator);
 	} //end for
+	CompileWeightConfig(config);
 } //end of the function EvolveWeightConfig
 //===========================================================================
 //
@@ -677,6 +966,7 @@ void ScaleWeight(weightconfig_t *config, char *name, float scale)
 			break;
 		} //end if
 	} //end for
+	CompileWeightConfig(config);
 } //end of the function ScaleWeight
 //===========================================================================
 //
@@ -719,6 +1009,7 @@ void ScaleFuzzyBalanceRange(weightconfig_t *config, float scale)
 	{
 		ScaleFuzzySeperatorBalanceRange_r(config->weights[i].firstseperator, scale);
 	} //end for
+	CompileWeightConfig(config);
 } //end of the function ScaleFuzzyBalanceRange
 //===========================================================================
 //
@@ -790,6 +1081,7 @@ void InterbreedWeightConfigs(weightconfig_t *config1, weightconfig_t *config2,
 									config2->weights[i].firstseperator,
 									configout->weights[i].firstseperator);
 	} //end for
+	CompileWeightConfig(configout);
 } //end of the function InterbreedWeightConfigs
 //===========================================================================
 //
@@ -45,11 +45,24 @@ typedef struct fuzzyseperator_s
 	struct fuzzyseperator_s *next;
 } fuzzyseperator_t;
 
+//compiled fuzzy separator, the cases of a switch are stored one after another
+typedef struct fuzzynode_s
+{
+	int index;						//inventory index
+	int value;						//inventory value up to which the case is used
+	int child;						//first case of the child switch, -1 if none
+	int next;						//next case of the switch, -1 if none
+	float weight;
+	float minweight;
+	float maxweight;
+} fuzzynode_t;
+
 //fuzzy weight
 typedef struct weight_s
 {
 	char *name;
 	struct fuzzyseperator_s *firstseperator;
+	int firstnode;					//first compiled case, -1 if none
 } weight_t;
 
 //weight configuration
@@ -58,6 +71,8 @@ typedef struct weightconfig_s
 	int numweights;
 	weight_t weights[MAX_WEIGHTS];
 	char		filename[MAX_QPATH];
+	int numnodes;
+	fuzzynode_t *nodes;				//compiled separators of all weights
 } weightconfig_t;
 
 //reads a weight configuration
@@ -71,6 +86,9 @@ int FindFuzzyWeight(const weightconfig_t *wc, const char *name);
 //returns the fuzzy weight for the given inventory and weight
 float FuzzyWeight(int *inventory, weightconfig_t *wc, int weightnum);
 float FuzzyWeightUndecided(int *inventory, weightconfig_t *wc, int weightnum);
+//stores the fuzzy weights for all the given weights in weights
+void FuzzyWeights(int *inventory, weightconfig_t *wc, const int *weightnums, float *weights, int count);
+void FuzzyWeightsUndecided(int *inventory, weightconfig_t *wc, const int *weightnums, float *weights, int count);
 //scales the weight with the given name
 void ScaleWeight(weightconfig_t *config, char *name, float scale);
 //scale the balance range
@@ -231,8 +231,13 @@ static int Export_BotLibVarGet( const char *var_name, char *value, int size )
 //===========================================================================
 static int Export_BotLibStartFrame(float time)
 {
+	int errnum;
+
 	if (!BotLibSetup("BotStartFrame")) return BLERR_LIBRARYNOTSETUP;
-	return AAS_StartFrame(time);
+	errnum = AAS_StartFrame(time);
+	//calculate the routes the bots will need this frame on the worker threads
+	if (errnum == BLERR_NOERROR) BotPrepareMoveRoutes();
+	return errnum;
 } //end of the function Export_BotLibStartFrame
 //===========================================================================
 //
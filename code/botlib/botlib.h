@@ -196,6 +196,9 @@ typedef struct botlib_import_s
 	int			(*FS_Write)( const void *buffer, int len, fileHandle_t f );
 	void		(*FS_FCloseFile)( fileHandle_t f );
 	int			(*FS_Seek)( fileHandle_t f, long offset, fsOrigin_t origin );
+	void		(*FS_Rename)( const char *from, const char *to );
+	const void	*(*FS_MapFile)( const char *qpath, int *length );	// read-only, NULL if not possible
+	void		(*FS_UnmapFile)( const void *base, int length );
 	//debug visualisation stuff
 	int			(*DebugLineCreate)(void);
 	void		(*DebugLineDelete)(int line);
@@ -205,6 +208,10 @@ typedef struct botlib_import_s
 	void		(*DebugPolygonDelete)(int id);
 
 	int			(*Sys_Milliseconds)(void);
+	//run func for every index in [0, count) spread over the worker threads,
+	//thread is 0 for the calling thread and 1 to JobWorkers() for the workers
+	void		(*ParallelFor)(int count, void (*func)(void *data, int index, int thread), void *data);
+	int			(*JobWorkers)(void);
 } botlib_import_t;
 
 typedef struct aas_export_s
@@ -447,6 +454,7 @@ name:						default:			module(s):			description:
 "maxclients"				"4"					be_interface.c		maximum number of clients
 "maxentities"				"1024"				be_interface.c		maximum number of entities
 "bot_developer"				"0"					be_interface.c		bot developer mode (it's "botDeveloper" in C to prevent symbol clash).
+"sourcecache"				"1"					l_precomp.c			reuse the precompiled tokens of bot files loaded before
 
 "phys_friction"				"6"					be_aas_move.c		ground friction
 "phys_stopspeed"			"100"				be_aas_move.c		stop speed
@@ -485,7 +493,14 @@ name:						default:			module(s):			description:
 "rs_maxjumpfallheight"		"450"				be_aas_move.c
 
 "max_aaslinks"				"4096"				be_aas_sample.c		maximum links in the AAS
-"max_routingcache"			"4096"				be_aas_route.c		maximum routing cache size in KB
+"samplegrid"				"1"					be_aas_sample.c		start point and trace queries from a grid of bsp nodes
+"samplebenchmark"			"0"					be_aas_main.c		time point and trace queries
+"routingheap"				"0"					be_aas_route.c		radix heap instead of fifo routing updates
+"precomputeroutingcache"	"0"					be_aas_route.c		create all default routing caches on the worker threads at map load
+"prepareroutes"				"1"					be_aas_route.c		calculate the routes bots will need each frame on the worker threads
+"routingbenchmark"			"0"					be_aas_main.c		time building all routing caches
+"routingcachebudget"		"12582912"			be_aas_route.c		bytes of routing cache above which the oldest caches are freed
+"routingcachestats"			"0"					be_aas_main.c		print routing cache lookups and memory use
 "forceclustering"			"0"					be_aas_main.c		force recalculation of clusters
 "forcereachability"			"0"					be_aas_main.c		force recalculation of reachabilities
 "forcewrite"				"0"					be_aas_main.c		force writing of aas file
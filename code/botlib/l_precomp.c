@@ -59,6 +59,7 @@ typedef enum {false, true}	bool;
 #include "l_memory.h"
 #include "l_script.h"
 #include "l_precomp.h"
+#include "l_libvar.h"
 #include "l_log.h"
 #endif //BOTLIB
 
@@ -119,6 +120,61 @@ token_t *freetokens;					//free tokens from the heap
 //list with global defines added to every source loaded
 static define_t *globaldefines;
 
+static int PC_ReadPrecompiledToken(source_t *source, token_t *token);
+
+#ifdef BOTLIB
+//Sources read from start to end are cached as the tokens that came out of
+//the precompiler. Loading the source again reads these tokens instead of
+//tokenizing and preprocessing the scripts. A cached source is only used
+//when the scripts it was made of and the global defines didn't change.
+
+#define MAX_CACHEDSOURCES		256
+#define MAX_CACHEDSCRIPTS		32
+
+//token of a cached source
+typedef struct pc_cachedtoken_s
+{
+	int string;								//offset of the token string
+	int type;
+	int subtype;
+	unsigned long int intvalue;
+	float floatvalue;
+	int line;
+	int linescrossed;
+	int script;								//script the token was read from
+} pc_cachedtoken_t;
+
+//script a cached source was made of
+typedef struct pc_cachedscript_s
+{
+	char filename[MAX_PATH];
+	int length;
+	unsigned int checksum;
+} pc_cachedscript_t;
+
+//cached source
+typedef struct pc_cachedsource_s
+{
+	char filename[MAX_PATH];
+	unsigned int defineschecksum;			//checksum of the global defines
+	int numscripts;
+	pc_cachedscript_t scripts[MAX_CACHEDSCRIPTS];
+	int numtokens;
+	int maxtokens;
+	pc_cachedtoken_t *tokens;
+	int stringslength;
+	int maxstringslength;
+	char *strings;							//strings of all the tokens
+	int failed;								//true if the source can't be cached
+	int stored;								//true if stored in the cache
+	int users;								//number of sources reading the tokens
+} pc_cachedsource_t;
+
+static pc_cachedsource_t *cachedsources[MAX_CACHEDSOURCES];
+static int nextcachedsource;
+static unsigned int globaldefineschecksum;
+#endif //BOTLIB
+
 //============================================================================
 //
 // Parameter:				-
@@ -135,6 +191,8 @@ void QDECL SourceError(source_t *source, const char *fmt, ...)
 	va_end(ap);
 #ifdef BOTLIB
 	botimport.Print(PRT_ERROR, "file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
+	//don't cache sources with errors
+	if (source->record) source->record->failed = true;
 #endif	//BOTLIB
 #ifdef MEQCC
 	printf("error: file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
@@ -159,6 +217,8 @@ void QDECL SourceWarning(source_t *source, const char *fmt, ...)
 	va_end(ap);
 #ifdef BOTLIB
 	botimport.Print(PRT_WARNING, "file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
+	//the warning wouldn't be printed when reading the cached source
+	if (source->record) source->record->failed = true;
 #endif //BOTLIB
 #ifdef MEQCC
 	printf("warning: file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
@@ -353,6 +413,292 @@ static int PC_UnreadSourceToken(source_t *source, token_t *token)
 	source->tokens = t;
 	return true;
 } //end of the function PC_UnreadSourceToken
+#ifdef BOTLIB
+//============================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+static unsigned int PC_Checksum(unsigned int checksum, const char *data, int length)
+{
+	int i;
+
+	//FNV-1a
+	for (i = 0; i < length; i++)
+	{
+		checksum ^= (byte) data[i];
+		checksum *= 16777619u;
+	} //end for
+	return checksum;
+} //end of the function PC_Checksum
+//============================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+static void PC_FreeCachedSource(pc_cachedsource_t *cs)
+{
+	if (cs->tokens) FreeMemory(cs->tokens);
+	if (cs->strings) FreeMemory(cs->strings);
+	FreeMemory(cs);
+} //end of the function PC_FreeCachedSource
+//============================================================================
+// removes the cached source from the cache, the source is freed once
+// no source reads from it anymore
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+static void PC_RemoveCachedSource(int index)
+{
+	pc_cachedsource_t *cs;
+
+	cs = cachedsources[index];
+	if (!cs) return;
+	cachedsources[index] = NULL;
+	cs->stored = false;
+	if (!cs->users) PC_FreeCachedSource(cs);
+} //end of the function PC_RemoveCachedSource
+//============================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+static void PC_FreeSourceCache(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_CACHEDSOURCES; i++)
+	{
+		PC_RemoveCachedSource(i);
+	} //end for
+} //end of the function PC_FreeSourceCache
+//============================================================================
+// returns true if the cached script still has the same contents
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+static int PC_CachedScriptValid(const pc_cachedscript_t *cscript)
+{
+	script_t *script;
+	int valid;
+
+	script = LoadScriptFile(cscript->filename);
+	if (!script) return false;
+	valid = script->length == cscript->length &&
+				PC_Checksum(2166136261u, script->buffer, script->length) == cscript->checksum;
+	FreeScript(script);
+	return valid;
+} //end of the function PC_CachedScriptValid
+//============================================================================
+// returns the cached source for the given file if it's still valid
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+static pc_cachedsource_t *PC_FindCachedSource(const char *filename)
+{
+	pc_cachedsource_t *cs;
+	int i, j;
+
+	for (i = 0; i < MAX_CACHEDSOURCES; i++)
+	{
+		cs = cachedsources[i];
+		if (!cs) continue;
+		if (strcmp(cs->filename, filename)) continue;
+		if (cs->defineschecksum != globaldefineschecksum)
+		{
+			PC_RemoveCachedSource(i);
+			continue;
+		} //end if
+		for (j = 0; j < cs->numscripts; j++)
+		{
+			if (!PC_CachedScriptValid(&cs->scripts[j])) break;
+		} //end for
+		if (j < cs->numscripts)
+		{
+			PC_RemoveCachedSource(i);
+			continue;
+		} //end if
+		return cs;
+	} //end for
+	return NULL;
+} //end of the function PC_FindCachedSource
+//============================================================================
+// adds the script to the scripts the recorded source is made of
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+static void PC_RecordScript(source_t *source, script_t *script)
+{
+	pc_cachedsource_t *cs;
+	pc_cachedscript_t *cscript;
+
+	cs = source->record;
+	if (!cs) return;
+	if (cs->numscripts >= MAX_CACHEDSCRIPTS || strlen(script->filename) >= sizeof(cscript->filename))
+	{
+		cs->failed = true;
+		return;
+	} //end if
+	cscript = &cs->scripts[cs->numscripts++];
+	strcpy(cscript->filename, script->filename);
+	cscript->length = script->length;
+	cscript->checksum = PC_Checksum(2166136261u, script->buffer, script->length);
+} //end of the function PC_RecordScript
+//============================================================================
+// adds a token read by the user of the source to the recorded tokens
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+static void PC_RecordToken(source_t *source, token_t *token)
+{
+	pc_cachedsource_t *cs;
+	pc_cachedtoken_t *ctoken, *newtokens;
+	char *newstrings;
+	int i, length;
+
+	cs = source->record;
+	if (cs->failed) return;
+	//find the script the token was read from
+	for (i = cs->numscripts - 1; i >= 0; i--)
+	{
+		if (!strcmp(cs->scripts[i].filename, source->scriptstack->filename)) break;
+	} //end for
+	if (i < 0)
+	{
+		cs->failed = true;
+		return;
+	} //end if
+	if (cs->numtokens >= cs->maxtokens)
+	{
+		cs->maxtokens = cs->maxtokens ? cs->maxtokens * 2 : 1024;
+		newtokens = (pc_cachedtoken_t *) GetMemory(cs->maxtokens * sizeof(pc_cachedtoken_t));
+		if (cs->tokens)
+		{
+			Com_Memcpy(newtokens, cs->tokens, cs->numtokens * sizeof(pc_cachedtoken_t));
+			FreeMemory(cs->tokens);
+		} //end if
+		cs->tokens = newtokens;
+	} //end if
+	length = strlen(token->string) + 1;
+	if (cs->stringslength + length > cs->maxstringslength)
+	{
+		cs->maxstringslength = cs->maxstringslength ? cs->maxstringslength * 2 : 8192;
+		while (cs->stringslength + length > cs->maxstringslength) cs->maxstringslength *= 2;
+		newstrings = (char *) GetMemory(cs->maxstringslength);
+		if (cs->strings)
+		{
+			Com_Memcpy(newstrings, cs->strings, cs->stringslength);
+			FreeMemory(cs->strings);
+		} //end if
+		cs->strings = newstrings;
+	} //end if
+	ctoken = &cs->tokens[cs->numtokens++];
+	ctoken->string = cs->stringslength;
+	Com_Memcpy(cs->strings + cs->stringslength, token->string, length);
+	cs->stringslength += length;
+	ctoken->type = token->type;
+	ctoken->subtype = token->subtype;
+	ctoken->intvalue = token->intvalue;
+	ctoken->floatvalue = token->floatvalue;
+	ctoken->line = token->line;
+	ctoken->linescrossed = token->linescrossed;
+	ctoken->script = i;
+} //end of the function PC_RecordToken
+//============================================================================
+// stores the tokens recorded from the source in the cache
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+static void PC_StoreRecordedSource(source_t *source)
+{
+	pc_cachedsource_t *cs;
+	int i;
+
+	cs = source->record;
+	source->record = NULL;
+	if (cs->failed)
+	{
+		PC_FreeCachedSource(cs);
+		return;
+	} //end if
+	//replace an older cached version of the same source
+	for (i = 0; i < MAX_CACHEDSOURCES; i++)
+	{
+		if (cachedsources[i] && !strcmp(cachedsources[i]->filename, cs->filename))
+		{
+			PC_RemoveCachedSource(i);
+		} //end if
+	} //end for
+	//replace the oldest cached source when the cache is full
+	PC_RemoveCachedSource(nextcachedsource);
+	cs->stored = true;
+	cachedsources[nextcachedsource] = cs;
+	nextcachedsource = (nextcachedsource + 1) % MAX_CACHEDSOURCES;
+} //end of the function PC_StoreRecordedSource
+//============================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+static int PC_ReadCachedToken(source_t *source, token_t *token)
+{
+	pc_cachedsource_t *cs;
+	pc_cachedtoken_t *ctoken;
+	token_t *t;
+
+	cs = source->cached;
+	//tokens unread by the user of the source come first
+	if (source->tokens)
+	{
+		Com_Memcpy(token, source->tokens, sizeof(token_t));
+		t = source->tokens;
+		source->tokens = source->tokens->next;
+		PC_FreeToken(t);
+		if (source->numunread > 0) source->numunread--;
+	} //end if
+	else
+	{
+		if (source->cachedtoken >= cs->numtokens) return false;
+		ctoken = &cs->tokens[source->cachedtoken++];
+		strcpy(token->string, cs->strings + ctoken->string);
+		token->type = ctoken->type;
+		token->subtype = ctoken->subtype;
+		token->intvalue = ctoken->intvalue;
+		token->floatvalue = ctoken->floatvalue;
+		token->whitespace_p = NULL;
+		token->endwhitespace_p = NULL;
+		token->line = ctoken->line;
+		token->linescrossed = ctoken->linescrossed;
+		token->next = NULL;
+		//keep the script file and line for errors reported by the user of the source
+		if (source->cachedtoken == 1 || ctoken[-1].script != ctoken->script)
+		{
+			Q_strncpyz(source->scriptstack->filename, cs->scripts[ctoken->script].filename,
+							sizeof(source->scriptstack->filename));
+		} //end if
+		source->scriptstack->line = ctoken->line;
+	} //end else
+	//copy token for unreading
+	Com_Memcpy(&source->token, token, sizeof(token_t));
+	return true;
+} //end of the function PC_ReadCachedToken
+#endif //BOTLIB
 //============================================================================
 //
 // Parameter:				-
@@ -690,6 +1036,10 @@ static int PC_ExpandBuiltinDefine(source_t *source, token_t *deftoken, define_t
 		} //end case
 		case BUILTIN_DATE:
 		{
+#ifdef BOTLIB
+			//the date changes between loads
+			if (source->record) source->record->failed = true;
+#endif //BOTLIB
 			t = time(NULL);
 			curtime = ctime(( const time_t *)&t);
 			strcpy(token->string, "\"");
@@ -704,6 +1054,9 @@ static int PC_ExpandBuiltinDefine(source_t *source, token_t *deftoken, define_t
 		} //end case
 		case BUILTIN_TIME:
 		{
+#ifdef BOTLIB
+			if (source->record) source->record->failed = true;
+#endif //BOTLIB
 			t = time(NULL);
 			curtime = ctime(( const time_t *)&t);
 			strcpy(token->string, "\"");
@@ -1000,6 +1353,9 @@ static int PC_Directive_include(source_t *source)
 		return false;
 #endif //SCREWUP
 	} //end if
+#ifdef BOTLIB
+	PC_RecordScript(source, script);
+#endif //BOTLIB
 	PC_PushScript(source, script);
 	return true;
 } //end of the function PC_Directive_include
@@ -1120,6 +1476,25 @@ static int PC_Directive_undef(source_t *source)
 	return true;
 } //end of the function PC_Directive_undef
 //============================================================================
+// same as PC_CheckTokenString but the token is not seen by the
+// user of the source
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+static int PC_CheckPrecompiledTokenString(source_t *source, char *string)
+{
+	token_t tok;
+
+	if (!PC_ReadPrecompiledToken(source, &tok)) return false;
+	//if the token is available
+	if (!strcmp(tok.string, string)) return true;
+	//
+	PC_UnreadSourceToken(source, &tok);
+	return false;
+} //end of the function PC_CheckPrecompiledTokenString
+//============================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -1180,7 +1555,7 @@ static int PC_Directive_define(source_t *source)
 	{
 		//read the define parameters
 		last = NULL;
-		if (!PC_CheckTokenString(source, ")"))
+		if (!PC_CheckPrecompiledTokenString(source, ")"))
 		{
 			while(1)
 			{
@@ -1330,6 +1705,9 @@ int PC_AddGlobalDefine(const char *string)
 	if (!define) return false;
 	define->next = globaldefines;
 	globaldefines = define;
+#ifdef BOTLIB
+	globaldefineschecksum = PC_Checksum(globaldefineschecksum, string, strlen(string) + 1);
+#endif //BOTLIB
 	return true;
 } //end of the function PC_AddGlobalDefine
 
@@ -1349,6 +1727,9 @@ void PC_RemoveAllGlobalDefines(void)
 		globaldefines = globaldefines->next;
 		PC_FreeDefine(define);
 	} //end for
+#ifdef BOTLIB
+	globaldefineschecksum = 0;
+#endif //BOTLIB
 } //end of the function PC_RemoveAllGlobalDefines
 //============================================================================
 //
@@ -2616,7 +2997,7 @@ static int QuakeCMacro(source_t *source)
 // Returns:					-
 // Changes Globals:		-
 //============================================================================
-int PC_ReadToken(source_t *source, token_t *token)
+static int PC_ReadPrecompiledToken(source_t *source, token_t *token)
 {
 	define_t *define;
 
@@ -2650,7 +3031,7 @@ int PC_ReadToken(source_t *source, token_t *token)
 		if (token->type == TT_STRING)
 		{
 			token_t newtoken;
-			if (PC_ReadToken(source, &newtoken))
+			if (PC_ReadPrecompiledToken(source, &newtoken))
 			{
 				if (newtoken.type == TT_STRING)
 				{
@@ -2664,7 +3045,7 @@ int PC_ReadToken(source_t *source, token_t *token)
 				}
 				else
 				{
-					PC_UnreadToken(source, &newtoken);
+					PC_UnreadSourceToken(source, &newtoken);
 				}
 			}
 		} //end if
@@ -2692,6 +3073,42 @@ int PC_ReadToken(source_t *source, token_t *token)
 		//found a token
 		return true;
 	} //end while
+} //end of the function PC_ReadPrecompiledToken
+//============================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+int PC_ReadToken(source_t *source, token_t *token)
+{
+#ifdef BOTLIB
+	if (source->cached) return PC_ReadCachedToken(source, token);
+#endif //BOTLIB
+	if (!PC_ReadPrecompiledToken(source, token))
+	{
+#ifdef BOTLIB
+		//if the whole source was read store the recorded tokens
+		if (source->record && !source->tokens && !source->scriptstack->next &&
+				EndOfScript(source->scriptstack))
+		{
+			PC_StoreRecordedSource(source);
+		} //end if
+#endif //BOTLIB
+		return false;
+	} //end if
+	//tokens unread by the user of the source are already recorded
+	if (source->numunread > 0)
+	{
+		source->numunread--;
+	} //end if
+#ifdef BOTLIB
+	else if (source->record)
+	{
+		PC_RecordToken(source, token);
+	} //end else if
+#endif //BOTLIB
+	return true;
 } //end of the function PC_ReadToken
 //============================================================================
 //
@@ -2802,7 +3219,7 @@ int PC_CheckTokenString(source_t *source, char *string)
 	//if the token is available
 	if (!strcmp(tok.string, string)) return true;
 	//
-	PC_UnreadSourceToken(source, &tok);
+	PC_UnreadToken(source, &tok);
 	return false;
 } //end of the function PC_CheckTokenString
 
@@ -2814,7 +3231,7 @@ int PC_CheckTokenString(source_t *source, char *string)
 //============================================================================
 void PC_UnreadLastToken(source_t *source)
 {
-	PC_UnreadSourceToken(source, &source->token);
+	PC_UnreadToken(source, &source->token);
 } //end of the function PC_UnreadLastToken
 //============================================================================
 //
@@ -2825,6 +3242,7 @@ void PC_UnreadLastToken(source_t *source)
 void PC_UnreadToken(source_t *source, token_t *token)
 {
 	PC_UnreadSourceToken(source, token);
+	source->numunread++;
 } //end of the function PC_UnreadToken
 
 //============================================================================
@@ -2833,13 +3251,62 @@ void PC_UnreadToken(source_t *source, token_t *token)
 // Returns:				-
 // Changes Globals:		-
 //============================================================================
-source_t *LoadSourceFile(const char *filename)
+#ifdef BOTLIB
+static source_t *PC_LoadCachedSource(const char *filename)
+{
+	pc_cachedsource_t *cs;
+	source_t *source;
+	script_t *script;
+
+	cs = PC_FindCachedSource(filename);
+	if (!cs) return NULL;
+
+	//empty script for the file and line of reported errors
+	script = (script_t *) GetClearedMemory(sizeof(script_t));
+	Q_strncpyz(script->filename, filename, sizeof(script->filename));
+	script->line = 1;
+
+	source = (source_t *) GetClearedMemory( sizeof( *source ) );
+	Q_strncpyz(source->filename, filename, sizeof(source->filename));
+	source->scriptstack = script;
+	source->cached = cs;
+	cs->users++;
+	return source;
+} //end of the function PC_LoadCachedSource
+#endif //BOTLIB
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+static source_t *PC_LoadSource(const char *filename, int usecache)
 {
 	source_t *source;
 	script_t *script;
 
 	PC_InitTokenHeap();
 
+#ifdef BOTLIB
+	if (usecache)
+	{
+		if (!LibVarValue("sourcecache", "1"))
+		{
+			PC_FreeSourceCache();
+			usecache = false;
+		} //end if
+		else if (strlen(filename) < MAX_PATH)
+		{
+			source = PC_LoadCachedSource(filename);
+			if (source) return source;
+		} //end else if
+		else
+		{
+			usecache = false;
+		} //end else
+	} //end if
+#endif //BOTLIB
+
 	script = LoadScriptFile(filename);
 	if (!script) return NULL;
 
@@ -2859,7 +3326,28 @@ source_t *LoadSourceFile(const char *filename)
 	source->definehash = GetClearedMemory(DEFINEHASHSIZE * sizeof(define_t *));
 #endif //DEFINEHASHING
 	PC_AddGlobalDefinesToSource(source);
+
+#ifdef BOTLIB
+	//record the tokens read from the source for the cache
+	if (usecache)
+	{
+		source->record = (pc_cachedsource_t *) GetClearedMemory(sizeof(pc_cachedsource_t));
+		strcpy(source->record->filename, filename);
+		source->record->defineschecksum = globaldefineschecksum;
+		PC_RecordScript(source, script);
+	} //end if
+#endif //BOTLIB
 	return source;
+} //end of the function PC_LoadSource
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+source_t *LoadSourceFile(const char *filename)
+{
+	return PC_LoadSource(filename, true);
 } //end of the function LoadSourceFile
 
 //============================================================================
@@ -2877,6 +3365,15 @@ void FreeSource(source_t *source)
 	int i;
 
 	//PC_PrintDefineHashTable(source->definehash);
+#ifdef BOTLIB
+	//free the recorded tokens of a source that wasn't read completely
+	if (source->record) PC_FreeCachedSource(source->record);
+	if (source->cached)
+	{
+		source->cached->users--;
+		if (!source->cached->users && !source->cached->stored) PC_FreeCachedSource(source->cached);
+	} //end if
+#endif //BOTLIB
 	//free all the scripts
 	while(source->scriptstack)
 	{
@@ -2892,7 +3389,8 @@ void FreeSource(source_t *source)
 		PC_FreeToken(token);
 	} //end for
 #if DEFINEHASHING
-	for (i = 0; i < DEFINEHASHSIZE; i++)
+	//cached sources don't have defines
+	for (i = 0; source->definehash && i < DEFINEHASHSIZE; i++)
 	{
 		while(source->definehash[i])
 		{
@@ -2948,7 +3446,7 @@ int PC_LoadSourceHandle(const char *filename)
 	if (i >= MAX_SOURCEFILES)
 		return 0;
 	PS_SetBaseFolder("");
-	source = LoadSourceFile(filename);
+	source = PC_LoadSource(filename, false);
 	if (!source)
 		return 0;
 	sourceFiles[i] = source;
@@ -104,6 +104,10 @@ typedef struct source_s
 	indent_t *indentstack;					//stack with indents
 	int skip;								// > 0 if skipping conditional code
 	token_t token;							//last read token
+	int numunread;							//tokens unread by the user of the source
+	struct pc_cachedsource_s *record;		//tokens recorded for the source cache
+	struct pc_cachedsource_s *cached;		//cached tokens the source is read from
+	int cachedtoken;						//next cached token to read
 } source_t;
 
 
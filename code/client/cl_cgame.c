@@ -805,6 +805,8 @@ void CL_InitGameClient( void ) {
 	mapname = Info_ValueForKey( info, "mapname" );
 	Com_sprintf( cl.mapname, sizeof( cl.mapname ), "maps/%s.bsp", mapname );
 
+	FS_BeginMapLoad( mapname, "client" );
+
 	// allow vertex lighting for in-game elements
 	re.VertexLighting( true );
 
@@ -822,6 +824,9 @@ void CL_InitGameClient( void ) {
 	// otherwise server commands sent just before a gamestate are dropped
 	VM_Call( gameClientVm, 3, CLIENT_INIT, clc.serverMessageSequence, clc.lastExecutedServerCommand, clc.clientNum );
 
+	// finish the sounds that are still being read
+	FS_RunAsyncReads( true );
+
 	// reset any CVAR_CHEAT cvars registered by gameclient
 	if ( !clc.demoplaying && !cl_connectedToCheatServer )
 		Cvar_SetCheatState();
@@ -838,6 +843,8 @@ void CL_InitGameClient( void ) {
 	// on the card even if the driver does deferred loading
 	re.EndRegistration();
 
+	FS_EndMapLoad();
+
 	// make sure everything is paged in
 	if (!Sys_LowPhysicalMemory()) {
 		Com_TouchMemory();
@@ -3389,6 +3389,9 @@ static void CL_InitRef( void ) {
 	rimp.FS_ListFiles = FS_ListFiles;
 	//rimp.FS_FileIsInPAK = FS_FileIsInPAK;
 	rimp.FS_FileExists = FS_FileExists;
+	rimp.FS_ReadFileAsync = FS_ReadFileAsync;
+	rimp.FS_CancelAsyncRead = FS_CancelAsyncRead;
+	rimp.FS_RunAsyncReads = FS_RunAsyncReads;
 
 	rimp.Cvar_Get = Cvar_Get;
 	rimp.Cvar_Set = Cvar_Set;
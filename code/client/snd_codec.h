@@ -81,6 +81,7 @@ void S_CodecUtilClose(snd_stream_t **stream);
 // WAV Codec
 extern snd_codec_t wav_codec;
 void *S_WAV_CodecLoad(const char *filename, snd_info_t *info);
+void *S_WAV_CodecLoadBuffer(const char *filename, const void *data, int length, snd_info_t *info);
 snd_stream_t *S_WAV_CodecOpenStream(const char *filename);
 void S_WAV_CodecCloseStream(snd_stream_t *stream);
 int S_WAV_CodecReadStream(snd_stream_t *stream, int bytes, void *buffer);
@@ -24,15 +24,61 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "client.h"
 #include "snd_codec.h"
 
+// the header is parsed either from a file or from a file that has already been read
+typedef struct {
+	fileHandle_t	file;
+	const byte		*data;		// used instead of the file if set
+	int				length;
+	int				pos;
+} wavReader_t;
+
+/*
+=================
+S_WavRead
+=================
+*/
+static int S_WavRead( wavReader_t *r, void *buffer, int len ) {
+	if ( !r->data ) {
+		return FS_Read( buffer, len, r->file );
+	}
+
+	if ( len > r->length - r->pos ) {
+		len = r->length - r->pos;
+	}
+
+	Com_Memcpy( buffer, r->data + r->pos, len );
+	r->pos += len;
+
+	return len;
+}
+
+/*
+=================
+S_WavSkip
+=================
+*/
+static void S_WavSkip( wavReader_t *r, int len ) {
+	if ( !r->data ) {
+		FS_Seek( r->file, len, FS_SEEK_CUR );
+		return;
+	}
+
+	if ( len > r->length - r->pos ) {
+		len = r->length - r->pos;
+	}
+
+	r->pos += len;
+}
+
 /*
 =================
 FGetLittleLong
 =================
 */
-static int FGetLittleLong( fileHandle_t f ) {
-	int		v;
+static int FGetLittleLong( wavReader_t *f ) {
+	int		v = 0;
 
-	FS_Read( &v, sizeof(v), f );
+	S_WavRead( f, &v, sizeof(v) );
 
 	return LittleLong( v);
 }
@@ -42,10 +88,10 @@ static int FGetLittleLong( fileHandle_t f ) {
 FGetLittleShort
 =================
 */
-static short FGetLittleShort( fileHandle_t f ) {
-	short	v;
+static short FGetLittleShort( wavReader_t *f ) {
+	short	v = 0;
 
-	FS_Read( &v, sizeof(v), f );
+	S_WavRead( f, &v, sizeof(v) );
 
 	return LittleShort( v);
 }
@@ -55,13 +101,13 @@ static short FGetLittleShort( fileHandle_t f ) {
 S_ReadChunkInfo
 =================
 */
-static int S_ReadChunkInfo(fileHandle_t f, char *name)
+static int S_ReadChunkInfo(wavReader_t *f, char *name)
 {
 	int len, r;
 
 	name[4] = 0;
 
-	r = FS_Read(name, 4, f);
+	r = S_WavRead(f, name, 4);
 	if(r != 4)
 		return -1;
 
@@ -81,7 +127,7 @@ S_FindRIFFChunk
 Returns the length of the data in the chunk, or -1 if not found
 =================
 */
-static int S_FindRIFFChunk( fileHandle_t f, char *chunk ) {
+static int S_FindRIFFChunk( wavReader_t *f, char *chunk ) {
 	char	name[5];
 	int		len;
 
@@ -94,7 +140,7 @@ static int S_FindRIFFChunk( fileHandle_t f, char *chunk ) {
 		len = PAD( len, 2 );
 
 		// Not the right chunk - skip it
-		FS_Seek( f, len, FS_SEEK_CUR );
+		S_WavSkip( f, len );
 	}
 
 	return -1;
@@ -133,14 +179,14 @@ static void S_ByteSwapRawSamples( int samples, int width, int s_channels, const
 S_ReadRIFFHeader
 =================
 */
-static bool S_ReadRIFFHeader(fileHandle_t file, snd_info_t *info)
+static bool S_ReadRIFFHeader(wavReader_t *file, snd_info_t *info)
 {
 	char dump[16];
 	int bits;
 	int fmtlen = 0;
 
 	// skip the riff wav header
-	FS_Read(dump, 12, file);
+	S_WavRead(file, dump, 12);
 
 	// Scan for the format chunk
 	if((fmtlen = S_FindRIFFChunk(file, "fmt ")) < 0)
@@ -170,7 +216,7 @@ static bool S_ReadRIFFHeader(fileHandle_t file, snd_info_t *info)
 	if(fmtlen > 16)
 	{
 		fmtlen -= 16;
-		FS_Seek( file, fmtlen, FS_SEEK_CUR );
+		S_WavSkip( file, fmtlen );
 	}
 
 	// Scan for the data chunk
@@ -202,6 +248,7 @@ S_WAV_CodecLoad
 */
 void *S_WAV_CodecLoad(const char *filename, snd_info_t *info)
 {
+	wavReader_t reader;
 	fileHandle_t file;
 	void *buffer;
 
@@ -212,8 +259,11 @@ void *S_WAV_CodecLoad(const char *filename, snd_info_t *info)
 		return NULL;
 	}
 
+	Com_Memset(&reader, 0, sizeof(reader));
+	reader.file = file;
+
 	// Read the RIFF header
-	if(!S_ReadRIFFHeader(file, info))
+	if(!S_ReadRIFFHeader(&reader, info))
 	{
 		FS_FCloseFile(file);
 		Com_Printf( S_COLOR_RED "ERROR: Incorrect/unsupported format in \"%s\"\n",
@@ -240,6 +290,53 @@ void *S_WAV_CodecLoad(const char *filename, snd_info_t *info)
 	return buffer;
 }
 
+/*
+=================
+S_WAV_CodecLoadBuffer
+
+Same as S_WAV_CodecLoad for a file that has already been read
+=================
+*/
+void *S_WAV_CodecLoadBuffer(const char *filename, const void *data, int length, snd_info_t *info)
+{
+	wavReader_t reader;
+	void *buffer;
+
+	Com_Memset(&reader, 0, sizeof(reader));
+	reader.data = data;
+	reader.length = length;
+
+	// Read the RIFF header
+	if(!S_ReadRIFFHeader(&reader, info))
+	{
+		Com_Printf( S_COLOR_RED "ERROR: Incorrect/unsupported format in \"%s\"\n",
+				filename);
+		return NULL;
+	}
+
+	// Reading a truncated file only gets what is there
+	if(info->size > length - reader.pos)
+	{
+		info->size = length - reader.pos;
+		info->samples = (info->size / info->width) / info->channels;
+	}
+
+	// Allocate some memory
+	buffer = Hunk_AllocateTempMemory(info->size);
+	if(!buffer)
+	{
+		Com_Printf( S_COLOR_RED "ERROR: Out of memory reading \"%s\"\n",
+				filename);
+		return NULL;
+	}
+
+	// Copy, byteswap
+	S_WavRead(&reader, buffer, info->size);
+	S_ByteSwapRawSamples(info->samples, info->width, info->channels, (byte *)buffer);
+
+	return buffer;
+}
+
 /*
 =================
 S_WAV_CodecOpenStream
@@ -247,6 +344,7 @@ S_WAV_CodecOpenStream
 */
 snd_stream_t *S_WAV_CodecOpenStream(const char *filename)
 {
+	wavReader_t reader;
 	snd_stream_t *rv;
 
 	// Open
@@ -254,8 +352,11 @@ snd_stream_t *S_WAV_CodecOpenStream(const char *filename)
 	if(!rv)
 		return NULL;
 
+	Com_Memset(&reader, 0, sizeof(reader));
+	reader.file = rv->file;
+
 	// Read the RIFF header
-	if(!S_ReadRIFFHeader(rv->file, &rv->info))
+	if(!S_ReadRIFFHeader(&reader, &rv->info))
 	{
 		S_CodecUtilClose(&rv);
 		return NULL;
@@ -38,6 +38,7 @@ static void S_UpdateBackgroundTrack( void );
 static void S_Base_StopAllSounds( void );
 static void S_Base_StopBackgroundTrack( void );
 static void S_memoryLoad( sfx_t *sfx );
+static void S_SoundLoaded( void *data, const char *qpath, void *buffer, int length );
 
 static snd_stream_t *s_backgroundStream = NULL;
 static char s_backgroundLoop[MAX_QPATH];
@@ -309,6 +310,10 @@ static void S_Base_DisableSounds( void ) {
 S_RegisterSound
 
 Creates a default buzz sound if the file can't be loaded
+
+Returns 0 for a file that isn't found. A wav file that is found is decoded
+later by S_SoundLoaded, so if that fails the handle stays valid and the sound
+plays as silence instead of the 0 handle a synchronous load would return.
 ==================
 */
 static sfxHandle_t S_Base_RegisterSound( const char *name, bool compressed ) {
@@ -329,7 +334,7 @@ static sfxHandle_t S_Base_RegisterSound( const char *name, bool compressed ) {
 		return 0;
 	}
 
-	if ( sfx->soundData ) {
+	if ( sfx->soundData || sfx->asyncRead ) {
 		if ( sfx->defaultSound ) {
 			Com_DPrintf( S_COLOR_YELLOW "WARNING: could not find %s - using default\n", sfx->soundName );
 			return 0;
@@ -340,6 +345,14 @@ static sfxHandle_t S_Base_RegisterSound( const char *name, bool compressed ) {
 	sfx->inMemory = false;
 	sfx->soundCompressed = compressed;
 
+	// wav files are decoded when they have been read, see S_SoundLoaded
+	if ( !sfx->defaultSound && !Q_stricmp( COM_GetExtension( sfx->soundName ), "wav" ) ) {
+		sfx->asyncRead = FS_ReadFileAsync( sfx->soundName, FS_ASYNC_LOW, S_SoundLoaded, sfx );
+		if ( sfx->asyncRead ) {
+			return sfx - s_knownSfx;
+		}
+	}
+
 	S_memoryLoad( sfx );
 
 	if ( sfx->defaultSound ) {
@@ -373,6 +386,12 @@ static void S_Base_BeginRegistration( void ) {
 
 static void S_memoryLoad( sfx_t *sfx ) {
 
+	// a sound that is used before its read completes is loaded right away
+	if ( sfx->asyncRead ) {
+		FS_CancelAsyncRead( sfx->asyncRead );
+		sfx->asyncRead = 0;
+	}
+
 	// load the sound file
 	if ( !S_LoadSound ( sfx ) ) {
 		Com_DPrintf( S_COLOR_YELLOW "WARNING: couldn't load sound: %s\n", sfx->soundName );
@@ -382,6 +401,27 @@ static void S_memoryLoad( sfx_t *sfx ) {
 	sfx->inMemory = true;
 }
 
+
+/*
+=====================
+S_SoundLoaded
+
+Completes a sound registered with S_RegisterSound once its file has been read
+=====================
+*/
+static void S_SoundLoaded( void *data, const char *qpath, void *buffer, int length ) {
+	sfx_t *sfx = (sfx_t *)data;
+
+	sfx->asyncRead = 0;
+
+	if ( !buffer || !S_LoadSoundBuffer( sfx, buffer, length ) ) {
+		Com_DPrintf( S_COLOR_YELLOW "WARNING: couldn't load sound: %s\n", sfx->soundName );
+		sfx->defaultSound = true;
+	}
+
+	sfx->inMemory = true;
+}
+
 //=============================================================================
 
 /*
@@ -1443,11 +1483,19 @@ void S_FreeOldestSound( void ) {
 // =======================================================================
 
 static void S_Base_Shutdown( void ) {
+	int i;
 
 	if ( !s_soundStarted ) {
 		return;
 	}
 
+	for ( i = 0; i < s_numSfx; i++ ) {
+		if ( s_knownSfx[i].asyncRead ) {
+			FS_CancelAsyncRead( s_knownSfx[i].asyncRead );
+			s_knownSfx[i].asyncRead = 0;
+		}
+	}
+
 	SNDDMA_Shutdown();
 
 	// release sound buffers only when switching to dedicated 
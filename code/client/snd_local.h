@@ -59,6 +59,7 @@ typedef struct sfx_s {
 	int				soundChannels;
 	char 			soundName[MAX_QPATH];
 	int				lastTimeUsed;
+	int				asyncRead;				// queued FS_ReadFileAsync request
 	struct sfx_s	*next;
 } sfx_t;
 
@@ -198,6 +199,7 @@ extern cvar_t *s_muteWhenMinimized;
 extern cvar_t *s_testsound;
 
 bool S_LoadSound( sfx_t *sfx );
+bool S_LoadSoundBuffer( sfx_t *sfx, const void *buffer, int length );
 
 void		SND_free(sndBuffer *v);
 sndBuffer*	SND_malloc( void );
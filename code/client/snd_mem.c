@@ -259,33 +259,24 @@ static int ResampleSfxRaw( short *sfx, int channels, int inrate, int inwidth, in
 
 /*
 ==============
-S_LoadSound
+S_StoreSound
 
-The filename may be different than sfx->name in the case
-of a forced fallback of a player specific sound
+Resamples the decoded data into sound buffers and frees it
 ==============
 */
-bool S_LoadSound( sfx_t *sfx )
+static void S_StoreSound( sfx_t *sfx, byte *data, const snd_info_t *info )
 {
-	byte	*data;
 	short	*samples;
-	snd_info_t	info;
-//	int		size;
 
-	// load it in
-	data = S_CodecLoad(sfx->soundName, &info);
-	if(!data)
-		return false;
-
-	if ( info.width == 1 ) {
+	if ( info->width == 1 ) {
 		Com_DPrintf(S_COLOR_YELLOW "WARNING: %s is a 8 bit audio file\n", sfx->soundName);
 	}
 
-	if ( info.rate != 22050 ) {
+	if ( info->rate != 22050 ) {
 		Com_DPrintf(S_COLOR_YELLOW "WARNING: %s is not a 22kHz audio file\n", sfx->soundName);
 	}
 
-	samples = Hunk_AllocateTempMemory(info.samples * sizeof(short) * 2);
+	samples = Hunk_AllocateTempMemory(info->samples * sizeof(short) * 2);
 
 	sfx->lastTimeUsed = s_soundtime + 1; // Com_Milliseconds()+1
 
@@ -295,22 +286,66 @@ bool S_LoadSound( sfx_t *sfx )
 	// manager to do the right thing for us and page
 	// sound in as needed
 
-	if( info.channels == 1 && sfx->soundCompressed == true) {
+	if( info->channels == 1 && sfx->soundCompressed == true) {
 		sfx->soundCompressionMethod = 1;
 		sfx->soundData = NULL;
-		sfx->soundLength = ResampleSfxRaw( samples, info.channels, info.rate, info.width, info.samples, data + info.dataofs );
+		sfx->soundLength = ResampleSfxRaw( samples, info->channels, info->rate, info->width, info->samples, data + info->dataofs );
 		S_AdpcmEncodeSound(sfx, samples);
 
 	} else {
 		sfx->soundCompressionMethod = 0;
 		sfx->soundData = NULL;
-		sfx->soundLength = ResampleSfx( sfx, info.channels, info.rate, info.width, info.samples, data + info.dataofs, false );
+		sfx->soundLength = ResampleSfx( sfx, info->channels, info->rate, info->width, info->samples, data + info->dataofs, false );
 	}
 
-	sfx->soundChannels = info.channels;
+	sfx->soundChannels = info->channels;
 	
 	Hunk_FreeTempMemory(samples);
 	Hunk_FreeTempMemory(data);
+}
+
+
+/*
+==============
+S_LoadSound
+
+The filename may be different than sfx->name in the case
+of a forced fallback of a player specific sound
+==============
+*/
+bool S_LoadSound( sfx_t *sfx )
+{
+	byte	*data;
+	snd_info_t	info;
+
+	// load it in
+	data = S_CodecLoad(sfx->soundName, &info);
+	if(!data)
+		return false;
+
+	S_StoreSound( sfx, data, &info );
+
+	return true;
+}
+
+
+/*
+==============
+S_LoadSoundBuffer
+
+Same as S_LoadSound for a wav file that has already been read
+==============
+*/
+bool S_LoadSoundBuffer( sfx_t *sfx, const void *buffer, int length )
+{
+	byte	*data;
+	snd_info_t	info;
+
+	data = S_WAV_CodecLoadBuffer(sfx->soundName, buffer, length, &info);
+	if(!data)
+		return false;
+
+	S_StoreSound( sfx, data, &info );
 
 	return true;
 }
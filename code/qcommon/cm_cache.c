@@ -0,0 +1,324 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// cm_cache.c -- precomputed patch collision cache
+
+/*
+
+Generating patch collides is by far the most expensive part of loading
+a clip map, everything else is copied almost directly from the bsp lumps.
+When cm_cache is enabled the generated facets and planes are written to
+cmcache/<mapname>.cmc below fs_homepath and reused on following loads of
+the same bsp.
+
+The file is written in native byte order and structure layout and is
+only accepted if ident, version, byte order, engine version, bsp checksum
+and the patch dimensions all match. All facet and plane data is stored in
+a single block addressed by relative offsets. It is read and validated in
+temp memory, and only copied to the hunk once all of it checks out, so a
+damaged file doesn't leave anything behind.
+
+*/
+
+#include "cm_local.h"
+#include "cm_patch.h"
+
+#define CM_CACHE_IDENT		(('C'<<24)+('M'<<16)+('C'<<8)+'Q')
+#define CM_CACHE_VERSION	3
+#define CM_CACHE_BYTEORDER	0x01020304
+
+typedef struct {
+	int			ident;
+	int			version;
+	int			byteOrder;		// CM_CACHE_BYTEORDER as written by the writer
+	char		engine[64];		// Q3_VERSION of the writer
+	unsigned int checksum;		// of the source bsp
+	int			numPatches;
+	int			facetSize;		// sizeof( facet_t ), catches layout changes
+	int			planeSize;		// sizeof( patchPlane_t )
+	int			dataLength;		// facet and plane data following the patch records
+} cmCacheHeader_t;
+
+typedef struct {
+	int			width;			// source mesh size, for validation
+	int			height;
+	vec3_t		bounds[2];
+	int			numPlanes;
+	int			planesOfs;		// relative to start of data
+	int			numFacets;
+	int			facetsOfs;
+} cmCachePatch_t;
+
+cvar_t		*cm_cache;
+
+
+/*
+=================
+CM_CachePath
+=================
+*/
+static const char *CM_CachePath( const char *name ) {
+	static char path[ MAX_QPATH ];
+	char base[ MAX_QPATH ];
+
+	COM_StripExtension( COM_SkipPath( (char *)name ), base, sizeof( base ) );
+	Com_sprintf( path, sizeof( path ), "cmcache/%s.cmc", base );
+
+	return path;
+}
+
+
+/*
+=================
+CM_ValidateCachedPatch
+=================
+*/
+static bool CM_ValidateCachedPatch( const cmCachePatch_t *rec, const patchSource_t *src, int dataLength ) {
+	if ( rec->width != src->width || rec->height != src->height ) {
+		return false;
+	}
+
+	if ( rec->numPlanes < 0 || rec->numPlanes > MAX_PATCH_PLANES || rec->numFacets < 0 || rec->numFacets > MAX_FACETS ) {
+		return false;
+	}
+
+	if ( rec->planesOfs < 0 || ( rec->planesOfs & 3 ) || rec->planesOfs + rec->numPlanes * (int)sizeof( patchPlane_t ) > dataLength ) {
+		return false;
+	}
+
+	if ( rec->facetsOfs < 0 || ( rec->facetsOfs & 3 ) || rec->facetsOfs + rec->numFacets * (int)sizeof( facet_t ) > dataLength ) {
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+=================
+CM_ValidateCachedFacets
+
+Make sure that a damaged file can't send traces outside of the plane array.
+=================
+*/
+static bool CM_ValidateCachedFacets( const patchCollide_t *pc ) {
+	const facet_t *facet;
+	int i, j;
+
+	for ( i = 0, facet = pc->facets; i < pc->numFacets; i++, facet++ ) {
+		if ( (unsigned)facet->surfacePlane >= (unsigned)pc->numPlanes ) {
+			return false;
+		}
+		if ( facet->numBorders < 0 || facet->numBorders > (int)ARRAY_LEN( facet->borderPlanes ) ) {
+			return false;
+		}
+		for ( j = 0; j < facet->numBorders; j++ ) {
+			if ( (unsigned)facet->borderPlanes[j] >= (unsigned)pc->numPlanes ) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+/*
+=================
+CM_LoadPatchCache
+
+Tries to fill in pc for all sources from the cache file,
+returns false if the file is missing, outdated or damaged.
+=================
+*/
+bool CM_LoadPatchCache( const char *name, patchSource_t *sources, int count ) {
+	cmCacheHeader_t	header;
+	cmCachePatch_t	*recs;
+	patchCollide_t	*pc, check;
+	fileHandle_t	f;
+	const char		*path;
+	byte			*temp, *data;
+	int				length, recsLength;
+	int				i;
+
+	if ( !cm_cache->integer || count <= 0 ) {
+		return false;
+	}
+
+	path = CM_CachePath( name );
+	length = FS_SV_FOpenFileRead( path, &f );
+	if ( f == FS_INVALID_HANDLE ) {
+		return false;
+	}
+
+	recsLength = count * sizeof( *recs );
+
+	if ( length < (int)sizeof( header ) || FS_Read( &header, sizeof( header ), f ) != sizeof( header ) ) {
+		FS_FCloseFile( f );
+		return false;
+	}
+
+	header.engine[ sizeof( header.engine ) - 1 ] = '\0';
+
+	if ( header.ident != CM_CACHE_IDENT || header.version != CM_CACHE_VERSION
+		|| header.byteOrder != CM_CACHE_BYTEORDER
+		|| strcmp( header.engine, Q3_VERSION ) != 0 || header.checksum != cm.checksum
+		|| header.numPatches != count || header.facetSize != sizeof( facet_t )
+		|| header.planeSize != sizeof( patchPlane_t ) || header.dataLength < 0
+		|| length != (int)sizeof( header ) + recsLength + header.dataLength ) {
+		Com_DPrintf( "%s is outdated\n", path );
+		FS_FCloseFile( f );
+		return false;
+	}
+
+	recs = Hunk_AllocateTempMemory( recsLength );
+	if ( FS_Read( recs, recsLength, f ) != recsLength ) {
+		Hunk_FreeTempMemory( recs );
+		FS_FCloseFile( f );
+		return false;
+	}
+
+	for ( i = 0; i < count; i++ ) {
+		if ( !CM_ValidateCachedPatch( &recs[i], &sources[i], header.dataLength ) ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: %s doesn't match the map\n", path );
+			Hunk_FreeTempMemory( recs );
+			FS_FCloseFile( f );
+			return false;
+		}
+	}
+
+	temp = Hunk_AllocateTempMemory( header.dataLength + 1 );
+	if ( FS_Read( temp, header.dataLength, f ) != header.dataLength ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: error reading %s\n", path );
+		Hunk_FreeTempMemory( temp );
+		Hunk_FreeTempMemory( recs );
+		FS_FCloseFile( f );
+		return false;
+	}
+
+	FS_FCloseFile( f );
+
+	for ( i = 0; i < count; i++ ) {
+		check.numPlanes = recs[i].numPlanes;
+		check.numFacets = recs[i].numFacets;
+		check.facets = (facet_t *)( temp + recs[i].facetsOfs );
+		if ( !CM_ValidateCachedFacets( &check ) ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: %s is damaged\n", path );
+			Hunk_FreeTempMemory( temp );
+			Hunk_FreeTempMemory( recs );
+			return false;
+		}
+	}
+
+	// nothing can fail from here on, facets and planes are used right from the copied block
+	data = Hunk_Alloc( header.dataLength, h_high );
+	Com_Memcpy( data, temp, header.dataLength );
+
+	for ( i = 0; i < count; i++ ) {
+		pc = Hunk_Alloc( sizeof( *pc ), h_high );
+		VectorCopy( recs[i].bounds[0], pc->bounds[0] );
+		VectorCopy( recs[i].bounds[1], pc->bounds[1] );
+		pc->numPlanes = recs[i].numPlanes;
+		pc->planes = (patchPlane_t *)( data + recs[i].planesOfs );
+		pc->numFacets = recs[i].numFacets;
+		pc->facets = (facet_t *)( data + recs[i].facetsOfs );
+		CM_BuildPatchTraceData( pc );
+		sources[i].pc = pc;
+	}
+
+	Hunk_FreeTempMemory( temp );
+	Hunk_FreeTempMemory( recs );
+
+	Com_Printf( "...loaded %i patch collides from %s\n", count, path );
+
+	return true;
+}
+
+
+/*
+=================
+CM_SavePatchCache
+=================
+*/
+void CM_SavePatchCache( const char *name, const patchSource_t *sources, int count ) {
+	cmCacheHeader_t	header;
+	cmCachePatch_t	*recs;
+	const patchCollide_t *pc;
+	fileHandle_t	f;
+	const char		*path;
+	int				dataLength, recsLength;
+	int				i;
+
+	if ( !cm_cache->integer || count <= 0 ) {
+		return;
+	}
+
+	recsLength = count * sizeof( *recs );
+	recs = Hunk_AllocateTempMemory( recsLength );
+
+	dataLength = 0;
+	for ( i = 0; i < count; i++ ) {
+		pc = sources[i].pc;
+		recs[i].width = sources[i].width;
+		recs[i].height = sources[i].height;
+		VectorCopy( pc->bounds[0], recs[i].bounds[0] );
+		VectorCopy( pc->bounds[1], recs[i].bounds[1] );
+		recs[i].numFacets = pc->numFacets;
+		recs[i].facetsOfs = dataLength;
+		dataLength += pc->numFacets * sizeof( facet_t );
+		recs[i].numPlanes = pc->numPlanes;
+		recs[i].planesOfs = dataLength;
+		dataLength += pc->numPlanes * sizeof( patchPlane_t );
+	}
+
+	Com_Memset( &header, 0, sizeof( header ) );
+	header.ident = CM_CACHE_IDENT;
+	header.version = CM_CACHE_VERSION;
+	header.byteOrder = CM_CACHE_BYTEORDER;
+	Q_strncpyz( header.engine, Q3_VERSION, sizeof( header.engine ) );
+	header.checksum = cm.checksum;
+	header.numPatches = count;
+	header.facetSize = sizeof( facet_t );
+	header.planeSize = sizeof( patchPlane_t );
+	header.dataLength = dataLength;
+
+	path = CM_CachePath( name );
+	f = FS_SV_FOpenFileWrite( path );
+	if ( f == FS_INVALID_HANDLE ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't write %s\n", path );
+		Hunk_FreeTempMemory( recs );
+		return;
+	}
+
+	FS_Write( &header, sizeof( header ), f );
+	FS_Write( recs, recsLength, f );
+	for ( i = 0; i < count; i++ ) {
+		pc = sources[i].pc;
+		FS_Write( pc->facets, pc->numFacets * sizeof( facet_t ), f );
+		FS_Write( pc->planes, pc->numPlanes * sizeof( patchPlane_t ), f );
+	}
+
+	FS_FCloseFile( f );
+
+	Hunk_FreeTempMemory( recs );
+
+	Com_DPrintf( "wrote %s\n", path );
+}
@@ -304,6 +304,8 @@ static void CMod_LoadLeafs( const lump_t *l )
 
 	cm.areas = Hunk_Alloc( cm.numAreas * sizeof( *cm.areas ), h_high );
 	cm.areaPortals = Hunk_Alloc( cm.numAreas * cm.numAreas * sizeof( *cm.areaPortals ), h_high );
+	cm.areaBytes = ( cm.numAreas + 7 ) >> 3;
+	cm.areaConnected = Hunk_Alloc( cm.numAreas * cm.areaBytes, h_high );
 }
 
 
@@ -509,14 +511,16 @@ CMod_LoadPatches
 =================
 */
 #define	MAX_PATCH_VERTS		1024
-static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts ) {
+static void CMod_LoadPatches( const char *name, const lump_t *surfs, const lump_t *verts ) {
 	drawVert_t	*dv, *dv_p;
 	dsurface_t	*in;
 	int			count;
 	int			i, j;
 	int			c;
 	cPatch_t	*patch;
-	vec3_t		points[MAX_PATCH_VERTS];
+	patchSource_t	*sources;
+	vec3_t		*points, *p;
+	int			numPatches, numPoints;
 	int			width, height;
 	int			shaderNum;
 
@@ -531,38 +535,94 @@ static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts ) {
 	if (verts->filelen % sizeof(*dv))
 		Com_Error( ERR_DROP, "%s: funny lump size", __func__ );
 
-	// scan through all the surfaces, but only load patches,
-	// not planar faces
-	for ( i = 0 ; i < count ; i++, in++ ) {
-		if ( LittleLong( in->surfaceType ) != MST_PATCH ) {
+	// count the patches, but not planar faces
+	numPatches = 0;
+	numPoints = 0;
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( LittleLong( in[i].surfaceType ) != MST_PATCH ) {
 			continue;		// ignore other surfaces
 		}
-		// FIXME: check for non-colliding patches
-
-		cm.surfaces[ i ] = patch = Hunk_Alloc( sizeof( *patch ), h_high );
 
-		// load the full drawverts onto the stack
-		width = LittleLong( in->patchWidth );
-		height = LittleLong( in->patchHeight );
+		width = LittleLong( in[i].patchWidth );
+		height = LittleLong( in[i].patchHeight );
 		c = width * height;
 		if ( c > MAX_PATCH_VERTS ) {
 			Com_Error( ERR_DROP, "%s: MAX_PATCH_VERTS", __func__ );
 		}
 
-		dv_p = dv + LittleLong( in->firstVert );
-		for ( j = 0 ; j < c ; j++, dv_p++ ) {
-			points[j][0] = LittleFloat( dv_p->xyz[0] );
-			points[j][1] = LittleFloat( dv_p->xyz[1] );
-			points[j][2] = LittleFloat( dv_p->xyz[2] );
+		numPatches++;
+		numPoints += c;
+	}
+
+	if ( !numPatches ) {
+		return;
+	}
+
+	sources = Hunk_AllocateTempMemory( numPatches * sizeof( *sources ) );
+
+	for ( i = 0, numPatches = 0 ; i < count ; i++ ) {
+		if ( LittleLong( in[i].surfaceType ) != MST_PATCH ) {
+			continue;
 		}
+		sources[ numPatches ].width = LittleLong( in[i].patchWidth );
+		sources[ numPatches ].height = LittleLong( in[i].patchHeight );
+		sources[ numPatches ].points = NULL;
+		sources[ numPatches ].pc = NULL;
+		numPatches++;
+	}
 
-		shaderNum = LittleLong( in->shaderNum );
+#ifndef BSPC
+	if ( !CM_LoadPatchCache( name, sources, numPatches ) )
+#endif
+	{
+		points = Hunk_AllocateTempMemory( numPoints * sizeof( *points ) );
+
+		// load the full drawverts of all patches, they
+		// can be generated independently from each other
+		p = points;
+		for ( i = 0, numPatches = 0 ; i < count ; i++ ) {
+			if ( LittleLong( in[i].surfaceType ) != MST_PATCH ) {
+				continue;
+			}
+
+			sources[ numPatches ].points = (const vec3_t *)p;
+			c = sources[ numPatches ].width * sources[ numPatches ].height;
+			numPatches++;
+
+			dv_p = dv + LittleLong( in[i].firstVert );
+			for ( j = 0 ; j < c ; j++, dv_p++, p++ ) {
+				(*p)[0] = LittleFloat( dv_p->xyz[0] );
+				(*p)[1] = LittleFloat( dv_p->xyz[1] );
+				(*p)[2] = LittleFloat( dv_p->xyz[2] );
+			}
+		}
+
+		// create the internal facet structures
+		CM_GeneratePatchCollides( sources, numPatches );
+
+		Hunk_FreeTempMemory( points );
+
+#ifndef BSPC
+		CM_SavePatchCache( name, sources, numPatches );
+#endif
+	}
+
+	for ( i = 0, numPatches = 0 ; i < count ; i++ ) {
+		if ( LittleLong( in[i].surfaceType ) != MST_PATCH ) {
+			continue;
+		}
+		// FIXME: check for non-colliding patches
+
+		cm.surfaces[ i ] = patch = Hunk_Alloc( sizeof( *patch ), h_high );
+
+		shaderNum = LittleLong( in[i].shaderNum );
 		patch->contents = cm.shaders[shaderNum].contentFlags;
 		patch->surfaceFlags = cm.shaders[shaderNum].surfaceFlags;
 
-		// create the internal facet structure
-		patch->pc = CM_GeneratePatchCollide( width, height, points );
+		patch->pc = sources[ numPatches++ ].pc;
 	}
+
+	Hunk_FreeTempMemory( sources );
 }
 
 
@@ -590,6 +650,8 @@ void CM_LoadMap( const char *name, bool clientload, int *checksum ) {
 	Cvar_SetDescription( cm_noCurves, "Do not collide against curves." );
 	cm_playerCurveClip = Cvar_Get( "cm_playerCurveClip", "1", CVAR_ARCHIVE_ND | CVAR_CHEAT );
 	Cvar_SetDescription( cm_playerCurveClip, "Collide player against curves." );
+	cm_cache = Cvar_Get( "cm_cache", "0", CVAR_ARCHIVE_ND );
+	Cvar_SetDescription( cm_cache, "Store generated curve collision data in cmcache/ and reuse it on following loads of the same map." );
 #endif
 
 	Com_DPrintf( "%s( '%s', %i )\n", __func__, name, clientload );
@@ -651,7 +713,7 @@ void CM_LoadMap( const char *name, bool clientload, int *checksum ) {
 	CMod_LoadNodes (&header.lumps[LUMP_NODES]);
 	CMod_LoadEntityString (&header.lumps[LUMP_ENTITIES]);
 	CMod_LoadVisibility( &header.lumps[LUMP_VISIBILITY] );
-	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS] );
+	CMod_LoadPatches( name, &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS] );
 
 	CMod_CheckLeafBrushes();
 
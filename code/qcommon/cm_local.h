@@ -123,6 +123,13 @@ typedef struct {
 	int			floodvalid;
 } cArea_t;
 
+#define	POINT_LEAF_CACHE	64		// must be a power of two
+
+typedef struct {
+	vec3_t		point;
+	int			leafnum;		// +1, 0 for an empty slot
+} cPointLeaf_t;
+
 typedef struct {
 	char		name[MAX_QPATH];
 
@@ -164,6 +171,8 @@ typedef struct {
 	int			numAreas;
 	cArea_t		*areas;
 	int			*areaPortals;	// [ numAreas*numAreas ] reference counts
+	int			areaBytes;
+	byte		*areaConnected;	// [ numAreas*areaBytes ] connected area bits, one row per area
 
 	int			numSurfaces;
 	cPatch_t	**surfaces;			// non-patches will be NULL
@@ -172,6 +181,8 @@ typedef struct {
 	int			checkcount;					// incremented on each trace
 
 	unsigned int checksum;
+
+	cPointLeaf_t pointLeafs[ POINT_LEAF_CACHE ];	// recent CM_PointClusterArea lookups
 } clipMap_t;
 
 
@@ -185,6 +196,7 @@ extern	int			c_traces, c_brush_traces, c_patch_traces;
 extern	cvar_t		*cm_noAreas;
 extern	cvar_t		*cm_noCurves;
 extern	cvar_t		*cm_playerCurveClip;
+extern	cvar_t		*cm_cache;
 
 // cm_test.c
 
@@ -236,7 +248,21 @@ bool CM_BoundsIntersectPoint( const vec3_t mins, const vec3_t maxs, const vec3_t
 
 // cm_patch.c
 
+typedef struct {
+	int				width;
+	int				height;
+	const vec3_t	*points;
+	struct patchCollide_s	*pc;	// filled in by CM_GeneratePatchCollides
+} patchSource_t;
+
 struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *points );
+void CM_GeneratePatchCollides( patchSource_t *sources, int count );
+
 void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc );
 bool CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc );
 void CM_ClearLevelPatches( void );
+
+// cm_cache.c
+
+bool CM_LoadPatchCache( const char *name, patchSource_t *sources, int count );
+void CM_SavePatchCache( const char *name, const patchSource_t *sources, int count );
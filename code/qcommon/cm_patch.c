@@ -23,6 +23,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "cm_local.h"
 #include "cm_patch.h"
 
+#if idx64
+#include <emmintrin.h>
+#endif
+
 /*
 
 This file does not reference any globals, and has these entry points:
@@ -419,11 +423,56 @@ PATCH COLLIDE GENERATION
 ================================================================================
 */
 
-static	int				numPlanes;
-static	patchPlane_t	planes[MAX_PATCH_PLANES];
+// warnings can't be printed from the worker threads, so they are
+// counted and reported when the patch collide is stored
+typedef enum {
+	PW_GRIDPLANE_UNRESOLVABLE,
+	PW_MIXED_PLANE_SIDES,
+	PW_TOO_MANY_BEVELS,
+	PW_BEVEL_PLANE_USED,
+	PW_INVALID_BEVEL,
+	PW_NUM_WARNINGS
+} patchWarning_t;
+
+static const struct {
+	const char	*text;
+	bool	developer;
+} patchWarnings[ PW_NUM_WARNINGS ] = {
+	{ "WARNING: CM_GridPlane unresolvable", false },
+	{ "WARNING: CM_SetBorderInward: mixed plane sides", true },
+	{ "ERROR: too many bevels", false },
+	{ "WARNING: bevel plane already used", false },
+	{ "WARNING: CM_AddFacetBevels... invalid bevel", true }
+};
+
+// generated data for a single patch, planes and facets are malloc'ed
+// and moved to the hunk by CM_StorePatchCollide
+typedef struct {
+	vec3_t			bounds[2];
+	int				numPlanes;
+	patchPlane_t	*planes;
+	int				numFacets;
+	facet_t			*facets;
+	int				numBlocks;
+	const char		*error;
+	int				warnings[ PW_NUM_WARNINGS ];
+	bool		debugBlock;
+	vec3_t			debugBlockPoints[4];
+} patchResult_t;
+
+// per-thread scratch space used while generating a patch collide
+typedef struct {
+	patchResult_t	*result;
 
-static	int				numFacets;
-static	facet_t			facets[MAX_FACETS];
+	int				numPlanes;
+	patchPlane_t	planes[MAX_PATCH_PLANES];
+
+	int				numFacets;
+	facet_t			facets[MAX_FACETS];
+
+	cGrid_t			grid;
+	int				gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2];
+} patchWork_t;
 
 #define	NORMAL_EPSILON	0.0001
 #define	DIST_EPSILON	0.02
@@ -494,27 +543,29 @@ static void CM_SnapVector( vec3_t normal ) {
 CM_FindPlane2
 ==================
 */
-static int CM_FindPlane2( const float plane[4], int *flipped ) {
+static int CM_FindPlane2( patchWork_t *pw, const float plane[4], int *flipped ) {
 	int i;
 
 	// see if the points are close enough to an existing plane
-	for ( i = 0 ; i < numPlanes ; i++ ) {
-		if (CM_PlaneEqual(&planes[i], plane, flipped)) return i;
+	for ( i = 0 ; i < pw->numPlanes ; i++ ) {
+		if (CM_PlaneEqual(&pw->planes[i], plane, flipped)) return i;
 	}
 
 	// add a new plane
-	if ( numPlanes == MAX_PATCH_PLANES ) {
-		Com_Error( ERR_DROP, "MAX_PATCH_PLANES" );
+	if ( pw->numPlanes == MAX_PATCH_PLANES ) {
+		pw->result->error = "MAX_PATCH_PLANES";
+		*flipped = false;
+		return 0;
 	}
 
-	Vector4Copy( plane, planes[numPlanes].plane );
-	planes[numPlanes].signbits = CM_SignbitsForNormal( plane );
+	Vector4Copy( plane, pw->planes[pw->numPlanes].plane );
+	pw->planes[pw->numPlanes].signbits = CM_SignbitsForNormal( plane );
 
-	numPlanes++;
+	pw->numPlanes++;
 
 	*flipped = false;
 
-	return numPlanes-1;
+	return pw->numPlanes-1;
 }
 
 
@@ -523,7 +574,7 @@ static int CM_FindPlane2( const float plane[4], int *flipped ) {
 CM_FindPlane
 ==================
 */
-static int CM_FindPlane( const float *p1, const float *p2, const float *p3 ) {
+static int CM_FindPlane( patchWork_t *pw, const float *p1, const float *p2, const float *p3 ) {
 	float	plane[4];
 	int		i;
 	float	d;
@@ -533,22 +584,22 @@ static int CM_FindPlane( const float *p1, const float *p2, const float *p3 ) {
 	}
 
 	// see if the points are close enough to an existing plane
-	for ( i = 0 ; i < numPlanes ; i++ ) {
-		if ( DotProduct( plane, planes[i].plane ) < 0 ) {
+	for ( i = 0 ; i < pw->numPlanes ; i++ ) {
+		if ( DotProduct( plane, pw->planes[i].plane ) < 0 ) {
 			continue;	// allow backwards planes?
 		}
 
-		d = DotProduct( p1, planes[i].plane ) - planes[i].plane[3];
+		d = DotProduct( p1, pw->planes[i].plane ) - pw->planes[i].plane[3];
 		if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
 			continue;
 		}
 
-		d = DotProduct( p2, planes[i].plane ) - planes[i].plane[3];
+		d = DotProduct( p2, pw->planes[i].plane ) - pw->planes[i].plane[3];
 		if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
 			continue;
 		}
 
-		d = DotProduct( p3, planes[i].plane ) - planes[i].plane[3];
+		d = DotProduct( p3, pw->planes[i].plane ) - pw->planes[i].plane[3];
 		if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
 			continue;
 		}
@@ -558,16 +609,17 @@ static int CM_FindPlane( const float *p1, const float *p2, const float *p3 ) {
 	}
 
 	// add a new plane
-	if ( numPlanes == MAX_PATCH_PLANES ) {
-		Com_Error( ERR_DROP, "MAX_PATCH_PLANES" );
+	if ( pw->numPlanes == MAX_PATCH_PLANES ) {
+		pw->result->error = "MAX_PATCH_PLANES";
+		return 0;
 	}
 
-	Vector4Copy( plane, planes[numPlanes].plane );
-	planes[numPlanes].signbits = CM_SignbitsForNormal( plane );
+	Vector4Copy( plane, pw->planes[pw->numPlanes].plane );
+	pw->planes[pw->numPlanes].signbits = CM_SignbitsForNormal( plane );
 
-	numPlanes++;
+	pw->numPlanes++;
 
-	return numPlanes-1;
+	return pw->numPlanes-1;
 }
 
 
@@ -576,14 +628,14 @@ static int CM_FindPlane( const float *p1, const float *p2, const float *p3 ) {
 CM_PointOnPlaneSide
 ==================
 */
-static int CM_PointOnPlaneSide( const float *p, int planeNum ) {
+static int CM_PointOnPlaneSide( patchWork_t *pw, const float *p, int planeNum ) {
 	const float *plane;
 	double	d;
 
 	if ( planeNum == -1 ) {
 		return SIDE_ON;
 	}
-	plane = planes[ planeNum ].plane;
+	plane = pw->planes[ planeNum ].plane;
 
 	d = DotProductDPf( p, plane ) - plane[3];
 
@@ -604,7 +656,7 @@ static int CM_PointOnPlaneSide( const float *p, int planeNum ) {
 CM_GridPlane
 ==================
 */
-static int	CM_GridPlane( int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i, int j, int tri ) {
+static int	CM_GridPlane( patchWork_t *pw, int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i, int j, int tri ) {
 	int		p;
 
 	p = gridPlanes[i][j][tri];
@@ -617,7 +669,7 @@ static int	CM_GridPlane( int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i,
 	}
 
 	// should never happen
-	Com_Printf( "WARNING: CM_GridPlane unresolvable\n" );
+	pw->result->warnings[ PW_GRIDPLANE_UNRESOLVABLE ]++;
 	return -1;
 }
 
@@ -627,7 +679,7 @@ static int	CM_GridPlane( int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i,
 CM_EdgePlaneNum
 ==================
 */
-static int CM_EdgePlaneNum( const cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i, int j, int k ) {
+static int CM_EdgePlaneNum( patchWork_t *pw, const cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i, int j, int k ) {
 	const float *p1, *p2;
 	vec3_t		up;
 	int			p;
@@ -636,66 +688,66 @@ static int CM_EdgePlaneNum( const cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][M
 	case 0:	// top border
 		p1 = grid->points[i][j];
 		p2 = grid->points[i+1][j];
-		p = CM_GridPlane( gridPlanes, i, j, 0 );
+		p = CM_GridPlane( pw, gridPlanes, i, j, 0 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p1, p2, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p1, p2, up );
 
 	case 2:	// bottom border
 		p1 = grid->points[i][j+1];
 		p2 = grid->points[i+1][j+1];
-		p = CM_GridPlane( gridPlanes, i, j, 1 );
+		p = CM_GridPlane( pw, gridPlanes, i, j, 1 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p2, p1, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p2, p1, up );
 
 	case 3: // left border
 		p1 = grid->points[i][j];
 		p2 = grid->points[i][j+1];
-		p = CM_GridPlane( gridPlanes, i, j, 1 );
+		p = CM_GridPlane( pw, gridPlanes, i, j, 1 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p2, p1, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p2, p1, up );
 
 	case 1:	// right border
 		p1 = grid->points[i+1][j];
 		p2 = grid->points[i+1][j+1];
-		p = CM_GridPlane( gridPlanes, i, j, 0 );
+		p = CM_GridPlane( pw, gridPlanes, i, j, 0 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p1, p2, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p1, p2, up );
 
 	case 4:	// diagonal out of triangle 0
 		p1 = grid->points[i+1][j+1];
 		p2 = grid->points[i][j];
-		p = CM_GridPlane( gridPlanes, i, j, 0 );
+		p = CM_GridPlane( pw, gridPlanes, i, j, 0 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p1, p2, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p1, p2, up );
 
 	case 5:	// diagonal out of triangle 1
 		p1 = grid->points[i][j];
 		p2 = grid->points[i+1][j+1];
-		p = CM_GridPlane( gridPlanes, i, j, 1 );
+		p = CM_GridPlane( pw, gridPlanes, i, j, 1 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p1, p2, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p1, p2, up );
 
 	}
 
-	Com_Error( ERR_DROP, "CM_EdgePlaneNum: bad k" );
+	pw->result->error = "CM_EdgePlaneNum: bad k";
 	return -1;
 }
 
@@ -705,7 +757,7 @@ static int CM_EdgePlaneNum( const cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][M
 CM_SetBorderInward
 ===================
 */
-static void CM_SetBorderInward( facet_t *facet, const cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2],
+static void CM_SetBorderInward( patchWork_t *pw, facet_t *facet, const cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2],
 						  int i, int j, int which ) {
 	int		k, l;
 	const float *points[4];
@@ -732,9 +784,8 @@ static void CM_SetBorderInward( facet_t *facet, const cGrid_t *grid, int gridPla
 		numPoints = 3;
 		break;
 	default:
-		Com_Error( ERR_FATAL, "CM_SetBorderInward: bad parameter" );
-		numPoints = 0;
-		break;
+		pw->result->error = "CM_SetBorderInward: bad parameter";
+		return;
 	}
 
 	for ( k = 0 ; k < facet->numBorders ; k++ ) {
@@ -746,7 +797,7 @@ static void CM_SetBorderInward( facet_t *facet, const cGrid_t *grid, int gridPla
 		for ( l = 0 ; l < numPoints ; l++ ) {
 			int		side;
 
-			side = CM_PointOnPlaneSide( points[l], facet->borderPlanes[k] );
+			side = CM_PointOnPlaneSide( pw, points[l], facet->borderPlanes[k] );
 			if ( side == SIDE_FRONT ) {
 				front++;
 			} else if ( side == SIDE_BACK ) {
@@ -763,14 +814,14 @@ static void CM_SetBorderInward( facet_t *facet, const cGrid_t *grid, int gridPla
 			facet->borderPlanes[k] = -1;
 		} else {
 			// bisecting side border
-			Com_DPrintf( "WARNING: CM_SetBorderInward: mixed plane sides\n" );
+			pw->result->warnings[ PW_MIXED_PLANE_SIDES ]++;
 			facet->borderInward[k] = false;
-			if ( !debugBlock ) {
-				debugBlock = true;
-				VectorCopy( grid->points[i][j], debugBlockPoints[0] );
-				VectorCopy( grid->points[i+1][j], debugBlockPoints[1] );
-				VectorCopy( grid->points[i+1][j+1], debugBlockPoints[2] );
-				VectorCopy( grid->points[i][j+1], debugBlockPoints[3] );
+			if ( !pw->result->debugBlock ) {
+				pw->result->debugBlock = true;
+				VectorCopy( grid->points[i][j], pw->result->debugBlockPoints[0] );
+				VectorCopy( grid->points[i+1][j], pw->result->debugBlockPoints[1] );
+				VectorCopy( grid->points[i+1][j+1], pw->result->debugBlockPoints[2] );
+				VectorCopy( grid->points[i][j+1], pw->result->debugBlockPoints[3] );
 			}
 		}
 	}
@@ -784,7 +835,7 @@ CM_ValidateFacet
 If the facet isn't bounded by its borders, we screwed up.
 ==================
 */
-static bool CM_ValidateFacet( const facet_t *facet ) {
+static bool CM_ValidateFacet( patchWork_t *pw, const facet_t *facet ) {
 	float		plane[4];
 	int			j;
 	winding_t	*w;
@@ -794,19 +845,19 @@ static bool CM_ValidateFacet( const facet_t *facet ) {
 		return false;
 	}
 
-	Vector4Copy( planes[ facet->surfacePlane ].plane, plane );
-	w = BaseWindingForPlane( plane,  plane[3] );
+	Vector4Copy( pw->planes[ facet->surfacePlane ].plane, plane );
+	w = BaseWindingForPlane( plane,  plane[3], &pw->result->error );
 	for ( j = 0 ; j < facet->numBorders && w ; j++ ) {
 		if ( facet->borderPlanes[j] == -1 ) {
 			FreeWinding( w );
 			return false;
 		}
-		Vector4Copy( planes[ facet->borderPlanes[j] ].plane, plane );
+		Vector4Copy( pw->planes[ facet->borderPlanes[j] ].plane, plane );
 		if ( !facet->borderInward[j] ) {
 			VectorSubtract( vec3_origin, plane, plane );
 			plane[3] = -plane[3];
 		}
-		ChopWindingInPlace( &w, plane, plane[3], 0.1f );
+		ChopWindingInPlace( &w, plane, plane[3], 0.1f, &pw->result->error );
 	}
 
 	if ( !w ) {
@@ -837,7 +888,7 @@ static bool CM_ValidateFacet( const facet_t *facet ) {
 CM_AddFacetBevels
 ==================
 */
-static void CM_AddFacetBevels( facet_t *facet ) {
+static void CM_AddFacetBevels( patchWork_t *pw, facet_t *facet ) {
 
 	int i, j, k, l;
 	int axis, dir, order, flipped;
@@ -846,19 +897,23 @@ static void CM_AddFacetBevels( facet_t *facet ) {
 	vec3_t mins, maxs, vec, vec2;
 	double d, d1[3], d2[3];
 
-	Vector4Copy( planes[ facet->surfacePlane ].plane, plane );
+	// no culling unless all axial bevels are in place
+	VectorSet( facet->bounds[0], -2*MAX_MAP_BOUNDS, -2*MAX_MAP_BOUNDS, -2*MAX_MAP_BOUNDS );
+	VectorSet( facet->bounds[1], 2*MAX_MAP_BOUNDS, 2*MAX_MAP_BOUNDS, 2*MAX_MAP_BOUNDS );
+
+	Vector4Copy( pw->planes[ facet->surfacePlane ].plane, plane );
 
-	w = BaseWindingForPlane( plane,  plane[3] );
+	w = BaseWindingForPlane( plane,  plane[3], &pw->result->error );
 	for ( j = 0 ; j < facet->numBorders && w ; j++ ) {
 		if (facet->borderPlanes[j] == facet->surfacePlane) continue;
-		Vector4Copy( planes[ facet->borderPlanes[j] ].plane, plane );
+		Vector4Copy( pw->planes[ facet->borderPlanes[j] ].plane, plane );
 
 		if ( !facet->borderInward[j] ) {
 			VectorSubtract( vec3_origin, plane, plane );
 			plane[3] = -plane[3];
 		}
 
-		ChopWindingInPlace( &w, plane, plane[3], 0.1f );
+		ChopWindingInPlace( &w, plane, plane[3], 0.1f, &pw->result->error );
 	}
 	if ( !w ) {
 		return;
@@ -866,6 +921,12 @@ static void CM_AddFacetBevels( facet_t *facet ) {
 
 	WindingBounds(w, mins, maxs);
 
+	// the bevels allow contacts slightly outside of the winding
+	for ( axis = 0 ; axis < 3 ; axis++ ) {
+		facet->bounds[0][axis] = mins[axis] - 1;
+		facet->bounds[1][axis] = maxs[axis] + 1;
+	}
+
 	// add the axial planes
 	order = 0;
 	for ( axis = 0 ; axis < 3 ; axis++ )
@@ -881,21 +942,36 @@ static void CM_AddFacetBevels( facet_t *facet ) {
 				plane[3] = -mins[axis];
 			}
 			//if it's the surface plane
-			if (CM_PlaneEqual(&planes[facet->surfacePlane], plane, &flipped)) {
+			if (CM_PlaneEqual(&pw->planes[facet->surfacePlane], plane, &flipped)) {
+#ifdef BSPC
+				if ( flipped ) {
+					// no opposite plane to bound this side
+					facet->bounds[0][axis] = -2*MAX_MAP_BOUNDS;
+					facet->bounds[1][axis] = 2*MAX_MAP_BOUNDS;
+				}
+#endif
 				continue;
 			}
 			// see if the plane is already present
 			for ( i = 0 ; i < facet->numBorders ; i++ ) {
-				if (CM_PlaneEqual(&planes[facet->borderPlanes[i]], plane, &flipped))
+				if (CM_PlaneEqual(&pw->planes[facet->borderPlanes[i]], plane, &flipped))
 					break;
 			}
 
+			if ( i < facet->numBorders && flipped != facet->borderInward[i] ) {
+				// present but facing the other way, so it doesn't bound this side
+				facet->bounds[0][axis] = -2*MAX_MAP_BOUNDS;
+				facet->bounds[1][axis] = 2*MAX_MAP_BOUNDS;
+			}
+
 			if ( i == facet->numBorders ) {
 				if ( facet->numBorders >= 4 + 6 + 16 ) {
-					Com_Printf( "ERROR: too many bevels\n" );
+					pw->result->warnings[ PW_TOO_MANY_BEVELS ]++;
+					facet->bounds[0][axis] = -2*MAX_MAP_BOUNDS;
+					facet->bounds[1][axis] = 2*MAX_MAP_BOUNDS;
 					continue;
 				}
-				facet->borderPlanes[facet->numBorders] = CM_FindPlane2(plane, &flipped);
+				facet->borderPlanes[facet->numBorders] = CM_FindPlane2( pw, plane, &flipped );
 				facet->borderNoAdjust[facet->numBorders] = 0;
 				facet->borderInward[facet->numBorders] = flipped;
 				facet->numBorders++;
@@ -947,41 +1023,41 @@ static void CM_AddFacetBevels( facet_t *facet ) {
 					continue;
 
 				//if it's the surface plane
-				if (CM_PlaneEqual(&planes[facet->surfacePlane], plane, &flipped)) {
+				if (CM_PlaneEqual(&pw->planes[facet->surfacePlane], plane, &flipped)) {
 					continue;
 				}
 				// see if the plane is already present
 				for ( i = 0 ; i < facet->numBorders ; i++ ) {
-					if (CM_PlaneEqual(&planes[facet->borderPlanes[i]], plane, &flipped)) {
+					if (CM_PlaneEqual(&pw->planes[facet->borderPlanes[i]], plane, &flipped)) {
 							break;
 					}
 				}
 
 				if ( i == facet->numBorders ) {
 					if ( facet->numBorders >= 4 + 6 + 16 ) {
-						Com_Printf( "ERROR: too many bevels\n" );
+						pw->result->warnings[ PW_TOO_MANY_BEVELS ]++;
 						continue;
 					}
-					facet->borderPlanes[facet->numBorders] = CM_FindPlane2(plane, &flipped);
+					facet->borderPlanes[facet->numBorders] = CM_FindPlane2( pw, plane, &flipped );
 
 					for ( k = 0 ; k < facet->numBorders ; k++ ) {
 						if (facet->borderPlanes[facet->numBorders] ==
-							facet->borderPlanes[k]) Com_Printf("WARNING: bevel plane already used\n");
+							facet->borderPlanes[k]) pw->result->warnings[ PW_BEVEL_PLANE_USED ]++;
 					}
 
 					facet->borderNoAdjust[facet->numBorders] = 0;
 					facet->borderInward[facet->numBorders] = flipped;
 					//
 					w2 = CopyWinding(w);
-					Vector4Copy(planes[facet->borderPlanes[facet->numBorders]].plane, newplane);
+					Vector4Copy(pw->planes[facet->borderPlanes[facet->numBorders]].plane, newplane);
 					if (!facet->borderInward[facet->numBorders])
 					{
 						VectorNegate(newplane, newplane);
 						newplane[3] = -newplane[3];
 					} //end if
-					ChopWindingInPlace( &w2, newplane, newplane[3], 0.1f );
+					ChopWindingInPlace( &w2, newplane, newplane[3], 0.1f, &pw->result->error );
 					if (!w2) {
-						Com_DPrintf("WARNING: CM_AddFacetBevels... invalid bevel\n");
+						pw->result->warnings[ PW_INVALID_BEVEL ]++;
 						continue;
 					}
 					else {
@@ -1000,7 +1076,9 @@ static void CM_AddFacetBevels( facet_t *facet ) {
 #ifndef BSPC
 	//add opposite plane
 	if ( facet->numBorders >= 4 + 6 + 16 ) {
-		Com_Printf( "ERROR: too many bevels\n" );
+		pw->result->warnings[ PW_TOO_MANY_BEVELS ]++;
+		VectorSet( facet->bounds[0], -2*MAX_MAP_BOUNDS, -2*MAX_MAP_BOUNDS, -2*MAX_MAP_BOUNDS );
+		VectorSet( facet->bounds[1], 2*MAX_MAP_BOUNDS, 2*MAX_MAP_BOUNDS, 2*MAX_MAP_BOUNDS );
 		return;
 	}
 	facet->borderPlanes[facet->numBorders] = facet->surfacePlane;
@@ -1023,16 +1101,17 @@ typedef enum {
 CM_PatchCollideFromGrid
 ==================
 */
-static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
+static void CM_PatchCollideFromGrid( patchWork_t *pw ) {
+	const cGrid_t	*grid = &pw->grid;
+	int				(*gridPlanes)[MAX_GRID_SIZE][2] = pw->gridPlanes;
 	int				i, j;
 	const float		*p1, *p2, *p3;
-	int				gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2];
 	facet_t			*facet;
 	int				borders[4];
 	bool		noAdjust[4];
 
-	numPlanes = 0;
-	numFacets = 0;
+	pw->numPlanes = 0;
+	pw->numFacets = 0;
 
 	// find the planes for each triangle of the grid
 	for ( i = 0 ; i < grid->width - 1 ; i++ ) {
@@ -1040,15 +1119,19 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 			p1 = grid->points[i][j];
 			p2 = grid->points[i+1][j];
 			p3 = grid->points[i+1][j+1];
-			gridPlanes[i][j][0] = CM_FindPlane( p1, p2, p3 );
+			gridPlanes[i][j][0] = CM_FindPlane( pw, p1, p2, p3 );
 
 			p1 = grid->points[i+1][j+1];
 			p2 = grid->points[i][j+1];
 			p3 = grid->points[i][j];
-			gridPlanes[i][j][1] = CM_FindPlane( p1, p2, p3 );
+			gridPlanes[i][j][1] = CM_FindPlane( pw, p1, p2, p3 );
 		}
 	}
 
+	if ( pw->result->error ) {
+		return;
+	}
+
 	// create the borders for each facet
 	for ( i = 0 ; i < grid->width - 1 ; i++ ) {
 		for ( j = 0 ; j < grid->height - 1 ; j++ ) {
@@ -1061,7 +1144,7 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 			}
 			noAdjust[EN_TOP] = ( borders[EN_TOP] == gridPlanes[i][j][0] );
 			if ( borders[EN_TOP] == -1 || noAdjust[EN_TOP] ) {
-				borders[EN_TOP] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 0 );
+				borders[EN_TOP] = CM_EdgePlaneNum( pw, grid, gridPlanes, i, j, 0 );
 			}
 
 			borders[EN_BOTTOM] = -1;
@@ -1072,7 +1155,7 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 			}
 			noAdjust[EN_BOTTOM] = ( borders[EN_BOTTOM] == gridPlanes[i][j][1] );
 			if ( borders[EN_BOTTOM] == -1 || noAdjust[EN_BOTTOM] ) {
-				borders[EN_BOTTOM] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 2 );
+				borders[EN_BOTTOM] = CM_EdgePlaneNum( pw, grid, gridPlanes, i, j, 2 );
 			}
 
 			borders[EN_LEFT] = -1;
@@ -1083,7 +1166,7 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 			}
 			noAdjust[EN_LEFT] = ( borders[EN_LEFT] == gridPlanes[i][j][1] );
 			if ( borders[EN_LEFT] == -1 || noAdjust[EN_LEFT] ) {
-				borders[EN_LEFT] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 3 );
+				borders[EN_LEFT] = CM_EdgePlaneNum( pw, grid, gridPlanes, i, j, 3 );
 			}
 
 			borders[EN_RIGHT] = -1;
@@ -1094,13 +1177,14 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 			}
 			noAdjust[EN_RIGHT] = ( borders[EN_RIGHT] == gridPlanes[i][j][0] );
 			if ( borders[EN_RIGHT] == -1 || noAdjust[EN_RIGHT] ) {
-				borders[EN_RIGHT] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 1 );
+				borders[EN_RIGHT] = CM_EdgePlaneNum( pw, grid, gridPlanes, i, j, 1 );
 			}
 
-			if ( numFacets == MAX_FACETS ) {
-				Com_Error( ERR_DROP, "MAX_FACETS" );
+			if ( pw->numFacets == MAX_FACETS ) {
+				pw->result->error = "MAX_FACETS";
+				return;
 			}
-			facet = &facets[numFacets];
+			facet = &pw->facets[pw->numFacets];
 			Com_Memset( facet, 0, sizeof( *facet ) );
 
 			if ( gridPlanes[i][j][0] == gridPlanes[i][j][1] ) {
@@ -1117,10 +1201,10 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 				facet->borderNoAdjust[2] = noAdjust[EN_BOTTOM];
 				facet->borderPlanes[3] = borders[EN_LEFT];
 				facet->borderNoAdjust[3] = noAdjust[EN_LEFT];
-				CM_SetBorderInward( facet, grid, gridPlanes, i, j, -1 );
-				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
-					numFacets++;
+				CM_SetBorderInward( pw, facet, grid, gridPlanes, i, j, -1 );
+				if ( CM_ValidateFacet( pw, facet ) ) {
+					CM_AddFacetBevels( pw, facet );
+					pw->numFacets++;
 				}
 			} else {
 				// two separate triangles
@@ -1134,19 +1218,20 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 				if ( facet->borderPlanes[2] == -1 ) {
 					facet->borderPlanes[2] = borders[EN_BOTTOM];
 					if ( facet->borderPlanes[2] == -1 ) {
-						facet->borderPlanes[2] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 4 );
+						facet->borderPlanes[2] = CM_EdgePlaneNum( pw, grid, gridPlanes, i, j, 4 );
 					}
 				}
- 				CM_SetBorderInward( facet, grid, gridPlanes, i, j, 0 );
-				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
-					numFacets++;
+ 				CM_SetBorderInward( pw, facet, grid, gridPlanes, i, j, 0 );
+				if ( CM_ValidateFacet( pw, facet ) ) {
+					CM_AddFacetBevels( pw, facet );
+					pw->numFacets++;
 				}
 
-				if ( numFacets == MAX_FACETS ) {
-					Com_Error( ERR_DROP, "MAX_FACETS" );
+				if ( pw->numFacets == MAX_FACETS ) {
+					pw->result->error = "MAX_FACETS";
+					return;
 				}
-				facet = &facets[numFacets];
+				facet = &pw->facets[pw->numFacets];
 				Com_Memset( facet, 0, sizeof( *facet ) );
 
 				facet->surfacePlane = gridPlanes[i][j][1];
@@ -1159,93 +1244,318 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 				if ( facet->borderPlanes[2] == -1 ) {
 					facet->borderPlanes[2] = borders[EN_TOP];
 					if ( facet->borderPlanes[2] == -1 ) {
-						facet->borderPlanes[2] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 5 );
+						facet->borderPlanes[2] = CM_EdgePlaneNum( pw, grid, gridPlanes, i, j, 5 );
 					}
 				}
-				CM_SetBorderInward( facet, grid, gridPlanes, i, j, 1 );
-				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
-					numFacets++;
+				CM_SetBorderInward( pw, facet, grid, gridPlanes, i, j, 1 );
+				if ( CM_ValidateFacet( pw, facet ) ) {
+					CM_AddFacetBevels( pw, facet );
+					pw->numFacets++;
 				}
 			}
 		}
 	}
 
-	// copy the results out
-	pf->numPlanes = numPlanes;
-	pf->numFacets = numFacets;
-	pf->facets = Hunk_Alloc( numFacets * sizeof( *pf->facets ), h_high );
-	Com_Memcpy( pf->facets, facets, numFacets * sizeof( *pf->facets ) );
-	pf->planes = Hunk_Alloc( numPlanes * sizeof( *pf->planes ), h_high );
-	Com_Memcpy( pf->planes, planes, numPlanes * sizeof( *pf->planes ) );
 }
 
 
 /*
 ===================
-CM_GeneratePatchCollide
+CM_GeneratePatchFacets
 
-Creates an internal structure that will be used to perform
-collision detection with a patch mesh.
+Subdivides the patch mesh and generates the collision facets for it.
+This may run on a worker thread, so the results are copied out to
+malloc'ed memory and errors are only recorded.
 
 Points are packed as concatenated rows.
 ===================
 */
-struct patchCollide_s *CM_GeneratePatchCollide( int width, int height, vec3_t *points ) {
-	patchCollide_t	*pf;
-	cGrid_t			grid;
+static void CM_GeneratePatchFacets( patchWork_t *pw, const patchSource_t *src, patchResult_t *res ) {
+	cGrid_t			*grid;
 	int				i, j;
 
-	if ( width <= 2 || height <= 2 || !points ) {
-		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: bad parameters: (%i, %i, %p)",
-			width, height, (void *)points );
-	}
-
-	if ( !(width & 1) || !(height & 1) ) {
-		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: even sizes are invalid for quadratic meshes" );
-	}
-
-	if ( width > MAX_GRID_SIZE || height > MAX_GRID_SIZE ) {
-		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: source is > MAX_GRID_SIZE" );
-	}
+	pw->result = res;
+	grid = &pw->grid;
 
 	// build a grid
-	grid.width = width;
-	grid.height = height;
-	grid.wrapWidth = false;
-	grid.wrapHeight = false;
-	for ( i = 0 ; i < width ; i++ ) {
-		for ( j = 0 ; j < height ; j++ ) {
-			VectorCopy( points[j*width + i], grid.points[i][j] );
+	grid->width = src->width;
+	grid->height = src->height;
+	grid->wrapWidth = false;
+	grid->wrapHeight = false;
+	for ( i = 0 ; i < src->width ; i++ ) {
+		for ( j = 0 ; j < src->height ; j++ ) {
+			VectorCopy( src->points[j*src->width + i], grid->points[i][j] );
 		}
 	}
 
 	// subdivide the grid
-	CM_SetGridWrapWidth( &grid );
-	CM_SubdivideGridColumns( &grid );
-	CM_RemoveDegenerateColumns( &grid );
+	CM_SetGridWrapWidth( grid );
+	CM_SubdivideGridColumns( grid );
+	CM_RemoveDegenerateColumns( grid );
 
-	CM_TransposeGrid( &grid );
+	CM_TransposeGrid( grid );
 
-	CM_SetGridWrapWidth( &grid );
-	CM_SubdivideGridColumns( &grid );
-	CM_RemoveDegenerateColumns( &grid );
+	CM_SetGridWrapWidth( grid );
+	CM_SubdivideGridColumns( grid );
+	CM_RemoveDegenerateColumns( grid );
 
 	// we now have a grid of points exactly on the curve
 	// the approximate surface defined by these points will be
 	// collided against
-	pf = Hunk_Alloc( sizeof( *pf ), h_high );
-	ClearBounds( pf->bounds[0], pf->bounds[1] );
-	for ( i = 0 ; i < grid.width ; i++ ) {
-		for ( j = 0 ; j < grid.height ; j++ ) {
-			AddPointToBounds( grid.points[i][j], pf->bounds[0], pf->bounds[1] );
+	ClearBounds( res->bounds[0], res->bounds[1] );
+	for ( i = 0 ; i < grid->width ; i++ ) {
+		for ( j = 0 ; j < grid->height ; j++ ) {
+			AddPointToBounds( grid->points[i][j], res->bounds[0], res->bounds[1] );
 		}
 	}
 
-	c_totalPatchBlocks += ( grid.width - 1 ) * ( grid.height - 1 );
+	res->numBlocks = ( grid->width - 1 ) * ( grid->height - 1 );
 
 	// generate a bsp tree for the surface
-	CM_PatchCollideFromGrid( &grid, pf );
+	CM_PatchCollideFromGrid( pw );
+
+	if ( res->error ) {
+		return;
+	}
+
+	// copy the results out
+	res->numPlanes = pw->numPlanes;
+	res->numFacets = pw->numFacets;
+	res->facets = malloc( pw->numFacets * sizeof( *res->facets ) + 1 );
+	res->planes = malloc( pw->numPlanes * sizeof( *res->planes ) + 1 );
+	if ( !res->facets || !res->planes ) {
+		res->error = "CM_GeneratePatchFacets: out of memory";
+		return;
+	}
+	Com_Memcpy( res->facets, pw->facets, pw->numFacets * sizeof( *res->facets ) );
+	Com_Memcpy( res->planes, pw->planes, pw->numPlanes * sizeof( *res->planes ) );
+}
+
+
+/*
+===================
+CM_FreePatchResult
+===================
+*/
+static void CM_FreePatchResult( patchResult_t *res ) {
+	free( res->facets );
+	free( res->planes );
+	res->facets = NULL;
+	res->planes = NULL;
+}
+
+
+/*
+===================
+CM_CompareFacetCenters
+===================
+*/
+static const facet_t	*sortFacets;
+static int				sortAxis;
+
+static int CM_CompareFacetCenters( const void *a, const void *b ) {
+	const int fa = *(const int *)a;
+	const int fb = *(const int *)b;
+	const float ca = sortFacets[ fa ].bounds[0][ sortAxis ] + sortFacets[ fa ].bounds[1][ sortAxis ];
+	const float cb = sortFacets[ fb ].bounds[0][ sortAxis ] + sortFacets[ fb ].bounds[1][ sortAxis ];
+
+	if ( ca < cb ) {
+		return -1;
+	}
+	if ( ca > cb ) {
+		return 1;
+	}
+	return fa - fb;
+}
+
+
+/*
+===================
+CM_BuildFacetNodes_r
+
+Splits the facets in half along the longest axis of their centers until
+there are only a few left in each node. Every split leaves at least two
+facets on each side, so numFacets nodes are always enough.
+===================
+*/
+#define	MAX_NODE_FACETS		4
+
+static int CM_BuildFacetNodes_r( patchCollide_t *pc, int firstFacet, int numFacets ) {
+	patchNode_t		*node;
+	const facet_t	*facet;
+	vec3_t			mins, maxs, center;
+	int				nodeNum, half;
+	int				i;
+
+	nodeNum = pc->numNodes++;
+	node = &pc->nodes[ nodeNum ];
+
+	ClearBounds( node->bounds[0], node->bounds[1] );
+	ClearBounds( mins, maxs );
+	for ( i = firstFacet ; i < firstFacet + numFacets ; i++ ) {
+		facet = &pc->facets[ pc->facetOrder[ i ] ];
+		AddPointToBounds( facet->bounds[0], node->bounds[0], node->bounds[1] );
+		AddPointToBounds( facet->bounds[1], node->bounds[0], node->bounds[1] );
+		VectorAdd( facet->bounds[0], facet->bounds[1], center );
+		AddPointToBounds( center, mins, maxs );
+	}
+
+	node->firstFacet = firstFacet;
+	node->numFacets = numFacets;
+	node->secondChild = 0;
+
+	if ( numFacets <= MAX_NODE_FACETS ) {
+		return nodeNum;
+	}
+
+	VectorSubtract( maxs, mins, center );
+	sortAxis = 0;
+	if ( center[1] > center[sortAxis] ) {
+		sortAxis = 1;
+	}
+	if ( center[2] > center[sortAxis] ) {
+		sortAxis = 2;
+	}
+	sortFacets = pc->facets;
+	qsort( pc->facetOrder + firstFacet, numFacets, sizeof( pc->facetOrder[0] ), CM_CompareFacetCenters );
+
+	half = numFacets / 2;
+	node->numFacets = 0;
+	CM_BuildFacetNodes_r( pc, firstFacet, half );
+	i = CM_BuildFacetNodes_r( pc, firstFacet + half, numFacets - half );
+	pc->nodes[ nodeNum ].secondChild = i;
+
+	return nodeNum;
+}
+
+
+/*
+===================
+CM_BuildPatchTraceData
+
+Repacks the facet planes for CM_FacetPlaneDistances and builds
+the facet hierarchy. Generated and cached patches both go through here.
+===================
+*/
+void CM_BuildPatchTraceData( patchCollide_t *pc ) {
+	const facet_t		*facet;
+	const patchPlane_t	*pp;
+	int					i, j, n;
+
+	pc->numFacetPlanes = 0;
+	pc->numNodes = 0;
+
+	if ( pc->numFacets <= 0 ) {
+		return;
+	}
+
+	for ( i = 0, facet = pc->facets ; i < pc->numFacets ; i++, facet++ ) {
+		pc->numFacetPlanes += ( facet->numBorders + 1 + 3 ) & ~3;
+	}
+
+	pc->facetPlanes = Hunk_Alloc( pc->numFacets * sizeof( pc->facetPlanes[0] ), h_high );
+	pc->fpNormal[0] = Hunk_Alloc( pc->numFacetPlanes * sizeof( float ), h_high );
+	pc->fpNormal[1] = Hunk_Alloc( pc->numFacetPlanes * sizeof( float ), h_high );
+	pc->fpNormal[2] = Hunk_Alloc( pc->numFacetPlanes * sizeof( float ), h_high );
+	pc->fpDist = Hunk_Alloc( pc->numFacetPlanes * sizeof( float ), h_high );
+	pc->fpFlags = Hunk_Alloc( pc->numFacetPlanes * sizeof( int ), h_high );
+
+	for ( i = 0, n = 0, facet = pc->facets ; i < pc->numFacets ; i++, facet++ ) {
+		pc->facetPlanes[i] = n;
+
+		pp = &pc->planes[ facet->surfacePlane ];
+		pc->fpNormal[0][n] = pp->plane[0];
+		pc->fpNormal[1][n] = pp->plane[1];
+		pc->fpNormal[2][n] = pp->plane[2];
+		pc->fpDist[n] = pp->plane[3];
+		pc->fpFlags[n] = pp->signbits;
+		n++;
+
+		for ( j = 0 ; j < facet->numBorders ; j++, n++ ) {
+			pp = &pc->planes[ facet->borderPlanes[j] ];
+			if ( facet->borderInward[j] ) {
+				pc->fpNormal[0][n] = -pp->plane[0];
+				pc->fpNormal[1][n] = -pp->plane[1];
+				pc->fpNormal[2][n] = -pp->plane[2];
+				pc->fpDist[n] = -pp->plane[3];
+			} else {
+				pc->fpNormal[0][n] = pp->plane[0];
+				pc->fpNormal[1][n] = pp->plane[1];
+				pc->fpNormal[2][n] = pp->plane[2];
+				pc->fpDist[n] = pp->plane[3];
+			}
+			pc->fpFlags[n] = pp->signbits | FACET_PLANE_BORDER;
+		}
+
+		// padding planes are far behind everything and never relevant
+		for ( ; n & 3 ; n++ ) {
+			pc->fpNormal[0][n] = 0;
+			pc->fpNormal[1][n] = 0;
+			pc->fpNormal[2][n] = 0;
+			pc->fpDist[n] = 1.0e30f;
+			pc->fpFlags[n] = FACET_PLANE_BORDER;
+		}
+	}
+
+	pc->facetOrder = Hunk_Alloc( pc->numFacets * sizeof( pc->facetOrder[0] ), h_high );
+	for ( i = 0 ; i < pc->numFacets ; i++ ) {
+		pc->facetOrder[i] = i;
+	}
+
+	pc->nodes = Hunk_Alloc( pc->numFacets * sizeof( pc->nodes[0] ), h_high );
+	CM_BuildFacetNodes_r( pc, 0, pc->numFacets );
+}
+
+
+/*
+===================
+CM_StorePatchCollide
+
+Reports warnings and moves the generated data to the hunk.
+===================
+*/
+static patchCollide_t *CM_StorePatchCollide( patchResult_t *res ) {
+	patchCollide_t	*pf;
+	int				i;
+
+	for ( i = 0 ; i < PW_NUM_WARNINGS ; i++ ) {
+		if ( !res->warnings[i] ) {
+			continue;
+		}
+		if ( patchWarnings[i].developer ) {
+			if ( res->warnings[i] == 1 )
+				Com_DPrintf( "%s\n", patchWarnings[i].text );
+			else
+				Com_DPrintf( "%s (%i times)\n", patchWarnings[i].text, res->warnings[i] );
+		} else {
+			if ( res->warnings[i] == 1 )
+				Com_Printf( "%s\n", patchWarnings[i].text );
+			else
+				Com_Printf( "%s (%i times)\n", patchWarnings[i].text, res->warnings[i] );
+		}
+	}
+
+	if ( res->debugBlock && !debugBlock ) {
+		debugBlock = true;
+		Com_Memcpy( debugBlockPoints, res->debugBlockPoints, sizeof( debugBlockPoints ) );
+	}
+
+	c_totalPatchBlocks += res->numBlocks;
+
+	pf = Hunk_Alloc( sizeof( *pf ), h_high );
+	VectorCopy( res->bounds[0], pf->bounds[0] );
+	VectorCopy( res->bounds[1], pf->bounds[1] );
+
+	pf->numPlanes = res->numPlanes;
+	pf->numFacets = res->numFacets;
+	pf->facets = Hunk_Alloc( res->numFacets * sizeof( *pf->facets ), h_high );
+	Com_Memcpy( pf->facets, res->facets, res->numFacets * sizeof( *pf->facets ) );
+	pf->planes = Hunk_Alloc( res->numPlanes * sizeof( *pf->planes ), h_high );
+	Com_Memcpy( pf->planes, res->planes, res->numPlanes * sizeof( *pf->planes ) );
+
+	CM_FreePatchResult( res );
+
+	CM_BuildPatchTraceData( pf );
 
 	// expand by one unit for epsilon purposes
 	pf->bounds[0][0] -= 1;
@@ -1259,6 +1569,132 @@ struct patchCollide_s *CM_GeneratePatchCollide( int width, int height, vec3_t *p
 	return pf;
 }
 
+
+typedef struct {
+	const patchSource_t	*sources;
+	patchResult_t		*results;
+	patchWork_t			*work;		// one per thread
+} patchJobs_t;
+
+static void CM_PatchCollideJob( void *data, int index, int thread ) {
+	patchJobs_t *jobs = (patchJobs_t *)data;
+
+	CM_GeneratePatchFacets( &jobs->work[ thread ], &jobs->sources[ index ], &jobs->results[ index ] );
+}
+
+
+/*
+===================
+CM_GeneratePatchCollides
+
+Creates the internal structures that will be used to perform
+collision detection with the patch meshes.
+
+Patches don't share any generation state, so they are spread over the
+worker threads and then stored to the hunk in source order, which keeps
+the results identical to generating them one by one.
+===================
+*/
+void CM_GeneratePatchCollides( patchSource_t *sources, int count ) {
+	patchJobs_t		jobs;
+	patchResult_t	*results;
+	const char		*error;
+	int				numThreads;
+	int				i;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		const patchSource_t *src = &sources[i];
+
+		if ( src->width <= 2 || src->height <= 2 || !src->points ) {
+			Com_Error( ERR_DROP, "CM_GeneratePatchFacets: bad parameters: (%i, %i, %p)",
+				src->width, src->height, (const void *)src->points );
+		}
+
+		if ( !(src->width & 1) || !(src->height & 1) ) {
+			Com_Error( ERR_DROP, "CM_GeneratePatchFacets: even sizes are invalid for quadratic meshes" );
+		}
+
+		if ( src->width > MAX_GRID_SIZE || src->height > MAX_GRID_SIZE ) {
+			Com_Error( ERR_DROP, "CM_GeneratePatchFacets: source is > MAX_GRID_SIZE" );
+		}
+	}
+
+	if ( count <= 0 ) {
+		return;
+	}
+
+#ifdef BSPC
+	numThreads = 1;
+#else
+	numThreads = Com_JobWorkers() + 1;
+#endif
+
+	results = Hunk_AllocateTempMemory( count * sizeof( *results ) );
+	Com_Memset( results, 0, count * sizeof( *results ) );
+
+	jobs.sources = sources;
+	jobs.results = results;
+	jobs.work = malloc( numThreads * sizeof( *jobs.work ) );
+	if ( !jobs.work ) {
+		Hunk_FreeTempMemory( results );
+		Com_Error( ERR_DROP, "CM_GeneratePatchCollides: failed to allocate work space" );
+	}
+
+#ifdef BSPC
+	for ( i = 0 ; i < count ; i++ ) {
+		CM_PatchCollideJob( &jobs, i, 0 );
+	}
+#else
+	Com_ParallelFor( count, CM_PatchCollideJob, &jobs );
+#endif
+
+	free( jobs.work );
+
+	// report the first error in source order
+	error = NULL;
+	for ( i = 0 ; i < count && !error ; i++ ) {
+		error = results[i].error;
+	}
+
+	if ( error ) {
+		for ( i = 0 ; i < count ; i++ ) {
+			CM_FreePatchResult( &results[i] );
+		}
+		Hunk_FreeTempMemory( results );
+		Com_Error( ERR_DROP, "%s", error );
+	}
+
+	for ( i = 0 ; i < count ; i++ ) {
+		sources[i].pc = CM_StorePatchCollide( &results[i] );
+	}
+
+	Hunk_FreeTempMemory( results );
+}
+
+
+/*
+===================
+CM_GeneratePatchCollide
+
+Creates an internal structure that will be used to perform
+collision detection with a patch mesh.
+
+Points are packed as concatenated rows.
+===================
+*/
+struct patchCollide_s *CM_GeneratePatchCollide( int width, int height, vec3_t *points ) {
+	patchSource_t	src;
+
+	src.width = width;
+	src.height = height;
+	src.points = (const vec3_t *)points;
+	src.pc = NULL;
+
+	CM_GeneratePatchCollides( &src, 1 );
+
+	return src.pc;
+}
+
 /*
 ================================================================================
 
@@ -1375,22 +1811,14 @@ static void CM_TracePointThroughPatchCollide( traceWork_t *tw, const struct patc
 CM_CheckFacetPlane
 ====================
 */
-static int CM_CheckFacetPlane( const float *plane, const vec3_t start, const vec3_t end, float *enterFrac, float *leaveFrac, int *hit ) {
-	float d1, d2, f;
+static void CM_CheckFacetPlane( float d1, float d2, float *enterFrac, float *leaveFrac, int *hit ) {
+	float f;
 
 	*hit = false;
 
-	d1 = DotProduct( start, plane ) - plane[3];
-	d2 = DotProduct( end, plane ) - plane[3];
-
-	// if completely in front of face, no intersection with the entire facet
-	if (d1 > 0 && ( d2 >= SURFACE_CLIP_EPSILON || d2 >= d1 )  ) {
-		return false;
-	}
-
 	// if it doesn't cross the plane, the plane isn't relevant
 	if (d1 <= 0 && d2 <= 0 ) {
-		return true;
+		return;
 	}
 
 	// crosses face
@@ -1413,53 +1841,115 @@ static int CM_CheckFacetPlane( const float *plane, const vec3_t start, const vec
 			*leaveFrac = f;
 		}
 	}
-	return true;
 }
 
 
 /*
 ====================
-CM_TraceThroughPatchCollide
+CM_FacetPlaneDistances
+
+Expands all planes of the facet by the trace volume and calculates the
+distances of the trace start and end points to them. Returns false if
+the trace is completely in front of any of the planes, in which case it
+can't touch the facet at all.
+
+The arithmetic matches the scalar plane by plane code exactly, so the
+vectorized path returns bit-identical results.
 ====================
 */
-void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc ) {
-	int i, j, hit, hitnum;
-	float offset, enterFrac, leaveFrac, t;
-	patchPlane_t *pp;
-	facet_t	*facet;
-	float plane[4], bestplane[4];
-	vec3_t startp, endp;
-#ifndef BSPC
-	static cvar_t *cv;
-#endif //BSPC
+#if idx64
+#define SELECT_PS( mask, a, b )	_mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) )
+#define FLAG_MASK( flags, bit )	_mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( flags, _mm_set1_epi32( bit ) ), _mm_set1_epi32( bit ) ) )
+
+static bool CM_FacetPlaneDistances( const traceWork_t *tw, const patchCollide_t *pc, int facetNum, float *dist, float *d1, float *d2 ) {
+	const int first = pc->facetPlanes[ facetNum ];
+	const int count = ( pc->facets[ facetNum ].numBorders + 1 + 3 ) & ~3;
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 eps = _mm_set1_ps( SURFACE_CLIP_EPSILON );
+	const __m128 signMask = _mm_castsi128_ps( _mm_set1_epi32( 0x80000000 ) );
+	__m128 nx, ny, nz, d, t, m, offset, ox, oy, oz, sx, sy, sz, ex, ey, ez, v1, v2, front;
+	__m128i flags;
+	int i;
 
-	if ( !CM_BoundsIntersect( tw->bounds[0], tw->bounds[1],
-				pc->bounds[0], pc->bounds[1] ) ) {
-		return;
-	}
+	for ( i = 0; i < count; i += 4 ) {
+		nx = _mm_loadu_ps( pc->fpNormal[0] + first + i );
+		ny = _mm_loadu_ps( pc->fpNormal[1] + first + i );
+		nz = _mm_loadu_ps( pc->fpNormal[2] + first + i );
+		d = _mm_loadu_ps( pc->fpDist + first + i );
 
-	if (tw->isPoint) {
-		CM_TracePointThroughPatchCollide( tw, pc );
-		return;
+		sx = _mm_set1_ps( tw->start[0] );
+		sy = _mm_set1_ps( tw->start[1] );
+		sz = _mm_set1_ps( tw->start[2] );
+		ex = _mm_set1_ps( tw->end[0] );
+		ey = _mm_set1_ps( tw->end[1] );
+		ez = _mm_set1_ps( tw->end[2] );
+
+		if ( tw->sphere.use ) {
+			// adjust the plane distance appropriately for radius
+			d = _mm_add_ps( d, _mm_set1_ps( tw->sphere.radius ) );
+
+			// find the closest point on the capsule to the plane
+			ox = _mm_set1_ps( tw->sphere.offset[0] );
+			oy = _mm_set1_ps( tw->sphere.offset[1] );
+			oz = _mm_set1_ps( tw->sphere.offset[2] );
+			t = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, ox ), _mm_mul_ps( ny, oy ) ), _mm_mul_ps( nz, oz ) );
+			m = _mm_cmpgt_ps( t, zero );
+			sx = SELECT_PS( m, _mm_sub_ps( sx, ox ), _mm_add_ps( sx, ox ) );
+			sy = SELECT_PS( m, _mm_sub_ps( sy, oy ), _mm_add_ps( sy, oy ) );
+			sz = SELECT_PS( m, _mm_sub_ps( sz, oz ), _mm_add_ps( sz, oz ) );
+			ex = SELECT_PS( m, _mm_sub_ps( ex, ox ), _mm_add_ps( ex, ox ) );
+			ey = SELECT_PS( m, _mm_sub_ps( ey, oy ), _mm_add_ps( ey, oy ) );
+			ez = SELECT_PS( m, _mm_sub_ps( ez, oz ), _mm_add_ps( ez, oz ) );
+		} else {
+			// select the box corner by the signbits of the source plane
+			flags = _mm_loadu_si128( (const __m128i *)( pc->fpFlags + first + i ) );
+			ox = SELECT_PS( FLAG_MASK( flags, 1 ), _mm_set1_ps( tw->offsets[7][0] ), _mm_set1_ps( tw->offsets[0][0] ) );
+			oy = SELECT_PS( FLAG_MASK( flags, 2 ), _mm_set1_ps( tw->offsets[7][1] ), _mm_set1_ps( tw->offsets[0][1] ) );
+			oz = SELECT_PS( FLAG_MASK( flags, 4 ), _mm_set1_ps( tw->offsets[7][2] ), _mm_set1_ps( tw->offsets[0][2] ) );
+			offset = _mm_add_ps( _mm_add_ps( _mm_mul_ps( ox, nx ), _mm_mul_ps( oy, ny ) ), _mm_mul_ps( oz, nz ) );
+
+			// surface planes are moved by -offset, borders by fabs( offset )
+			d = _mm_add_ps( d, SELECT_PS( FLAG_MASK( flags, FACET_PLANE_BORDER ),
+				_mm_andnot_ps( signMask, offset ), _mm_xor_ps( signMask, offset ) ) );
+		}
+
+		v1 = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( sx, nx ), _mm_mul_ps( sy, ny ) ), _mm_mul_ps( sz, nz ) ), d );
+		v2 = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( ex, nx ), _mm_mul_ps( ey, ny ) ), _mm_mul_ps( ez, nz ) ), d );
+
+		// if completely in front of face, no intersection with the entire facet
+		front = _mm_and_ps( _mm_cmpgt_ps( v1, zero ), _mm_or_ps( _mm_cmpge_ps( v2, eps ), _mm_cmpge_ps( v2, v1 ) ) );
+		if ( _mm_movemask_ps( front ) ) {
+			return false;
+		}
+
+		_mm_storeu_ps( dist + i, d );
+		_mm_storeu_ps( d1 + i, v1 );
+		_mm_storeu_ps( d2 + i, v2 );
 	}
 
-	Vector4Set(bestplane, 0, 0, 0, 0);
+	return true;
+}
+#else
+static bool CM_FacetPlaneDistances( const traceWork_t *tw, const patchCollide_t *pc, int facetNum, float *dist, float *d1, float *d2 ) {
+	const int first = pc->facetPlanes[ facetNum ];
+	const int count = pc->facets[ facetNum ].numBorders + 1;
+	vec3_t normal, startp, endp;
+	float offset, t;
+	int i, flags;
+
+	for ( i = 0; i < count; i++ ) {
+		normal[0] = pc->fpNormal[0][ first + i ];
+		normal[1] = pc->fpNormal[1][ first + i ];
+		normal[2] = pc->fpNormal[2][ first + i ];
+		dist[i] = pc->fpDist[ first + i ];
+		flags = pc->fpFlags[ first + i ];
 
-	facet = pc->facets;
-	for ( i = 0 ; i < pc->numFacets ; i++, facet++ ) {
-		enterFrac = -1.0;
-		leaveFrac = 1.0;
-		hitnum = -1;
-		//
-		pp = &pc->planes[ facet->surfacePlane ];
-		VectorCopy(pp->plane, plane);
-		plane[3] = pp->plane[3];
 		if ( tw->sphere.use ) {
 			// adjust the plane distance appropriately for radius
-			plane[3] += tw->sphere.radius;
+			dist[i] += tw->sphere.radius;
 
 			// find the closest point on the capsule to the plane
-			t = DotProduct( plane, tw->sphere.offset );
+			t = DotProduct( normal, tw->sphere.offset );
 			if ( t > 0.0f ) {
 				VectorSubtract( tw->start, tw->sphere.offset, startp );
 				VectorSubtract( tw->end, tw->sphere.offset, endp );
@@ -1470,82 +1960,122 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *
 			}
 		}
 		else {
-			offset = DotProduct( tw->offsets[ pp->signbits ], plane );
-			plane[3] -= offset;
+			offset = DotProduct( tw->offsets[ flags & 7 ], normal );
+			if ( flags & FACET_PLANE_BORDER ) {
+				// NOTE: this works even though the plane might be flipped because the bbox is centered
+				dist[i] += fabs( offset );
+			} else {
+				dist[i] -= offset;
+			}
 			VectorCopy( tw->start, startp );
 			VectorCopy( tw->end, endp );
 		}
 
-		if (!CM_CheckFacetPlane(plane, startp, endp, &enterFrac, &leaveFrac, &hit)) {
+		d1[i] = DotProduct( startp, normal ) - dist[i];
+		d2[i] = DotProduct( endp, normal ) - dist[i];
+
+		// if completely in front of face, no intersection with the entire facet
+		if ( d1[i] > 0 && ( d2[i] >= SURFACE_CLIP_EPSILON || d2[i] >= d1[i] ) ) {
+			return false;
+		}
+	}
+
+	return true;
+}
+#endif
+
+
+#define	MAX_NODE_STACK		64
+
+/*
+====================
+CM_TraceThroughPatchCollide
+
+Facets are visited through the bounding volume hierarchy, so among
+facets hit at the same fraction the lowest numbered one is preferred
+to pick the same plane as walking them in order.
+====================
+*/
+void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc ) {
+	float dist[ MAX_FACET_PLANES ], d1[ MAX_FACET_PLANES ], d2[ MAX_FACET_PLANES ];
+	int stack[ MAX_NODE_STACK ];
+	int i, j, k, hit, hitnum, best, bestFacet, numStack, first;
+	float enterFrac, leaveFrac;
+	const patchNode_t *node;
+	const facet_t *facet;
+#ifndef BSPC
+	static cvar_t *cv;
+#endif //BSPC
+
+	if ( !CM_BoundsIntersect( tw->bounds[0], tw->bounds[1],
+				pc->bounds[0], pc->bounds[1] ) ) {
+		return;
+	}
+
+	if (tw->isPoint) {
+		CM_TracePointThroughPatchCollide( tw, pc );
+		return;
+	}
+
+	if ( !pc->numNodes ) {
+		return;
+	}
+
+	bestFacet = -1;
+	stack[0] = 0;
+	numStack = 1;
+	while ( numStack ) {
+		node = &pc->nodes[ stack[ --numStack ] ];
+		if ( !CM_BoundsIntersect( tw->bounds[0], tw->bounds[1], node->bounds[0], node->bounds[1] ) ) {
 			continue;
 		}
-		if (hit) {
-			Vector4Copy(plane, bestplane);
+		if ( node->secondChild ) {
+			stack[ numStack++ ] = node->secondChild;
+			stack[ numStack++ ] = node - pc->nodes + 1;
+			continue;
 		}
 
-		for ( j = 0; j < facet->numBorders; j++ ) {
-			pp = &pc->planes[ facet->borderPlanes[j] ];
-			if (facet->borderInward[j]) {
-				VectorNegate(pp->plane, plane);
-				plane[3] = -pp->plane[3];
-			}
-			else {
-				VectorCopy(pp->plane, plane);
-				plane[3] = pp->plane[3];
+		for ( k = 0 ; k < node->numFacets ; k++ ) {
+			i = pc->facetOrder[ node->firstFacet + k ];
+			if ( !CM_FacetPlaneDistances( tw, pc, i, dist, d1, d2 ) ) {
+				continue;
 			}
-			if ( tw->sphere.use ) {
-				// adjust the plane distance appropriately for radius
-				plane[3] += tw->sphere.radius;
-
-				// find the closest point on the capsule to the plane
-				t = DotProduct( plane, tw->sphere.offset );
-				if ( t > 0.0f ) {
-					VectorSubtract( tw->start, tw->sphere.offset, startp );
-					VectorSubtract( tw->end, tw->sphere.offset, endp );
-				}
-				else {
-					VectorAdd( tw->start, tw->sphere.offset, startp );
-					VectorAdd( tw->end, tw->sphere.offset, endp );
+			facet = &pc->facets[ i ];
+
+			enterFrac = -1.0;
+			leaveFrac = 1.0;
+			hitnum = -1;
+			best = 0;
+			// surface plane first, then the borders
+			for ( j = 0 ; j <= facet->numBorders ; j++ ) {
+				CM_CheckFacetPlane( d1[j], d2[j], &enterFrac, &leaveFrac, &hit );
+				if ( hit ) {
+					hitnum = j - 1;
+					best = j;
 				}
 			}
-			else {
-				// NOTE: this works even though the plane might be flipped because the bbox is centered
-				offset = DotProduct( tw->offsets[ pp->signbits ], plane );
-				plane[3] += fabs(offset);
-				VectorCopy( tw->start, startp );
-				VectorCopy( tw->end, endp );
-			}
-
-			if (!CM_CheckFacetPlane(plane, startp, endp, &enterFrac, &leaveFrac, &hit)) {
-				break;
-			}
-			if (hit) {
-				hitnum = j;
-				Vector4Copy(plane, bestplane);
-			}
-		}
-		if (j < facet->numBorders) continue;
-		//never clip against the back side
-		if (hitnum == facet->numBorders - 1) continue;
+			//never clip against the back side
+			if (hitnum == facet->numBorders - 1) continue;
 
-		if (enterFrac < leaveFrac && enterFrac >= 0) {
-			if (enterFrac < tw->trace.fraction) {
-				//if (enterFrac < 0) {
-				//	enterFrac = 0;
-				//}
+			if (enterFrac < leaveFrac && enterFrac >= 0) {
+				if ( enterFrac < tw->trace.fraction || ( enterFrac == tw->trace.fraction && bestFacet > i ) ) {
 #ifndef BSPC
-				if (!cv) {
-					cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
-				}
-				if (cv && cv->integer) {
-					debugPatchCollide = pc;
-					debugFacet = facet;
-				}
+					if (!cv) {
+						cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
+					}
+					if (cv && cv->integer) {
+						debugPatchCollide = pc;
+						debugFacet = facet;
+					}
 #endif //BSPC
-
-				tw->trace.fraction = enterFrac;
-				VectorCopy( bestplane, tw->trace.plane.normal );
-				tw->trace.plane.dist = bestplane[3];
+					bestFacet = i;
+					first = pc->facetPlanes[ i ] + best;
+					tw->trace.fraction = enterFrac;
+					tw->trace.plane.normal[0] = pc->fpNormal[0][ first ];
+					tw->trace.plane.normal[1] = pc->fpNormal[1][ first ];
+					tw->trace.plane.normal[2] = pc->fpNormal[2][ first ];
+					tw->trace.plane.dist = dist[ best ];
+				}
 			}
 		}
 	}
@@ -1566,85 +2096,43 @@ CM_PositionTestInPatchCollide
 ====================
 */
 bool CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc ) {
-	int i, j;
-	float offset, t;
-	patchPlane_t *pp;
-	facet_t	*facet;
-	float plane[4];
-	vec3_t startp;
+	float dist[ MAX_FACET_PLANES ], d1[ MAX_FACET_PLANES ], d2[ MAX_FACET_PLANES ];
+	int stack[ MAX_NODE_STACK ];
+	int i, k, numStack;
+	const patchNode_t *node;
 
 	if (tw->isPoint) {
 		return false;
 	}
-	//
-	facet = pc->facets;
-	for ( i = 0 ; i < pc->numFacets ; i++, facet++ ) {
-		pp = &pc->planes[ facet->surfacePlane ];
-		VectorCopy(pp->plane, plane);
-		plane[3] = pp->plane[3];
-		if ( tw->sphere.use ) {
-			// adjust the plane distance appropriately for radius
-			plane[3] += tw->sphere.radius;
 
-			// find the closest point on the capsule to the plane
-			t = DotProduct( plane, tw->sphere.offset );
-			if ( t > 0 ) {
-				VectorSubtract( tw->start, tw->sphere.offset, startp );
-			}
-			else {
-				VectorAdd( tw->start, tw->sphere.offset, startp );
-			}
-		}
-		else {
-			offset = DotProduct( tw->offsets[ pp->signbits ], plane);
-			plane[3] -= offset;
-			VectorCopy( tw->start, startp );
-		}
+	if ( !pc->numNodes ) {
+		return false;
+	}
 
-		if ( DotProduct( plane, startp ) - plane[3] > 0.0f ) {
+	// start and end are the same here, so a facet contains the
+	// trace volume if it isn't in front of any of its planes
+	stack[0] = 0;
+	numStack = 1;
+	while ( numStack ) {
+		node = &pc->nodes[ stack[ --numStack ] ];
+		if ( !CM_BoundsIntersect( tw->bounds[0], tw->bounds[1], node->bounds[0], node->bounds[1] ) ) {
+			continue;
+		}
+		if ( node->secondChild ) {
+			stack[ numStack++ ] = node->secondChild;
+			stack[ numStack++ ] = node - pc->nodes + 1;
 			continue;
 		}
 
-		for ( j = 0; j < facet->numBorders; j++ ) {
-			pp = &pc->planes[ facet->borderPlanes[j] ];
-			if (facet->borderInward[j]) {
-				VectorNegate(pp->plane, plane);
-				plane[3] = -pp->plane[3];
-			}
-			else {
-				VectorCopy(pp->plane, plane);
-				plane[3] = pp->plane[3];
-			}
-			if ( tw->sphere.use ) {
-				// adjust the plane distance appropriately for radius
-				plane[3] += tw->sphere.radius;
-
-				// find the closest point on the capsule to the plane
-				t = DotProduct( plane, tw->sphere.offset );
-				if ( t > 0.0f ) {
-					VectorSubtract( tw->start, tw->sphere.offset, startp );
-				}
-				else {
-					VectorAdd( tw->start, tw->sphere.offset, startp );
-				}
-			}
-			else {
-				// NOTE: this works even though the plane might be flipped because the bbox is centered
-				offset = DotProduct( tw->offsets[ pp->signbits ], plane);
-				plane[3] += fabs(offset);
-				VectorCopy( tw->start, startp );
-			}
-
-			if ( DotProduct( plane, startp ) - plane[3] > 0.0f ) {
-				break;
+		for ( k = 0 ; k < node->numFacets ; k++ ) {
+			i = pc->facetOrder[ node->firstFacet + k ];
+			if ( CM_FacetPlaneDistances( tw, pc, i, dist, d1, d2 ) ) {
+				// inside this patch facet
+				return true;
 			}
 		}
-		if (j < facet->numBorders) {
-			continue;
-		}
-		// inside this patch facet
-		return true;
 	}
+
 	return false;
 }
 
@@ -1740,7 +2228,7 @@ void CM_DrawDebugSurface( void (*drawPoly)(int color, int numPoints, float *poin
 			plane[3] += fabs(DotProduct(v1, v2));
 			//*/
 
-			w = BaseWindingForPlane( plane,  plane[3] );
+			w = BaseWindingForPlane( plane,  plane[3], NULL );
 			for ( j = 0 ; j < facet->numBorders + 1 && w; j++ ) {
 				//
 				if (j < facet->numBorders) {
@@ -1771,7 +2259,7 @@ void CM_DrawDebugSurface( void (*drawPoly)(int color, int numPoints, float *poin
 				VectorNegate(plane, v2);
 				plane[3] -= fabs(DotProduct(v1, v2));
 
-				ChopWindingInPlace( &w, plane, plane[3], 0.1f );
+				ChopWindingInPlace( &w, plane, plane[3], 0.1f, NULL );
 			}
 			if ( w ) {
 				if ( facet == debugFacet ) {
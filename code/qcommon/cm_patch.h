@@ -74,14 +74,38 @@ typedef struct {
 	int			borderPlanes[4+6+16];
 	int			borderInward[4+6+16];
 	bool	borderNoAdjust[4+6+16];
+	vec3_t		bounds[2];		// enclosed by the axial bevels, for culling
 } facet_t;
 
+// facet planes are repacked as structure of arrays, one group per facet
+// with the surface plane first and the borders already flipped inward,
+// padded to a multiple of four so they can be tested four at a time
+#define	FACET_PLANE_BORDER	8	// flags are source plane signbits + this
+#define	MAX_FACET_PLANES	( ( 1 + 4+6+16 + 3 ) & ~3 )
+
+typedef struct {
+	vec3_t	bounds[2];
+	int		secondChild;		// first child follows the node, 0 for leafs
+	int		firstFacet;			// into facetOrder
+	int		numFacets;
+} patchNode_t;
+
 typedef struct patchCollide_s {
 	vec3_t	bounds[2];
 	int		numPlanes;			// surface planes plus edge planes
 	patchPlane_t	*planes;
 	int		numFacets;
 	facet_t	*facets;
+
+	// derived from the facets by CM_BuildPatchTraceData
+	int		*facetPlanes;		// [numFacets] first facet plane, a multiple of 4
+	int		numFacetPlanes;
+	float	*fpNormal[3];
+	float	*fpDist;
+	int		*fpFlags;
+	int		numNodes;
+	patchNode_t	*nodes;			// facet bounding volume hierarchy
+	int		*facetOrder;
 } patchCollide_t;
 
 
@@ -101,3 +125,4 @@ typedef struct {
 
 
 struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *points );
+void CM_BuildPatchTraceData( patchCollide_t *pc );
@@ -26,13 +26,6 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "cm_local.h"
 
 
-// counters are only bumped when running single threaded,
-// because they are an awful coherence problem
-static int c_active_windings;
-static int c_peak_windings;
-static int c_winding_allocs;
-static int c_winding_points;
-
 /*
 =============
 AllocWinding
@@ -43,27 +36,19 @@ static winding_t *AllocWinding( int points )
 	winding_t	*w;
 	size_t		s;
 
-	c_winding_allocs++;
-	c_winding_points += points;
-	c_active_windings++;
-	if ( c_active_windings > c_peak_windings )
-		c_peak_windings = c_active_windings;
-
+	// patch collides are generated on worker threads,
+	// so windings can't be allocated from the zone
 	s = sizeof( *w ) - sizeof( w->p ) + sizeof( w->p[0] ) * points;
-	w = Z_Malloc( s );
-	Com_Memset( w, 0, s );
+	w = calloc( 1, s );
+	if ( !w )
+		Sys_Error( "AllocWinding: failed on allocation of %i bytes", (int)s );
 	return w;
 }
 
 
 void FreeWinding (winding_t *w)
 {
-	if (*(unsigned *)w == 0xdeaddead)
-		Com_Error (ERR_FATAL, "FreeWinding: freed a freed winding");
-	*(unsigned *)w = 0xdeaddead;
-
-	c_active_windings--;
-	Z_Free (w);
+	free (w);
 }
 
 /*
@@ -192,9 +177,12 @@ void	WindingCenter (winding_t *w, vec3_t center)
 /*
 =================
 BaseWindingForPlane
+
+With an error pointer, the error is recorded there and NULL is returned
+instead of calling Com_Error, so it can be used on the job workers.
 =================
 */
-winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist)
+winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist, const char **error)
 {
 	int		i, x;
 	vec_t	max, v;
@@ -214,8 +202,12 @@ winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist)
 			max = v;
 		}
 	}
-	if (x==-1)
-		Com_Error (ERR_DROP, "BaseWindingForPlane: no axis found");
+	if (x==-1) {
+		if (!error)
+			Com_Error (ERR_DROP, "BaseWindingForPlane: no axis found");
+		*error = "BaseWindingForPlane: no axis found";
+		return NULL;
+	}
 		
 	VectorCopy (vec3_origin, vup);
 	switch (x)
@@ -418,7 +410,7 @@ static void ClipWindingEpsilon( winding_t *in, vec3_t normal, vec_t dist, vec_t
 ChopWindingInPlace
 =============
 */
-void ChopWindingInPlace( winding_t **inout, const vec3_t normal, vec_t dist, vec_t epsilon )
+void ChopWindingInPlace( winding_t **inout, const vec3_t normal, vec_t dist, vec_t epsilon, const char **error )
 {
 	winding_t	*in;
 	vec_t	dists[MAX_POINTS_ON_WINDING+4];
@@ -512,10 +504,16 @@ void ChopWindingInPlace( winding_t **inout, const vec3_t normal, vec_t dist, vec
 		f->numpoints++;
 	}
 	
-	if (f->numpoints > maxpts)
-		Com_Error (ERR_DROP, "ClipWinding: points exceeded estimate");
-	if (f->numpoints > MAX_POINTS_ON_WINDING)
-		Com_Error (ERR_DROP, "ClipWinding: MAX_POINTS_ON_WINDING");
+	if (f->numpoints > maxpts || f->numpoints > MAX_POINTS_ON_WINDING) {
+		if (!error) {
+			if (f->numpoints > maxpts)
+				Com_Error (ERR_DROP, "ClipWinding: points exceeded estimate");
+			Com_Error (ERR_DROP, "ClipWinding: MAX_POINTS_ON_WINDING");
+		}
+		*error = f->numpoints > maxpts ? "ClipWinding: points exceeded estimate" : "ClipWinding: MAX_POINTS_ON_WINDING";
+		FreeWinding (f);
+		f = NULL;
+	}
 
 	FreeWinding (in);
 	*inout = f;
@@ -48,7 +48,7 @@ void	WindingCenter (winding_t *w, vec3_t center);
 winding_t	*ChopWinding (winding_t *in, vec3_t normal, vec_t dist);
 winding_t	*CopyWinding (const winding_t *w);
 winding_t	*ReverseWinding (winding_t *w);
-winding_t	*BaseWindingForPlane (vec3_t normal, vec_t dist);
+winding_t	*BaseWindingForPlane (vec3_t normal, vec_t dist, const char **error);
 void	CheckWinding (winding_t *w);
 void	WindingPlane (winding_t *w, vec3_t normal, vec_t *dist);
 void	RemoveColinearPoints (winding_t *w);
@@ -58,5 +58,5 @@ void	WindingBounds( const winding_t *w, vec3_t mins, vec3_t maxs );
 
 void	AddWindingToConvexHull( winding_t *w, winding_t **hull, vec3_t normal );
 
-void	ChopWindingInPlace( winding_t **w, const vec3_t normal, vec_t dist, vec_t epsilon );
+void	ChopWindingInPlace( winding_t **w, const vec3_t normal, vec_t dist, vec_t epsilon, const char **error );
 // frees the original if clipped
@@ -61,6 +61,41 @@ int CM_PointLeafnum( const vec3_t p ) {
 }
 
 
+/*
+==================
+CM_PointClusterArea
+
+Same as CM_LeafCluster and CM_LeafArea of CM_PointLeafnum, but game code
+asks for the same few points over and over, so recent results are kept
+in a small direct mapped cache. Points always map to the same leaf for
+a loaded map, so it only has to be cleared with the map.
+==================
+*/
+void CM_PointClusterArea( const vec3_t p, int *cluster, int *area ) {
+	const unsigned int *v = (const unsigned int *)p;
+	cPointLeaf_t *entry;
+	unsigned int hash;
+	int leafnum;
+
+	hash = ( v[0] * 73856093U ) ^ ( v[1] * 19349663U ) ^ ( v[2] * 83492791U );
+	entry = &cm.pointLeafs[ ( hash ^ ( hash >> 16 ) ) & ( POINT_LEAF_CACHE - 1 ) ];
+
+	if ( entry->leafnum && entry->point[0] == p[0] && entry->point[1] == p[1] && entry->point[2] == p[2] ) {
+		leafnum = entry->leafnum - 1;
+	} else {
+		leafnum = CM_PointLeafnum( p );
+		if ( leafnum < 0 || leafnum >= cm.numLeafs ) {
+			Com_Error( ERR_DROP, "CM_PointClusterArea: bad number" );
+		}
+		VectorCopy( p, entry->point );
+		entry->leafnum = leafnum + 1;
+	}
+
+	*cluster = cm.leafs[ leafnum ].cluster;
+	*area = cm.leafs[ leafnum ].area;
+}
+
+
 /*
 ======================================================================
 
@@ -345,6 +380,39 @@ static void CM_FloodArea_r( int areaNum, int floodnum) {
 	}
 }
 
+/*
+====================
+CM_SetAreaConnections
+
+Fills in the connectivity rows of all areas in the flood
+that was just started from firstArea, they are all the same.
+====================
+*/
+static void CM_SetAreaConnections( int firstArea, int floodnum ) {
+	byte	*row;
+	int		i;
+
+	if ( !cm.areaConnected ) {
+		return;
+	}
+
+	row = cm.areaConnected + firstArea * cm.areaBytes;
+	Com_Memset( row, 0, cm.areaBytes );
+
+	for ( i = firstArea ; i < cm.numAreas ; i++ ) {
+		if ( cm.areas[i].floodvalid == cm.floodvalid && cm.areas[i].floodnum == floodnum ) {
+			row[i>>3] |= 1<<(i&7);
+		}
+	}
+
+	for ( i = firstArea + 1 ; i < cm.numAreas ; i++ ) {
+		if ( row[i>>3] & (1<<(i&7)) ) {
+			Com_Memcpy( cm.areaConnected + i * cm.areaBytes, row, cm.areaBytes );
+		}
+	}
+}
+
+
 /*
 ====================
 CM_FloodAreaConnections
@@ -367,6 +435,8 @@ void	CM_FloodAreaConnections( void ) {
 		}
 		floodnum++;
 		CM_FloodArea_r (i, floodnum);
+
+		CM_SetAreaConnections( i, floodnum );
 	}
 
 }
@@ -421,7 +491,7 @@ bool	CM_AreasConnected( int area1, int area2 ) {
 		Com_Error (ERR_DROP, "area >= cm.numAreas");
 	}
 
-	if (cm.areas[area1].floodnum == cm.areas[area2].floodnum) {
+	if ( cm.areaConnected[ area1 * cm.areaBytes + ( area2 >> 3 ) ] & ( 1 << ( area2 & 7 ) ) ) {
 		return true;
 	}
 	return false;
@@ -444,8 +514,8 @@ This is used to cull non-visible entities from snapshots
 */
 int CM_WriteAreaBits (byte *buffer, int area)
 {
+	const byte	*row;
 	int		i;
-	int		floodnum;
 	int		bytes;
 
 	bytes = (cm.numAreas+7)>>3;
@@ -460,11 +530,10 @@ int CM_WriteAreaBits (byte *buffer, int area)
 	}
 	else
 	{
-		floodnum = cm.areas[area].floodnum;
-		for (i=0 ; i<cm.numAreas ; i++)
+		row = cm.areaConnected + area * cm.areaBytes;
+		for (i=0 ; i<bytes ; i++)
 		{
-			if (cm.areas[i].floodnum == floodnum || area == -1)
-				buffer[i>>3] |= 1<<(i&7);
+			buffer[i] |= row[i];
 		}
 	}
 
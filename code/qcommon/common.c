@@ -956,12 +956,17 @@ all big things are allocated on the hunk.
 #define MINFRAGMENT	64
 
 #ifdef USE_MULTI_SEGMENT
-#define DIRECTION next
-// we may have up to 4 lists to group free blocks by size
-//#define TINY_SIZE	32
-#define SMALL_SIZE	64
-#define MEDIUM_SIZE	128
-
+// free blocks are kept in segregated lists: each power of two size range
+// is split into ZONE_SL_COUNT lists, and blocks below ZONE_SMALL_SIZE go
+// into ZONE_SL_COUNT lists of ZONE_ALIGN bytes each. Bitmaps of the
+// non-empty lists give a suitable free block in constant time.
+#define ZONE_SL_BITS	4
+#define ZONE_SL_COUNT	( 1 << ZONE_SL_BITS )
+#define ZONE_ALIGN_BITS	3
+#define ZONE_ALIGN		( 1 << ZONE_ALIGN_BITS )
+#define ZONE_SMALL_BITS	( ZONE_SL_BITS + ZONE_ALIGN_BITS )
+#define ZONE_SMALL_SIZE	( 1 << ZONE_SMALL_BITS )
+#define ZONE_FL_COUNT	( 32 - ZONE_SMALL_BITS )
 #endif
 
 #define USE_STATIC_TAGS
@@ -996,14 +1001,9 @@ typedef struct memzone_s {
 	int		used;			// total bytes used
 	memblock_t	blocklist;	// start / end cap for linked list
 #ifdef USE_MULTI_SEGMENT
-	memblock_t	dummy0;		// just to allocate some space before freelist
-	freeblock_t	freelist_tiny;
-	memblock_t	dummy1;
-	freeblock_t	freelist_small;
-	memblock_t	dummy2;
-	freeblock_t	freelist_medium;
-	memblock_t	dummy3;
-	freeblock_t	freelist;
+	unsigned int	flBitmap;					// bit set for each fl with a non-empty list
+	unsigned int	slBitmap[ ZONE_FL_COUNT ];	// bit set for each non-empty list
+	freeblock_t	freelist[ ZONE_FL_COUNT ][ ZONE_SL_COUNT ];
 #else
 	memblock_t	*rover;
 #endif
@@ -1021,18 +1021,93 @@ static memzone_t *smallzone;
 
 #ifdef USE_MULTI_SEGMENT
 
-static void InitFree( freeblock_t *fb )
+#if defined( _MSC_VER )
+#include <intrin.h>
+static ID_INLINE int Z_LowestBit( unsigned int x )
+{
+	unsigned long i;
+	_BitScanForward( &i, x );
+	return (int)i;
+}
+
+static ID_INLINE int Z_HighestBit( unsigned int x )
+{
+	unsigned long i;
+	_BitScanReverse( &i, x );
+	return (int)i;
+}
+#elif defined( __GNUC__ )
+#define Z_LowestBit( x ) __builtin_ctz( x )
+#define Z_HighestBit( x ) ( 31 - __builtin_clz( x ) )
+#else
+static int Z_LowestBit( unsigned int x )
+{
+	int i = 0;
+	while ( !( x & 1 ) ) {
+		x >>= 1;
+		i++;
+	}
+	return i;
+}
+
+static int Z_HighestBit( unsigned int x )
+{
+	int i = 0;
+	while ( x >>= 1 ) {
+		i++;
+	}
+	return i;
+}
+#endif
+
+
+/*
+================
+MapFree
+
+Returns the list holding free blocks of this size
+================
+*/
+static void MapFree( unsigned int size, int *fl, int *sl )
+{
+	int bit;
+
+	if ( size < ZONE_SMALL_SIZE ) {
+		*fl = 0;
+		*sl = size >> ZONE_ALIGN_BITS;
+	} else {
+		bit = Z_HighestBit( size );
+		*fl = bit - ZONE_SMALL_BITS + 1;
+		*sl = ( size >> ( bit - ZONE_SL_BITS ) ) ^ ZONE_SL_COUNT;
+	}
+}
+
+
+/*
+================
+MapSearch
+
+Returns the first list where every free block is at least size bytes
+================
+*/
+static void MapSearch( unsigned int size, int *fl, int *sl )
 {
-	memblock_t *block = (memblock_t*)( (byte*)fb - sizeof( memblock_t ) );
-	Com_Memset( block, 0, sizeof( *block ) );
+	if ( size < ZONE_SMALL_SIZE ) {
+		size += ZONE_ALIGN - 1;
+	} else {
+		size += ( 1U << ( Z_HighestBit( size ) - ZONE_SL_BITS ) ) - 1;
+	}
+
+	MapFree( size, fl, sl );
 }
 
 
-static void RemoveFree( memblock_t *block )
+static void RemoveFree( memzone_t *zone, memblock_t *block )
 {
 	freeblock_t *fb = (freeblock_t*)( block + 1 );
 	freeblock_t *prev;
 	freeblock_t *next;
+	int fl, sl;
 
 #ifdef ZONE_DEBUG
 	if ( fb->next == NULL || fb->prev == NULL || fb->next == fb || fb->prev == fb ) {
@@ -1045,6 +1120,15 @@ static void RemoveFree( memblock_t *block )
 
 	prev->next = next;
 	next->prev = prev;
+
+	// list became empty
+	if ( prev == next ) {
+		MapFree( block->size, &fl, &sl );
+		zone->slBitmap[ fl ] &= ~( 1U << sl );
+		if ( !zone->slBitmap[ fl ] ) {
+			zone->flBitmap &= ~( 1U << fl );
+		}
+	}
 }
 
 
@@ -1052,24 +1136,7 @@ static void InsertFree( memzone_t *zone, memblock_t *block )
 {
 	freeblock_t *fb = (freeblock_t*)( block + 1 );
 	freeblock_t *prev, *next;
-#ifdef TINY_SIZE
-	if ( block->size <= TINY_SIZE )
-		prev = &zone->freelist_tiny;
-	else
-#endif
-#ifdef SMALL_SIZE
-	if ( block->size <= SMALL_SIZE )
-		prev = &zone->freelist_small;
-	else
-#endif
-#ifdef MEDIUM_SIZE
-	if ( block->size <= MEDIUM_SIZE )
-		prev = &zone->freelist_medium;
-	else
-#endif
-		prev = &zone->freelist;
-
-	next = prev->next;
+	int fl, sl;
 
 #ifdef ZONE_DEBUG
 	if ( block->size < sizeof( *fb ) + sizeof( *block ) ) {
@@ -1077,11 +1144,19 @@ static void InsertFree( memzone_t *zone, memblock_t *block )
 	}
 #endif
 
+	MapFree( block->size, &fl, &sl );
+
+	prev = &zone->freelist[ fl ][ sl ];
+	next = prev->next;
+
 	prev->next = fb;
 	next->prev = fb;
 
 	fb->prev = prev;
 	fb->next = next;
+
+	zone->flBitmap |= 1U << fl;
+	zone->slBitmap[ fl ] |= 1U << sl;
 }
 
 
@@ -1147,59 +1222,54 @@ static freeblock_t *NewBlock( memzone_t *zone, int size )
 }
 
 
+/*
+================
+SearchFree
+
+Takes the first block from the smallest non-empty list that only holds
+big enough blocks. If there is none, the list the size falls into is
+scanned before a new segment is allocated.
+================
+*/
 static memblock_t *SearchFree( memzone_t *zone, int size )
 {
-	const freeblock_t *fb;
+	const freeblock_t *fb, *head;
 	memblock_t *base;
-
-#ifdef TINY_SIZE
-	if ( size <= TINY_SIZE )
-		fb = zone->freelist_tiny.DIRECTION;
-	else
-#endif
-#ifdef SMALL_SIZE
-	if ( size <= SMALL_SIZE )
-		fb = zone->freelist_small.DIRECTION;
-	else
-#endif
-#ifdef MEDIUM_SIZE
-	if ( size <= MEDIUM_SIZE )
-		fb = zone->freelist_medium.DIRECTION;
-	else
-#endif
-		fb = zone->freelist.DIRECTION;
-
-	for ( ;; ) {
-		// not found, allocate new segment?
-		if ( fb == &zone->freelist ) {
-			fb = NewBlock( zone, size );
-		} else {
-#ifdef TINY_SIZE
-			if ( fb == &zone->freelist_tiny ) {
-				fb = zone->freelist_small.DIRECTION;
-				continue;
-			}
-#endif
-#ifdef SMALL_SIZE
-			if ( fb == &zone->freelist_small ) {
-				fb = zone->freelist_medium.DIRECTION;
-				continue;
+	unsigned int map;
+	int fl, sl;
+
+	MapSearch( size, &fl, &sl );
+
+	if ( fl < ZONE_FL_COUNT ) {
+		map = zone->slBitmap[ fl ] & ( ~0U << sl );
+		if ( !map && fl + 1 < ZONE_FL_COUNT ) {
+			map = zone->flBitmap & ( ~0U << ( fl + 1 ) );
+			if ( map ) {
+				fl = Z_LowestBit( map );
+				map = zone->slBitmap[ fl ];
 			}
-#endif
-#ifdef MEDIUM_SIZE
-			if ( fb == &zone->freelist_medium ) {
-				fb = zone->freelist.DIRECTION;
-				continue;
-			}
-#endif
 		}
+		if ( map ) {
+			sl = Z_LowestBit( map );
+			fb = zone->freelist[ fl ][ sl ].next;
+			return (memblock_t*)( (byte*) fb - sizeof( *base ) );
+		}
+	}
+
+	// blocks in the list of this size may still fit
+	MapFree( size, &fl, &sl );
+	head = &zone->freelist[ fl ][ sl ];
+	for ( fb = head->next; fb != head; fb = fb->next ) {
 		base = (memblock_t*)( (byte*) fb - sizeof( *base ) );
-		fb = fb->DIRECTION;
 		if ( base->size >= size ) {
 			return base;
 		}
 	}
-	return NULL;
+
+	// not found, allocate new segment
+	fb = NewBlock( zone, size );
+
+	return (memblock_t*)( (byte*) fb - sizeof( *base ) );
 }
 #endif // USE_MULTI_SEGMENT
 
@@ -1212,6 +1282,9 @@ Z_ClearZone
 static void Z_ClearZone( memzone_t *zone, memzone_t *head, int size, int segnum ) {
 	memblock_t	*block;
 	int min_fragment;
+#ifdef USE_MULTI_SEGMENT
+	int i, j;
+#endif
 
 #ifdef USE_MULTI_SEGMENT
 	min_fragment = sizeof( memblock_t ) + sizeof( freeblock_t );
@@ -1243,17 +1316,13 @@ static void Z_ClearZone( memzone_t *zone, memzone_t *head, int size, int segnum
 	block->size = size - sizeof(memzone_t);
 
 #ifdef USE_MULTI_SEGMENT
-	InitFree( &zone->freelist );
-	zone->freelist.next = zone->freelist.prev = &zone->freelist;
-
-	InitFree( &zone->freelist_medium );
-	zone->freelist_medium.next = zone->freelist_medium.prev = &zone->freelist_medium;
-
-	InitFree( &zone->freelist_small );
-	zone->freelist_small.next = zone->freelist_small.prev = &zone->freelist_small;
-
-	InitFree( &zone->freelist_tiny );
-	zone->freelist_tiny.next = zone->freelist_tiny.prev = &zone->freelist_tiny;
+	zone->flBitmap = 0;
+	for ( i = 0; i < ZONE_FL_COUNT; i++ ) {
+		zone->slBitmap[ i ] = 0;
+		for ( j = 0; j < ZONE_SL_COUNT; j++ ) {
+			zone->freelist[ i ][ j ].next = zone->freelist[ i ][ j ].prev = &zone->freelist[ i ][ j ];
+		}
+	}
 
 	InsertFree( zone, block );
 #endif
@@ -1346,7 +1415,7 @@ void Z_Free( void *ptr ) {
 	other = block->prev;
 	if ( other->tag == TAG_FREE ) {
 #ifdef USE_MULTI_SEGMENT
-		RemoveFree( other );
+		RemoveFree( zone, other );
 #endif
 		// merge with previous free block
 		MergeBlock( other, block );
@@ -1365,7 +1434,7 @@ void Z_Free( void *ptr ) {
 	other = block->next;
 	if ( other->tag == TAG_FREE ) {
 #ifdef USE_MULTI_SEGMENT
-		RemoveFree( other );
+		RemoveFree( zone, other );
 #endif
 		// merge the next free block onto the end
 		MergeBlock( block, other );
@@ -1469,7 +1538,7 @@ void *Z_TagMalloc( int size, memtag_t tag ) {
 #ifdef USE_MULTI_SEGMENT
 	base = SearchFree( zone, size );
 
-	RemoveFree( base );
+	RemoveFree( zone, base );
 #else
 
 	base = rover = zone->rover;
@@ -1964,6 +2033,106 @@ static void Com_Meminfo_f( void ) {
 }
 
 
+/*
+=================
+Com_ZoneBench_f
+
+Churns a zone with allocations sized like the strings and small structures
+the engine keeps there, then reports the throughput and the fragmentation
+left behind. The random sequence is fixed, so runs can be compared.
+=================
+*/
+#define ZONE_BENCH_SLOTS	4096
+
+static int Com_ZoneBenchRand( int *seed ) {
+	return ( Q_rand( seed ) >> 16 ) & 0x7FFF;
+}
+
+static void Com_ZoneBench_f( void ) {
+	zone_stats_t before, after;
+	const memzone_t *zone;
+	void	**slots;
+	int64_t	start, usec;
+	int		iterations, allocs, frees, live, size, seed, zoneSize;
+	int		i, n, r;
+	bool	small;
+
+	if ( Cmd_Argc() > 3 ) {
+		Com_Printf( "Usage: zonebench [iterations] [main|small]\n" );
+		return;
+	}
+
+	iterations = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 1000000;
+	if ( iterations <= 0 ) {
+		iterations = 1000000;
+	}
+
+	small = !Q_stricmp( Cmd_Argv( 2 ), "small" );
+	zone = small ? smallzone : mainzone;
+
+	slots = calloc( ZONE_BENCH_SLOTS, sizeof( slots[0] ) );
+	if ( !slots ) {
+		return;
+	}
+
+	Zone_Stats( "bench", zone, false, &before );
+	zoneSize = zone->size;
+
+	seed = 0x5EED;
+	allocs = frees = live = 0;
+
+	start = Sys_Microseconds();
+
+	for ( i = 0; i < iterations; i++ ) {
+		n = Com_ZoneBenchRand( &seed ) % ZONE_BENCH_SLOTS;
+		if ( slots[ n ] ) {
+			Z_Free( slots[ n ] );
+			slots[ n ] = NULL;
+			frees++;
+			live--;
+			continue;
+		}
+
+		// mostly short strings, some structures and a few bigger buffers
+		r = Com_ZoneBenchRand( &seed ) & 255;
+		size = Com_ZoneBenchRand( &seed );
+		if ( r < 192 ) {
+			size = 1 + size % 64;
+		} else if ( small || r < 248 ) {
+			size = 64 + size % 448;
+		} else {
+			size = 512 + size % 7680;
+		}
+
+		slots[ n ] = Z_TagMalloc( size, small ? TAG_SMALL : TAG_GENERAL );
+		allocs++;
+		live++;
+	}
+
+	usec = Sys_Microseconds() - start;
+
+	Zone_Stats( "bench", zone, false, &after );
+
+	for ( n = 0; n < ZONE_BENCH_SLOTS; n++ ) {
+		if ( slots[ n ] ) {
+			Z_Free( slots[ n ] );
+		}
+	}
+
+	free( slots );
+
+	Com_Printf( "%s zone: %i allocs, %i frees in %i msec, %.1f nsec per call\n",
+		small ? "small" : "main", allocs, frees, (int)( usec / 1000 ),
+		(double)usec * 1000.0 / ( allocs + frees ) );
+	Com_Printf( "%8i blocks live at the end\n", live );
+	Com_Printf( "%8i free blocks before, %i after\n", before.freeBlocks, after.freeBlocks );
+	Com_Printf( "%8i bytes in free blocks, largest %i bytes (%.1f%% fragmented)\n",
+		after.freeBytes, after.freeLargest,
+		after.freeBytes ? 100.0 * ( after.freeBytes - after.freeLargest ) / after.freeBytes : 0.0 );
+	Com_Printf( "%8i bytes zone growth, %i segments\n", zone->size - zoneSize, after.zoneSegments );
+}
+
+
 /*
 ===============
 Com_TouchMemory
@@ -2182,6 +2351,7 @@ static void Com_InitHunkMemory( void ) {
 	Hunk_Clear();
 
 	Cmd_AddCommand( "meminfo", Com_Meminfo_f );
+	Cmd_AddCommand( "zonebench", Com_ZoneBench_f );
 #ifdef ZONE_DEBUG
 	Cmd_AddCommand( "zonelog", Z_LogHeap );
 #endif
@@ -3809,6 +3979,10 @@ void Com_Init( char *commandLine ) {
 	// done early so bind command exists
 	Com_InitKeyCommands();
 
+	// done early so the filesystem can scan pk3 files in parallel
+	Com_StartupVariable( "com_jobWorkers" );
+	Com_InitJobs();
+
 	FS_InitFilesystem();
 
 	com_logfile = Cvar_Get( "logfile", "0", CVAR_TEMP );
@@ -3961,6 +4135,8 @@ void Com_Init( char *commandLine ) {
 	}
 #endif
 
+	Com_InitJobs();
+
 	// Pick a random port value
 	Com_RandomBytes( (byte*)&qport, sizeof( qport ) );
 	Netchan_Init( qport & 0xffff );
@@ -4311,6 +4487,9 @@ void Com_Frame( bool noDelay ) {
 
 	Cbuf_Execute();
 
+	// call back the file reads that completed since the last frame
+	FS_RunAsyncReads( false );
+
 	// mess with msec if needed
 	msec = Com_ModifyMsec( realMsec );
 
@@ -4437,6 +4616,8 @@ Com_Shutdown
 =================
 */
 static void Com_Shutdown( void ) {
+	Com_ShutdownJobs();
+
 	if ( logfile != FS_INVALID_HANDLE ) {
 		FS_FCloseFile( logfile );
 		logfile = FS_INVALID_HANDLE;
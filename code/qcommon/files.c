@@ -228,11 +228,12 @@ static const unsigned pak_checksums[] = {
 #define MAX_ZPATH			256
 #define MAX_FILEHASH_SIZE	4096
 
+// no pointers, so the file tables can be used right from the mapped pk3 cache
 typedef struct fileInPack_s {
-	char					*name;		// name of the file
-	unsigned long			pos;		// file info position in zip
-	unsigned long			size;		// file size
-	struct	fileInPack_s*	next;		// next file in the hash
+	int				name;		// offset of the name in pack->names
+	int				next;		// index of the next file in the hash, -1 at the end
+	unsigned int	pos;		// file info position in zip
+	unsigned int	size;		// file size
 } fileInPack_t;
 
 typedef struct pack_s {
@@ -246,12 +247,17 @@ typedef struct pack_s {
 	int				referenced;					// referenced file flags
 	bool		exclude;					// found in \fs_excludeReference list
 	int				hashSize;					// hash table size (power of 2)
-	fileInPack_t*	*hashTable;					// hash table
-	fileInPack_t*	buildBuffer;				// buffer with the filenames etc.
+	const int		*hashTable;					// index of the first file in each chain, -1 if empty
+	const fileInPack_t *buildBuffer;			// all files in zip order
+	const char		*names;						// filenames, addressed by fileInPack_t.name
+	int				namesLen;
 	int				index;
 
 	int				handleUsed;
 
+	struct pakMap_s	*map;						// whole pk3 mapped into memory, see FS_MapPak
+	bool		mapFailed;
+
 #ifdef USE_HANDLE_CACHE
 	struct pack_s	*next_h;						// double-linked list of unreferenced paks with open file handles
 	struct pack_s	*prev_h;
@@ -267,11 +273,25 @@ typedef struct pack_s {
 	struct pack_s	*next;
 	struct pack_s	*prev;
 	int				checksumFeed;
+	bool		pureChecksumValid;			// pure_checksum was computed for checksumFeed
 	int				*headerLongs;
 	int				numHeaderLongs;
+#ifdef USE_PK3_CACHE_FILE
+	struct pakCacheMap_s *cacheMap;				// pk3 cache file holding the file tables, NULL if they are allocated with the pak
+#endif
 #endif
 } pack_t;
 
+#define FS_PakFileName( pak, file ) ( (pak)->names + (file)->name )
+
+static ID_INLINE const fileInPack_t *FS_PakHashChain( const pack_t *pak, long hash ) {
+	return pak->hashTable[ hash ] < 0 ? NULL : &pak->buildBuffer[ pak->hashTable[ hash ] ];
+}
+
+static ID_INLINE const fileInPack_t *FS_PakNextFile( const pack_t *pak, const fileInPack_t *file ) {
+	return file->next < 0 ? NULL : &pak->buildBuffer[ file->next ];
+}
+
 typedef struct {
 	char		*path;		// c:\quake3
 	char		*gamedir;	// baseq3
@@ -325,6 +345,7 @@ static	int			fs_packCount;			// total number of packs in searchpath
 static	int			fs_dirCount;			// total number of directories in searchpath
 
 static	int			fs_checksumFeed;
+static	int			fs_pakSequence;			// changed with the search paths, pak references and exclusions
 
 typedef union qfile_gus {
 	FILE*		o;
@@ -378,6 +399,7 @@ void Com_AppendCDKey( const char *filename );
 void Com_ReadCDKey( const char *filename );
 
 static int FS_GetModList( char *listbuf, int bufsize );
+static void FS_FlushMissingFiles( void );
 void FS_Reload( void );
 
 
@@ -876,6 +898,9 @@ fileHandle_t FS_SV_FOpenFileWrite( const char *filename ) {
 
 	Com_DPrintf( "writing to: %s\n", ospath );
 
+	// the new file may shadow a cached miss
+	FS_FlushMissingFiles();
+
 	fd->handleFiles.file.o = Sys_FOpen( ospath, "wb" );
 	if ( !fd->handleFiles.file.o ) {
 		if ( FS_CreatePath( ospath ) ) {
@@ -1002,6 +1027,8 @@ void FS_SV_Rename( const char *from, const char *to ) {
 		Com_Printf( "FS_SV_Rename: %s --> %s\n", from_ospath, to_ospath );
 	}
 
+	FS_FlushMissingFiles();
+
 	if ( rename( from_ospath, to_ospath ) ) {
 		// Failed, try copying it and deleting the original
 		FS_CopyFile( from_ospath, to_ospath );
@@ -1041,6 +1068,8 @@ void FS_Rename( const char *from, const char *to ) {
 		FS_Remove( to_ospath );
 	}
 
+	FS_FlushMissingFiles();
+
 	if ( rename( from_ospath, to_ospath ) ) {
 		// Failed, try copying it and deleting the original
 		FS_CopyFile( from_ospath, to_ospath );
@@ -1222,6 +1251,9 @@ fileHandle_t FS_FOpenFileWrite( const char *filename ) {
 	// enabling the following line causes a recursive function call loop
 	// when running with +set logfile 1 +set developer 1
 	//Com_DPrintf( "writing to: %s\n", ospath );
+
+	FS_FlushMissingFiles();
+
 	fd->handleFiles.file.o = Sys_FOpen( ospath, "wb" );
 	if ( fd->handleFiles.file.o == NULL ) {
 		if ( FS_CreatePath( ospath ) ) {
@@ -1276,6 +1308,8 @@ fileHandle_t FS_FOpenFileAppend( const char *filename ) {
 	fd = &fsh[ f ];
 	FS_InitHandle( fd );
 
+	FS_FlushMissingFiles();
+
 	fd->handleFiles.file.o = Sys_FOpen( ospath, "ab" );
 	if ( fd->handleFiles.file.o == NULL ) {
 		if ( FS_CreatePath( ospath ) ) {
@@ -1436,538 +1470,2147 @@ void FS_RestorePure( void )
 }
 
 
-static int FS_OpenFileInPak( fileHandle_t *file, pack_t *pak, fileInPack_t *pakFile, bool uniqueFILE ) {
-	fileHandleData_t *f;
-	unz_s *zfi;
-	FILE *temp;
+/*
+=============================================================================
 
-	// mark the pak as having been referenced and mark specifics on gameclient and ui
-	// these are loaded from all pk3s
-	// from every pk3 file.
+MERGED FILE INDEX
 
-	if ( !( pak->referenced & FS_GENERAL_REF ) && FS_GeneralRef( pakFile->name ) ) {
-		pak->referenced |= FS_GENERAL_REF;
-	}
+All pk3 entries of the search path are merged into a single hash table,
+so finding a file costs one lookup instead of a probe into every pak.
+Each name keeps the paks that contain it in search order, because the
+pure list can change without a restart and the first pure pak has to be
+picked at lookup time.
 
-	if ( !pak->handle ) {
-		pak->handle = unzOpen( pak->pakFilename );
-		if ( !pak->handle ) {
-			Com_Printf( S_COLOR_RED "Error opening %s@%s\n", pak->pakBasename, pakFile->name );
-			*file = FS_INVALID_HANDLE;
-			return -1;
-		}
-	}
+Loose directories can change behind our back, so only misses are kept
+for them. The miss cache is flushed on every write through the
+filesystem and whenever the pure list is set.
 
-	if ( uniqueFILE ) {
-		// open a new file on the pakfile
-		temp = unzReOpen( pak->pakFilename, pak->handle );
-		if ( temp == NULL ) {
-			Com_Printf( S_COLOR_RED "Couldn't reopen %s", pak->pakFilename );
-			*file = FS_INVALID_HANDLE;
-			return -1;
-		}
-	} else {
-		temp = pak->handle;
-	}
+Directory listings use a second index of all pk3 entries sorted by
+name, the files under a path are next to each other in it and are
+found with a binary search, see FS_ListFilteredFiles.
 
-	*file = FS_HandleForFile();
-	f = &fsh[ *file ];
-	FS_InitHandle( f );
+=============================================================================
+*/
 
-	f->zipFile = true;
-	f->handleFiles.file.z = temp;
-	f->handleFiles.unique = uniqueFILE;
+#define MAX_INDEX_HASH_SIZE		(1<<20)
+#define MISSING_HASH_SIZE		1024
+#define MAX_MISSING_FILES		4096
+#define MAX_MISSING_DIRS		32		// directories with a bit in fileMissing_t
 
-	Q_strncpyz( f->name, pakFile->name, sizeof( f->name ) );
-	zfi = (unz_s *)f->handleFiles.file.z;
-	// in case the file was new
-	temp = zfi->file;
-	// set the file position in the zip file (also sets the current file info)
-	unzSetCurrentFileInfoPosition( pak->handle, pakFile->pos );
-	// copy the file info into the unzip structure
-	Com_Memcpy( zfi, pak->handle, sizeof( *zfi ) );
-	// we copy this back into the structure
-	zfi->file = temp;
-	// open the file in the zip
-	unzOpenCurrentFile( f->handleFiles.file.z );
-	f->zipFilePos = pakFile->pos;
-	f->zipFileLen = pakFile->size;
-	f->pakIndex = pak->index;
-	fs_lastPakIndex = pak->index;
-	f->pak = pak;
+typedef struct fileIndex_s {
+	const fileInPack_t	*file;
+	const char			*name;			// of file, in its pak
+	const searchpath_t	*search;
+	unsigned int		fullHash;
+	int					order;			// position of search in fs_searchpaths
+	struct fileIndex_s	*nextSource;	// same file in a later pak
+	struct fileIndex_s	*next;			// next name in the hash bucket
+} fileIndex_t;
 
-#ifdef USE_HANDLE_CACHE
-	if ( pak->next_h ) {
-		FS_RemoveFromHandleList( pak );
-	}
-#endif
+typedef struct {
+	const searchpath_t	*search;
+	int					order;
+} indexDir_t;
 
-	pak->handleUsed++;
+typedef struct {
+	const char			*name;			// of file, in its pak
+	const searchpath_t	*search;
+	int					order;			// position of search in fs_searchpaths
+	int					file;			// position of file in the pak
+} listEntry_t;
 
-	if ( fs_debug->integer ) {
-		Com_Printf( "FS_FOpenFileRead: %s (found in '%s')\n",
-			pakFile->name, pak->pakFilename );
+typedef struct fileMissing_s {
+	struct fileMissing_s *next;
+	unsigned int		fullHash;
+	unsigned int		dirs;			// bits of fs_indexDirs known not to have the file
+	char				name[1];
+} fileMissing_t;
+
+static fileIndex_t	**fs_indexTable;	// NULL if not built yet
+static int			fs_indexSize;		// hash table size (power of 2)
+static int			fs_indexNames;		// number of unique pak file names
+static int			fs_indexPaths;		// number of search paths
+static indexDir_t	*fs_indexDirs;		// directories in search order
+static int			fs_numIndexDirs;
+
+static listEntry_t	*fs_listIndex;		// all pak files sorted by name, NULL if not built yet
+static int			fs_numListEntries;
+
+static fileMissing_t *fs_missingTable[ MISSING_HASH_SIZE ];
+static int			fs_numMissingFiles;
+
+
+/*
+=================
+FS_FlushMissingFiles
+=================
+*/
+static void FS_FlushMissingFiles( void ) {
+	fileMissing_t *m, *next;
+	int i;
+
+	if ( !fs_numMissingFiles ) {
+		return;
 	}
 
-	return zfi->cur_file_info.uncompressed_size;
+	for ( i = 0; i < MISSING_HASH_SIZE; i++ ) {
+		for ( m = fs_missingTable[i]; m; m = next ) {
+			next = m->next;
+			Z_Free( m );
+		}
+		fs_missingTable[i] = NULL;
+	}
+
+	fs_numMissingFiles = 0;
 }
 
 
 /*
-===========
-FS_FOpenFileRead
+=================
+FS_FileIsMissing
 
-Finds the file in the search path.
-Returns filesize and an open FILE pointer.
-Used for streaming data out of either a
-separate file or a ZIP file.
-===========
+Returns true if the directory was already checked and the file wasn't there
+=================
 */
-extern bool		com_fullyInitialized;
+static bool FS_FileIsMissing( const char *filename, unsigned int fullHash, int dirIndex ) {
+	const fileMissing_t *m;
 
-int FS_FOpenFileRead( const char *filename, fileHandle_t *file, bool uniqueFILE ) {
-	const searchpath_t	*search;
-	char			*netpath;
-	pack_t			*pak;
-	fileInPack_t	*pakFile;
-	directory_t		*dir;
-	long			hash;
-	long			fullHash;
-	FILE			*temp;
-	int				length;
-	fileHandleData_t *f;
+	if ( dirIndex >= MAX_MISSING_DIRS ) {
+		return false;
+	}
 
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	for ( m = fs_missingTable[ fullHash & (MISSING_HASH_SIZE-1) ]; m; m = m->next ) {
+		// loose files may be case sensitive
+		if ( m->fullHash == fullHash && !strcmp( m->name, filename ) ) {
+			return ( m->dirs & ( 1U << dirIndex ) ) != 0;
+		}
 	}
 
-	if ( !filename ) {
-		Com_Error( ERR_FATAL, "FS_FOpenFileRead: NULL 'filename' parameter passed\n" );
+	return false;
+}
+
+
+/*
+=================
+FS_AddMissingFile
+=================
+*/
+static void FS_AddMissingFile( const char *filename, unsigned int fullHash, int dirIndex ) {
+	fileMissing_t *m;
+	int hash, len;
+
+	if ( dirIndex >= MAX_MISSING_DIRS ) {
+		return;
 	}
 
-	// qpaths are not supposed to have a leading slash
-	if ( filename[0] == '/' || filename[0] == '\\' ) {
-		filename++;
+	hash = fullHash & (MISSING_HASH_SIZE-1);
+	for ( m = fs_missingTable[ hash ]; m; m = m->next ) {
+		if ( m->fullHash == fullHash && !strcmp( m->name, filename ) ) {
+			m->dirs |= 1U << dirIndex;
+			return;
+		}
 	}
 
-	// make absolutely sure that it can't back up the path.
-	// The searchpaths do guarantee that something will always
-	// be prepended, so we don't need to worry about "c:" or "//limbo"
-	if ( FS_CheckDirTraversal( filename ) ) {
-		*file = FS_INVALID_HANDLE;
-		return -1;
+	if ( fs_numMissingFiles >= MAX_MISSING_FILES ) {
+		FS_FlushMissingFiles();
 	}
 
-	// we will calculate full hash only once then just mask it by current pack->hashSize
-	// we can do that as long as we know properties of our hash function
-	fullHash = FS_HashFileName( filename, 0U );
+	len = (int)strlen( filename );
+	m = Z_Malloc( sizeof( *m ) + len );
+	Com_Memcpy( m->name, filename, len + 1 );
+	m->fullHash = fullHash;
+	m->dirs = 1U << dirIndex;
+	m->next = fs_missingTable[ hash ];
+	fs_missingTable[ hash ] = m;
+	fs_numMissingFiles++;
+}
 
-	if ( file == NULL ) {
-		// just wants to see if file is there
-		for ( search = fs_searchpaths ; search ; search = search->next ) {
-			// is the element a pak file?
-			if ( search->pack && search->pack->hashTable[ (hash = fullHash & (search->pack->hashSize-1)) ] ) {
-				// skip non-pure files
-				if ( !FS_PakIsPure( search->pack ) )
-					continue;
-				// look through all the pak file elements
-				pak = search->pack;
-				pakFile = pak->hashTable[hash];
-				do {
-					// case and separator insensitive comparisons
-					if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-						// found it!
-						return pakFile->size; 
-					}
-					pakFile = pakFile->next;
-				} while ( pakFile != NULL );
-			} else if ( search->dir && search->policy != DIR_DENY ) {
-				dir = search->dir;
-				netpath = FS_BuildOSPath( dir->path, dir->gamedir, filename );
-				temp = Sys_FOpen( netpath, "rb" );
-				if ( temp ) {
-					length = FS_FileLength( temp );
-					fclose( temp );
-					return length;
-				}
-			}
-		}
-		return -1;
-	}
 
-	// make sure the q3key file is only readable by the quake3.exe at initialization
-	// any other time the key should only be accessed in memory using the provided functions
-	if ( com_fullyInitialized && strstr( filename, "q3key" ) ) {
-		*file = FS_INVALID_HANDLE;
-		return -1;
+/*
+=================
+FS_FreeIndex
+
+Must be called whenever fs_searchpaths is changed,
+the index is rebuilt on next lookup.
+=================
+*/
+static void FS_FreeIndex( void ) {
+	if ( fs_indexTable ) {
+		Z_Free( fs_indexTable );
+		fs_indexTable = NULL;
 	}
 
-	//
-	// search through the path, one element at a time
-	//
-	for ( search = fs_searchpaths ; search ; search = search->next ) {
-		// is the element a pak file?
-		if ( search->pack && search->pack->hashTable[ (hash = fullHash & (search->pack->hashSize-1)) ] ) {
-			// disregard if it doesn't match one of the allowed pure pak files
-			if ( !FS_PakIsPure( search->pack ) ) {
-				continue;
-			}
-			// look through all the pak file elements
-			pak = search->pack;
-			pakFile = pak->hashTable[hash];
-			do {
-				// case and separator insensitive comparisons
-				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-					// found it!
-					return FS_OpenFileInPak( file, pak, pakFile, uniqueFILE );
-				}
-				pakFile = pakFile->next;
-			} while ( pakFile != NULL );
-		} else if ( search->dir && search->policy != DIR_DENY ) {
-			// check a file in the directory tree
-			dir = search->dir;
+	fs_indexSize = 0;
+	fs_indexNames = 0;
+	fs_indexPaths = 0;
+	fs_indexDirs = NULL;
+	fs_numIndexDirs = 0;
 
-			netpath = FS_BuildOSPath( dir->path, dir->gamedir, filename );
+	if ( fs_listIndex ) {
+		Z_Free( fs_listIndex );
+		fs_listIndex = NULL;
+	}
+	fs_numListEntries = 0;
+
+	FS_FlushMissingFiles();
+}
 
-			temp = Sys_FOpen( netpath, "rb" );
-			if ( temp == NULL ) {
-				continue;
-			}
 
-			*file = FS_HandleForFile();
-			f = &fsh[ *file ];
-			FS_InitHandle( f );
+/*
+=================
+FS_BuildIndex
 
-			f->handleFiles.file.o = temp;
-			Q_strncpyz( f->name, filename, sizeof( f->name ) );
-			f->zipFile = false;
+Search paths are walked backwards, so each new source becomes the
+first one for its name.
+=================
+*/
+static void FS_BuildIndex( void ) {
+	const searchpath_t	**list;
+	const searchpath_t	*search;
+	const fileInPack_t	*pakFile;
+	const char			*name;
+	fileIndex_t			*node, **prev, *entry;
+	unsigned int		fullHash;
+	int					numPaths, numFiles, numDirs;
+	int					i, n, size;
+	byte				*buf;
 
-			if ( fs_debug->integer ) {
-				Com_Printf( "FS_FOpenFileRead: %s (found in '%s/%s')\n", filename,
-					dir->path, dir->gamedir );
-			}
+	FS_FreeIndex();
 
-			return FS_FileLength( f->handleFiles.file.o );
+	numPaths = numFiles = numDirs = 0;
+	for ( search = fs_searchpaths; search; search = search->next ) {
+		if ( search->pack ) {
+			numFiles += search->pack->numfiles;
+		} else {
+			numDirs++;
 		}
+		numPaths++;
 	}
 
-#ifdef FS_MISSING
-	if ( missingFiles ) {
-		fprintf( missingFiles, "%s\n", filename );
-	}
-#endif
+	for ( fs_indexSize = 1024; fs_indexSize < numFiles && fs_indexSize < MAX_INDEX_HASH_SIZE; fs_indexSize <<= 1 )
+		;
 
-	*file = FS_INVALID_HANDLE;
-	return -1;
-}
+	size = fs_indexSize * sizeof( fs_indexTable[0] ) + numFiles * sizeof( *node ) + numDirs * sizeof( fs_indexDirs[0] );
+	buf = Z_Malloc( size );
+	fs_indexTable = (fileIndex_t **)buf;
+	node = (fileIndex_t *)( fs_indexTable + fs_indexSize );
+	fs_indexDirs = (indexDir_t *)( node + numFiles );
 
+	fs_indexPaths = numPaths;
 
-/*
-===========
-FS_TouchFileInPak
-===========
-*/
-void FS_TouchFileInPak( const char *filename ) {
-	const searchpath_t *search;
-	long			fullHash, hash;
-	pack_t			*pak;
-	fileInPack_t	*pakFile;
+	list = Z_Malloc( numPaths * sizeof( list[0] ) );
+	for ( i = 0, search = fs_searchpaths; search; search = search->next ) {
+		list[i++] = search;
+	}
 
-	fullHash = FS_HashFileName( filename, 0U );
+	for ( i = 0; i < numPaths; i++ ) {
+		if ( !list[i]->pack ) {
+			fs_indexDirs[ fs_numIndexDirs ].search = list[i];
+			fs_indexDirs[ fs_numIndexDirs ].order = i;
+			fs_numIndexDirs++;
+		}
+	}
 
-	for ( search = fs_searchpaths ; search ; search = search->next ) {
-		
-		// is the element a pak file?
-		if ( !search->pack )
+	for ( i = numPaths - 1; i >= 0; i-- ) {
+		search = list[i];
+		if ( !search->pack ) {
 			continue;
-		
-		if ( search->pack->exclude ) // skip paks in \fs_excludeReference list
-			continue;
-
-		if ( search->pack->hashTable[ (hash = fullHash & (search->pack->hashSize-1)) ] ) {
-			pak = search->pack;
-			pakFile = pak->hashTable[hash];
-			do {
-				// case and separator insensitive comparisons
-				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-					// found it!
-					if ( !( pak->referenced & FS_GENERAL_REF ) && FS_GeneralRef( filename ) ) {
-						pak->referenced |= FS_GENERAL_REF;
-					}
-					if ( !( pak->referenced & FS_GAMECLIENT_REF ) && !strcmp( filename, "vm/gameclient.qvm" ) ) {
-						pak->referenced |= FS_GAMECLIENT_REF;
-					}
-					if ( !( pak->referenced & FS_UI_REF ) && !strcmp( filename, "vm/ui.qvm" ) ) {
-						pak->referenced |= FS_UI_REF;
+		}
+		for ( n = 0; n < search->pack->hashSize; n++ ) {
+			for ( pakFile = FS_PakHashChain( search->pack, n ); pakFile; pakFile = FS_PakNextFile( search->pack, pakFile ) ) {
+				name = FS_PakFileName( search->pack, pakFile );
+				fullHash = FS_HashFileName( name, 0U );
+				prev = &fs_indexTable[ fullHash & (fs_indexSize-1) ];
+				for ( entry = *prev; entry; prev = &entry->next, entry = entry->next ) {
+					if ( entry->fullHash == fullHash && !FS_FilenameCompare( entry->name, name ) ) {
+						break;
 					}
-					return;
 				}
-				pakFile = pakFile->next;
-			} while ( pakFile != NULL );
+				if ( entry && entry->search == search ) {
+					// same name twice in one pak, the first one in the pak hash chain is used
+					continue;
+				}
+				node->file = pakFile;
+				node->name = name;
+				node->search = search;
+				node->fullHash = fullHash;
+				node->order = i;
+				if ( entry ) {
+					// replace the previous first source in the bucket
+					node->nextSource = entry;
+					node->next = entry->next;
+					entry->next = NULL;
+				} else {
+					node->nextSource = NULL;
+					node->next = NULL;
+					fs_indexNames++;
+				}
+				*prev = node;
+				node++;
+			}
 		}
 	}
+
+	Z_Free( list );
 }
 
 
 /*
-===========
-FS_Home_FOpenFileRead
-===========
+=================
+FS_FindIndexedFile
+
+Returns the first pak source of the file or NULL
+=================
 */
-int FS_Home_FOpenFileRead( const char *filename, fileHandle_t *file ) 
-{
-	char path[ MAX_OSPATH*3 + 1 ];
-	fileHandleData_t *fd;
-	fileHandle_t f;	
+static const fileIndex_t *FS_FindIndexedFile( const char *filename, unsigned int fullHash ) {
+	const fileIndex_t *entry;
 
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	if ( !fs_indexTable ) {
+		FS_BuildIndex();
 	}
 
-	// should never happen but for safe
-	if ( !file ) { 
-		return -1;
+	for ( entry = fs_indexTable[ fullHash & (fs_indexSize-1) ]; entry; entry = entry->next ) {
+		// case and separator insensitive comparisons
+		if ( entry->fullHash == fullHash && !FS_FilenameCompare( entry->name, filename ) ) {
+			return entry;
+		}
 	}
 
-	// allocate new file handle
-	f = FS_HandleForFile(); 
+	return NULL;
+}
+
+
+/*
+=================
+FS_FindPureIndexedFile
+
+Returns the first source of the file in an allowed pak or NULL,
+order is set to its position in the search path.
+=================
+*/
+static const fileIndex_t *FS_FindPureIndexedFile( const char *filename, unsigned int fullHash, int *order ) {
+	const fileIndex_t *entry;
+
+	for ( entry = FS_FindIndexedFile( filename, fullHash ); entry; entry = entry->nextSource ) {
+		// disregard if it doesn't match one of the allowed pure pak files
+		if ( FS_PakIsPure( entry->search->pack ) ) {
+			*order = entry->order;
+			return entry;
+		}
+	}
+
+	*order = fs_indexPaths;
+	return NULL;
+}
+
+
+/*
+=============================================================================
+
+PK3 MAPPING
+
+A pak is mapped into memory the first time a whole file is read from it.
+Such reads then need neither stdio nor the unzip read buffer, stored files
+are copied and deflated ones are inflated straight from the mapping into
+the destination.
+
+FS_MapFile hands out stored files without any copy. Each of these views
+holds a reference to the mapping, so it stays valid if the pak is freed.
+
+=============================================================================
+*/
+
+#define MAX_PAK_VIEWS	64
+
+typedef struct pakMap_s {
+	const byte	*base;
+	int			length;
+	long		zipOffset;		// bytes before the zipfile
+	int			refs;			// the pak and all views into the mapping
+} pakMap_t;
+
+typedef struct {
+	const void	*base;			// NULL for a free slot
+	pakMap_t	*map;
+} pakView_t;
+
+static cvar_t		*fs_mapPaks;
+static pakView_t	fs_pakViews[ MAX_PAK_VIEWS ];
+
+
+/*
+=================
+FS_MapPak
+=================
+*/
+static pakMap_t *FS_MapPak( pack_t *pak ) {
+	pakMap_t	*map;
+	const void	*base;
+	long		zipOffset;
+	int			length;
+
+	if ( pak->map || pak->mapFailed || !fs_mapPaks->integer ) {
+		return pak->map;
+	}
+
+	base = Sys_MapFile( pak->pakFilename, &length );
+	if ( !base ) {
+		pak->mapFailed = true;
+		return NULL;
+	}
+
+	zipOffset = unzMappedZipOffset( base, length );
+	if ( zipOffset < 0 ) {
+		Sys_UnmapFile( base, length );
+		pak->mapFailed = true;
+		return NULL;
+	}
+
+	map = Z_TagMalloc( sizeof( *map ), TAG_PACK );
+	map->base = base;
+	map->length = length;
+	map->zipOffset = zipOffset;
+	map->refs = 1;
+
+	pak->map = map;
+
+	return map;
+}
+
+
+/*
+=================
+FS_ReleasePakMap
+=================
+*/
+static void FS_ReleasePakMap( pakMap_t *map ) {
+	if ( --map->refs == 0 ) {
+		Sys_UnmapFile( map->base, map->length );
+		Z_Free( map );
+	}
+}
+
+
+/*
+=================
+FS_LocateMappedFile
+=================
+*/
+static bool FS_LocateMappedFile( pack_t *pak, const fileInPack_t *pakFile, unz_mapped_file *file ) {
+	const pakMap_t *map;
+
+	map = FS_MapPak( pak );
+	if ( !map ) {
+		return false;
+	}
+
+	if ( unzLocateMappedFile( map->base, map->length, map->zipOffset, pakFile->pos, file ) != UNZ_OK ) {
+		return false;
+	}
+
+	// mark the pak as having been referenced
+	if ( !( pak->referenced & FS_GENERAL_REF ) && FS_GeneralRef( FS_PakFileName( pak, pakFile ) ) ) {
+		pak->referenced |= FS_GENERAL_REF;
+		fs_pakSequence++;
+	}
+
+	fs_lastPakIndex = pak->index;
+
+	return true;
+}
+
+
+/*
+=================
+FS_ReadFileInPak
+
+Reads a whole file from the mapped pak, returns -1 if
+the pak can't be mapped or the entry is damaged.
+=================
+*/
+static int FS_ReadFileInPak( pack_t *pak, const fileInPack_t *pakFile, void *buffer, int len ) {
+	unz_mapped_file file;
+
+	if ( !FS_LocateMappedFile( pak, pakFile, &file ) ) {
+		return -1;
+	}
+
+	if ( unzReadMappedFile( &file, buffer, len ) != len ) {
+		return -1;
+	}
+
+	if ( fs_debug->integer ) {
+		Com_Printf( "FS_ReadFile: %s (mapped from '%s')\n", FS_PakFileName( pak, pakFile ), pak->pakFilename );
+	}
+
+	return len;
+}
+
+
+/*
+=================
+FS_MapFileInPak
+
+Returns a view of a stored file in the mapped pak. The view must be
+aligned the same way as the lumps in it, zipalign'ed paks are fine.
+=================
+*/
+static const void *FS_MapFileInPak( pack_t *pak, const fileInPack_t *pakFile, int *length ) {
+	unz_mapped_file file;
+	pakView_t *view;
+	int i;
+
+	for ( i = 0, view = fs_pakViews; i < MAX_PAK_VIEWS; i++, view++ ) {
+		if ( !view->base ) {
+			break;
+		}
+	}
+
+	if ( i == MAX_PAK_VIEWS ) {
+		return NULL;
+	}
+
+	if ( !FS_LocateMappedFile( pak, pakFile, &file ) ) {
+		return NULL;
+	}
+
+	if ( file.compression_method != 0 || file.uncompressed_size == 0 || ( (intptr_t)file.data & 3 ) ) {
+		return NULL;
+	}
+
+	view->base = file.data;
+	view->map = pak->map;
+	view->map->refs++;
+
+	if ( fs_debug->integer ) {
+		Com_Printf( "FS_MapFile: %s (found in '%s')\n", FS_PakFileName( pak, pakFile ), pak->pakFilename );
+	}
+
+	*length = (int)file.uncompressed_size;
+	return file.data;
+}
+
+
+static int FS_OpenFileInPak( fileHandle_t *file, pack_t *pak, const fileInPack_t *pakFile, bool uniqueFILE ) {
+	fileHandleData_t *f;
+	unz_s *zfi;
+	FILE *temp;
+
+	// mark the pak as having been referenced and mark specifics on gameclient and ui
+	// these are loaded from all pk3s
+	// from every pk3 file.
+
+	if ( !( pak->referenced & FS_GENERAL_REF ) && FS_GeneralRef( FS_PakFileName( pak, pakFile ) ) ) {
+		pak->referenced |= FS_GENERAL_REF;
+		fs_pakSequence++;
+	}
+
+	if ( !pak->handle ) {
+		pak->handle = unzOpen( pak->pakFilename );
+		if ( !pak->handle ) {
+			Com_Printf( S_COLOR_RED "Error opening %s@%s\n", pak->pakBasename, FS_PakFileName( pak, pakFile ) );
+			*file = FS_INVALID_HANDLE;
+			return -1;
+		}
+	}
+
+	if ( uniqueFILE ) {
+		// open a new file on the pakfile
+		temp = unzReOpen( pak->pakFilename, pak->handle );
+		if ( temp == NULL ) {
+			Com_Printf( S_COLOR_RED "Couldn't reopen %s", pak->pakFilename );
+			*file = FS_INVALID_HANDLE;
+			return -1;
+		}
+	} else {
+		temp = pak->handle;
+	}
+
+	*file = FS_HandleForFile();
+	f = &fsh[ *file ];
+	FS_InitHandle( f );
+
+	f->zipFile = true;
+	f->handleFiles.file.z = temp;
+	f->handleFiles.unique = uniqueFILE;
+
+	Q_strncpyz( f->name, FS_PakFileName( pak, pakFile ), sizeof( f->name ) );
+	zfi = (unz_s *)f->handleFiles.file.z;
+	// in case the file was new
+	temp = zfi->file;
+	// set the file position in the zip file (also sets the current file info)
+	unzSetCurrentFileInfoPosition( pak->handle, pakFile->pos );
+	// copy the file info into the unzip structure
+	Com_Memcpy( zfi, pak->handle, sizeof( *zfi ) );
+	// we copy this back into the structure
+	zfi->file = temp;
+	// open the file in the zip
+	unzOpenCurrentFile( f->handleFiles.file.z );
+	f->zipFilePos = pakFile->pos;
+	f->zipFileLen = pakFile->size;
+	f->pakIndex = pak->index;
+	fs_lastPakIndex = pak->index;
+	f->pak = pak;
+
+#ifdef USE_HANDLE_CACHE
+	if ( pak->next_h ) {
+		FS_RemoveFromHandleList( pak );
+	}
+#endif
+
+	pak->handleUsed++;
+
+	if ( fs_debug->integer ) {
+		Com_Printf( "FS_FOpenFileRead: %s (found in '%s')\n",
+			FS_PakFileName( pak, pakFile ), pak->pakFilename );
+	}
+
+	return zfi->cur_file_info.uncompressed_size;
+}
+
+
+/*
+===========
+FS_OpenFileRead
+
+Finds the file in the search path. If pakFile is given, a file found
+in a pk3 isn't opened but returned there with file set to an invalid
+handle, so it can be read from the mapped pak.
+===========
+*/
+extern bool		com_fullyInitialized;
+
+static int FS_OpenFileRead( const char *filename, fileHandle_t *file, bool uniqueFILE, const fileIndex_t **pakFile ) {
+	const searchpath_t	*search;
+	const fileIndex_t	*entry;
+	char			*netpath;
+	directory_t		*dir;
+	unsigned int	fullHash;
+	FILE			*temp;
+	int				length;
+	int				order;
+	int				i;
+	fileHandleData_t *f;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	if ( !filename ) {
+		Com_Error( ERR_FATAL, "FS_FOpenFileRead: NULL 'filename' parameter passed\n" );
+	}
+
+	// qpaths are not supposed to have a leading slash
+	if ( filename[0] == '/' || filename[0] == '\\' ) {
+		filename++;
+	}
+
+	// make absolutely sure that it can't back up the path.
+	// The searchpaths do guarantee that something will always
+	// be prepended, so we don't need to worry about "c:" or "//limbo"
+	if ( FS_CheckDirTraversal( filename ) ) {
+		*file = FS_INVALID_HANDLE;
+		return -1;
+	}
+
+	// the hash is calculated only once for both the merged index and the miss cache
+	fullHash = FS_HashFileName( filename, 0U );
+
+	if ( file == NULL ) {
+		// just wants to see if file is there
+		entry = FS_FindPureIndexedFile( filename, fullHash, &order );
+
+		// directories before the pak can still override it
+		for ( i = 0; i < fs_numIndexDirs && fs_indexDirs[i].order < order; i++ ) {
+			search = fs_indexDirs[i].search;
+			if ( search->policy == DIR_DENY || FS_FileIsMissing( filename, fullHash, i ) ) {
+				continue;
+			}
+			dir = search->dir;
+			netpath = FS_BuildOSPath( dir->path, dir->gamedir, filename );
+			temp = Sys_FOpen( netpath, "rb" );
+			if ( temp ) {
+				length = FS_FileLength( temp );
+				fclose( temp );
+				return length;
+			}
+			FS_AddMissingFile( filename, fullHash, i );
+		}
+
+		if ( entry ) {
+			// found it!
+			return entry->file->size;
+		}
+
+		return -1;
+	}
+
+	// make sure the q3key file is only readable by the quake3.exe at initialization
+	// any other time the key should only be accessed in memory using the provided functions
+	if ( com_fullyInitialized && strstr( filename, "q3key" ) ) {
+		*file = FS_INVALID_HANDLE;
+		return -1;
+	}
+
+	//
+	// find the first allowed pak with the file, then check the directories in front of it
+	//
+	entry = FS_FindPureIndexedFile( filename, fullHash, &order );
+
+	for ( i = 0; i < fs_numIndexDirs && fs_indexDirs[i].order < order; i++ ) {
+		search = fs_indexDirs[i].search;
+		if ( search->policy == DIR_DENY || FS_FileIsMissing( filename, fullHash, i ) ) {
+			continue;
+		}
+
+		// check a file in the directory tree
+		dir = search->dir;
+
+		netpath = FS_BuildOSPath( dir->path, dir->gamedir, filename );
+
+		temp = Sys_FOpen( netpath, "rb" );
+		if ( temp == NULL ) {
+			FS_AddMissingFile( filename, fullHash, i );
+			continue;
+		}
+
+		*file = FS_HandleForFile();
+		f = &fsh[ *file ];
+		FS_InitHandle( f );
+
+		f->handleFiles.file.o = temp;
+		Q_strncpyz( f->name, filename, sizeof( f->name ) );
+		f->zipFile = false;
+
+		if ( fs_debug->integer ) {
+			Com_Printf( "FS_FOpenFileRead: %s (found in '%s/%s')\n", filename,
+				dir->path, dir->gamedir );
+		}
+
+		return FS_FileLength( f->handleFiles.file.o );
+	}
+
+	if ( entry ) {
+		// found it!
+		if ( pakFile ) {
+			*pakFile = entry;
+			*file = FS_INVALID_HANDLE;
+			return entry->file->size;
+		}
+		return FS_OpenFileInPak( file, entry->search->pack, entry->file, uniqueFILE );
+	}
+
+#ifdef FS_MISSING
+	if ( missingFiles ) {
+		fprintf( missingFiles, "%s\n", filename );
+	}
+#endif
+
+	*file = FS_INVALID_HANDLE;
+	return -1;
+}
+
+
+/*
+===========
+FS_FOpenFileRead
+
+Finds the file in the search path.
+Returns filesize and an open FILE pointer.
+Used for streaming data out of either a
+separate file or a ZIP file.
+===========
+*/
+int FS_FOpenFileRead( const char *filename, fileHandle_t *file, bool uniqueFILE ) {
+	return FS_OpenFileRead( filename, file, uniqueFILE, NULL );
+}
+
+
+/*
+===========
+FS_MapFile
+
+Maps a file read-only into memory if the search path resolves it to a
+plain file or a stored file in a pk3. Returns NULL if the file is missing,
+compressed or can't be mapped, the caller should then fall back to reading it.
+===========
+*/
+const void *FS_MapFile( const char *filename, int *length ) {
+	const searchpath_t	*search;
+	const fileIndex_t	*entry;
+	const directory_t	*dir;
+	const char		*netpath;
+	const void		*base;
+	unsigned int	fullHash;
+	FILE			*temp;
+	int				order;
+	int				i;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	if ( !filename || !length ) {
+		Com_Error( ERR_FATAL, "FS_MapFile: NULL parameter" );
+	}
+
+	// qpaths are not supposed to have a leading slash
+	if ( filename[0] == '/' || filename[0] == '\\' ) {
+		filename++;
+	}
+
+	if ( FS_CheckDirTraversal( filename ) ) {
+		return NULL;
+	}
+
+	fullHash = FS_HashFileName( filename, 0U );
+
+	// a pak with the file stops the search
+	entry = FS_FindPureIndexedFile( filename, fullHash, &order );
+
+	for ( i = 0; i < fs_numIndexDirs && fs_indexDirs[i].order < order; i++ ) {
+		search = fs_indexDirs[i].search;
+		if ( search->policy == DIR_DENY || FS_FileIsMissing( filename, fullHash, i ) ) {
+			continue;
+		}
+		dir = search->dir;
+		netpath = FS_BuildOSPath( dir->path, dir->gamedir, filename );
+		base = Sys_MapFile( netpath, length );
+		if ( base ) {
+			if ( fs_debug->integer ) {
+				Com_Printf( "FS_MapFile: %s (found in '%s/%s')\n", filename, dir->path, dir->gamedir );
+			}
+			return base;
+		}
+		// don't map a file further down the path if this one exists
+		temp = Sys_FOpen( netpath, "rb" );
+		if ( temp ) {
+			fclose( temp );
+			return NULL;
+		}
+		FS_AddMissingFile( filename, fullHash, i );
+	}
+
+	if ( entry ) {
+		return FS_MapFileInPak( entry->search->pack, entry->file, length );
+	}
+
+	return NULL;
+}
+
+
+/*
+===========
+FS_UnmapFile
+===========
+*/
+void FS_UnmapFile( const void *base, int length ) {
+	pakView_t *view;
+	int i;
+
+	for ( i = 0, view = fs_pakViews; i < MAX_PAK_VIEWS; i++, view++ ) {
+		if ( view->base == base ) {
+			FS_ReleasePakMap( view->map );
+			view->base = NULL;
+			view->map = NULL;
+			return;
+		}
+	}
+
+	Sys_UnmapFile( base, length );
+}
+
+
+/*
+===========
+FS_TouchFileInPak
+===========
+*/
+void FS_TouchFileInPak( const char *filename ) {
+	const fileIndex_t *entry;
+	pack_t			*pak;
+
+	for ( entry = FS_FindIndexedFile( filename, FS_HashFileName( filename, 0U ) ); entry; entry = entry->nextSource ) {
+		pak = entry->search->pack;
+
+		if ( pak->exclude ) // skip paks in \fs_excludeReference list
+			continue;
+
+		// found it!
+		if ( !( pak->referenced & FS_GENERAL_REF ) && FS_GeneralRef( filename ) ) {
+			pak->referenced |= FS_GENERAL_REF;
+			fs_pakSequence++;
+		}
+		if ( !( pak->referenced & FS_GAMECLIENT_REF ) && !strcmp( filename, "vm/gameclient.qvm" ) ) {
+			pak->referenced |= FS_GAMECLIENT_REF;
+			fs_pakSequence++;
+		}
+		if ( !( pak->referenced & FS_UI_REF ) && !strcmp( filename, "vm/ui.qvm" ) ) {
+			pak->referenced |= FS_UI_REF;
+			fs_pakSequence++;
+		}
+		return;
+	}
+}
+
+
+/*
+===========
+FS_Home_FOpenFileRead
+===========
+*/
+int FS_Home_FOpenFileRead( const char *filename, fileHandle_t *file ) 
+{
+	char path[ MAX_OSPATH*3 + 1 ];
+	fileHandleData_t *fd;
+	fileHandle_t f;	
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	// should never happen but for safe
+	if ( !file ) { 
+		return -1;
+	}
+
+	// allocate new file handle
+	f = FS_HandleForFile(); 
 	fd = &fsh[ f ];
 	FS_InitHandle( fd );
 
-	Com_sprintf( path, sizeof( path ), "%s%c%s%c%s", fs_homepath->string,
-		PATH_SEP, fs_gamedir, PATH_SEP, filename );
+	Com_sprintf( path, sizeof( path ), "%s%c%s%c%s", fs_homepath->string,
+		PATH_SEP, fs_gamedir, PATH_SEP, filename );
+
+	if ( fs_debug->integer ) {
+		Com_Printf( "%s: %s\n", __func__, path );
+	}
+
+	fd->handleFiles.file.o = Sys_FOpen( path, "rb" );
+	if ( fd->handleFiles.file.o != NULL ) {
+		Q_strncpyz( fd->name, filename, sizeof( fd->name ) );
+		fd->handleSync = false;
+		fd->zipFile = false;
+		*file = f;
+		return FS_FileLength( fd->handleFiles.file.o );
+	}
+
+	*file = FS_INVALID_HANDLE;
+	return -1;
+}
+
+
+/*
+=================
+FS_Read
+
+Properly handles partial reads
+=================
+*/
+int FS_Read( void *buffer, int len, fileHandle_t f ) {
+	int		block, remaining;
+	int		read;
+	byte	*buf;
+	int		tries;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	if ( f <= 0 || f >= MAX_FILE_HANDLES ) {
+		return 0;
+	}
+
+	buf = (byte *)buffer;
+	fs_readCount += len;
+
+	if ( !fsh[f].zipFile ) {
+		remaining = len;
+		tries = 0;
+		while (remaining) {
+			block = remaining;
+			read = fread( buf, 1, block, fsh[f].handleFiles.file.o );
+			if (read == 0) {
+				// we might have been trying to read from a CD, which
+				// sometimes returns a 0 read on windows
+				if (!tries) {
+					tries = 1;
+				} else {
+					return len-remaining;	//Com_Error (ERR_FATAL, "FS_Read: 0 bytes read");
+				}
+			}
+
+			if (read == -1) {
+				Com_Error (ERR_FATAL, "FS_Read: -1 bytes read");
+			}
+
+			remaining -= read;
+			buf += read;
+		}
+		return len;
+	} else {
+		return unzReadCurrentFile( fsh[f].handleFiles.file.z, buffer, len );
+	}
+}
+
+
+/*
+=================
+FS_Write
+
+Properly handles partial writes
+=================
+*/
+int FS_Write( const void *buffer, int len, fileHandle_t h ) {
+	int		block, remaining;
+	int		written;
+	byte	*buf;
+	int		tries;
+	FILE	*f;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	//if ( h <= 0 || h >= MAX_FILE_HANDLES ) {
+	//	return 0;
+	//}
+
+	f = FS_FileForHandle(h);
+	buf = (byte *)buffer;
+
+	remaining = len;
+	tries = 0;
+	while (remaining) {
+		block = remaining;
+		written = fwrite (buf, 1, block, f);
+		if (written == 0) {
+			if (!tries) {
+				tries = 1;
+			} else {
+				Com_Printf( "FS_Write: 0 bytes written\n" );
+				return 0;
+			}
+		}
+
+		if (written == -1) {
+			Com_Printf( "FS_Write: -1 bytes written\n" );
+			return 0;
+		}
+
+		remaining -= written;
+		buf += written;
+	}
+	if ( fsh[h].handleSync ) {
+		fflush( f );
+	}
+	return len;
+}
+
+void QDECL FS_Printf( fileHandle_t h, const char *fmt, ... ) {
+	va_list		argptr;
+	char		msg[MAXPRINTMSG];
+
+	va_start (argptr,fmt);
+	Q_vsnprintf (msg, sizeof(msg), fmt, argptr);
+	va_end (argptr);
+
+	FS_Write(msg, strlen(msg), h);
+}
+
+#define PK3_SEEK_BUFFER_SIZE 65536
+
+/*
+=================
+FS_Seek
+
+=================
+*/
+int FS_Seek( fileHandle_t f, long offset, fsOrigin_t origin ) {
+	int		_origin;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+		return -1;
+	}
+
+	if ( fsh[f].zipFile == true ) {
+		//FIXME: this is really, really crappy
+		//(but better than what was here before)
+		byte	buffer[PK3_SEEK_BUFFER_SIZE];
+		int		remainder;
+		int		currentPosition = FS_FTell( f );
+
+		// change negative offsets into FS_SEEK_SET
+		if ( offset < 0 ) {
+			switch( origin ) {
+				case FS_SEEK_END:
+					remainder = fsh[f].zipFileLen + offset;
+					break;
+
+				case FS_SEEK_CUR:
+					remainder = currentPosition + offset;
+					break;
+
+				case FS_SEEK_SET:
+				default:
+					remainder = 0;
+					break;
+			}
+
+			if ( remainder < 0 ) {
+				remainder = 0;
+			}
+
+			origin = FS_SEEK_SET;
+		} else {
+			if ( origin == FS_SEEK_END ) {
+				remainder = fsh[f].zipFileLen - currentPosition + offset;
+			} else {
+				remainder = offset;
+			}
+		}
+
+		switch( origin ) {
+			case FS_SEEK_SET:
+				if ( remainder == currentPosition ) {
+					return offset;
+				}
+				unzSetCurrentFileInfoPosition( fsh[f].handleFiles.file.z, fsh[f].zipFilePos );
+				unzOpenCurrentFile( fsh[f].handleFiles.file.z );
+				//fallthrough
+
+			case FS_SEEK_END:
+			case FS_SEEK_CUR:
+				while( remainder > PK3_SEEK_BUFFER_SIZE ) {
+					FS_Read( buffer, PK3_SEEK_BUFFER_SIZE, f );
+					remainder -= PK3_SEEK_BUFFER_SIZE;
+				}
+				FS_Read( buffer, remainder, f );
+				return offset;
+
+			default:
+				Com_Error( ERR_FATAL, "Bad origin in FS_Seek" );
+				return -1;
+		}
+	} else {
+		FILE *file;
+		file = FS_FileForHandle( f );
+		switch( origin ) {
+		case FS_SEEK_CUR:
+			_origin = SEEK_CUR;
+			break;
+		case FS_SEEK_END:
+			_origin = SEEK_END;
+			break;
+		case FS_SEEK_SET:
+			_origin = SEEK_SET;
+			break;
+		default:
+			Com_Error( ERR_FATAL, "Bad origin in FS_Seek" );
+			return -1;
+		}
+
+		return fseek( file, offset, _origin );
+	}
+}
+
+
+/*
+=============================================================================
+
+MAP LOAD PREFETCH
+
+The names of all files read with FS_ReadFile between FS_BeginMapLoad and
+FS_EndMapLoad are recorded to prefetch/<map>.<part>.txt below fs_homepath.
+On the next load of the same part of the map the listed files that come
+from mapped pk3s are inflated on the worker threads before the loading
+starts, up to fs_prefetch megabytes, and FS_ReadFile only copies them.
+Prefetched files that weren't read are dropped at the end of the load.
+
+=============================================================================
+*/
+
+#define MAX_PREFETCH_FILES	4096
+#define RECORD_HASH_SIZE	1024
+
+typedef struct {
+	pack_t				*pack;
+	const fileInPack_t	*file;
+	unz_mapped_file		mapped;
+	byte				*data;		// malloc'ed, NULL once it's used or if it couldn't be read
+	int					length;
+} prefetchFile_t;
+
+typedef struct recordedFile_s {
+	struct recordedFile_s *next;
+	char				name[1];
+} recordedFile_t;
+
+static cvar_t			*fs_prefetch;
+
+static char				fs_recordPath[ MAX_QPATH ];	// empty if not recording
+static int				fs_recordLength;			// of the loaded list, to skip unchanged writes
+static unsigned int		fs_recordChecksum;
+static recordedFile_t	*fs_recordHash[ RECORD_HASH_SIZE ];
+static recordedFile_t	*fs_recordList[ MAX_PREFETCH_FILES ];	// in the order of the first read
+static int				fs_numRecorded;
+
+static prefetchFile_t	*fs_prefetchFiles;
+static int				fs_numPrefetchFiles;
+static int				fs_prefetchNext;			// where the next read is expected
+static int				fs_prefetchReady;
+static int				fs_prefetchHits;
+
+
+/*
+=================
+FS_RecordFileRead
+=================
+*/
+static void FS_RecordFileRead( const char *qpath ) {
+	recordedFile_t *rec;
+	long hash;
+	int len;
+
+	if ( !fs_recordPath[0] || fs_numRecorded >= MAX_PREFETCH_FILES ) {
+		return;
+	}
+
+	// qpaths are not supposed to have a leading slash
+	if ( qpath[0] == '/' || qpath[0] == '\\' ) {
+		qpath++;
+	}
+
+	hash = FS_HashFileName( qpath, RECORD_HASH_SIZE );
+	for ( rec = fs_recordHash[ hash ]; rec; rec = rec->next ) {
+		if ( !FS_FilenameCompare( rec->name, qpath ) ) {
+			return;
+		}
+	}
+
+	len = (int)strlen( qpath );
+	rec = Z_Malloc( sizeof( *rec ) + len );
+	Com_Memcpy( rec->name, qpath, len + 1 );
+	rec->next = fs_recordHash[ hash ];
+	fs_recordHash[ hash ] = rec;
+	fs_recordList[ fs_numRecorded++ ] = rec;
+}
+
+
+/*
+=================
+FS_WriteRecordedFiles
+=================
+*/
+static void FS_WriteRecordedFiles( void ) {
+	fileHandle_t f;
+	char *text, *s;
+	int i, length;
+
+	if ( !fs_numRecorded ) {
+		return;
+	}
+
+	length = 0;
+	for ( i = 0; i < fs_numRecorded; i++ ) {
+		length += (int)strlen( fs_recordList[i]->name ) + 1;
+	}
+
+	text = Z_Malloc( length + 1 );
+	for ( i = 0, s = text; i < fs_numRecorded; i++ ) {
+		s = Q_stradd( s, fs_recordList[i]->name );
+		*s++ = '\n';
+	}
+
+	if ( length == fs_recordLength && Com_BlockChecksum( text, length ) == fs_recordChecksum ) {
+		Z_Free( text );
+		return;
+	}
+
+	f = FS_SV_FOpenFileWrite( fs_recordPath );
+	if ( f == FS_INVALID_HANDLE ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't write %s\n", fs_recordPath );
+		Z_Free( text );
+		return;
+	}
+
+	FS_Write( text, length, f );
+	FS_FCloseFile( f );
+
+	Z_Free( text );
+
+	Com_DPrintf( "wrote %s\n", fs_recordPath );
+}
+
+
+/*
+=================
+FS_StopMapLoad
+
+Ends recording and drops all prefetched files.
+=================
+*/
+static void FS_StopMapLoad( bool writeRecord ) {
+	recordedFile_t *rec, *next;
+	int i;
+
+	if ( fs_recordPath[0] && writeRecord ) {
+		FS_WriteRecordedFiles();
+	}
+
+	for ( i = 0; i < RECORD_HASH_SIZE; i++ ) {
+		for ( rec = fs_recordHash[i]; rec; rec = next ) {
+			next = rec->next;
+			Z_Free( rec );
+		}
+		fs_recordHash[i] = NULL;
+	}
+
+	fs_numRecorded = 0;
+	fs_recordPath[0] = '\0';
+
+	if ( fs_prefetchFiles ) {
+		Com_DPrintf( "%i of %i prefetched files used\n", fs_prefetchHits, fs_prefetchReady );
+		for ( i = 0; i < fs_numPrefetchFiles; i++ ) {
+			free( fs_prefetchFiles[i].data );
+		}
+		Z_Free( fs_prefetchFiles );
+		fs_prefetchFiles = NULL;
+	}
+
+	fs_numPrefetchFiles = 0;
+	fs_prefetchNext = 0;
+	fs_prefetchReady = 0;
+	fs_prefetchHits = 0;
+}
+
+
+static void FS_PrefetchJob( void *data, int index, int thread ) {
+	prefetchFile_t *pf = (prefetchFile_t *)data + index;
+
+	if ( unzReadMappedFile( &pf->mapped, pf->data, pf->length ) != pf->length ) {
+		free( pf->data );
+		pf->data = NULL;
+	}
+}
+
+
+/*
+=================
+FS_PrefetchFiles
+
+Inflates the files of a recorded list that are found in mapped pk3s.
+=================
+*/
+static void FS_PrefetchFiles( char *text ) {
+	const fileIndex_t *entry;
+	const pakMap_t	*map;
+	prefetchFile_t	*pf;
+	fileHandle_t	h;
+	char			*name, *s;
+	int				count, budget, total, start, i;
+
+	count = 0;
+	for ( s = text; *s; s++ ) {
+		if ( *s == '\n' ) {
+			count++;
+		}
+	}
+	if ( count > MAX_PREFETCH_FILES ) {
+		count = MAX_PREFETCH_FILES;
+	}
+	if ( count == 0 ) {
+		return;
+	}
+
+	start = Sys_Milliseconds();
+
+	fs_prefetchFiles = Z_Malloc( count * sizeof( fs_prefetchFiles[0] ) );
+
+	budget = fs_prefetch->integer * 1024 * 1024;
+	total = 0;
+
+	for ( name = text; *name && fs_numPrefetchFiles < count; name = s ) {
+		s = strchr( name, '\n' );
+		if ( !s ) {
+			break;
+		}
+		*s++ = '\0';
+
+		// look it up the same way FS_ReadFile will
+		entry = NULL;
+		FS_OpenFileRead( name, &h, false, &entry );
+		if ( h != FS_INVALID_HANDLE ) {
+			FS_FCloseFile( h );
+			continue;
+		}
+		if ( !entry || entry->file->size > (unsigned int)( budget - total ) ) {
+			continue;
+		}
+
+		map = FS_MapPak( entry->search->pack );
+		if ( !map ) {
+			continue;
+		}
+
+		pf = &fs_prefetchFiles[ fs_numPrefetchFiles ];
+		if ( unzLocateMappedFile( map->base, map->length, map->zipOffset, entry->file->pos, &pf->mapped ) != UNZ_OK ) {
+			continue;
+		}
+
+		pf->data = malloc( entry->file->size + 1 );
+		if ( !pf->data ) {
+			continue;
+		}
+
+		pf->pack = entry->search->pack;
+		pf->file = entry->file;
+		pf->length = entry->file->size;
+		total += pf->length;
+		fs_numPrefetchFiles++;
+	}
+
+	Com_ParallelFor( fs_numPrefetchFiles, FS_PrefetchJob, fs_prefetchFiles );
+
+	total = 0;
+	for ( i = 0; i < fs_numPrefetchFiles; i++ ) {
+		if ( fs_prefetchFiles[i].data ) {
+			total += fs_prefetchFiles[i].length;
+			fs_prefetchReady++;
+		}
+	}
+
+	Com_Printf( "...prefetched %i files, %i KB in %i msec\n", fs_prefetchReady, total / 1024, Sys_Milliseconds() - start );
+}
+
+
+/*
+=================
+FS_ReadPrefetchedFile
+
+Copies a prefetched file, returns false if it isn't there.
+=================
+*/
+static bool FS_ReadPrefetchedFile( pack_t *pak, const fileInPack_t *pakFile, void *buffer, int len ) {
+	prefetchFile_t *pf;
+	unz_mapped_file file;
+	int i;
+
+	pf = NULL;
+	for ( i = 0; i < fs_numPrefetchFiles; i++ ) {
+		pf = &fs_prefetchFiles[ ( fs_prefetchNext + i ) % fs_numPrefetchFiles ];
+		if ( pf->file == pakFile && pf->pack == pak ) {
+			break;
+		}
+	}
+
+	if ( i == fs_numPrefetchFiles || !pf->data || pf->length != len ) {
+		return false;
+	}
+
+	fs_prefetchNext = (int)( pf - fs_prefetchFiles ) + 1;
+
+	// references are marked the same way as for a regular read
+	if ( !FS_LocateMappedFile( pak, pakFile, &file ) ) {
+		return false;
+	}
+
+	Com_Memcpy( buffer, pf->data, len );
+	free( pf->data );
+	pf->data = NULL;
+	fs_prefetchHits++;
 
 	if ( fs_debug->integer ) {
-		Com_Printf( "%s: %s\n", __func__, path );
+		Com_Printf( "FS_ReadFile: %s (prefetched from '%s')\n", FS_PakFileName( pak, pakFile ), pak->pakFilename );
 	}
 
-	fd->handleFiles.file.o = Sys_FOpen( path, "rb" );
-	if ( fd->handleFiles.file.o != NULL ) {
-		Q_strncpyz( fd->name, filename, sizeof( fd->name ) );
-		fd->handleSync = false;
-		fd->zipFile = false;
-		*file = f;
-		return FS_FileLength( fd->handleFiles.file.o );
+	return true;
+}
+
+
+/*
+=================
+FS_BeginMapLoad
+
+Starts recording the files read for a part of the map load,
+and prefetches the files recorded the last time.
+=================
+*/
+void FS_BeginMapLoad( const char *mapname, const char *part ) {
+	char			base[ MAX_QPATH ];
+	fileHandle_t	f;
+	char			*text;
+	int				length;
+
+	FS_StopMapLoad( false );
+
+	if ( !fs_searchpaths || !fs_prefetch->integer ) {
+		return;
 	}
 
-	*file = FS_INVALID_HANDLE;
-	return -1;
+	COM_StripExtension( COM_SkipPath( (char *)mapname ), base, sizeof( base ) );
+	Com_sprintf( fs_recordPath, sizeof( fs_recordPath ), "prefetch/%s.%s.txt", base, part );
+	fs_recordLength = 0;
+	fs_recordChecksum = 0;
+
+	length = FS_SV_FOpenFileRead( fs_recordPath, &f );
+	if ( f == FS_INVALID_HANDLE ) {
+		return;
+	}
+
+	text = Hunk_AllocateTempMemory( length + 1 );
+	if ( FS_Read( text, length, f ) != length ) {
+		Hunk_FreeTempMemory( text );
+		FS_FCloseFile( f );
+		return;
+	}
+	FS_FCloseFile( f );
+	text[ length ] = '\0';
+
+	fs_recordLength = length;
+	fs_recordChecksum = Com_BlockChecksum( text, length );
+
+	FS_PrefetchFiles( text );
+
+	Hunk_FreeTempMemory( text );
 }
 
 
 /*
 =================
-FS_Read
+FS_EndMapLoad
+=================
+*/
+void FS_EndMapLoad( void ) {
+	FS_StopMapLoad( true );
+}
 
-Properly handles partial reads
+
+/*
+=============================================================================
+
+ASYNCHRONOUS FILE READS
+
+FS_ReadFileAsync looks the file up on the main thread, so the pure and
+search path rules are the same as for FS_ReadFile, and queues the read.
+Files from memory mapped pk3s are inflated and loose files are read on
+the reader threads, highest priority first. Files from pk3s that can't be
+mapped are read on the main thread when the request is called back.
+
+Callbacks are only called from FS_RunAsyncReads. FS_ReadFile of the same
+file from inside the callback is served from the buffer that was just read,
+so loaders that take a file name can be used unchanged.
+
+Slots are only taken and freed on the main thread. The reader threads
+change the state of the requests they read, always with the lock held.
+
+=============================================================================
+*/
+
+#define MAX_ASYNC_READS		1024
+#define MAX_ASYNC_THREADS	4
+
+typedef enum {
+	AR_FREE,
+	AR_QUEUED,			// waiting for a reader thread
+	AR_READING,			// owned by the thread that reads it
+	AR_DONE,			// waiting to be called back
+	AR_CANCELLED,		// cancelled while it was being read
+	AR_DISCARDED		// cancelled and read, waiting to be freed
+} asyncReadState_t;
+
+typedef struct {
+	asyncReadState_t	state;
+	int					id;
+	fsAsyncPriority_t	priority;
+	int					order;			// keeps requests of the same priority in order
+	fsAsyncCallback_t	callback;
+	void				*data;
+	char				qpath[ MAX_ZPATH ];
+	bool				mainThread;		// read with FS_ReadFile when it's called back
+	bool				isMapped;
+	unz_mapped_file		mapped;
+	FILE				*file;			// loose file, closed by the reader
+	byte				*buffer;		// malloc'ed by the reader, NULL if the read failed
+	int					length;
+} asyncRead_t;
+
+static asyncRead_t	fs_asyncReads[ MAX_ASYNC_READS ];
+static int			fs_asyncSerial;
+static int			fs_asyncOrder;
+static int			fs_numAsyncReads;		// requests that aren't AR_FREE, only changed on the main thread
+static int			fs_numAsyncQueued;
+static int			fs_numAsyncReading;		// including the cancelled ones
+
+static void			*fs_asyncThreads[ MAX_ASYNC_THREADS ];
+static int			fs_numAsyncThreads;
+static void			*fs_asyncLock;
+static void			*fs_asyncWake;			// posted once for each queued request
+static void			*fs_asyncDone;			// posted when a read finishes while the main thread waits
+static bool			fs_asyncWaiting;
+static bool			fs_asyncShutdown;
+
+// the request that is being called back
+static const char	*fs_asyncPath;
+static byte			*fs_asyncBuffer;
+static int			fs_asyncLength;
+
+
+static void FS_LockAsyncReads( void ) {
+	if ( fs_asyncLock ) {
+		Sys_LockMutex( fs_asyncLock );
+	}
+}
+
+
+static void FS_UnlockAsyncReads( void ) {
+	if ( fs_asyncLock ) {
+		Sys_UnlockMutex( fs_asyncLock );
+	}
+}
+
+
+/*
+=================
+FS_FreeAsyncRead
+
+Must be called on the main thread with the lock held.
 =================
 */
-int FS_Read( void *buffer, int len, fileHandle_t f ) {
-	int		block, remaining;
-	int		read;
-	byte	*buf;
-	int		tries;
+static void FS_FreeAsyncRead( asyncRead_t *r ) {
+	if ( r->file ) {
+		fclose( r->file );
+	}
+	free( r->buffer );
+	Com_Memset( r, 0, sizeof( *r ) );
+	fs_numAsyncReads--;
+}
+
+
+/*
+=================
+FS_NextAsyncRead
+
+Takes the queued request with the highest priority, must be called with the lock held.
+=================
+*/
+static asyncRead_t *FS_NextAsyncRead( void ) {
+	asyncRead_t *r, *best;
+	int i;
+
+	if ( !fs_numAsyncQueued ) {
+		return NULL;
+	}
+
+	best = NULL;
+	for ( i = 0, r = fs_asyncReads; i < MAX_ASYNC_READS; i++, r++ ) {
+		if ( r->state != AR_QUEUED ) {
+			continue;
+		}
+		if ( !best || r->priority > best->priority || ( r->priority == best->priority && r->order - best->order < 0 ) ) {
+			best = r;
+		}
+	}
+
+	if ( best ) {
+		best->state = AR_READING;
+		fs_numAsyncQueued--;
+		fs_numAsyncReading++;
+	}
+
+	return best;
+}
+
+
+/*
+=================
+FS_ReadAsyncFile
+
+Reads a request taken with FS_NextAsyncRead, runs without the lock.
+=================
+*/
+static void FS_ReadAsyncFile( asyncRead_t *r ) {
+	bool ok;
+
+	r->buffer = malloc( r->length + 1 );
+	if ( r->buffer ) {
+		if ( r->isMapped ) {
+			ok = ( unzReadMappedFile( &r->mapped, r->buffer, r->length ) == r->length );
+		} else {
+			ok = ( fread( r->buffer, 1, r->length, r->file ) == (size_t)r->length );
+		}
+		if ( ok ) {
+			r->buffer[ r->length ] = '\0';
+		} else {
+			free( r->buffer );
+			r->buffer = NULL;
+		}
+	}
+
+	if ( r->file ) {
+		fclose( r->file );
+		r->file = NULL;
+	}
+
+	FS_LockAsyncReads();
+	fs_numAsyncReading--;
+	if ( r->state == AR_CANCELLED ) {
+		r->state = AR_DISCARDED;
+	} else {
+		r->state = AR_DONE;
+	}
+	if ( fs_asyncWaiting ) {
+		fs_asyncWaiting = false;
+		Sys_SemaphorePost( fs_asyncDone );
+	}
+	FS_UnlockAsyncReads();
+}
+
+
+/*
+=================
+FS_AsyncReader
+=================
+*/
+static void FS_AsyncReader( void *arg ) {
+	asyncRead_t *r;
+
+	for ( ;; ) {
+		Sys_SemaphoreWait( fs_asyncWake );
+
+		if ( fs_asyncShutdown ) {
+			break;
+		}
+
+		Sys_LockMutex( fs_asyncLock );
+		r = FS_NextAsyncRead();
+		Sys_UnlockMutex( fs_asyncLock );
+
+		// the main thread may have taken it while waiting
+		if ( r ) {
+			FS_ReadAsyncFile( r );
+		}
+	}
+}
+
+
+/*
+=================
+FS_StartAsyncReaders
+
+The readers are started with the first request, one for each job worker
+up to MAX_ASYNC_THREADS. Without workers all reads are done by FS_RunAsyncReads.
+=================
+*/
+static void FS_StartAsyncReaders( void ) {
+	int count;
+
+	count = Com_JobWorkers();
+	if ( count > MAX_ASYNC_THREADS ) {
+		count = MAX_ASYNC_THREADS;
+	}
+	if ( count == 0 || fs_asyncLock ) {
+		return;
+	}
+
+	fs_asyncLock = Sys_CreateMutex();
+	fs_asyncWake = Sys_CreateSemaphore();
+	fs_asyncDone = Sys_CreateSemaphore();
+	if ( !fs_asyncLock || !fs_asyncWake || !fs_asyncDone ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: failed to create async read synchronization objects\n" );
+		if ( fs_asyncDone ) {
+			Sys_DestroySemaphore( fs_asyncDone );
+			fs_asyncDone = NULL;
+		}
+		if ( fs_asyncWake ) {
+			Sys_DestroySemaphore( fs_asyncWake );
+			fs_asyncWake = NULL;
+		}
+		if ( fs_asyncLock ) {
+			Sys_DestroyMutex( fs_asyncLock );
+			fs_asyncLock = NULL;
+		}
+		return;
+	}
+
+	fs_asyncShutdown = false;
+	for ( fs_numAsyncThreads = 0; fs_numAsyncThreads < count; fs_numAsyncThreads++ ) {
+		fs_asyncThreads[ fs_numAsyncThreads ] = Sys_CreateThread( FS_AsyncReader, NULL );
+		if ( !fs_asyncThreads[ fs_numAsyncThreads ] ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: failed to create async reader thread %i\n", fs_numAsyncThreads );
+			break;
+		}
+	}
+}
+
+
+/*
+=================
+FS_ShutdownAsyncReads
+
+Drops all requests without calling back and stops the readers,
+must be done before the paks are released.
+=================
+*/
+static void FS_ShutdownAsyncReads( void ) {
+	asyncRead_t *r;
+	int i;
+
+	FS_LockAsyncReads();
+	for ( i = 0, r = fs_asyncReads; i < MAX_ASYNC_READS; i++, r++ ) {
+		if ( r->state == AR_READING ) {
+			r->state = AR_CANCELLED;
+		} else if ( r->state == AR_QUEUED || r->state == AR_DONE || r->state == AR_DISCARDED ) {
+			FS_FreeAsyncRead( r );
+		}
+	}
+	fs_numAsyncQueued = 0;
+	while ( fs_numAsyncReading ) {
+		fs_asyncWaiting = true;
+		FS_UnlockAsyncReads();
+		Sys_SemaphoreWait( fs_asyncDone );
+		FS_LockAsyncReads();
+	}
+	for ( i = 0, r = fs_asyncReads; i < MAX_ASYNC_READS; i++, r++ ) {
+		if ( r->state == AR_DISCARDED ) {
+			FS_FreeAsyncRead( r );
+		}
+	}
+	FS_UnlockAsyncReads();
+
+	if ( !fs_asyncLock ) {
+		return;
+	}
+
+	fs_asyncShutdown = true;
+	for ( i = 0; i < fs_numAsyncThreads; i++ ) {
+		Sys_SemaphorePost( fs_asyncWake );
+	}
+	for ( i = 0; i < fs_numAsyncThreads; i++ ) {
+		Sys_JoinThread( fs_asyncThreads[ i ] );
+		fs_asyncThreads[ i ] = NULL;
+	}
+	fs_numAsyncThreads = 0;
+
+	Sys_DestroySemaphore( fs_asyncDone );
+	fs_asyncDone = NULL;
+	Sys_DestroySemaphore( fs_asyncWake );
+	fs_asyncWake = NULL;
+	Sys_DestroyMutex( fs_asyncLock );
+	fs_asyncLock = NULL;
+}
+
+
+/*
+=================
+FS_ReadPrefetchedAsync
+
+Takes a request for a file that was prefetched for the map load
+without handing it to a reader.
+=================
+*/
+static bool FS_ReadPrefetchedAsync( asyncRead_t *r, const fileIndex_t *entry, int length ) {
+	if ( !fs_numPrefetchFiles ) {
+		return false;
+	}
+
+	r->buffer = malloc( length + 1 );
+	if ( !r->buffer ) {
+		return false;
+	}
+
+	if ( !FS_ReadPrefetchedFile( entry->search->pack, entry->file, r->buffer, length ) ) {
+		free( r->buffer );
+		r->buffer = NULL;
+		return false;
+	}
+
+	r->buffer[ length ] = '\0';
+
+	return true;
+}
+
+
+/*
+=================
+FS_ReadFileAsync
+=================
+*/
+int FS_ReadFileAsync( const char *qpath, fsAsyncPriority_t priority, fsAsyncCallback_t callback, void *data ) {
+	const fileIndex_t *entry;
+	fileHandle_t h;
+	asyncRead_t *r;
+	int length, i;
 
 	if ( !fs_searchpaths ) {
 		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
 	}
 
-	if ( f <= 0 || f >= MAX_FILE_HANDLES ) {
+	if ( !qpath || !qpath[0] ) {
+		Com_Error( ERR_FATAL, "FS_ReadFileAsync with empty name" );
+	}
+
+	if ( fs_numAsyncReads >= MAX_ASYNC_READS || strlen( qpath ) >= sizeof( fs_asyncReads[0].qpath ) ) {
 		return 0;
 	}
 
-	buf = (byte *)buffer;
-	fs_readCount += len;
+	// config files have to go through the journal
+	if ( com_journalDataFile != FS_INVALID_HANDLE && strstr( qpath, ".cfg" ) ) {
+		return 0;
+	}
 
-	if ( !fsh[f].zipFile ) {
-		remaining = len;
-		tries = 0;
-		while (remaining) {
-			block = remaining;
-			read = fread( buf, 1, block, fsh[f].handleFiles.file.o );
-			if (read == 0) {
-				// we might have been trying to read from a CD, which
-				// sometimes returns a 0 read on windows
-				if (!tries) {
-					tries = 1;
-				} else {
-					return len-remaining;	//Com_Error (ERR_FATAL, "FS_Read: 0 bytes read");
-				}
-			}
+	// look it up the same way FS_ReadFile does
+	entry = NULL;
+	length = FS_OpenFileRead( qpath, &h, false, &entry );
+	if ( h == FS_INVALID_HANDLE && !entry ) {
+		return 0;
+	}
+
+	FS_RecordFileRead( qpath );
+
+	// the readers only look at the states of the slots, and nothing but
+	// the main thread turns a free slot into a used one or back
+	FS_LockAsyncReads();
+	for ( i = 0, r = fs_asyncReads; i < MAX_ASYNC_READS; i++, r++ ) {
+		if ( r->state == AR_FREE ) {
+			break;
+		}
+	}
+	FS_UnlockAsyncReads();
+
+	if ( h != FS_INVALID_HANDLE ) {
+		// take the loose file over from the handle
+		r->file = fsh[ h ].handleFiles.file.o;
+		fsh[ h ].handleFiles.file.o = NULL;
+		FS_FCloseFile( h );
+	} else if ( FS_ReadPrefetchedAsync( r, entry, length ) ) {
+		// nothing left to read
+	} else if ( FS_LocateMappedFile( entry->search->pack, entry->file, &r->mapped ) ) {
+		r->isMapped = true;
+		if ( fs_debug->integer ) {
+			Com_Printf( "FS_ReadFileAsync: %s (mapped from '%s')\n", qpath, entry->search->pack->pakFilename );
+		}
+	} else {
+		r->mainThread = true;
+	}
+
+	if ( ++fs_asyncSerial >= MAX_QINT / MAX_ASYNC_READS ) {
+		fs_asyncSerial = 1;
+	}
+
+	r->id = fs_asyncSerial * MAX_ASYNC_READS + i;
+	r->priority = priority;
+	r->order = fs_asyncOrder++;
+	r->callback = callback;
+	r->data = data;
+	r->length = length;
+	Q_strncpyz( r->qpath, qpath, sizeof( r->qpath ) );
+
+	fs_numAsyncReads++;
+
+	if ( r->mainThread || r->buffer ) {
+		FS_LockAsyncReads();
+		r->state = AR_DONE;
+		FS_UnlockAsyncReads();
+		return r->id;
+	}
+
+	FS_StartAsyncReaders();
 
-			if (read == -1) {
-				Com_Error (ERR_FATAL, "FS_Read: -1 bytes read");
-			}
+	FS_LockAsyncReads();
+	r->state = AR_QUEUED;
+	fs_numAsyncQueued++;
+	FS_UnlockAsyncReads();
 
-			remaining -= read;
-			buf += read;
-		}
-		return len;
-	} else {
-		return unzReadCurrentFile( fsh[f].handleFiles.file.z, buffer, len );
+	if ( fs_asyncWake ) {
+		Sys_SemaphorePost( fs_asyncWake );
 	}
+
+	return r->id;
 }
 
 
 /*
 =================
-FS_Write
-
-Properly handles partial writes
+FS_CancelAsyncRead
 =================
 */
-int FS_Write( const void *buffer, int len, fileHandle_t h ) {
-	int		block, remaining;
-	int		written;
-	byte	*buf;
-	int		tries;
-	FILE	*f;
+void FS_CancelAsyncRead( int request ) {
+	asyncRead_t *r;
 
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	if ( request <= 0 ) {
+		return;
 	}
 
-	//if ( h <= 0 || h >= MAX_FILE_HANDLES ) {
-	//	return 0;
-	//}
-
-	f = FS_FileForHandle(h);
-	buf = (byte *)buffer;
+	r = &fs_asyncReads[ request % MAX_ASYNC_READS ];
 
-	remaining = len;
-	tries = 0;
-	while (remaining) {
-		block = remaining;
-		written = fwrite (buf, 1, block, f);
-		if (written == 0) {
-			if (!tries) {
-				tries = 1;
-			} else {
-				Com_Printf( "FS_Write: 0 bytes written\n" );
-				return 0;
+	FS_LockAsyncReads();
+	if ( r->id == request ) {
+		if ( r->state == AR_READING ) {
+			r->state = AR_CANCELLED;
+		} else if ( r->state == AR_QUEUED || r->state == AR_DONE ) {
+			if ( r->state == AR_QUEUED ) {
+				fs_numAsyncQueued--;
 			}
+			FS_FreeAsyncRead( r );
 		}
+	}
+	FS_UnlockAsyncReads();
+}
 
-		if (written == -1) {
-			Com_Printf( "FS_Write: -1 bytes written\n" );
-			return 0;
-		}
 
-		remaining -= written;
-		buf += written;
-	}
-	if ( fsh[h].handleSync ) {
-		fflush( f );
+/*
+=================
+FS_CallAsyncRead
+
+Calls back a request that is done, the slot is freed first
+so the callback can queue, cancel and run other requests.
+=================
+*/
+static void FS_CallAsyncRead( asyncRead_t *r ) {
+	fsAsyncCallback_t	callback;
+	void				*data;
+	char				qpath[ MAX_ZPATH ];
+	byte				*buffer;
+	int					length;
+	const char			*oldPath;
+	byte				*oldBuffer;
+	int					oldLength;
+	bool				mainThread;
+
+	callback = r->callback;
+	data = r->data;
+	mainThread = r->mainThread;
+	Q_strncpyz( qpath, r->qpath, sizeof( qpath ) );
+
+	buffer = r->buffer;
+	length = buffer ? r->length : -1;
+	r->buffer = NULL;
+
+	FS_LockAsyncReads();
+	FS_FreeAsyncRead( r );
+	FS_UnlockAsyncReads();
+
+	if ( mainThread ) {
+		length = FS_ReadFile( qpath, (void **)&buffer );
+	} else if ( buffer ) {
+		fs_loadCount++;
 	}
-	return len;
-}
 
-void QDECL FS_Printf( fileHandle_t h, const char *fmt, ... ) {
-	va_list		argptr;
-	char		msg[MAXPRINTMSG];
+	oldPath = fs_asyncPath;
+	oldBuffer = fs_asyncBuffer;
+	oldLength = fs_asyncLength;
 
-	va_start (argptr,fmt);
-	Q_vsnprintf (msg, sizeof(msg), fmt, argptr);
-	va_end (argptr);
+	fs_asyncPath = qpath;
+	fs_asyncBuffer = buffer;
+	fs_asyncLength = length;
 
-	FS_Write(msg, strlen(msg), h);
+	callback( data, qpath, buffer, length );
+
+	fs_asyncPath = oldPath;
+	fs_asyncBuffer = oldBuffer;
+	fs_asyncLength = oldLength;
+
+	if ( !mainThread ) {
+		free( buffer );
+	} else if ( buffer ) {
+		FS_FreeFile( buffer );
+	}
 }
 
-#define PK3_SEEK_BUFFER_SIZE 65536
 
 /*
 =================
-FS_Seek
+FS_RunAsyncReads
 
+Requests are called back in the order they were queued, by priority.
+The main thread reads queued requests itself while waiting, and all
+of them when there are no reader threads.
 =================
 */
-int FS_Seek( fileHandle_t f, long offset, fsOrigin_t origin ) {
-	int		_origin;
-
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
-		return -1;
-	}
-
-	if ( fsh[f].zipFile == true ) {
-		//FIXME: this is really, really crappy
-		//(but better than what was here before)
-		byte	buffer[PK3_SEEK_BUFFER_SIZE];
-		int		remainder;
-		int		currentPosition = FS_FTell( f );
-
-		// change negative offsets into FS_SEEK_SET
-		if ( offset < 0 ) {
-			switch( origin ) {
-				case FS_SEEK_END:
-					remainder = fsh[f].zipFileLen + offset;
-					break;
+void FS_RunAsyncReads( bool wait ) {
+	asyncRead_t *r, *best;
+	int i;
 
-				case FS_SEEK_CUR:
-					remainder = currentPosition + offset;
-					break;
+	while ( fs_numAsyncReads ) {
+		FS_LockAsyncReads();
 
-				case FS_SEEK_SET:
-				default:
-					remainder = 0;
-					break;
+		best = NULL;
+		for ( i = 0, r = fs_asyncReads; i < MAX_ASYNC_READS; i++, r++ ) {
+			if ( r->state == AR_DISCARDED ) {
+				FS_FreeAsyncRead( r );
+				continue;
 			}
-
-			if ( remainder < 0 ) {
-				remainder = 0;
+			if ( r->state != AR_DONE ) {
+				continue;
 			}
-
-			origin = FS_SEEK_SET;
-		} else {
-			if ( origin == FS_SEEK_END ) {
-				remainder = fsh[f].zipFileLen - currentPosition + offset;
-			} else {
-				remainder = offset;
+			if ( !best || r->priority > best->priority || ( r->priority == best->priority && r->order - best->order < 0 ) ) {
+				best = r;
 			}
 		}
 
-		switch( origin ) {
-			case FS_SEEK_SET:
-				if ( remainder == currentPosition ) {
-					return offset;
-				}
-				unzSetCurrentFileInfoPosition( fsh[f].handleFiles.file.z, fsh[f].zipFilePos );
-				unzOpenCurrentFile( fsh[f].handleFiles.file.z );
-				//fallthrough
+		if ( best ) {
+			FS_UnlockAsyncReads();
+			FS_CallAsyncRead( best );
+			continue;
+		}
 
-			case FS_SEEK_END:
-			case FS_SEEK_CUR:
-				while( remainder > PK3_SEEK_BUFFER_SIZE ) {
-					FS_Read( buffer, PK3_SEEK_BUFFER_SIZE, f );
-					remainder -= PK3_SEEK_BUFFER_SIZE;
-				}
-				FS_Read( buffer, remainder, f );
-				return offset;
+		if ( !wait && fs_numAsyncThreads ) {
+			FS_UnlockAsyncReads();
+			break;
+		}
 
-			default:
-				Com_Error( ERR_FATAL, "Bad origin in FS_Seek" );
-				return -1;
+		r = FS_NextAsyncRead();
+		if ( r ) {
+			FS_UnlockAsyncReads();
+			FS_ReadAsyncFile( r );
+			continue;
 		}
-	} else {
-		FILE *file;
-		file = FS_FileForHandle( f );
-		switch( origin ) {
-		case FS_SEEK_CUR:
-			_origin = SEEK_CUR;
-			break;
-		case FS_SEEK_END:
-			_origin = SEEK_END;
-			break;
-		case FS_SEEK_SET:
-			_origin = SEEK_SET;
+
+		if ( !fs_numAsyncReading ) {
+			FS_UnlockAsyncReads();
 			break;
-		default:
-			Com_Error( ERR_FATAL, "Bad origin in FS_Seek" );
-			return -1;
 		}
 
-		return fseek( file, offset, _origin );
+		fs_asyncWaiting = true;
+		FS_UnlockAsyncReads();
+		Sys_SemaphoreWait( fs_asyncDone );
+	}
+}
+
+
+/*
+=================
+FS_ReadCalledBackFile
+
+Serves FS_ReadFile of the file whose callback is running,
+returns -2 if it's another file.
+=================
+*/
+static int FS_ReadCalledBackFile( const char *qpath, void **buffer ) {
+	byte *buf;
+
+	if ( !fs_asyncBuffer ) {
+		return -2;
+	}
+
+	if ( qpath[0] == '/' || qpath[0] == '\\' ) {
+		qpath++;
+	}
+
+	if ( FS_FilenameCompare( qpath, fs_asyncPath ) ) {
+		return -2;
+	}
+
+	if ( buffer ) {
+		buf = Hunk_AllocateTempMemory( fs_asyncLength + 1 );
+		Com_Memcpy( buf, fs_asyncBuffer, fs_asyncLength + 1 );
+		*buffer = buf;
+		fs_loadStack++;
 	}
+
+	return fs_asyncLength;
 }
 
 
@@ -1979,12 +3622,31 @@ CONVENIENCE FUNCTIONS FOR ENTIRE FILES
 ======================================================================================
 */
 
+/*
+=================
+FS_PakPureChecksum
+
+The pure checksum depends on the checksum feed, paks loaded from
+the cache compute it on first use and keep it until the feed changes.
+=================
+*/
+static int FS_PakPureChecksum( pack_t *pak ) {
+#ifdef USE_PK3_CACHE
+	if ( !pak->pureChecksumValid || pak->checksumFeed != fs_checksumFeed ) {
+		pak->headerLongs[ 0 ] = LittleLong( fs_checksumFeed );
+		pak->pure_checksum = Com_BlockChecksum( pak->headerLongs, sizeof( pak->headerLongs[0] ) * pak->numHeaderLongs );
+		pak->pure_checksum = LittleLong( pak->pure_checksum );
+		pak->checksumFeed = fs_checksumFeed;
+		pak->pureChecksumValid = true;
+	}
+#endif
+	return pak->pure_checksum;
+}
+
+
 bool FS_FileIsInPAK( const char *filename, int *pChecksum, char *pakName ) {
-	const searchpath_t	*search;
-	const pack_t		*pak;
-	const fileInPack_t	*pakFile;
-	long			hash;
-	long			fullHash;
+	const fileIndex_t	*entry;
+	pack_t				*pak;
 
 	if ( !fs_searchpaths ) {
 		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
@@ -2005,41 +3667,28 @@ bool FS_FileIsInPAK( const char *filename, int *pChecksum, char *pakName ) {
 		return false;
 	}
 
-	fullHash = FS_HashFileName( filename, 0U );
-
 	//
-	// search through the path, one element at a time
+	// search through the paks containing the file, in search order
 	//
-	for ( search = fs_searchpaths ; search ; search = search->next ) {
-
-		// is the element a pak file?
-		if ( search->pack && search->pack->hashTable[ (hash = fullHash & (search->pack->hashSize-1)) ] ) {
-			// disregard if it doesn't match one of the allowed pure pak files
-			//if ( !FS_PakIsPure( search->pack ) ) {
-			//	continue;
-			//}
-			//
-			if ( search->pack->exclude ) {
-				continue;
-			}
+	for ( entry = FS_FindIndexedFile( filename, FS_HashFileName( filename, 0U ) ); entry; entry = entry->nextSource ) {
+		pak = entry->search->pack;
+
+		// disregard if it doesn't match one of the allowed pure pak files
+		//if ( !FS_PakIsPure( pak ) ) {
+		//	continue;
+		//}
+		//
+		if ( pak->exclude ) {
+			continue;
+		}
 
-			// look through all the pak file elements
-			pak = search->pack;
-			pakFile = pak->hashTable[hash];
-			do {
-				// case and separator insensitive comparisons
-				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-					if ( pChecksum ) {
-						*pChecksum = pak->pure_checksum;
-					}
-					if ( pakName ) {
-						Com_sprintf( pakName, MAX_OSPATH, "%s/%s", pak->pakGamename, pak->pakBasename );
-					}
-					return true;
-				}
-				pakFile = pakFile->next;
-			} while ( pakFile != NULL );
+		if ( pChecksum ) {
+			*pChecksum = FS_PakPureChecksum( pak );
+		}
+		if ( pakName ) {
+			Com_sprintf( pakName, MAX_OSPATH, "%s/%s", pak->pakGamename, pak->pakBasename );
 		}
+		return true;
 	}
 	return false;
 }
@@ -2054,6 +3703,7 @@ a null buffer will just return the file length without loading
 ============
 */
 int FS_ReadFile( const char *qpath, void **buffer ) {
+	const fileIndex_t *pakFile;
 	fileHandle_t	h;
 	byte*			buf;
 	bool		isConfig;
@@ -2114,9 +3764,16 @@ int FS_ReadFile( const char *qpath, void **buffer ) {
 		}
 	}
 
+	// inside an async read callback
+	len = FS_ReadCalledBackFile( qpath, buffer );
+	if ( len != -2 ) {
+		return len;
+	}
+
 	// look for it in the filesystem or pack files
-	len = FS_FOpenFileRead( qpath, &h, false );
-	if ( h == FS_INVALID_HANDLE ) {
+	pakFile = NULL;
+	len = FS_OpenFileRead( qpath, &h, false, &pakFile );
+	if ( h == FS_INVALID_HANDLE && !pakFile ) {
 		if ( buffer ) {
 			*buffer = NULL;
 		}
@@ -2131,26 +3788,46 @@ int FS_ReadFile( const char *qpath, void **buffer ) {
 	}
 
 	if ( !buffer ) {
+		if ( pakFile ) {
+			// still reference the pak
+			len = FS_OpenFileInPak( &h, pakFile->search->pack, pakFile->file, false );
+		}
 		if ( isConfig ) {
 			Com_DPrintf( "Writing len for %s to journal file.\n", qpath );
 			FS_Write( &len, sizeof( len ), com_journalDataFile );
 			FS_Flush( com_journalDataFile );
 		}
-		FS_FCloseFile( h );
+		if ( h != FS_INVALID_HANDLE ) {
+			FS_FCloseFile( h );
+		}
 		return len;
 	}
 
 	buf = Hunk_AllocateTempMemory( len + 1 );
 	*buffer = buf;
 
-	FS_Read( buf, len, h );
+	if ( pakFile && !FS_ReadPrefetchedFile( pakFile->search->pack, pakFile->file, buf, len ) ) {
+		// go through a regular handle if the pak can't be mapped
+		if ( FS_ReadFileInPak( pakFile->search->pack, pakFile->file, buf, len ) != len
+			&& FS_OpenFileInPak( &h, pakFile->search->pack, pakFile->file, false ) < 0 ) {
+			Hunk_FreeTempMemory( buf );
+			*buffer = NULL;
+			return -1;
+		}
+	}
+
+	if ( h != FS_INVALID_HANDLE ) {
+		FS_Read( buf, len, h );
+		FS_FCloseFile( h );
+	}
 
 	fs_loadCount++;
 	fs_loadStack++;
 
 	// guarantee that it will have a trailing 0 for string operations
 	buf[ len ] = '\0';
-	FS_FCloseFile( h );
+
+	FS_RecordFileRead( qpath );
 
 	// if we are journaling and it is a config file, write it to the journal file
 	if ( isConfig ) {
@@ -2303,7 +3980,7 @@ static bool fs_cacheSynced = true;
 // 3: [size of file offset and file time]
 // non-matching header will cause whole file being ignored
 static const byte cache_header[ 4 ] = {
-	0, //version
+	2, //version
 #ifdef Q3_LITTLE_ENDIAN
 	0x0,
 #else
@@ -2313,25 +3990,31 @@ static const byte cache_header[ 4 ] = {
 	( ( sizeof( fileOffset_t ) - 1 ) << 4 ) | ( sizeof( fileTime_t ) - 1 )
 };
 
+// each pak is stored as one record, aligned to 4 bytes:
+// header, pak filename, hash table, fileInPack_t records,
+// checksums excluding first uninitialized and the filenames
 typedef struct pk3cacheHeader_s {
+	int recordLen;		// including this header
 	int pakNameLen;		// full path
-	int namesLen;
 	int numFiles;
+	int hashSize;
+	int namesLen;
 	int numHeaderLongs; // including first uninitialized
-	int contentLen;
+	int checksum;		// regular checksum, doesn't depend on the checksum feed
 	fileTime_t ctime;	// creation/status change time
 	fileTime_t mtime;	// modification time
 	fileOffset_t size;	// zip file size
 } pk3cacheHeader_t;
 
-typedef struct pk3cacheFileItem_s {
-	unsigned long name; // offset in namebuffer
-	unsigned long size;
-	unsigned long pos;	// info position in pk3 file
-} pk3cacheFileItem_t;
-
 #pragma pack( pop )
 
+// the cache file stays mapped while any pak uses the file tables in it
+typedef struct pakCacheMap_s {
+	const byte	*base;
+	int			length;
+	int			refs;
+} pakCacheMap_t;
+
 #endif // USE_PK3_CACHE_FILE
 
 
@@ -2478,56 +4161,49 @@ static void FS_FreeUnusedCache( void )
 
 #ifdef USE_PK3_CACHE_FILE
 
-static void FS_WriteCacheHeader( FILE *f )
+/*
+============
+FS_ReleaseCacheMap
+============
+*/
+static void FS_ReleaseCacheMap( pakCacheMap_t *map )
 {
-	fwrite( cache_header, sizeof( cache_header ), 1, f );
+	if ( --map->refs > 0 )
+		return;
+
+	Sys_UnmapFile( map->base, map->length );
+	Z_Free( map );
 }
 
 
-static bool FS_ValidateCacheHeader( FILE *f )
+static void FS_WritePadding( int len, FILE *f )
 {
-	byte buf[ sizeof(cache_header) ];
-
-	if ( fread( buf, sizeof( buf ), 1, f ) != 1 )
-		return false;
-
-	if ( memcmp( buf, cache_header, sizeof( buf ) ) != 0 )
-		return false;
+	static const byte zeros[ sizeof( int ) ] = { 0 };
 
-	return true;
+	if ( PAD( len, sizeof( int ) ) != len )
+		fwrite( zeros, PAD( len, sizeof( int ) ) - len, 1, f );
 }
 
 
 static bool FS_SavePackToFile( const pack_t *pak, FILE *f )
 {
-	const char *namePtr;
-	const char *pakName;
-	int i, pakNameLen;
 	pk3cacheHeader_t pk;
-	pk3cacheFileItem_t it;
-	int namesLen, contentLen;
-	
-	namePtr = (char*)(pak->buildBuffer + pak->numfiles);
-
-	pakName = pak->pakFilename;
-	pakNameLen = (int) strlen( pakName ) + 1;
-	pakNameLen = PAD( pakNameLen, sizeof( int ) );
-
-	namesLen = pakName - namePtr;
+	int pakNameLen;
 
-	// file content length
-	contentLen = 0;
+	pakNameLen = (int) strlen( pak->pakFilename ) + 1;
 
 	// pak filename length
-	pk.pakNameLen = pakNameLen;
-	// filenames length
-	pk.namesLen = namesLen;
+	pk.pakNameLen = PAD( pakNameLen, sizeof( int ) );
 	// number of files
 	pk.numFiles = pak->numfiles;
+	// hash table size
+	pk.hashSize = pak->hashSize;
+	// filenames length
+	pk.namesLen = pak->namesLen;
 	// number of checksums
 	pk.numHeaderLongs = pak->numHeaderLongs;
-	// content of some files
-	pk.contentLen = contentLen;
+	// regular checksum
+	pk.checksum = pak->checksum;
 	// creation/status change time
 	pk.ctime = pak->ctime;
 	// modification time
@@ -2535,105 +4211,135 @@ static bool FS_SavePackToFile( const pack_t *pak, FILE *f )
 	// pak file size
 	pk.size = pak->size;
 
-	// dump header
-	fwrite( &pk, sizeof( pk ), 1, f );
+	pk.recordLen = sizeof( pk ) + pk.pakNameLen + pk.hashSize * sizeof( pak->hashTable[0] )
+		+ pk.numFiles * sizeof( pak->buildBuffer[0] ) + ( pk.numHeaderLongs - 1 ) * sizeof( pak->headerLongs[0] )
+		+ pk.namesLen;
+
+	// dump header
+	fwrite( &pk, sizeof( pk ), 1, f );
+
+	// pak filename
+	fwrite( pak->pakFilename, pakNameLen, 1, f );
+	FS_WritePadding( pakNameLen, f );
+
+	// hash table and file entries, written as they are used
+	fwrite( pak->hashTable, pk.hashSize * sizeof( pak->hashTable[0] ), 1, f );
+	fwrite( pak->buildBuffer, pk.numFiles * sizeof( pak->buildBuffer[0] ), 1, f );
+
+	// pure checksums, excluding first uninitialized
+	fwrite( pak->headerLongs + 1, ( pk.numHeaderLongs - 1 ) * sizeof( pak->headerLongs[0] ), 1, f );
+
+	// filenames
+	fwrite( pak->names, pk.namesLen, 1, f );
+
+	return true;
+}
+
 
-	// pak filename
-	fwrite( pakName, pakNameLen, 1, f );
+/*
+============
+FS_ValidateCachedTables
 
-	// filenames
-	fwrite( namePtr, namesLen, 1, f );
+Make sure that a damaged cache file can't send lookups outside of the
+record, hash chains must always point back to earlier files.
+============
+*/
+static bool FS_ValidateCachedTables( const pk3cacheHeader_t *pk, const int *hashTable, const fileInPack_t *files, const char *names )
+{
+	int i;
+
+	if ( pk->numFiles > 0 && ( pk->namesLen == 0 || names[ pk->namesLen - 1 ] != '\0' ) )
+		return false;
 
-	// file entries
-	for ( i = 0; i < pak->numfiles; i++ )
+	for ( i = 0; i < pk->hashSize; i++ )
 	{
-		it.name = (unsigned long)(pak->buildBuffer[i].name - namePtr);
-		it.size = pak->buildBuffer[i].size;
-		it.pos = pak->buildBuffer[i].pos;
-		fwrite( &it, sizeof( it ), 1, f );
+		if ( hashTable[i] < -1 || hashTable[i] >= pk->numFiles )
+			return false;
 	}
 
-	// pure checksums, excluding first uninitialized
-	fwrite( pak->headerLongs + 1, (pak->numHeaderLongs - 1) * sizeof( pak->headerLongs[0] ), 1, f );
+	for ( i = 0; i < pk->numFiles; i++ )
+	{
+		if ( files[i].name < 0 || files[i].name >= pk->namesLen )
+			return false;
+		if ( files[i].next < -1 || files[i].next >= i )
+			return false;
+	}
 
 	return true;
 }
 
 
-static bool FS_LoadPakFromFile( FILE *f )
+/*
+============
+FS_LoadPakFromCache
+
+Creates a pak_t that uses the file tables of the record at offset right from
+the mapped cache file, returns the length of the record or 0 if there are no
+more valid records.
+============
+*/
+static int FS_LoadPakFromCache( pakCacheMap_t *map, int offset )
 {
 	fileTime_t ctime, mtime;
 	fileOffset_t fsize;
-	fileInPack_t *curFile;
-	char pakName[ PAD( MAX_OSPATH*3+1, sizeof( int ) ) ];
-	char pakBase[ PAD( MAX_OSPATH, sizeof( int ) ) ], *basename;
-	char *filename_inzip;
+	char pakBase[ PAD( MAX_OSPATH, sizeof( int ) ) ];
 	pk3cacheHeader_t pk;
-	pk3cacheFileItem_t it;
+	const byte *rec;
+	const char *basename;
+	const char *pakName;
+	const int *hashTable;
+	const int *headerLongs;
+	const fileInPack_t *files;
+	const char *names;
 	pack_t *pack;
-	char *namePtr;
-	int size, i;
+	int64_t recordLen;
+	int remaining, size;
 	int pakBaseLen;
-	int hashSize;
-	long hash;
 
-	if ( fread( &pk, sizeof( pk ), 1, f ) != 1 )
-		return false; // probably EOF
+	remaining = map->length - offset;
+	if ( remaining < (int)sizeof( pk ) )
+		return 0; // EOF
+
+	rec = map->base + offset;
+	Com_Memcpy( &pk, rec, sizeof( pk ) );
 
 	// validate header data
 
-	if ( pk.pakNameLen > sizeof( pakName ) || pk.pakNameLen & 3 || pk.pakNameLen == 0 )
-	{
-		//Com_Printf( "bad pakNameLen: %08X\n", pk.pakNameLen );
-		return false;
-	}
+	if ( pk.pakNameLen > PAD( MAX_OSPATH*3+1, sizeof( int ) ) || pk.pakNameLen & 3 || pk.pakNameLen <= 0 )
+		return 0;
 
-	if ( pk.namesLen & 3 || pk.namesLen < pk.numFiles )
-	{
-		//Com_Printf( "bad namesLen: %i\n", pk.namesLen );
-		return false;
-	}
+	if ( pk.hashSize <= 0 || pk.hashSize > MAX_FILEHASH_SIZE || ( pk.hashSize & ( pk.hashSize - 1 ) ) )
+		return 0;
 
-	if ( pk.numHeaderLongs == 0 || pk.numHeaderLongs > pk.numFiles + 1 )
-	{
-		//Com_Printf( "bad numHeaderLongs: %i\n", pk.numHeaderLongs );
-		return false;
-	}
+	if ( pk.numFiles < 0 || pk.namesLen < 0 || pk.namesLen & 3 || pk.numHeaderLongs <= 0 )
+		return 0;
 
-	if ( pk.contentLen & 3 || pk.contentLen < 0 )
-	{
-		//Com_Printf( "bad contentLen: %i\n", pk.contentLen );
-		return false;
-	}
+	recordLen = (int64_t)sizeof( pk ) + pk.pakNameLen + (int64_t)pk.hashSize * sizeof( hashTable[0] )
+		+ (int64_t)pk.numFiles * sizeof( files[0] ) + (int64_t)( pk.numHeaderLongs - 1 ) * sizeof( headerLongs[0] )
+		+ pk.namesLen;
 
-	// load filename
-	if ( fread( pakName, pk.pakNameLen, 1, f ) != 1 )
-	{
-		//Com_Printf( "error reading pakname\n" );
-		return false;
-	}
+	if ( pk.recordLen != recordLen || pk.recordLen > remaining || pk.recordLen & 3 )
+		return 0;
+
+	pakName = (const char *)( rec + sizeof( pk ) );
+	hashTable = (const int *)( pakName + pk.pakNameLen );
+	files = (const fileInPack_t *)( hashTable + pk.hashSize );
+	headerLongs = (const int *)( files + pk.numFiles );
+	names = (const char *)( headerLongs + pk.numHeaderLongs - 1 );
 
 	// pakName must be zero-terminated
 	if ( pakName[ pk.pakNameLen - 1 ] != '\0' )
-	{
-		//Com_Printf( "pakname is not zero-terminated!\n" );
-		return false;
-	}
+		return 0;
 
 	if ( !Sys_GetFileStats( pakName, &fsize, &mtime, &ctime ) || fsize != pk.size || mtime != pk.mtime || ctime != pk.ctime )
 	{
-		const int seek_len = pk.namesLen + pk.numFiles * sizeof( it ) + (pk.numHeaderLongs-1) * sizeof( pack->headerLongs[0] ) + pk.contentLen;
-		if ( fseek( f, seek_len, SEEK_CUR ) != 0 )
-		{
-			return false;
-		}
-		else
-		{
-			fs_paksSkipped++;
-			return true; // just outdated info, we can continue
-		}
+		fs_paksSkipped++;
+		return pk.recordLen; // just outdated info, we can continue
 	}
 
+	if ( !FS_ValidateCachedTables( &pk, hashTable, files, names ) )
+		return 0;
+
 	// extract basename from zip path
 	basename = strrchr( pakName, PATH_SEP );
 	if ( basename == NULL )
@@ -2646,12 +4352,8 @@ static bool FS_LoadPakFromFile( FILE *f )
 	pakBaseLen = (int) strlen( pakBase ) + 1;
 	pakBaseLen = PAD( pakBaseLen, sizeof( int ) );
 
-	hashSize = FS_PakHashSize( pk.numFiles );
-
-	size = sizeof( *pack ) + pk.namesLen + pk.numFiles * sizeof( pack->buildBuffer[0] );
-	size += hashSize * sizeof( pack->hashTable[0] );
-	size += pk.pakNameLen;
-	size += pakBaseLen;
+	// only the names and checksums are copied, the tables stay in the cache file
+	size = sizeof( *pack ) + pk.pakNameLen + pakBaseLen;
 	size += pk.numHeaderLongs * sizeof( pack->headerLongs[0] );
 
 	pack = Z_TagMalloc( size, TAG_PACK );
@@ -2661,105 +4363,35 @@ static bool FS_LoadPakFromFile( FILE *f )
 	pack->ctime = pk.ctime;
 	pack->size = pk.size;
 
-//	pack->handle = uf;
 	pack->numfiles = pk.numFiles;
 	pack->numHeaderLongs = pk.numHeaderLongs;
 
-	// setup memory layout
-	pack->hashSize = hashSize;
-	pack->hashTable = (fileInPack_t **)( pack + 1 );
-
-	pack->buildBuffer = (fileInPack_t*)( pack->hashTable + pack->hashSize );
+	pack->hashSize = pk.hashSize;
+	pack->hashTable = hashTable;
+	pack->buildBuffer = files;
+	pack->names = names;
+	pack->namesLen = pk.namesLen;
 
-	namePtr = (char*)( pack->buildBuffer + pack->numfiles );
+	pack->cacheMap = map;
+	map->refs++;
 
-	pack->pakFilename = (char*)( namePtr + pk.namesLen );
+	pack->pakFilename = (char*)( pack + 1 );
 	pack->pakBasename = (char*)( pack->pakFilename + pk.pakNameLen );
 	pack->headerLongs = (int*)( pack->pakBasename + pakBaseLen );
 
 	strcpy( pack->pakFilename, pakName );
 	strcpy( pack->pakBasename, pakBase );
 
-	if ( fread( namePtr, pk.namesLen, 1, f ) != 1 )
-	{
-		//Com_Printf( "error reading pak filenames\n" );
-		goto __error;
-	}
-
-	// filenames buffer must be zero-terminated
-	if ( namePtr[ pk.namesLen - 1 ] != '\0' )
-	{
-		//Com_Printf( "not zero terminated filenames\n" );
-		goto __error;
-	}
-
-	curFile = pack->buildBuffer;
-	for ( i = 0; i < pk.numFiles; i++ )
-	{
-		if ( fread( &it, sizeof( it ), 1, f ) != 1 )
-		{
-			//Com_Printf( "error reading file item[%i]\n", i );
-			goto __error;
-		}
-		if ( it.name >= pk.namesLen )
-		{
-			//Com_Printf( "bad name offset: %i (expecting less than %i)\n", it.name, pk.namesLen );
-			goto __error;
-		}
-
-		filename_inzip = namePtr + it.name;
-		FS_ConvertFilename( filename_inzip );
-		if ( !FS_BannedPakFile( filename_inzip ) ) {
-			// store the file position in the zip
-			curFile->name = filename_inzip;
-			curFile->size = it.size;
-			curFile->pos = it.pos;
-
-			// update hash table
-			hash = FS_HashFileName( filename_inzip, pack->hashSize );
-			curFile->next = pack->hashTable[ hash ];
-			pack->hashTable[ hash ] = curFile;
-			curFile++;
-		} else {
-			pack->numfiles--;
-		}
-	}
-
-	if ( fread( pack->headerLongs + 1, ( pack->numHeaderLongs - 1 ) * sizeof( pack->headerLongs[0] ), 1, f ) != 1 )
-	{
-		//Com_Printf( "error reading headerLongs\n" );
-		goto __error;
-	}
-
-	pack->checksumFeed = fs_checksumFeed;
-	pack->headerLongs[ 0 ] = LittleLong( fs_checksumFeed );
-
-	pack->checksum = Com_BlockChecksum( pack->headerLongs + 1, sizeof( pack->headerLongs[0] ) * ( pack->numHeaderLongs - 1 ) );
-	pack->checksum = LittleLong( pack->checksum );
-
-	pack->pure_checksum = Com_BlockChecksum( pack->headerLongs, sizeof( pack->headerLongs[0] ) * pack->numHeaderLongs );
-	pack->pure_checksum = LittleLong( pack->pure_checksum );
+	Com_Memcpy( pack->headerLongs + 1, headerLongs, ( pack->numHeaderLongs - 1 ) * sizeof( pack->headerLongs[0] ) );
 
-	// seek through unused content
-	if ( pk.contentLen > 0 )
-	{
-		if ( fseek( f, pk.contentLen, SEEK_CUR ) != 0 )
-			goto __error;
-	}
-	else if ( pk.contentLen < 0 )
-	{
-		goto __error;
-	}
+	// the pure checksum is computed on demand, see FS_PakPureChecksum
+	pack->checksum = pk.checksum;
 
 	fs_paksCached++;
 
 	FS_InsertPK3ToCache( pack );
 
-	return true;
-
-__error:
-	FS_FreePak( pack );
-	return false;
+	return pk.recordLen;
 }
 
 
@@ -2767,13 +4399,17 @@ __error:
 ============
 FS_SaveCache
 
-Called at the end of FS_Startup() after releasing unused paks
+Called at the end of FS_Startup() after releasing unused paks.
+
+The loaded cache file may still be mapped, so the new one is written
+to a temporary file and then moved into place.
 ============
 */
 static bool FS_SaveCache( void )
 {
-	const char *filename = CACHE_FILE_NAME;
-	const char *ospath;
+	char ospath[ MAX_OSPATH*2+1 ];
+	char tmppath[ MAX_OSPATH*2+1 ];
+	char oldpath[ MAX_OSPATH*2+1 ];
 	const searchpath_t *sp;
 	FILE *f;
 
@@ -2798,13 +4434,15 @@ static bool FS_SaveCache( void )
 
 	sp = fs_searchpaths;
 
-	ospath = FS_BuildOSPath( fs_homepath->string, filename, NULL );
+	Q_strncpyz( ospath, FS_BuildOSPath( fs_homepath->string, CACHE_FILE_NAME, NULL ), sizeof( ospath ) );
+	Q_strncpyz( tmppath, FS_BuildOSPath( fs_homepath->string, CACHE_FILE_NAME ".tmp", NULL ), sizeof( tmppath ) );
+	Q_strncpyz( oldpath, FS_BuildOSPath( fs_homepath->string, CACHE_FILE_NAME ".old", NULL ), sizeof( oldpath ) );
 
-	f = Sys_FOpen( ospath, "wb" );
+	f = Sys_FOpen( tmppath, "wb" );
 	if ( f == NULL )
 		return false;
 
-	FS_WriteCacheHeader( f );
+	fwrite( cache_header, sizeof( cache_header ), 1, f );
 
 	while ( sp != NULL )
 	{
@@ -2815,8 +4453,26 @@ static bool FS_SaveCache( void )
 		sp = sp->next;
 	}
 
+	if ( ferror( f ) )
+	{
+		fclose( f );
+		remove( tmppath );
+		return false;
+	}
+
 	fclose( f );
 
+	// a mapped file can't be replaced on every platform, but it can be renamed
+	remove( oldpath );
+	rename( ospath, oldpath );
+	if ( rename( tmppath, ospath ) != 0 )
+	{
+		rename( oldpath, ospath );
+		remove( tmppath );
+		return false;
+	}
+	remove( oldpath );
+
 	fs_paksReleased = 0;
 	fs_paksSkipped = 0;
 	fs_paksReaded = 0;
@@ -2838,7 +4494,9 @@ static void FS_LoadCache( void )
 {
 	const char *filename = CACHE_FILE_NAME;
 	const char *ospath;
-	FILE *f;
+	pakCacheMap_t *map;
+	const void *base;
+	int length, offset, recordLen;
 
 	fs_paksReaded = 0;
 	fs_paksReleased = 0;
@@ -2851,20 +4509,27 @@ static void FS_LoadCache( void )
 
 	ospath = FS_BuildOSPath( fs_homepath->string, filename, NULL );
 
-	f = Sys_FOpen( ospath, "rb" );
-	if ( f == NULL )
+	base = Sys_MapFile( ospath, &length );
+	if ( base == NULL )
 		return;
 
-	if ( !FS_ValidateCacheHeader( f ) )
+	if ( length < (int)sizeof( cache_header ) || memcmp( base, cache_header, sizeof( cache_header ) ) != 0 )
 	{
-		fclose( f );
+		Sys_UnmapFile( base, length );
 		return;
 	}
 
-	while ( FS_LoadPakFromFile( f ) )
-		;
+	map = Z_Malloc( sizeof( *map ) );
+	map->base = (const byte *)base;
+	map->length = length;
+	map->refs = 1;
 
-	fclose( f );
+	offset = sizeof( cache_header );
+	while ( ( recordLen = FS_LoadPakFromCache( map, offset ) ) > 0 )
+		offset += recordLen;
+
+	// unmapped right away if no pak is using it
+	FS_ReleaseCacheMap( map );
 
 	fs_cacheLoaded = true;
 
@@ -2876,50 +4541,170 @@ static void FS_LoadCache( void )
 #endif // USE_PK3_CACHE
 
 
+typedef enum {
+	ZIP_ENTRY_FILE,
+	ZIP_ENTRY_BANNED,		// not added to the hash table
+	ZIP_ENTRY_UNSUPPORTED	// unsupported compression method
+} zipEntryType_t;
+
+typedef struct {
+	zipEntryType_t	type;
+	unsigned long	pos;		// position of the info in the central directory
+	unsigned long	size;
+	unsigned long	method;
+	int				nameOfs;
+} zipEntry_t;
+
+typedef struct {
+	const char		*zipfile;
+	bool			valid;
+	int				numEntries;
+	zipEntry_t		*entries;
+	char			*names;
+	int				namelen;	// of the supported entries
+	int				filecount;	// supported entries
+	int				numfiles;	// supported entries that aren't banned
+	int				*headerLongs;
+	int				numHeaderLongs;
+	int				checksum;
+	int				pure_checksum;
+} zipScan_t;
+
+
 /*
 =================
-FS_LoadZipFile
+FS_ScanZipFile
 
-Creates a new pak_t in the search chain for the contents
-of a zip file.
+Reads the central directory of a zip file and computes the checksums.
+Everything is kept in malloc'ed memory and nothing is printed, so
+this can run on a worker thread while other zip files are scanned.
 =================
 */
-static pack_t *FS_LoadZipFile( const char *zipfile )
+static void FS_ScanZipFile( zipScan_t *scan )
 {
-	fileInPack_t	*curFile;
-	pack_t			*pack;
-	unzFile			uf;
-	int				err;
-	unz_global_info gi;
-	char			filename_inzip[MAX_ZPATH];
+	unz_central_dir	dir;
 	unz_file_info	file_info;
-	unsigned int	i, namelen, hashSize, size;
-	long			hash;
-	int				fs_numHeaderLongs;
-	int				*fs_headerLongs;
-	int				filecount;
+	zipEntry_t		*entry;
+	char			filename_inzip[MAX_ZPATH];
 	char			*namePtr;
-	const char		*basename;
-	int				fileNameLen;
-	int				baseNameLen;
+	const char		*zipfile;
+	unsigned int	i;
 
-#ifdef USE_PK3_CACHE
-	pack = FS_LoadCachedPK3( zipfile );
-	if ( pack )
+	zipfile = scan->zipfile;
+	Com_Memset( scan, 0, sizeof( *scan ) );
+	scan->zipfile = zipfile;
+
+	if ( unzReadCentralDir( scan->zipfile, &dir ) != UNZ_OK ) {
+		return;
+	}
+
+	// all names are stored inside the central directory
+	scan->entries = malloc( dir.number_entry * sizeof( scan->entries[0] ) + 1 );
+	scan->names = malloc( dir.size_central_dir + dir.number_entry + 1 );
+	scan->headerLongs = malloc( ( dir.number_entry + 1 ) * sizeof( scan->headerLongs[0] ) );
+	if ( !scan->entries || !scan->names || !scan->headerLongs ) {
+		unzFreeCentralDir( &dir );
+		return;
+	}
+
+	scan->headerLongs[ scan->numHeaderLongs++ ] = LittleLong( fs_checksumFeed );
+
+	namePtr = scan->names;
+	for ( i = 0; i < dir.number_entry; i++ )
 	{
-		// update pure checksum
-		if ( pack->checksumFeed != fs_checksumFeed )
-		{
-			pack->headerLongs[ 0 ] = LittleLong( fs_checksumFeed );
-			pack->pure_checksum = Com_BlockChecksum( pack->headerLongs, sizeof( pack->headerLongs[0] ) * pack->numHeaderLongs );
-			pack->pure_checksum = LittleLong( pack->pure_checksum );
-			pack->checksumFeed = fs_checksumFeed;
+		if ( unzGetCentralDirFileInfo( &dir, &file_info, filename_inzip, sizeof( filename_inzip ) ) != UNZ_OK ) {
+			break;
+		}
+		filename_inzip[sizeof(filename_inzip)-1] = '\0';
+
+		entry = &scan->entries[ scan->numEntries++ ];
+		entry->pos = dir.pos_in_central_dir;
+		entry->size = file_info.uncompressed_size;
+		entry->method = file_info.compression_method;
+		entry->nameOfs = (int)( namePtr - scan->names );
+
+		if ( file_info.compression_method != 0 && file_info.compression_method != 8 /*Z_DEFLATED*/ ) {
+			entry->type = ZIP_ENTRY_UNSUPPORTED;
+		} else {
+			scan->namelen += strlen( filename_inzip ) + 1;
+			scan->filecount++;
+
+			if ( file_info.uncompressed_size > 0 ) {
+				scan->headerLongs[ scan->numHeaderLongs++ ] = LittleLong( file_info.crc );
+			}
+
+			FS_ConvertFilename( filename_inzip );
+			if ( FS_BannedPakFile( filename_inzip ) ) {
+				entry->type = ZIP_ENTRY_BANNED;
+			} else {
+				entry->type = ZIP_ENTRY_FILE;
+				scan->numfiles++;
+			}
 		}
 
-		pack->touched = true;
-		return pack; // loaded from cache
+		strcpy( namePtr, filename_inzip );
+		namePtr += strlen( filename_inzip ) + 1;
+
+		unzGoToNextCentralDirFile( &dir );
 	}
-#endif
+
+	unzFreeCentralDir( &dir );
+
+	scan->checksum = Com_BlockChecksum( scan->headerLongs + 1, sizeof( scan->headerLongs[0] ) * ( scan->numHeaderLongs - 1 ) );
+	scan->checksum = LittleLong( scan->checksum );
+
+	scan->pure_checksum = Com_BlockChecksum( scan->headerLongs, sizeof( scan->headerLongs[0] ) * scan->numHeaderLongs );
+	scan->pure_checksum = LittleLong( scan->pure_checksum );
+
+	scan->valid = true;
+}
+
+
+/*
+=================
+FS_FreeZipScan
+=================
+*/
+static void FS_FreeZipScan( zipScan_t *scan )
+{
+	free( scan->entries );
+	free( scan->names );
+	free( scan->headerLongs );
+	scan->entries = NULL;
+	scan->names = NULL;
+	scan->headerLongs = NULL;
+}
+
+
+/*
+=================
+FS_CreatePak
+
+Creates a new pak_t from a scanned zip file, returns NULL
+if the zip file isn't valid or doesn't contain any usable file.
+=================
+*/
+static pack_t *FS_CreatePak( const zipScan_t *scan )
+{
+	fileInPack_t	*buildBuffer, *curFile;
+	int				*hashTable;
+	pack_t			*pack;
+	const zipEntry_t *entry;
+	unsigned int	namelen, hashSize, size;
+	long			hash;
+	char			*names, *namePtr;
+	const char		*zipfile;
+	const char		*basename;
+	const char		*filename;
+	int				fileNameLen;
+	int				baseNameLen;
+	int				i;
+
+	if ( !scan->valid ) {
+		return NULL;
+	}
+
+	zipfile = scan->zipfile;
 
 	// extract basename from zip path
 	basename = strrchr( zipfile, PATH_SEP );
@@ -2932,137 +4717,100 @@ static pack_t *FS_LoadZipFile( const char *zipfile )
 	fileNameLen = (int) strlen( zipfile ) + 1;
 	baseNameLen = (int) strlen( basename ) + 1;
 
-	uf = unzOpen( zipfile );
-	err = unzGetGlobalInfo( uf, &gi );
-
-	if ( err != UNZ_OK ) {
-		return NULL;
-	}
-
-	namelen = 0;
-	filecount = 0;
-	unzGoToFirstFile( uf );
-	for (i = 0; i < gi.number_entry; i++)
-	{
-		err = unzGetCurrentFileInfo(uf, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0);
-		filename_inzip[sizeof(filename_inzip)-1] = '\0';
-		if (err != UNZ_OK) {
-			break;
+	for ( i = 0, entry = scan->entries; i < scan->numEntries; i++, entry++ ) {
+		if ( entry->type == ZIP_ENTRY_UNSUPPORTED ) {
+			Com_Printf( S_COLOR_YELLOW "%s|%s: unsupported compression method %i\n", basename, scan->names + entry->nameOfs, (int)entry->method );
 		}
-		if ( file_info.compression_method != 0 && file_info.compression_method != 8 /*Z_DEFLATED*/ ) {
-			Com_Printf( S_COLOR_YELLOW "%s|%s: unsupported compression method %i\n", basename, filename_inzip, (int)file_info.compression_method );
-			unzGoToNextFile( uf );
-			continue;
-		} 
-		namelen += strlen( filename_inzip ) + 1;
-		unzGoToNextFile( uf );
-		filecount++;
 	}
 
-	if ( filecount == 0 ) {
-		unzClose( uf );
+	if ( scan->filecount == 0 ) {
 		return NULL;
 	}
 
 	// get the hash table size from the number of files in the zip
 	// because lots of custom pk3 files have less than 32 or 64 files
-	hashSize = FS_PakHashSize( filecount );
+	hashSize = FS_PakHashSize( scan->filecount );
 
-	namelen = PAD( namelen, sizeof( int ) );
-	size = sizeof( *pack ) + hashSize * sizeof( pack->hashTable[0] ) + filecount * sizeof( pack->buildBuffer[0] ) + namelen;
+	namelen = PAD( scan->namelen, sizeof( int ) );
+	size = sizeof( *pack ) + hashSize * sizeof( pack->hashTable[0] ) + scan->filecount * sizeof( pack->buildBuffer[0] ) + namelen;
 	size += PAD( fileNameLen, sizeof( int ) );
 	size += PAD( baseNameLen, sizeof( int ) );
 #ifdef USE_PK3_CACHE
-	size += ( filecount + 1 ) * sizeof( fs_headerLongs[0] );
+	size += scan->numHeaderLongs * sizeof( scan->headerLongs[0] );
 #endif
 	pack = Z_TagMalloc( size, TAG_PACK );
 	Com_Memset( pack, 0, size );
 
-	pack->handle = uf;
-	pack->numfiles = filecount;
+	pack->numfiles = scan->numfiles;
 	pack->hashSize = hashSize;
-	pack->hashTable = (fileInPack_t **)( pack + 1 );
+	hashTable = (int *)( pack + 1 );
+	for ( i = 0; i < hashSize; i++ ) {
+		hashTable[i] = -1;
+	}
+
+	buildBuffer = (fileInPack_t*)( hashTable + hashSize );
+	names = namePtr = (char*)( buildBuffer + scan->filecount );
 
-	pack->buildBuffer = (fileInPack_t*)( pack->hashTable + pack->hashSize );
-	namePtr = (char*)( pack->buildBuffer + filecount );
+	pack->hashTable = hashTable;
+	pack->buildBuffer = buildBuffer;
+	pack->names = names;
 
 	pack->pakFilename = (char*)( namePtr + namelen );
 	pack->pakBasename = (char*)( pack->pakFilename + PAD( fileNameLen, sizeof( int ) ) );
 
-#ifdef USE_PK3_CACHE
-	fs_headerLongs = (int*)( pack->pakBasename + PAD( baseNameLen, sizeof( int ) ) );
-#else
-	fs_headerLongs = Z_Malloc( ( filecount + 1 ) * sizeof( fs_headerLongs[0] ) );
-#endif
-
-	fs_numHeaderLongs = 0;
-	fs_headerLongs[ fs_numHeaderLongs++ ] = LittleLong( fs_checksumFeed );
-
 	Com_Memcpy( pack->pakFilename, zipfile, fileNameLen );
 	Com_Memcpy( pack->pakBasename, basename, baseNameLen );
 
 	// strip .pk3 if needed
 	FS_StripExt( pack->pakBasename, ".pk3" );
 
-	unzGoToFirstFile( uf );
-	curFile = pack->buildBuffer;
-	for ( i = 0; i < gi.number_entry; i++ )
+	curFile = buildBuffer;
+	for ( i = 0, entry = scan->entries; i < scan->numEntries; i++, entry++ )
 	{
-		err = unzGetCurrentFileInfo( uf, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0 );
-		filename_inzip[sizeof(filename_inzip)-1] = '\0';
-		if (err != UNZ_OK) {
-			break;
-		}
-		if ( file_info.compression_method != 0 && file_info.compression_method != 8 /*Z_DEFLATED*/ ) {
-			unzGoToNextFile( uf );
+		if ( entry->type != ZIP_ENTRY_FILE ) {
 			continue;
-		} 
-		if ( file_info.uncompressed_size > 0 ) {
-			fs_headerLongs[fs_numHeaderLongs++] = LittleLong( file_info.crc );
-		}
-
-		FS_ConvertFilename( filename_inzip );
-		if ( !FS_BannedPakFile( filename_inzip ) ) {
-			// store the file position in the zip
-			unzGetCurrentFileInfoPosition( uf, &curFile->pos );
-			curFile->size = file_info.uncompressed_size;
-			curFile->name = namePtr;
-			strcpy( curFile->name, filename_inzip );
-			namePtr += strlen( filename_inzip ) + 1;
-
-			// update hash table
-			hash = FS_HashFileName( filename_inzip, pack->hashSize );
-			curFile->next = pack->hashTable[ hash ];
-			pack->hashTable[ hash ] = curFile; 
-			curFile++;
-		} else {
-			pack->numfiles--;
 		}
 
-		unzGoToNextFile( uf );
+		filename = scan->names + entry->nameOfs;
+
+		// store the file position in the zip
+		curFile->pos = entry->pos;
+		curFile->size = entry->size;
+		curFile->name = (int)( namePtr - names );
+		strcpy( namePtr, filename );
+		namePtr += strlen( filename ) + 1;
+
+		// update hash table, chains always point back to earlier files
+		hash = FS_HashFileName( filename, pack->hashSize );
+		curFile->next = hashTable[ hash ];
+		hashTable[ hash ] = (int)( curFile - buildBuffer );
+		curFile++;
 	}
 
-	pack->checksum = Com_BlockChecksum( fs_headerLongs + 1, sizeof( fs_headerLongs[0] ) * ( fs_numHeaderLongs - 1 ) );
-	pack->checksum = LittleLong( pack->checksum );
+	pack->namesLen = PAD( (int)( namePtr - names ), sizeof( int ) );
 
-	pack->pure_checksum = Com_BlockChecksum( fs_headerLongs, sizeof( fs_headerLongs[0] ) * fs_numHeaderLongs );
-	pack->pure_checksum = LittleLong( pack->pure_checksum );
+	pack->checksum = scan->checksum;
+	pack->pure_checksum = scan->pure_checksum;
 
 #ifdef USE_PK3_CACHE
-	pack->headerLongs = fs_headerLongs;
-	pack->numHeaderLongs = fs_numHeaderLongs;
+	pack->headerLongs = (int*)( pack->pakBasename + PAD( baseNameLen, sizeof( int ) ) );
+	pack->numHeaderLongs = scan->numHeaderLongs;
 	pack->checksumFeed = fs_checksumFeed;
-#else
-	Z_Free( fs_headerLongs );
+	pack->pureChecksumValid = true;
+	Com_Memcpy( pack->headerLongs, scan->headerLongs, scan->numHeaderLongs * sizeof( scan->headerLongs[0] ) );
 #endif
 
-#ifdef USE_HANDLE_CACHE
-	FS_AddToHandleList( pack );
-#else
-	if ( fs_locked->integer == 0 )
+	// keep the zip open for cached or locked handles, otherwise it's opened on demand
+#ifndef USE_HANDLE_CACHE
+	if ( fs_locked->integer )
+#endif
 	{
-		unzClose( pack->handle );
-		pack->handle = NULL;
+		pack->handle = unzOpen( zipfile );
+	}
+
+#ifdef USE_HANDLE_CACHE
+	if ( pack->handle ) {
+		FS_AddToHandleList( pack );
 	}
 #endif
 
@@ -3077,6 +4825,58 @@ static pack_t *FS_LoadZipFile( const char *zipfile )
 }
 
 
+#ifdef USE_PK3_CACHE
+/*
+=================
+FS_LoadCachedZipFile
+
+Returns the cached pak_t for a zip file if it is still up to date.
+=================
+*/
+static pack_t *FS_LoadCachedZipFile( const char *zipfile )
+{
+	pack_t *pack;
+
+	pack = FS_LoadCachedPK3( zipfile );
+	if ( pack )
+	{
+		pack->touched = true;
+	}
+
+	return pack;
+}
+#endif
+
+
+/*
+=================
+FS_LoadZipFile
+
+Creates a new pak_t in the search chain for the contents
+of a zip file.
+=================
+*/
+static pack_t *FS_LoadZipFile( const char *zipfile )
+{
+	zipScan_t	scan;
+	pack_t		*pack;
+
+#ifdef USE_PK3_CACHE
+	pack = FS_LoadCachedZipFile( zipfile );
+	if ( pack ) {
+		return pack; // loaded from cache
+	}
+#endif
+
+	scan.zipfile = zipfile;
+	FS_ScanZipFile( &scan );
+	pack = FS_CreatePak( &scan );
+	FS_FreeZipScan( &scan );
+
+	return pack;
+}
+
+
 /*
 =================
 FS_FreePak
@@ -3096,6 +4896,18 @@ static void FS_FreePak( pack_t *pak )
 		pak->handle = NULL;
 	}
 
+	if ( pak->map ) {
+		FS_ReleasePakMap( pak->map );
+		pak->map = NULL;
+	}
+
+#ifdef USE_PK3_CACHE_FILE
+	if ( pak->cacheMap ) {
+		FS_ReleaseCacheMap( pak->cacheMap );
+		pak->cacheMap = NULL;
+	}
+#endif
+
 	Z_Free( pak );
 }
 
@@ -3197,26 +5009,150 @@ char *FS_CopyString( const char *in ) {
 }
 
 
+#define FOUND_FILES_HASH_SIZE	2048
+
+// unique file names collected by FS_ListFilteredFiles
+typedef struct {
+	char	*list[MAX_FOUND_FILES];
+	int		next[MAX_FOUND_FILES];
+	int		hashTable[FOUND_FILES_HASH_SIZE];
+	int		count;
+} foundFiles_t;
+
+
 /*
 ==================
 FS_AddFileToList
+
+Chains hold the list index + 1, zero ends a chain.
 ==================
 */
-static int FS_AddFileToList( const char *name, char **list, int nfiles ) {
-	int		i;
+static void FS_AddFileToList( const char *name, foundFiles_t *files ) {
+	int		i, hash;
 
-	if ( nfiles == MAX_FOUND_FILES - 1 ) {
-		return nfiles;
+	if ( files->count == MAX_FOUND_FILES - 1 ) {
+		return;
 	}
-	for ( i = 0 ; i < nfiles ; i++ ) {
-		if ( !Q_stricmp( name, list[i] ) ) {
-			return nfiles; // already in list
+	hash = FS_HashFileName( name, FOUND_FILES_HASH_SIZE );
+	for ( i = files->hashTable[ hash ]; i; i = files->next[ i - 1 ] ) {
+		if ( !Q_stricmp( name, files->list[ i - 1 ] ) ) {
+			return; // already in list
+		}
+	}
+	files->list[ files->count ] = FS_CopyString( name );
+	files->next[ files->count ] = files->hashTable[ hash ];
+	files->count++;
+	files->hashTable[ hash ] = files->count;
+}
+
+
+/*
+=================
+FS_CompareListEntries
+=================
+*/
+static int FS_CompareListEntries( const void *a, const void *b ) {
+	return strcmp( ((const listEntry_t *)a)->name, ((const listEntry_t *)b)->name );
+}
+
+
+/*
+=================
+FS_CompareListOrder
+
+Puts the matches back in search path and zip order
+=================
+*/
+static int FS_CompareListOrder( const void *a, const void *b ) {
+	const listEntry_t *e1 = *(const listEntry_t **)a;
+	const listEntry_t *e2 = *(const listEntry_t **)b;
+
+	if ( e1->order != e2->order ) {
+		return e1->order - e2->order;
+	}
+
+	return e1->file - e2->file;
+}
+
+
+/*
+=================
+FS_BuildListIndex
+
+Pak file names are lower case with forward slashes,
+so sorting them groups all files under each directory.
+=================
+*/
+static void FS_BuildListIndex( void ) {
+	const searchpath_t	*search;
+	listEntry_t			*entry;
+	int					numFiles, order, i;
+
+	numFiles = 0;
+	for ( search = fs_searchpaths; search; search = search->next ) {
+		if ( search->pack ) {
+			numFiles += search->pack->numfiles;
+		}
+	}
+
+	fs_listIndex = Z_Malloc( ( numFiles + 1 ) * sizeof( fs_listIndex[0] ) );
+	fs_numListEntries = numFiles;
+
+	entry = fs_listIndex;
+	for ( order = 0, search = fs_searchpaths; search; search = search->next, order++ ) {
+		if ( !search->pack ) {
+			continue;
+		}
+		for ( i = 0; i < search->pack->numfiles; i++, entry++ ) {
+			entry->name = FS_PakFileName( search->pack, &search->pack->buildBuffer[i] );
+			entry->search = search;
+			entry->order = order;
+			entry->file = i;
+		}
+	}
+
+	qsort( fs_listIndex, fs_numListEntries, sizeof( fs_listIndex[0] ), FS_CompareListEntries );
+}
+
+
+/*
+=================
+FS_FindListRange
+
+Returns the number of pak files starting with prefix, and the first one in *first
+=================
+*/
+static int FS_FindListRange( const char *prefix, int prefixLen, const listEntry_t **first ) {
+	int lo, hi, mid, start;
+
+	if ( !fs_listIndex ) {
+		FS_BuildListIndex();
+	}
+
+	lo = 0;
+	hi = fs_numListEntries;
+	while ( lo < hi ) {
+		mid = ( lo + hi ) / 2;
+		if ( strncmp( fs_listIndex[ mid ].name, prefix, prefixLen ) < 0 ) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
 		}
 	}
-	list[ nfiles ] = FS_CopyString( name );
-	nfiles++;
+	start = lo;
 
-	return nfiles;
+	hi = fs_numListEntries;
+	while ( lo < hi ) {
+		mid = ( lo + hi ) / 2;
+		if ( strncmp( fs_listIndex[ mid ].name, prefix, prefixLen ) <= 0 ) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	*first = fs_listIndex + start;
+	return lo - start;
 }
 
 
@@ -3261,15 +5197,18 @@ from all search paths
 static char **FS_ListFilteredFiles( const char *path, const char *extension, const char *filter, int *numfiles, int flags ) {
 	int				nfiles;
 	char			**listCopy;
-	char			*list[MAX_FOUND_FILES];
+	foundFiles_t	*files;
 	const searchpath_t	*search;
+	const listEntry_t	*first, **matches;
+	int				numMatches, m, order;
 	int				i;
 	int				pathLength;
 	int				extLen;
 	int				length, pathDepth, temp;
 	pack_t			*pak;
-	fileInPack_t	*buildBuffer;
+	const fileInPack_t *buildBuffer;
 	char			zpath[MAX_ZPATH];
+	char			prefix[MAX_ZPATH];
 	bool		hasPatterns;
 	const char		*x;
 
@@ -3302,19 +5241,96 @@ static char **FS_ListFilteredFiles( const char *path, const char *extension, con
 	if ( pathLength > 0 && ( path[pathLength-1] == '\\' || path[pathLength-1] == '/' ) ) {
 		pathLength--;
 	}
-	nfiles = 0;
 	FS_ReturnPath(path, zpath, &pathDepth);
 
+	files = Z_Malloc( sizeof( *files ) );
+
+	//
+	// pick the pak files under the path from the sorted index
+	//
+	matches = NULL;
+	numMatches = 0;
+	if ( !filter && ( flags & FS_MATCH_PK3s ) && pathLength < (int)sizeof( prefix ) ) {
+		// pak names are lower case, as Q_stricmpn compares them
+		for ( i = 0; i < pathLength; i++ ) {
+			prefix[i] = ( path[i] >= 'A' && path[i] <= 'Z' ) ? path[i] + ( 'a' - 'A' ) : path[i];
+		}
+		prefix[i] = '\0';
+
+		length = FS_FindListRange( prefix, pathLength, &first );
+		if ( length ) {
+			matches = Z_Malloc( length * sizeof( matches[0] ) );
+		}
+
+		for ( i = 0; i < length; i++ ) {
+			const char *name;
+			int zpathLen, depth;
+
+			// check for directory match
+			name = first[i].name;
+
+			zpathLen = FS_ReturnPath(name, zpath, &depth);
+
+			if ( (depth-pathDepth)>2 || pathLength > zpathLen ) {
+				continue;
+			}
+
+			// check for extension match
+			temp = (int)strlen( name );
+
+			if ( fnamecallback ) {
+				// use custom filter
+				if ( !fnamecallback( name, temp ) )
+					continue;
+			} else {
+				if ( temp < extLen )
+					continue;
+				if ( *extension ) {
+					if ( hasPatterns ) {
+						x = strrchr( name, '.' );
+						if ( !x || !Com_FilterExt( extension, x+1 ) ) {
+							continue;
+						}
+					} else {
+						if ( Q_stricmp( name + temp - extLen, extension ) ) {
+							continue;
+						}
+					}
+				}
+			}
+
+			matches[ numMatches++ ] = &first[i];
+		}
+
+		qsort( matches, numMatches, sizeof( matches[0] ), FS_CompareListOrder );
+	}
+
 	//
 	// search through the path, one element at a time, adding to list
 	//
-	for (search = fs_searchpaths ; search ; search = search->next) {
+	m = 0;
+	for ( order = 0, search = fs_searchpaths ; search ; search = search->next, order++ ) {
 		// is the element a pak file?
 		if ( search->pack && ( flags & FS_MATCH_PK3s ) ) {
 
 			//ZOID:  If we are pure, don't search for files on paks that
 			// aren't on the pure list
 			if ( !FS_PakIsPure( search->pack ) && !( flags & FS_MATCH_UNPURE ) ) {
+				while ( m < numMatches && matches[m]->order == order ) {
+					m++;
+				}
+				continue;
+			}
+
+			if ( !filter ) {
+				// unique the match
+				temp = pathLength;
+				if (pathLength) {
+					temp++;		// include the '/'
+				}
+				for ( ; m < numMatches && matches[m]->order == order; m++ ) {
+					FS_AddFileToList( matches[m]->name + temp, files );
+				}
 				continue;
 			}
 
@@ -3323,57 +5339,13 @@ static char **FS_ListFilteredFiles( const char *path, const char *extension, con
 			buildBuffer = pak->buildBuffer;
 			for (i = 0; i < pak->numfiles; i++) {
 				const char *name;
-				int zpathLen, depth;
-
-				// check for directory match
-				name = buildBuffer[i].name;
-				//
-				if ( filter ) {
-					// case insensitive
-					if ( !Com_FilterPath( filter, name ) )
-						continue;
-					// unique the match
-					nfiles = FS_AddFileToList( name, list, nfiles );
-				}
-				else {
-
-					zpathLen = FS_ReturnPath(name, zpath, &depth);
-
-					if ( (depth-pathDepth)>2 || pathLength > zpathLen || Q_stricmpn( name, path, pathLength ) ) {
-						continue;
-					}
 
-					// check for extension match
-					length = (int)strlen( name );
-
-					if ( fnamecallback ) {
-						// use custom filter
-						if ( !fnamecallback( name, length ) )
-							continue;
-					} else {
-						if ( length < extLen )
-							continue;
-						if ( *extension ) {
-							if ( hasPatterns ) {
-								x = strrchr( name, '.' );
-								if ( !x || !Com_FilterExt( extension, x+1 ) ) {
-									continue;
-								}
-							} else {
-								if ( Q_stricmp( name + length - extLen, extension ) ) {
-									continue;
-								}
-							}
-						}
-					}
-					// unique the match
-
-					temp = pathLength;
-					if (pathLength) {
-						temp++;		// include the '/'
-					}
-					nfiles = FS_AddFileToList( name + temp, list, nfiles );
-				}
+				name = FS_PakFileName( pak, &buildBuffer[i] );
+				// case insensitive
+				if ( !Com_FilterPath( filter, name ) )
+					continue;
+				// unique the match
+				FS_AddFileToList( name, files );
 			}
 		} else if ( search->dir && ( flags & FS_MATCH_EXTERN ) && search->policy != DIR_DENY ) { // scan for files in the filesystem
 			const char *netpath;
@@ -3393,25 +5365,33 @@ static char **FS_ListFilteredFiles( const char *path, const char *extension, con
 						continue;
 				} // else - should be already filtered by Sys_ListFiles
 
-				nfiles = FS_AddFileToList( name, list, nfiles );
+				FS_AddFileToList( name, files );
 			}
 			Sys_FreeFileList( sysFiles );
 		}		
 	}
 
+	if ( matches ) {
+		Z_Free( matches );
+	}
+
 	// return a copy of the list
+	nfiles = files->count;
 	*numfiles = nfiles;
 
 	if ( !nfiles ) {
+		Z_Free( files );
 		return NULL;
 	}
 
 	listCopy = Z_Malloc( ( nfiles + 1 ) * sizeof( listCopy[0] ) );
 	for ( i = 0 ; i < nfiles ; i++ ) {
-		listCopy[i] = list[i];
+		listCopy[i] = files->list[i];
 	}
 	listCopy[i] = NULL;
 
+	Z_Free( files );
+
 	return listCopy;
 }
 
@@ -3913,6 +5893,11 @@ static void FS_Path_f( void ) {
 		}
 	}
 
+	if ( !fs_indexTable ) {
+		FS_BuildIndex();
+	}
+	Com_Printf( "\n%i unique files in pk3 index, %i cached misses\n", fs_indexNames, fs_numMissingFiles );
+
 	Com_Printf( "\n" );
 	for ( i = 1 ; i < MAX_FILE_HANDLES ; i++ ) {
 		if ( fsh[i].handleFiles.file.o ) {
@@ -3966,7 +5951,7 @@ static void FS_Which_f( void ) {
 	const searchpath_t *search;
 	char			*netpath;
 	pack_t			*pak;
-	fileInPack_t	*pakFile;
+	const fileInPack_t *pakFile;
 	directory_t		*dir;
 	long			hash;
 	FILE			*temp;
@@ -3994,20 +5979,20 @@ static void FS_Which_f( void ) {
 			hash = FS_HashFileName(filename, search->pack->hashSize);
 		}
 		// is the element a pak file?
-		if ( search->pack && search->pack->hashTable[hash] ) {
+		if ( search->pack && search->pack->hashTable[hash] >= 0 ) {
 			// look through all the pak file elements
 			pak = search->pack;
-			pakFile = pak->hashTable[hash];
+			pakFile = FS_PakHashChain( pak, hash );
 			do {
 				// case and separator insensitive comparisons
-				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
+				if ( !FS_FilenameCompare( FS_PakFileName( pak, pakFile ), filename ) ) {
 					// found it!
 					Com_Printf( "File \"%s\" found in \"%s\"\n", filename, pak->pakFilename );
 					if ( ++numfound >= 32 ) {
 						return;
 					}
 				}
-				pakFile = pakFile->next;
+				pakFile = FS_PakNextFile( pak, pakFile );
 			} while(pakFile != NULL);
 		} else if ( search->dir ) {
 			dir = search->dir;
@@ -4033,8 +6018,128 @@ static void FS_Which_f( void ) {
 }
 
 
+/*
+============
+FS_InflateBench_f
+
+Reads every file of a pk3 twice through a private handle, once with
+whole file reads that take the one-shot inflate and once starting with
+a single byte read, which leaves the rest to the streaming inflate.
+============
+*/
+static void FS_InflateBench_f( void ) {
+	const searchpath_t *search;
+	const pack_t	*pak;
+	const char		*name;
+	char			fullname[ MAX_OSPATH ];
+	unzFile			uf;
+	byte			*buf[2];
+	unsigned long	maxSize, total;
+	int64_t			start, usec[2];
+	int				i, pass, len, files, mismatch;
+
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "Usage: inflatebench <pk3>\n" );
+		return;
+	}
+
+	name = Cmd_Argv( 1 );
+
+	pak = NULL;
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		if ( !search->pack ) {
+			continue;
+		}
+		Com_sprintf( fullname, sizeof( fullname ), "%s/%s", search->pack->pakGamename, search->pack->pakBasename );
+		if ( !Q_stricmp( name, search->pack->pakBasename ) || !Q_stricmp( name, fullname ) ) {
+			pak = search->pack;
+			break;
+		}
+	}
+
+	if ( !pak ) {
+		Com_Printf( "Pak not found: \"%s\"\n", name );
+		return;
+	}
+
+	uf = unzOpen( pak->pakFilename );
+	if ( !uf ) {
+		Com_Printf( "Couldn't open %s\n", pak->pakFilename );
+		return;
+	}
+
+	maxSize = 1;
+	for ( i = 0 ; i < pak->numfiles ; i++ ) {
+		if ( pak->buildBuffer[i].size > maxSize ) {
+			maxSize = pak->buildBuffer[i].size;
+		}
+	}
+
+	buf[0] = Hunk_AllocateTempMemory( maxSize );
+	buf[1] = Hunk_AllocateTempMemory( maxSize );
+
+	usec[0] = usec[1] = 0;
+	total = 0;
+	files = 0;
+	mismatch = 0;
+
+	for ( i = 0 ; i < pak->numfiles ; i++ ) {
+		len = pak->buildBuffer[i].size;
+		for ( pass = 0 ; pass < 2 ; pass++ ) {
+			unzSetCurrentFileInfoPosition( uf, pak->buildBuffer[i].pos );
+			if ( unzOpenCurrentFile( uf ) != UNZ_OK ) {
+				break;
+			}
+			start = Sys_Microseconds();
+			if ( pass == 0 || len <= 1 ) {
+				unzReadCurrentFile( uf, buf[pass], len );
+			} else {
+				unzReadCurrentFile( uf, buf[pass], 1 );
+				unzReadCurrentFile( uf, buf[pass] + 1, len - 1 );
+			}
+			usec[pass] += Sys_Microseconds() - start;
+			unzCloseCurrentFile( uf );
+		}
+		if ( pass != 2 ) {
+			continue;
+		}
+		if ( memcmp( buf[0], buf[1], len ) != 0 ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: %s differs\n", FS_PakFileName( pak, &pak->buildBuffer[i] ) );
+			mismatch++;
+		}
+		total += len;
+		files++;
+	}
+
+	Hunk_FreeTempMemory( buf[1] );
+	Hunk_FreeTempMemory( buf[0] );
+	unzClose( uf );
+
+	Com_Printf( "%s: %i files, %lu bytes\n", pak->pakFilename, files, total );
+	Com_Printf( "whole reads:   %8.2f msec, %7.1f MB/s\n", usec[0] / 1000.0, usec[0] ? total / (double)usec[0] : 0.0 );
+	Com_Printf( "chunked reads: %8.2f msec, %7.1f MB/s\n", usec[1] / 1000.0, usec[1] ? total / (double)usec[1] : 0.0 );
+	if ( mismatch ) {
+		Com_Printf( S_COLOR_YELLOW "%i files differ\n", mismatch );
+	}
+}
+
+
 //===========================================================================
 
+typedef struct {
+	zipScan_t		scan;		// scan.zipfile is set for paks that need to be scanned
+	pack_t			*pack;		// loaded from the pk3 cache
+} pakLoad_t;
+
+static void FS_ScanZipJob( void *data, int index, int thread ) {
+	pakLoad_t *load = (pakLoad_t *)data + index;
+
+	if ( load->scan.zipfile ) {
+		FS_ScanZipFile( &load->scan );
+	}
+}
+
+
 /*
 ================
 FS_AddGameDirectory
@@ -4060,6 +6165,8 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 	int				pakwhich;
 	int				path_len;
 	int				dir_len;
+	pakLoad_t		*pakLoads;
+	int				i;
 
 	for ( sp = fs_searchpaths ; sp ; sp = sp->next ) {
 		if ( sp->dir && !Q_stricmp( sp->dir->path, path ) && !Q_stricmp( sp->dir->gamedir, dir )) {
@@ -4101,6 +6208,27 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 	if ( numfiles >= 2 )
 		FS_SortFileList( pakfiles, numfiles - 1 );
 
+	// read the central directories of all pk3 files that aren't cached yet
+	// on the worker threads, the paks are still created in sorted order below
+	pakLoads = NULL;
+	if ( numfiles > 0 ) {
+		pakLoads = Z_Malloc( numfiles * sizeof( pakLoads[0] ) );
+		for ( i = 0; i < numfiles; i++ ) {
+			if ( !FS_IsExt( pakfiles[i], ".pk3", strlen( pakfiles[i] ) ) ) {
+				continue;
+			}
+			pakfile = FS_BuildOSPath( path, dir, pakfiles[i] );
+#ifdef USE_PK3_CACHE
+			pakLoads[i].pack = FS_LoadCachedZipFile( pakfile );
+			if ( pakLoads[i].pack ) {
+				continue;
+			}
+#endif
+			pakLoads[i].scan.zipfile = CopyString( pakfile );
+		}
+		Com_ParallelFor( numfiles, FS_ScanZipJob, pakLoads );
+	}
+
 	pakfilesi = 0;
 	pakdirsi = 0;
 
@@ -4141,8 +6269,11 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 			}
 
 			// The next .pk3 file is before the next .pk3dir
-			pakfile = FS_BuildOSPath( path, dir, pakfiles[pakfilesi] );
-			if ( (pak = FS_LoadZipFile( pakfile ) ) == NULL ) {
+			pak = pakLoads[pakfilesi].pack;
+			if ( !pak ) {
+				pak = FS_CreatePak( &pakLoads[pakfilesi].scan );
+			}
+			if ( pak == NULL ) {
 				// This isn't a .pk3! Next!
 				pakfilesi++;
 				continue;
@@ -4203,6 +6334,16 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 	}
 
 	// done
+	for ( i = 0; i < numfiles; i++ ) {
+		if ( pakLoads[i].scan.zipfile ) {
+			FS_FreeZipScan( &pakLoads[i].scan );
+			Z_Free( (char *)pakLoads[i].scan.zipfile );
+		}
+	}
+	if ( pakLoads ) {
+		Z_Free( pakLoads );
+	}
+
 	Sys_FreeFileList( pakdirs );
 	Sys_FreeFileList( pakfiles );
 }
@@ -4400,10 +6541,16 @@ void FS_Shutdown( bool closemfp )
 	}
 #endif
 
+	// prefetched files and async reads refer to the paks
+	FS_StopMapLoad( false );
+	FS_ShutdownAsyncReads();
+
 #ifdef USE_PK3_CACHE
 	FS_ResetCacheReferences();
 #endif
 
+	FS_FreeIndex();
+
 	// free everything
 	for( p = fs_searchpaths; p; p = next )
 	{
@@ -4428,6 +6575,7 @@ void FS_Shutdown( bool closemfp )
 	// any FS_ calls will now be an error until reinitialized
 	fs_searchpaths = NULL;
 	fs_packFiles = 0;
+	fs_pakSequence++;
 
 	fs_pk3dirCount = 0;
 	fs_packCount = 0;
@@ -4438,6 +6586,7 @@ void FS_Shutdown( bool closemfp )
 	Cmd_RemoveCommand( "fdir" );
 	Cmd_RemoveCommand( "touchFile" );
 	Cmd_RemoveCommand( "which" );
+	Cmd_RemoveCommand( "inflatebench" );
 	Cmd_RemoveCommand( "lsof" );
 	Cmd_RemoveCommand( "fs_restart" );
 }
@@ -4523,6 +6672,11 @@ static void FS_ReorderPurePaks( void )
 			p_previous = &s->next;
 		}
 	}
+
+	if ( fs_reordered ) {
+		FS_FreeIndex();
+		fs_pakSequence++;
+	}
 }
 
 
@@ -4560,15 +6714,27 @@ static void FS_ListOpenFiles_f( void ) {
 /*
 =====================
 FS_LoadedPakPureChecksums
+
+Collects the pure checksums of the loaded pk3 files, only done
+again when the search paths or the checksum feed have changed.
 =====================
 */
 static int fs_numPureChecksums;
 static int fs_pureChecksum[ MAX_FOUND_FILES ];
+static int fs_pureChecksumSequence = -1;
+static int fs_pureChecksumFeed;
 
 static void FS_LoadedPakPureChecksums( void )
 {
 	const searchpath_t *search;
 
+	if ( fs_pureChecksumSequence == fs_pakSequence && fs_pureChecksumFeed == fs_checksumFeed ) {
+		return;
+	}
+
+	fs_pureChecksumSequence = fs_pakSequence;
+	fs_pureChecksumFeed = fs_checksumFeed;
+
 	fs_numPureChecksums = 0;
 	for ( search = fs_searchpaths ; search ; search = search->next ) {
 		if ( search->pack ) {
@@ -4577,7 +6743,7 @@ static void FS_LoadedPakPureChecksums( void )
 				fs_numPureChecksums = 0;
 				return;
 			}
-			fs_pureChecksum[ fs_numPureChecksums ] = search->pack->pure_checksum;
+			fs_pureChecksum[ fs_numPureChecksums ] = FS_PakPureChecksum( search->pack );
 			fs_numPureChecksums++;
 		}
 	}
@@ -4593,6 +6759,8 @@ bool FS_IsPureChecksum( int sum )
 {
 	int i;
 
+	FS_LoadedPakPureChecksums();
+
 	if ( fs_numPureChecksums == 0 )
 		return true;
 	
@@ -4666,6 +6834,18 @@ static void FS_Startup( void ) {
 		Cvar_ForceReset( "fs_game" );
 	}
 
+#if idx64
+	fs_mapPaks = Cvar_Get( "fs_mapPaks", "1", 0 );
+#else
+	fs_mapPaks = Cvar_Get( "fs_mapPaks", "0", 0 );
+#endif
+	Cvar_SetDescription( fs_mapPaks, "Map pk3 files into memory to read whole files from them without intermediate copies, needs a lot of address space." );
+
+	fs_prefetch = Cvar_Get( "fs_prefetch", "0", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( fs_prefetch, "0", "1024", CV_INTEGER );
+	Cvar_SetDescription( fs_prefetch, "Record the files read while a map is loaded to prefetch/ and inflate them on the worker threads on the next load of the map, needs fs_mapPaks.\n"
+		"Value is the memory limit for prefetched files in megabytes, 0 disables." );
+
 	fs_excludeReference = Cvar_Get( "fs_excludeReference", "", CVAR_ARCHIVE_ND | CVAR_LATCH );
 	Cvar_SetDescription( fs_excludeReference,
 		"Exclude specified pak files from download list on client side.\n"
@@ -4734,8 +6914,11 @@ static void FS_Startup( void ) {
 	// reorder the pure pk3 files according to server order
 	FS_ReorderPurePaks();
 
-	// get the pure checksums of the pk3 files loaded by the server
-	FS_LoadedPakPureChecksums();
+	// merge all pak contents into a single lookup table
+	FS_BuildIndex();
+
+	// the pak checksum strings are built again on first use
+	fs_pakSequence++;
 
 	end = Sys_Milliseconds();
 
@@ -4752,6 +6935,7 @@ static void FS_Startup( void ) {
 	Cmd_AddCommand( "lsof", FS_ListOpenFiles_f );
  	Cmd_AddCommand( "which", FS_Which_f );
 	Cmd_SetCommandCompletionFunc( "which", FS_CompleteFileName );
+	Cmd_AddCommand( "inflatebench", FS_InflateBench_f );
 	Cmd_AddCommand( "fs_restart", FS_Reload );
 
 	// print the current search paths
@@ -4805,15 +6989,25 @@ FS_LoadedPakChecksums
 
 Returns a space separated string containing the checksums of all loaded pk3 files.
 Servers with sv_pure set will get this string and pass it to clients.
+The string is kept until the search paths change.
 =====================
 */
 const char *FS_LoadedPakChecksums( bool *overflowed ) {
 	static char	info[BIG_INFO_STRING];
+	static bool	infoOverflowed;
+	static int	sequence = -1;
 	const searchpath_t *search;
 	char buf[ 32 ];
 	char *s, *max;
 	int len;
 
+	if ( sequence == fs_pakSequence ) {
+		*overflowed = infoOverflowed;
+		return info;
+	}
+
+	sequence = fs_pakSequence;
+
 	s = info;
 	info[0] = '\0';
 	max = &info[sizeof(info)-1];
@@ -4840,6 +7034,8 @@ const char *FS_LoadedPakChecksums( bool *overflowed ) {
 		s = Q_stradd( s, buf );
 	}
 
+	infoOverflowed = *overflowed;
+
 	return info;
 }
 
@@ -4855,10 +7051,17 @@ Servers with sv_pure set will get this string and pass it to clients.
 #ifndef DEDICATED
 const char *FS_LoadedPakNames( void ) {
 	static char	info[BIG_INFO_STRING];
+	static int	sequence = -1;
 	const searchpath_t *search;
 	char *s, *max;
 	int len;
 
+	if ( sequence == fs_pakSequence ) {
+		return info;
+	}
+
+	sequence = fs_pakSequence;
+
 	s = info;
 	info[0] = '\0';
 	max = &info[sizeof(info)-1];
@@ -4895,13 +7098,26 @@ FS_ReferencedPakChecksums
 
 Returns a space separated string containing the checksums of all referenced pk3 files.
 The server will send this to the clients so they can check which files should be auto-downloaded. 
+The string is kept until the search paths or pak references change.
 =====================
 */
 const char *FS_ReferencedPakChecksums( void ) {
 	static char	info[BIG_INFO_STRING];
+	static int	sequence = -1;
 	const searchpath_t *search;
+	char buf[ 32 ];
+	char *s, *max;
+	int len;
 
+	if ( sequence == fs_pakSequence ) {
+		return info;
+	}
+
+	sequence = fs_pakSequence;
+
+	s = info;
 	info[0] = '\0';
+	max = &info[sizeof(info)-1];
 
 	for ( search = fs_searchpaths ; search ; search = search->next ) {
 		// is the element a pak file?
@@ -4910,7 +7126,11 @@ const char *FS_ReferencedPakChecksums( void ) {
 				continue;
 			}
 			if ( search->pack->referenced || !FS_IsBaseGame( search->pack->pakGamename ) ) {
-				Q_strcat( info, sizeof( info ), va( "%i ", search->pack->checksum ) );
+				len = sprintf( buf, "%i ", search->pack->checksum );
+				if ( s + len > max ) {
+					break;
+				}
+				s = Q_stradd( s, buf );
 			}
 		}
 	}
@@ -4927,14 +7147,25 @@ Returns a space separated string containing the pure checksums of all referenced
 Servers with sv_pure set will get this string back from clients for pure validation 
 
 The string has a specific order, "gameclient ui @ ref1 ref2 ref3 ..."
+It is kept until the search paths, pak references or the checksum feed change.
 =====================
 */
 const char *FS_ReferencedPakPureChecksums( int maxlen ) {
 	static char	info[ MAX_STRING_CHARS*2 ];
+	static int	sequence = -1;
+	static int	infoFeed, infoMaxlen;
 	char *s, *max;
 	const searchpath_t	*search;
 	int nFlags, numPaks, checksum;
 
+	if ( sequence == fs_pakSequence && infoFeed == fs_checksumFeed && infoMaxlen == maxlen ) {
+		return info;
+	}
+
+	sequence = fs_pakSequence;
+	infoFeed = fs_checksumFeed;
+	infoMaxlen = maxlen;
+
 	max = info + maxlen; // maxlen is always smaller than MAX_STRING_CHARS so we can overflow a bit
 	s = info;
 	*s = '\0';
@@ -4951,13 +7182,13 @@ const char *FS_ReferencedPakPureChecksums( int maxlen ) {
 		for ( search = fs_searchpaths ; search ; search = search->next ) {
 			// is the element a pak file and has it been referenced based on flag?
 			if ( search->pack && (search->pack->referenced & nFlags)) {
-				s = Q_stradd( s, va( "%i ", search->pack->pure_checksum ) );
+				s = Q_stradd( s, va( "%i ", FS_PakPureChecksum( search->pack ) ) );
 				if ( s > max ) // client-side overflow
 					break;
 				if ( nFlags & (FS_GAMECLIENT_REF | FS_UI_REF) ) {
 					break;
 				}
-				checksum ^= search->pack->pure_checksum;
+				checksum ^= FS_PakPureChecksum( search->pack );
 				numPaks++;
 			}
 		}
@@ -5003,6 +7234,7 @@ bool FS_ExcludeReference( void ) {
 			for ( i = 0; i < nargs; i++ ) {
 				if ( Q_stricmp( Cmd_Argv( i ), pakName ) == 0 ) {
 					search->pack->exclude = true;
+					fs_pakSequence++;
 					x = true;
 					break;
 				}
@@ -5024,9 +7256,21 @@ The server will send this to the clients so they can check which files should be
 */
 const char *FS_ReferencedPakNames( void ) {
 	static char	info[BIG_INFO_STRING];
+	static int	sequence = -1;
 	const searchpath_t *search;
 	const char *pakName;
+	char *s, *max;
+	int len;
+
+	if ( sequence == fs_pakSequence ) {
+		return info;
+	}
+
+	sequence = fs_pakSequence;
+
+	s = info;
 	info[0] = '\0';
+	max = &info[sizeof(info)-1];
 
 	// we want to return ALL pk3's from the fs_game path
 	// and referenced one's from baseq3
@@ -5038,10 +7282,17 @@ const char *FS_ReferencedPakNames( void ) {
 			}
 			if ( search->pack->referenced || !FS_IsBaseGame( search->pack->pakGamename ) ) {
 				pakName = va( "%s/%s", search->pack->pakGamename, search->pack->pakBasename );
+				len = (int)strlen( pakName );
+				if ( *info != '\0' ) {
+					len++;
+				}
+				if ( s + len > max ) {
+					break;
+				}
 				if ( *info != '\0' ) {
-					Q_strcat( info, sizeof( info ), " " );
+					s = Q_stradd( s, " " );
 				}
-				Q_strcat( info, sizeof( info ), pakName );
+				s = Q_stradd( s, pakName );
 			}
 		}
 	}
@@ -5067,6 +7318,7 @@ void FS_ClearPakReferences( int flags ) {
 			search->pack->referenced &= ~flags;
 		}
 	}
+	fs_pakSequence++;
 }
 
 
@@ -5112,6 +7364,9 @@ void FS_PureServerSetLoadedPaks( const char *pakSums, const char *pakNames ) {
 
 	FS_SetDirPolicy( c ? DIR_DENY : DIR_ALLOW );
 
+	// also drops files missing from the previous map
+	FS_FlushMissingFiles();
+
 	for ( i = 0 ; i < c ; i++ ) {
 		fs_serverPaks[i] = atoi( Cmd_Argv( i ) );
 	}
@@ -5571,6 +7826,8 @@ fileHandle_t FS_PipeOpenWrite( const char *cmd, const char *filename ) {
 	fd = &fsh[ f ];
 	FS_InitHandle( fd );
 
+	FS_FlushMissingFiles();
+
 	if ( FS_CreatePath( ospath ) ) {
 		return FS_INVALID_HANDLE;
 	}
@@ -0,0 +1,256 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// jobs.c -- worker thread pool for splitting independent work items
+
+/*
+
+Job functions are executed on worker threads as well as on the main thread,
+so they must not touch anything that isn't thread safe: no Com_Printf,
+Com_Error, Z_Malloc, Hunk_Alloc, cvars or filesystem handles.
+Errors and warnings should be recorded in the job data and reported by the
+caller after Com_ParallelFor returns.
+
+*/
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+#define MAX_JOB_WORKERS 16
+
+typedef struct {
+	jobFunc_t	func;
+	void		*data;
+	int			count;
+	int			next;			// next item index to process
+	int			finished;		// workers that ran out of items
+} jobBatch_t;
+
+static cvar_t		*com_jobWorkers;
+
+static void			*workerThreads[ MAX_JOB_WORKERS ];
+static int			numWorkers;
+
+static void			*jobLock;
+static void			*jobWake;		// posted once per worker for each batch
+static void			*jobDone;		// posted when the last worker has finished a batch
+static jobBatch_t	jobBatch;
+static bool		jobShutdown;
+
+
+/*
+=================
+Com_RunBatchItems
+
+Processes items from the current batch until there are none left.
+=================
+*/
+static void Com_RunBatchItems( jobBatch_t *batch, int thread ) {
+	int index;
+
+	for ( ;; ) {
+		Sys_LockMutex( jobLock );
+		index = batch->next;
+		if ( index < batch->count ) {
+			batch->next++;
+		}
+		Sys_UnlockMutex( jobLock );
+
+		if ( index >= batch->count ) {
+			break;
+		}
+
+		batch->func( batch->data, index, thread );
+	}
+}
+
+
+/*
+=================
+Com_JobWorker
+=================
+*/
+static void Com_JobWorker( void *arg ) {
+	const int thread = (int)(intptr_t)arg;
+
+	for ( ;; ) {
+		Sys_SemaphoreWait( jobWake );
+
+		if ( jobShutdown ) {
+			break;
+		}
+
+		Com_RunBatchItems( &jobBatch, thread );
+
+		Sys_LockMutex( jobLock );
+		jobBatch.finished++;
+		if ( jobBatch.finished == numWorkers ) {
+			Sys_SemaphorePost( jobDone );
+		}
+		Sys_UnlockMutex( jobLock );
+	}
+}
+
+
+/*
+=================
+Com_ParallelFor
+
+Calls func( data, index, thread ) for each index in [0, count), spreading
+the calls over the worker threads and the calling thread, and returns once
+all of them are complete. Items are picked in order but may complete in any
+order. The thread argument is 0 for the calling thread and 1..Com_JobWorkers()
+for the workers, so it can be used to select per-thread scratch space.
+Must only be called from the main thread.
+=================
+*/
+void Com_ParallelFor( int count, jobFunc_t func, void *data ) {
+	int i;
+
+	if ( numWorkers == 0 || count <= 1 ) {
+		for ( i = 0; i < count; i++ ) {
+			func( data, i, 0 );
+		}
+		return;
+	}
+
+	jobBatch.func = func;
+	jobBatch.data = data;
+	jobBatch.count = count;
+	jobBatch.next = 0;
+	jobBatch.finished = 0;
+
+	for ( i = 0; i < numWorkers; i++ ) {
+		Sys_SemaphorePost( jobWake );
+	}
+
+	Com_RunBatchItems( &jobBatch, 0 );
+
+	Sys_SemaphoreWait( jobDone );
+
+	jobBatch.func = NULL;
+	jobBatch.data = NULL;
+}
+
+
+/*
+=================
+Com_JobWorkers
+
+Returns number of worker threads, 0 if all work runs on the main thread.
+=================
+*/
+int Com_JobWorkers( void ) {
+	return numWorkers;
+}
+
+
+/*
+=================
+Com_InitJobs
+
+Called once before the filesystem is started, so pk3 files can be
+scanned in parallel, and again after the config files are executed,
+which restarts the workers if an archived com_jobWorkers differs.
+=================
+*/
+void Com_InitJobs( void ) {
+	int count;
+
+	com_jobWorkers = Cvar_Get( "com_jobWorkers", "-1", CVAR_ARCHIVE_ND | CVAR_LATCH );
+	Cvar_CheckRange( com_jobWorkers, "-1", XSTRING( MAX_JOB_WORKERS ), CV_INTEGER );
+	Cvar_SetDescription( com_jobWorkers, "Number of worker threads used for parallel loading work:\n"
+		" -1 - one less than the number of CPU cores\n"
+		"  0 - run everything on the main thread" );
+
+	count = com_jobWorkers->integer;
+	if ( count < 0 ) {
+		count = Sys_CPUCount() - 1;
+	}
+	if ( count > MAX_JOB_WORKERS ) {
+		count = MAX_JOB_WORKERS;
+	}
+	if ( count < 0 ) {
+		count = 0;
+	}
+	if ( jobLock && count == numWorkers ) {
+		return;
+	}
+
+	Com_ShutdownJobs();
+
+	if ( count == 0 ) {
+		return;
+	}
+
+	jobLock = Sys_CreateMutex();
+	jobWake = Sys_CreateSemaphore();
+	jobDone = Sys_CreateSemaphore();
+	if ( !jobLock || !jobWake || !jobDone ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: failed to create job synchronization objects\n" );
+		Com_ShutdownJobs();
+		return;
+	}
+
+	jobShutdown = false;
+	for ( numWorkers = 0; numWorkers < count; numWorkers++ ) {
+		workerThreads[ numWorkers ] = Sys_CreateThread( Com_JobWorker, (void *)(intptr_t)( numWorkers + 1 ) );
+		if ( !workerThreads[ numWorkers ] ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: failed to create worker thread %i\n", numWorkers );
+			break;
+		}
+	}
+
+	Com_Printf( "...started %i worker threads\n", numWorkers );
+}
+
+
+/*
+=================
+Com_ShutdownJobs
+=================
+*/
+void Com_ShutdownJobs( void ) {
+	int i;
+
+	jobShutdown = true;
+	for ( i = 0; i < numWorkers; i++ ) {
+		Sys_SemaphorePost( jobWake );
+	}
+	for ( i = 0; i < numWorkers; i++ ) {
+		Sys_JoinThread( workerThreads[ i ] );
+		workerThreads[ i ] = NULL;
+	}
+	numWorkers = 0;
+
+	if ( jobDone ) {
+		Sys_DestroySemaphore( jobDone );
+		jobDone = NULL;
+	}
+	if ( jobWake ) {
+		Sys_DestroySemaphore( jobWake );
+		jobWake = NULL;
+	}
+	if ( jobLock ) {
+		Sys_DestroyMutex( jobLock );
+		jobLock = NULL;
+	}
+}
@@ -737,6 +737,16 @@ typedef enum {
 	FS_SEEK_SET
 } fsOrigin_t;
 
+// priority parm for FS_ReadFileAsync, higher priority requests are read first
+typedef enum {
+	FS_ASYNC_LOW,
+	FS_ASYNC_NORMAL,
+	FS_ASYNC_HIGH
+} fsAsyncPriority_t;
+
+// completion callback for FS_ReadFileAsync, buffer is NULL and length -1 if the read failed
+typedef void (*fsAsyncCallback_t)( void *data, const char *qpath, void *buffer, int length );
+
 //=============================================
 
 extern const byte locase[ 256 ];
@@ -733,6 +733,11 @@ int		FS_FOpenFileRead( const char *qpath, fileHandle_t *file, bool uniqueFILE );
 
 void FS_TouchFileInPak( const char *filename );
 
+// maps a plain file from the search path read-only into memory,
+// returns NULL if it is missing, in a pk3 or can't be mapped
+const void *FS_MapFile( const char *qpath, int *length );
+void	FS_UnmapFile( const void *base, int length );
+
 void FS_BypassPure( void );
 void FS_RestorePure( void );
 
@@ -770,6 +775,23 @@ void	FS_ForceFlush( fileHandle_t f );
 void	FS_FreeFile( void *buffer );
 // frees the memory returned by FS_ReadFile
 
+void	FS_BeginMapLoad( const char *mapname, const char *part );
+void	FS_EndMapLoad( void );
+// records the files read with FS_ReadFile in between, the next load
+// of the same part of the map prefetches them, see fs_prefetch
+
+int		FS_ReadFileAsync( const char *qpath, fsAsyncPriority_t priority, fsAsyncCallback_t callback, void *data );
+// queues a read of a whole file on the reader threads and returns the request,
+// or 0 if the file can't be read asynchronously and FS_ReadFile should be used.
+// The callback is called from FS_RunAsyncReads on the main thread, and the
+// buffer is freed when it returns.
+
+void	FS_CancelAsyncRead( int request );
+// drops a request that hasn't called back yet, its callback won't be called
+
+void	FS_RunAsyncReads( bool wait );
+// calls back completed requests, and waits for all of them if wait is set
+
 void	FS_WriteFile( const char *qpath, const void *buffer, int size );
 // writes a complete file, creating any subdirectories needed
 
@@ -971,6 +993,14 @@ void		Com_WriteConfiguration( void );
 int			Com_HexStrToInt( const char *str );
 bool	Com_GetHashColor( const char *str, byte *color );
 
+// worker thread pool, see jobs.c
+typedef void (*jobFunc_t)( void *data, int index, int thread );
+
+void		Com_InitJobs( void );
+void		Com_ShutdownJobs( void );
+int			Com_JobWorkers( void );
+void		Com_ParallelFor( int count, jobFunc_t func, void *data );
+
 
 static ID_INLINE unsigned int log2pad( unsigned int v, int roundup )
 {
@@ -1301,6 +1331,10 @@ void Sys_FreeFileList( char **list );
 
 bool Sys_GetFileStats( const char *filename, fileOffset_t *size, fileTime_t *mtime, fileTime_t *ctime );
 
+// read-only file mappings
+const void *Sys_MapFile( const char *ospath, int *length );
+void Sys_UnmapFile( const void *base, int length );
+
 void Sys_BeginProfiling( void );
 void Sys_EndProfiling( void );
 
@@ -1313,6 +1347,19 @@ void *Sys_LoadFunction( void *handle, const char *name );
 int   Sys_LoadFunctionErrors( void );
 void  Sys_UnloadLibrary( void *handle );
 
+// threads and synchronization primitives, only used by the job system
+void	*Sys_CreateThread( void (*func)( void *arg ), void *arg );
+void	Sys_JoinThread( void *thread );
+void	*Sys_CreateMutex( void );
+void	Sys_DestroyMutex( void *mutex );
+void	Sys_LockMutex( void *mutex );
+void	Sys_UnlockMutex( void *mutex );
+void	*Sys_CreateSemaphore( void );
+void	Sys_DestroySemaphore( void *sem );
+void	Sys_SemaphorePost( void *sem );
+void	Sys_SemaphoreWait( void *sem );
+int		Sys_CPUCount( void );
+
 // adaptive huffman functions
 void Huff_Compress( msg_t *buf, int offset );
 void Huff_Decompress( msg_t *buf, int offset );
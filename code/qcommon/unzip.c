@@ -952,6 +952,13 @@ static int inflateInit2_ OF((z_streamp strm, int  windowBits,
 #define inflateInit2(strm, windowBits) \
         inflateInit2_((strm), (windowBits), ZLIB_VERSION, sizeof(z_stream))
 
+static int inflate_buffer OF((const Byte *in, uLong inLen, Byte *out, uLong outLen, uLong *outDone));
+/*
+    Decompresses a raw deflate stream that is completely in memory, see
+  the fast one-shot inflate below. Returns Z_DATA_ERROR for anything that
+  should be left to inflate.
+*/
+
 
 // static const char   * zError           OF((int err));
 // static int            inflateSyncPoint OF((z_streamp z));
@@ -1043,6 +1050,8 @@ typedef unsigned long  ulg;
 typedef uLong (*check_func) OF((uLong check, const Byte *buf, uInt len));
 static voidp zcalloc OF((voidp opaque, unsigned items, unsigned size));
 static void   zcfree  OF((voidp opaque, voidp ptr));
+static voidp zmalloc OF((voidp opaque, unsigned items, unsigned size));
+static void   zmfree  OF((voidp opaque, voidp ptr));
 
 #define ZALLOC(strm, items, size) \
            (*((strm)->zalloc))((strm)->opaque, (items), (size))
@@ -1995,6 +2004,52 @@ extern int unzOpenCurrentFile (unzFile file)
 }
 
 
+/*
+  Decompress the whole current file into buf in one go, before anything
+    has been read from it.
+  return 1 if the file is done, 0 if it must be read through inflate
+*/
+static int unzlocal_InflateCurrentFile (unz_s* s, void *buf)
+{
+	file_in_zip_read_info_s* pfile_in_zip_read_info=s->pfile_in_zip_read;
+	uLong compressed=pfile_in_zip_read_info->rest_read_compressed;
+	uLong uncompressed=pfile_in_zip_read_info->rest_read_uncompressed;
+	uLong done;
+	Byte *in;
+	int err;
+
+	if (compressed<=UNZ_BUFSIZE)
+		in = (Byte*)pfile_in_zip_read_info->read_buffer;
+	else
+	{
+		/* not from the zone, the data may be much larger than the zone */
+		in = (Byte*)malloc(compressed);
+		if (in==NULL)
+			return 0;
+	}
+
+	err = Z_DATA_ERROR;
+	if (fseek(pfile_in_zip_read_info->file,
+			  pfile_in_zip_read_info->pos_in_zipfile +
+				 pfile_in_zip_read_info->byte_before_the_zipfile,SEEK_SET)==0 &&
+		(compressed==0 || fread(in,compressed,1,pfile_in_zip_read_info->file)==1))
+		err = inflate_buffer(in,compressed,(Byte*)buf,uncompressed,&done);
+
+	if (in!=(Byte*)pfile_in_zip_read_info->read_buffer)
+		free(in);
+
+	/* an early end of the stream is left to inflate as well */
+	if (err!=Z_OK || done!=uncompressed)
+		return 0;
+
+	pfile_in_zip_read_info->pos_in_zipfile += compressed;
+	pfile_in_zip_read_info->rest_read_compressed = 0;
+	pfile_in_zip_read_info->rest_read_uncompressed = 0;
+	pfile_in_zip_read_info->stream.total_out += done;
+	return 1;
+}
+
+
 /*
   Read bytes from the current file.
   buf contain buffer where data must be copied
@@ -2033,6 +2088,17 @@ extern int unzReadCurrentFile  (unzFile file, void *buf, unsigned len)
 		pfile_in_zip_read_info->stream.avail_out = 
 		  (uInt)pfile_in_zip_read_info->rest_read_uncompressed;
 
+	/* whole file reads don't need to go through the inflate stream */
+	if ((pfile_in_zip_read_info->compression_method!=0) &&
+		(pfile_in_zip_read_info->stream.total_out==0) &&
+		(pfile_in_zip_read_info->rest_read_compressed==s->cur_file_info.compressed_size) &&
+		(pfile_in_zip_read_info->stream.avail_out==pfile_in_zip_read_info->rest_read_uncompressed) &&
+		(pfile_in_zip_read_info->stream.avail_out>0))
+	{
+		if (unzlocal_InflateCurrentFile(s,buf))
+			return (int)pfile_in_zip_read_info->stream.total_out;
+	}
+
 	while (pfile_in_zip_read_info->stream.avail_out>0)
 	{
 		if ((pfile_in_zip_read_info->stream.avail_in==0) &&
@@ -2293,6 +2359,829 @@ extern int unzGetGlobalComment (unzFile file, char *szComment, uLong uSizeBuf)
 	return (int)uReadThis;
 }
 
+
+static uLong unzlocal_mappedShort (const unsigned char *p)
+{
+	return (uLong)p[0] | ((uLong)p[1]<<8);
+}
+
+static uLong unzlocal_mappedLong (const unsigned char *p)
+{
+	return (uLong)p[0] | ((uLong)p[1]<<8) | ((uLong)p[2]<<16) | ((uLong)p[3]<<24);
+}
+
+/*
+  Locate the end of central directory of a zipfile mapped into memory.
+  return the number of bytes before the zipfile (>0 for sfx), or <0 if
+    the mapping doesn't hold a valid zipfile
+*/
+extern long unzMappedZipOffset (const unsigned char *base, unsigned long length)
+{
+	uLong uMaxBack=0xffff; /* maximum size of global comment */
+	uLong central_pos,size_central_dir,offset_central_dir;
+	uLong i;
+
+	if (length<22)
+		return UNZ_BADZIPFILE;
+
+	if (uMaxBack>length)
+		uMaxBack = length;
+
+	central_pos = 0;
+	for (i=length-4; i>0 && i+uMaxBack>=length; i--)
+		if (unzlocal_mappedLong(base+i)==0x06054b50)
+		{
+			central_pos = i;
+			break;
+		}
+
+	if (central_pos==0 || central_pos+22>length)
+		return UNZ_BADZIPFILE;
+
+	size_central_dir = unzlocal_mappedLong(base+central_pos+12);
+	offset_central_dir = unzlocal_mappedLong(base+central_pos+16);
+
+	if (central_pos<offset_central_dir+size_central_dir)
+		return UNZ_BADZIPFILE;
+
+	return (long)(central_pos-(offset_central_dir+size_central_dir));
+}
+
+/*
+  Locate the data of the file whose central directory entry is at
+    pos_in_central_dir (as returned by unzGetCurrentFileInfoPosition) in a
+    zipfile mapped into memory. The static header is checked the same way
+    as unzOpenCurrentFile does, but no file i/o is done.
+  return UNZ_OK if there is no problem
+*/
+extern int unzLocateMappedFile (const unsigned char *base, unsigned long length, long byte_before_the_zipfile,
+								unsigned long pos_in_central_dir, unz_mapped_file *file)
+{
+	const unsigned char *p;
+	uLong offset,uFlags,size_filename,size_extra_field,crc;
+
+	offset = pos_in_central_dir + byte_before_the_zipfile;
+	if (offset>length || length-offset<SIZECENTRALDIRITEM)
+		return UNZ_BADZIPFILE;
+
+	p = base + offset;
+	if (unzlocal_mappedLong(p)!=0x02014b50)
+		return UNZ_BADZIPFILE;
+
+	file->compression_method = unzlocal_mappedShort(p+10);
+	crc = unzlocal_mappedLong(p+16);
+	file->compressed_size = unzlocal_mappedLong(p+20);
+	file->uncompressed_size = unzlocal_mappedLong(p+24);
+	size_filename = unzlocal_mappedShort(p+28);
+
+	if ((file->compression_method!=0) && (file->compression_method!=Z_DEFLATED))
+		return UNZ_BADZIPFILE;
+
+	/* the static header */
+	offset = unzlocal_mappedLong(p+42) + byte_before_the_zipfile;
+	if (offset>length || length-offset<SIZEZIPLOCALHEADER)
+		return UNZ_BADZIPFILE;
+
+	p = base + offset;
+	if (unzlocal_mappedLong(p)!=0x04034b50)
+		return UNZ_BADZIPFILE;
+
+	uFlags = unzlocal_mappedShort(p+6);
+	if (unzlocal_mappedShort(p+8)!=file->compression_method)
+		return UNZ_BADZIPFILE;
+
+	if ((uFlags & 8)==0 && (unzlocal_mappedLong(p+14)!=crc ||
+		unzlocal_mappedLong(p+18)!=file->compressed_size ||
+		unzlocal_mappedLong(p+22)!=file->uncompressed_size))
+		return UNZ_BADZIPFILE;
+
+	if (unzlocal_mappedShort(p+26)!=size_filename)
+		return UNZ_BADZIPFILE;
+	size_extra_field = unzlocal_mappedShort(p+28);
+
+	offset += SIZEZIPLOCALHEADER + size_filename + size_extra_field;
+	if (offset>length || length-offset<file->compressed_size)
+		return UNZ_BADZIPFILE;
+
+	file->data = base + offset;
+	return UNZ_OK;
+}
+
+/*
+  Read a file located with unzLocateMappedFile. Stored data is copied and
+    deflated data is inflated straight from the mapping into buf.
+  Only malloc is used, so it's safe to call from any thread.
+  return the number of unsigned char copied, or <0 with error code
+*/
+extern int unzReadMappedFile (const unz_mapped_file *file, void *buf, unsigned len)
+{
+	z_stream stream;
+	uLong done;
+	int err;
+
+	if (len>file->uncompressed_size)
+		len = (unsigned)file->uncompressed_size;
+
+	if (file->compression_method==0)
+	{
+		if (len>file->compressed_size)
+			return UNZ_BADZIPFILE;
+		Com_Memcpy(buf,file->data,len);
+		return (int)len;
+	}
+
+	if (inflate_buffer(file->data,file->compressed_size,(Byte*)buf,len,&done)==Z_OK &&
+		done==len)
+		return (int)done;
+
+	/* anything unusual, including an early end of the stream, is left to inflate */
+	Com_Memset(&stream,0,sizeof(stream));
+	stream.zalloc = (alloc_func)zmalloc;
+	stream.zfree = (free_func)zmfree;
+	err = inflateInit2(&stream,-MAX_WBITS);
+	if (err!=Z_OK)
+		return err;
+
+	stream.next_in = (Byte*)file->data;
+	stream.avail_in = (uInt)file->compressed_size;
+	stream.next_out = (Byte*)buf;
+	stream.avail_out = (uInt)len;
+
+	/* the size is known, so Z_STREAM_END isn't required (see unzOpenCurrentFile) */
+	while (stream.avail_out>0)
+	{
+		err = inflate(&stream,Z_SYNC_FLUSH);
+		if (err==Z_STREAM_END)
+			break;
+		if (err!=Z_OK)
+		{
+			inflateEnd(&stream);
+			return err;
+		}
+	}
+
+	inflateEnd(&stream);
+	return (int)stream.total_out;
+}
+
+/*
+  Read the whole central dir of a zipfile into memory, the end of central
+    dir is checked the same way as unzOpen does.
+  Only malloc and stdio are used, so it's safe to call from any thread.
+  return UNZ_OK if there is no problem
+*/
+extern int unzReadCentralDir (const char *path, unz_central_dir *dir)
+{
+	uLong central_pos,uL;
+	uLong number_disk,number_disk_with_CD,number_entry,number_entry_CD;
+	uLong size_central_dir,offset_central_dir,size_comment;
+	FILE *fin;
+	int err=UNZ_OK;
+
+	Com_Memset(dir,0,sizeof(*dir));
+
+	fin=F_OPEN(path,"rb");
+	if (fin==NULL)
+		return UNZ_ERRNO;
+
+	central_pos = unzlocal_SearchCentralDir(fin);
+	if (central_pos==0)
+		err=UNZ_ERRNO;
+
+	if (fseek(fin,central_pos,SEEK_SET)!=0)
+		err=UNZ_ERRNO;
+
+	if (unzlocal_getLong(fin,&uL)!=UNZ_OK)
+		err=UNZ_ERRNO;
+
+	if (unzlocal_getShort(fin,&number_disk)!=UNZ_OK)
+		err=UNZ_ERRNO;
+
+	if (unzlocal_getShort(fin,&number_disk_with_CD)!=UNZ_OK)
+		err=UNZ_ERRNO;
+
+	if (unzlocal_getShort(fin,&number_entry)!=UNZ_OK)
+		err=UNZ_ERRNO;
+
+	if (unzlocal_getShort(fin,&number_entry_CD)!=UNZ_OK)
+		err=UNZ_ERRNO;
+
+	if ((number_entry_CD!=number_entry) ||
+		(number_disk_with_CD!=0) ||
+		(number_disk!=0))
+		err=UNZ_BADZIPFILE;
+
+	if (unzlocal_getLong(fin,&size_central_dir)!=UNZ_OK)
+		err=UNZ_ERRNO;
+
+	if (unzlocal_getLong(fin,&offset_central_dir)!=UNZ_OK)
+		err=UNZ_ERRNO;
+
+	if (unzlocal_getShort(fin,&size_comment)!=UNZ_OK)
+		err=UNZ_ERRNO;
+
+	if ((central_pos<offset_central_dir+size_central_dir) &&
+		(err==UNZ_OK))
+		err=UNZ_BADZIPFILE;
+
+	if (err==UNZ_OK)
+	{
+		/* the central dir ends where the end of central dir starts */
+		dir->data = (unsigned char*)malloc(size_central_dir+1);
+		if (dir->data==NULL)
+			err=UNZ_INTERNALERROR;
+		else if (fseek(fin,central_pos-size_central_dir,SEEK_SET)!=0)
+			err=UNZ_ERRNO;
+		else if (size_central_dir>0 && fread(dir->data,(uInt)size_central_dir,1,fin)!=1)
+			err=UNZ_ERRNO;
+	}
+
+	fclose(fin);
+
+	if (err!=UNZ_OK)
+	{
+		unzFreeCentralDir(dir);
+		return err;
+	}
+
+	dir->size_central_dir = size_central_dir;
+	dir->offset_central_dir = offset_central_dir;
+	dir->number_entry = number_entry;
+	dir->num_file = 0;
+	dir->pos_in_central_dir = offset_central_dir;
+	return UNZ_OK;
+}
+
+/*
+  Get info about the current entry of a central dir read by unzReadCentralDir
+  return UNZ_OK if there is no problem
+*/
+extern int unzGetCentralDirFileInfo (const unz_central_dir *dir, unz_file_info *pfile_info,
+									 char *szFileName, uLong fileNameBufferSize)
+{
+	unz_file_info file_info;
+	const unsigned char *p;
+	uLong offset,uSizeRead;
+
+	if (dir->data==NULL || dir->num_file>=dir->number_entry)
+		return UNZ_PARAMERROR;
+
+	offset = dir->pos_in_central_dir - dir->offset_central_dir;
+	if (offset>dir->size_central_dir || dir->size_central_dir-offset<SIZECENTRALDIRITEM)
+		return UNZ_BADZIPFILE;
+
+	p = dir->data + offset;
+	if (unzlocal_mappedLong(p)!=0x02014b50)
+		return UNZ_BADZIPFILE;
+
+	file_info.version = unzlocal_mappedShort(p+4);
+	file_info.version_needed = unzlocal_mappedShort(p+6);
+	file_info.flag = unzlocal_mappedShort(p+8);
+	file_info.compression_method = unzlocal_mappedShort(p+10);
+	file_info.dosDate = unzlocal_mappedLong(p+12);
+	unzlocal_DosDateToTmuDate(file_info.dosDate,&file_info.tmu_date);
+	file_info.crc = unzlocal_mappedLong(p+16);
+	file_info.compressed_size = unzlocal_mappedLong(p+20);
+	file_info.uncompressed_size = unzlocal_mappedLong(p+24);
+	file_info.size_filename = unzlocal_mappedShort(p+28);
+	file_info.size_file_extra = unzlocal_mappedShort(p+30);
+	file_info.size_file_comment = unzlocal_mappedShort(p+32);
+	file_info.disk_num_start = unzlocal_mappedShort(p+34);
+	file_info.internal_fa = unzlocal_mappedShort(p+36);
+	file_info.external_fa = unzlocal_mappedLong(p+38);
+
+	if (szFileName!=NULL)
+	{
+		if (file_info.size_filename<fileNameBufferSize)
+		{
+			*(szFileName+file_info.size_filename)='\0';
+			uSizeRead = file_info.size_filename;
+		}
+		else
+			uSizeRead = fileNameBufferSize;
+
+		if (dir->size_central_dir-offset-SIZECENTRALDIRITEM<uSizeRead)
+			return UNZ_BADZIPFILE;
+
+		if (uSizeRead>0)
+			Com_Memcpy(szFileName,p+SIZECENTRALDIRITEM,uSizeRead);
+	}
+
+	if (pfile_info!=NULL)
+		*pfile_info=file_info;
+
+	return UNZ_OK;
+}
+
+/*
+  Set the next entry of a central dir read by unzReadCentralDir as the current one.
+  return UNZ_END_OF_LIST_OF_FILE if the current entry was the latest.
+*/
+extern int unzGoToNextCentralDirFile (unz_central_dir *dir)
+{
+	unz_file_info file_info;
+	int err;
+
+	if (dir->num_file+1>=dir->number_entry)
+		return UNZ_END_OF_LIST_OF_FILE;
+
+	err = unzGetCentralDirFileInfo(dir,&file_info,NULL,0);
+	if (err!=UNZ_OK)
+		return err;
+
+	dir->pos_in_central_dir += SIZECENTRALDIRITEM + file_info.size_filename +
+			file_info.size_file_extra + file_info.size_file_comment;
+	dir->num_file++;
+	return UNZ_OK;
+}
+
+/*
+  Free the memory allocated by unzReadCentralDir
+*/
+extern void unzFreeCentralDir (unz_central_dir *dir)
+{
+	if (dir->data!=NULL)
+		free(dir->data);
+	dir->data = NULL;
+}
+
+/*
+  Fast one-shot inflate
+
+  Decompresses a raw deflate stream that is completely in memory straight
+  into the output buffer, which is what unzReadMappedFile and whole file
+  reads with unzReadCurrentFile need. There is no window or stream state to
+  maintain: bits are taken from a 64 bit buffer that is refilled a word at
+  a time, one lookup in the literal/length table resolves two literals when
+  both codes fit into its primary bits, and matches are copied a word at
+  a time.
+  Streams the classic inflate could treat differently (invalid or incomplete
+  codes, distances before the start of the output, reading past the input)
+  are rejected with Z_DATA_ERROR, and the callers then decompress them with
+  inflate, so the output is always the same.
+*/
+
+#define IB_LITLEN_BITS		11
+#define IB_DIST_BITS		8
+#define IB_PRECODE_BITS		7
+#define IB_LITLEN_ENOUGH	2342	/* primary table and subtables, 288 symbols, 15 bits max */
+#define IB_DIST_ENOUGH		402		/* primary table and subtables, 32 symbols, 15 bits max */
+#define IB_MAX_OVERRUN		8		/* zero bytes read past the input before giving up */
+
+/* table entry: code length, kind, extra bits (or subtable bits) and value */
+#define IB_ENTRY(len,kind,extra,value) ((uint32_t)(len) | ((uint32_t)(kind)<<5) | \
+										((uint32_t)(extra)<<8) | ((uint32_t)(value)<<16))
+#define IB_LEN(e)		((e) & 31)
+#define IB_KIND(e)		(((e)>>5) & 7)
+#define IB_EXTRA(e)		(((e)>>8) & 31)
+#define IB_VALUE(e)		((e)>>16)
+
+#define IB_LITERAL		0		/* value is the literal */
+#define IB_LITERAL2		1		/* value holds two literals, first in the low byte */
+#define IB_MATCH		2		/* value is the length or distance base */
+#define IB_END			3		/* end of block */
+#define IB_SUBTABLE		4		/* value is the subtable offset, extra its bits */
+#define IB_INVALID		5
+
+static const unsigned short ib_length_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const unsigned char ib_length_extra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const unsigned short ib_dist_base[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const unsigned char ib_dist_extra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const unsigned char ib_precode_order[19] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+typedef enum { IB_LITLEN_TABLE, IB_DIST_TABLE, IB_PRECODE_TABLE } ib_table_type;
+
+static ID_INLINE uint64_t ib_load64 (const Byte *p)
+{
+#ifdef Q3_LITTLE_ENDIAN
+	uint64_t v;
+	Com_Memcpy(&v,p,8);
+	return v;
+#else
+	return (uint64_t)p[0] | ((uint64_t)p[1]<<8) | ((uint64_t)p[2]<<16) | ((uint64_t)p[3]<<24) |
+		((uint64_t)p[4]<<32) | ((uint64_t)p[5]<<40) | ((uint64_t)p[6]<<48) | ((uint64_t)p[7]<<56);
+#endif
+}
+
+static uint32_t ib_symbol_entry (ib_table_type type, unsigned sym)
+{
+	if (type==IB_PRECODE_TABLE)
+		return IB_ENTRY(0,IB_LITERAL,0,sym);
+	if (type==IB_DIST_TABLE)
+	{
+		if (sym<30)
+			return IB_ENTRY(0,IB_MATCH,ib_dist_extra[sym],ib_dist_base[sym]);
+		return IB_ENTRY(0,IB_INVALID,0,0);
+	}
+	if (sym<256)
+		return IB_ENTRY(0,IB_LITERAL,0,sym);
+	if (sym==256)
+		return IB_ENTRY(0,IB_END,0,0);
+	if (sym<286)
+		return IB_ENTRY(0,IB_MATCH,ib_length_extra[sym-257],ib_length_base[sym-257]);
+	return IB_ENTRY(0,IB_INVALID,0,0);
+}
+
+/*
+  Build the decoding table for n code lengths.
+  return 0 if there is no problem, 1 if all the lengths are zero
+    or <0 for an over-subscribed or incomplete code
+*/
+static int ib_build_table (ib_table_type type, const unsigned char *lens, unsigned n,
+						   uint32_t *table, unsigned root, unsigned enough)
+{
+	unsigned count[16],offs[16];
+	unsigned short sorted[288];
+	unsigned len,sym,max,code,rev,idx,i,k;
+	unsigned curr,drop,low,next,mask;
+	uint32_t entry,*sub;
+	int left;
+
+	for (len=0;len<16;len++)
+		count[len] = 0;
+	for (sym=0;sym<n;sym++)
+		count[lens[sym]]++;
+
+	for (max=15;max>0 && count[max]==0;max--)
+		;
+
+	for (i=0;i<(1u<<root);i++)
+		table[i] = IB_ENTRY(1,IB_INVALID,0,0);
+
+	if (max==0)
+		return 1;
+
+	/* only a single code of one bit may leave the code incomplete */
+	left = 1;
+	for (len=1;len<16;len++)
+	{
+		left <<= 1;
+		left -= count[len];
+		if (left<0)
+			return -1;
+	}
+	if (left>0 && max!=1)
+		return -1;
+
+	offs[1] = 0;
+	for (len=1;len<15;len++)
+		offs[len+1] = offs[len] + count[len];
+	for (sym=0;sym<n;sym++)
+		if (lens[sym]!=0)
+			sorted[offs[lens[sym]]++] = (unsigned short)sym;
+
+	/* assign the canonical codes in order, codes longer than root
+	   share a subtable with all the codes that have the same root bits */
+	code = 0;
+	idx = 0;
+	sub = NULL;
+	curr = drop = 0;
+	low = (unsigned)-1;
+	next = 1u<<root;
+	mask = (1u<<root)-1;
+	for (len=1;len<=max;len++)
+	{
+		for (k=count[len];k>0;k--)
+		{
+			sym = sorted[idx++];
+			entry = ib_symbol_entry(type,sym) | len;
+
+			for (rev=0,i=0;i<len;i++)
+				rev |= ((code>>i)&1) << (len-1-i);
+
+			if (len<=root)
+			{
+				for (i=rev;i<(1u<<root);i+=1u<<len)
+					table[i] = entry;
+			}
+			else
+			{
+				if ((rev & mask)!=low)
+				{
+					/* size the new subtable by the codes that are left */
+					int room;
+					low = rev & mask;
+					drop = root;
+					curr = len - root;
+					room = 1 << curr;
+					while (curr+drop<max)
+					{
+						/* k codes of this length are left, including this one */
+						room -= curr+drop==len ? (int)k : (int)count[curr+drop];
+						if (room<=0)
+							break;
+						curr++;
+						room <<= 1;
+					}
+					if (next+(1u<<curr)>enough)
+						return -1;
+					sub = table + next;
+					table[low] = IB_ENTRY(0,IB_SUBTABLE,curr,next);
+					next += 1u<<curr;
+				}
+				for (i=rev>>root;i<(1u<<curr);i+=1u<<(len-root))
+					sub[i] = entry;
+			}
+			code++;
+		}
+		code <<= 1;
+	}
+
+	return 0;
+}
+
+/*
+  Let the primary literal/length entries resolve two literals at once
+  when the codes of both fit into the primary bits.
+*/
+static void ib_pair_literals (uint32_t *table)
+{
+	uint32_t single[1<<IB_LITLEN_BITS];
+	uint32_t e1,e2;
+	unsigned i,n1,n2;
+
+	Com_Memcpy(single,table,sizeof(single));
+
+	for (i=0;i<(1u<<IB_LITLEN_BITS);i++)
+	{
+		e1 = single[i];
+		if (IB_KIND(e1)!=IB_LITERAL)
+			continue;
+		n1 = IB_LEN(e1);
+		if (n1>=IB_LITLEN_BITS)
+			continue;
+		/* the entry is the same for all the bits above its code */
+		e2 = single[i>>n1];
+		n2 = IB_LEN(e2);
+		if (IB_KIND(e2)!=IB_LITERAL || n1+n2>IB_LITLEN_BITS)
+			continue;
+		table[i] = IB_ENTRY(n1+n2,IB_LITERAL2,0,IB_VALUE(e1) | (IB_VALUE(e2)<<8));
+	}
+}
+
+#define IB_REFILL() \
+	if (bitcount<56) \
+	{ \
+		if (in_end-in_next>=8) \
+		{ \
+			bitbuf |= ib_load64(in_next) << bitcount; \
+			in_next += (63-bitcount)>>3; \
+			bitcount |= 56; \
+		} \
+		else \
+		{ \
+			while (bitcount<56) \
+			{ \
+				if (in_next<in_end) \
+					bitbuf |= (uint64_t)*in_next++ << bitcount; \
+				else if (++overrun>IB_MAX_OVERRUN) \
+					return Z_DATA_ERROR; \
+				bitcount += 8; \
+			} \
+		} \
+	}
+
+#define IB_BITS(n)		((unsigned)bitbuf & ((1u<<(n))-1))
+#define IB_DROP(n)		{ bitbuf >>= (n); bitcount -= (n); }
+
+/*
+  Decompress the raw deflate stream in[0..inLen) into out, stopping at the
+    end of the last block or when outLen bytes are done.
+  return Z_OK with the number of bytes done in *outDone, or Z_DATA_ERROR
+*/
+static int inflate_buffer (const Byte *in, uLong inLen, Byte *out, uLong outLen, uLong *outDone)
+{
+	uint32_t litlen[IB_LITLEN_ENOUGH];
+	uint32_t dist[IB_DIST_ENOUGH];
+	uint32_t precode[1<<IB_PRECODE_BITS];
+	unsigned char lens[286+30];
+	const Byte *in_next = in, *in_end = in + inLen;
+	Byte *out_next = out, *out_end = out + outLen;
+	const Byte *src;
+	Byte *dst;
+	uint64_t bitbuf = 0;
+	unsigned bitcount = 0, overrun = 0;
+	unsigned final, type, nlen, ndist, ncode, i, rep, length, distance;
+	uint32_t entry;
+	int r;
+
+	*outDone = 0;
+	if (outLen==0)
+		return Z_OK;
+
+	do
+	{
+		IB_REFILL();
+		final = IB_BITS(1);
+		type = (unsigned)(bitbuf>>1) & 3;
+		IB_DROP(3);
+
+		if (type==0)
+		{
+			/* stored block, give back the whole bytes in the bit buffer */
+			IB_DROP(bitcount&7);
+			if ((bitcount>>3)<overrun)
+				return Z_DATA_ERROR;
+			in_next -= (bitcount>>3) - overrun;
+			bitbuf = 0;
+			bitcount = 0;
+			overrun = 0;
+
+			if (in_end-in_next<4)
+				return Z_DATA_ERROR;
+			length = in_next[0] | (in_next[1]<<8);
+			if ((in_next[2] | (in_next[3]<<8))!=(~length & 0xffff))
+				return Z_DATA_ERROR;
+			in_next += 4;
+			if (length>(uLong)(out_end-out_next))
+				length = (unsigned)(out_end-out_next);
+			if ((uLong)(in_end-in_next)<length)
+				return Z_DATA_ERROR;
+			Com_Memcpy(out_next,in_next,length);
+			in_next += length;
+			out_next += length;
+			if (out_next==out_end)
+				break;
+			continue;
+		}
+
+		if (type==1)
+		{
+			for (i=0;i<144;i++) lens[i] = 8;
+			for (;i<256;i++) lens[i] = 9;
+			for (;i<280;i++) lens[i] = 7;
+			for (;i<288;i++) lens[i] = 8;
+			ib_build_table(IB_LITLEN_TABLE,lens,288,litlen,IB_LITLEN_BITS,IB_LITLEN_ENOUGH);
+			for (i=0;i<32;i++) lens[i] = 5;
+			ib_build_table(IB_DIST_TABLE,lens,32,dist,IB_DIST_BITS,IB_DIST_ENOUGH);
+		}
+		else if (type==2)
+		{
+			IB_REFILL();
+			nlen = IB_BITS(5) + 257;
+			ndist = ((unsigned)(bitbuf>>5) & 31) + 1;
+			ncode = ((unsigned)(bitbuf>>10) & 15) + 4;
+			IB_DROP(14);
+			/* same limits as inflate_blocks */
+			if (nlen>286 || ndist>30)
+				return Z_DATA_ERROR;
+
+			for (i=0;i<19;i++)
+				lens[i] = 0;
+			for (i=0;i<ncode;i++)
+			{
+				IB_REFILL();
+				lens[ib_precode_order[i]] = (unsigned char)IB_BITS(3);
+				IB_DROP(3);
+			}
+			if (ib_build_table(IB_PRECODE_TABLE,lens,19,precode,IB_PRECODE_BITS,1<<IB_PRECODE_BITS)!=0)
+				return Z_DATA_ERROR;
+
+			for (i=0;i<nlen+ndist;)
+			{
+				IB_REFILL();
+				entry = precode[IB_BITS(IB_PRECODE_BITS)];
+				if (IB_KIND(entry)==IB_INVALID)
+					return Z_DATA_ERROR;
+				IB_DROP(IB_LEN(entry));
+				if (IB_VALUE(entry)<16)
+				{
+					lens[i++] = (unsigned char)IB_VALUE(entry);
+					continue;
+				}
+				if (IB_VALUE(entry)==16)
+				{
+					if (i==0)
+						return Z_DATA_ERROR;
+					rep = 3 + IB_BITS(2);
+					IB_DROP(2);
+					length = lens[i-1];
+				}
+				else if (IB_VALUE(entry)==17)
+				{
+					rep = 3 + IB_BITS(3);
+					IB_DROP(3);
+					length = 0;
+				}
+				else
+				{
+					rep = 11 + IB_BITS(7);
+					IB_DROP(7);
+					length = 0;
+				}
+				if (i+rep>nlen+ndist)
+					return Z_DATA_ERROR;
+				while (rep--)
+					lens[i++] = (unsigned char)length;
+			}
+
+			if (ib_build_table(IB_LITLEN_TABLE,lens,nlen,litlen,IB_LITLEN_BITS,IB_LITLEN_ENOUGH)!=0)
+				return Z_DATA_ERROR;
+			r = ib_build_table(IB_DIST_TABLE,lens+nlen,ndist,dist,IB_DIST_BITS,IB_DIST_ENOUGH);
+			/* no distance codes is fine as long as there are no length codes either */
+			if (r<0 || (r==1 && nlen>257))
+				return Z_DATA_ERROR;
+		}
+		else
+			return Z_DATA_ERROR;
+
+		ib_pair_literals(litlen);
+
+		for (;;)
+		{
+			if (out_next==out_end)
+				goto done;
+
+			/* a length with its extra bits and a distance with its extra bits
+			   take at most 48 bits, so a single refill is enough */
+			IB_REFILL();
+			entry = litlen[IB_BITS(IB_LITLEN_BITS)];
+			if (IB_KIND(entry)==IB_SUBTABLE)
+				entry = litlen[IB_VALUE(entry) + (((unsigned)(bitbuf>>IB_LITLEN_BITS)) & ((1u<<IB_EXTRA(entry))-1))];
+			IB_DROP(IB_LEN(entry));
+
+			switch (IB_KIND(entry))
+			{
+			case IB_LITERAL:
+				*out_next++ = (Byte)IB_VALUE(entry);
+				continue;
+
+			case IB_LITERAL2:
+				*out_next++ = (Byte)IB_VALUE(entry);
+				if (out_next==out_end)
+					goto done;
+				*out_next++ = (Byte)(IB_VALUE(entry)>>8);
+				continue;
+
+			case IB_MATCH:
+				break;
+
+			case IB_END:
+				goto endblock;
+
+			default:
+				return Z_DATA_ERROR;
+			}
+
+			length = IB_VALUE(entry) + IB_BITS(IB_EXTRA(entry));
+			IB_DROP(IB_EXTRA(entry));
+
+			entry = dist[IB_BITS(IB_DIST_BITS)];
+			if (IB_KIND(entry)==IB_SUBTABLE)
+				entry = dist[IB_VALUE(entry) + (((unsigned)(bitbuf>>IB_DIST_BITS)) & ((1u<<IB_EXTRA(entry))-1))];
+			if (IB_KIND(entry)!=IB_MATCH)
+				return Z_DATA_ERROR;
+			IB_DROP(IB_LEN(entry));
+			distance = IB_VALUE(entry) + IB_BITS(IB_EXTRA(entry));
+			IB_DROP(IB_EXTRA(entry));
+
+			if (distance>(uLong)(out_next-out))
+				return Z_DATA_ERROR;
+			if (length>(uLong)(out_end-out_next))
+				length = (unsigned)(out_end-out_next);
+
+			dst = out_next;
+			src = out_next - distance;
+			out_next += length;
+			if (distance>=8 && (uLong)(out_end-dst)>=length+8)
+			{
+				/* may write up to 7 bytes past the match, it's overwritten later */
+				do {
+					Com_Memcpy(dst,src,8);
+					dst += 8;
+					src += 8;
+				} while (dst<out_next);
+			}
+			else if (distance==1)
+				Com_Memset(dst,*src,length);
+			else
+			{
+				while (dst<out_next)
+					*dst++ = *src++;
+			}
+		}
+endblock:
+		;
+	} while (!final);
+
+done:
+	/* all the bits used must come from the input */
+	if (overrun*8>bitcount)
+		return Z_DATA_ERROR;
+
+	*outDone = (uLong)(out_next-out);
+	return Z_OK;
+}
+
 /* infblock.h -- header to use infblock.c
  * Copyright (C) 1995-1998 Mark Adler
  * For conditions of distribution and use, see copyright notice in zlib.h 
@@ -4215,3 +5104,16 @@ void  zcfree (voidp opaque, voidp ptr)
     Z_Free(ptr);
     if (opaque) return; /* make compiler happy */
 }
+
+/* plain malloc for streams that may be used outside of the main thread */
+voidp zmalloc (voidp opaque, unsigned items, unsigned size)
+{
+    if (opaque) items += size - size; /* make compiler happy */
+    return (voidp)malloc(items*size);
+}
+
+void  zmfree (voidp opaque, voidp ptr)
+{
+    free(ptr);
+    if (opaque) return; /* make compiler happy */
+}
@@ -77,6 +77,26 @@ typedef struct unz_file_info_internal_s
     unsigned long offset_curfile;/* relative offset of static header 4 unsigned chars */
 } unz_file_info_internal;
 
+/* unz_mapped_file describes a file inside a zipfile mapped into memory */
+typedef struct unz_mapped_file_s
+{
+	const unsigned char *data;          /* compressed data inside the mapping */
+	unsigned long compression_method;   /* compression method (0==store) */
+	unsigned long compressed_size;      /* compressed size                 */
+	unsigned long uncompressed_size;    /* uncompressed size               */
+} unz_mapped_file;
+
+/* unz_central_dir holds a copy of the central dir read by unzReadCentralDir */
+typedef struct unz_central_dir_s
+{
+	unsigned char *data;                /* the central dir, malloc'ed      */
+	unsigned long size_central_dir;     /* size of the central dir         */
+	unsigned long offset_central_dir;   /* offset of the central dir       */
+	unsigned long number_entry;         /* total number of entries         */
+	unsigned long num_file;             /* index of the current entry      */
+	unsigned long pos_in_central_dir;   /* position of the current entry   */
+} unz_central_dir;
+
 typedef void* (*alloc_func) (void* opaque, unsigned int items, unsigned int size);
 typedef void   (*free_func) (void* opaque, void* address);
 
@@ -334,3 +354,59 @@ extern int unzGetLocalExtrafield (unzFile file, void* buf, unsigned len);
   the return value is the number of unsigned chars copied in buf, or (if <0) 
 	the error code
 */
+
+extern long unzMappedZipOffset (const unsigned char *base, unsigned long length);
+
+/*
+  Locate the end of central directory of a zipfile mapped into memory,
+  return the number of bytes before the zipfile or <0 if it isn't valid
+*/
+
+extern int unzLocateMappedFile (const unsigned char *base, unsigned long length, long byte_before_the_zipfile,
+								unsigned long pos_in_central_dir, unz_mapped_file *file);
+
+/*
+  Locate the data of a file in a zipfile mapped into memory, pos_in_central_dir
+  is the value returned by unzGetCurrentFileInfoPosition
+  return UNZ_OK if there is no problem
+*/
+
+extern int unzReadMappedFile (const unz_mapped_file *file, void *buf, unsigned len);
+
+/*
+  Read a file located with unzLocateMappedFile, stored data is copied and
+  deflated data is inflated straight from the mapping
+  Only malloc is used, so it's safe to call from any thread.
+  return the number of unsigned char copied, or <0 with error code
+*/
+
+extern int unzReadCentralDir (const char *path, unz_central_dir *dir);
+
+/*
+  Read the whole central dir of a zipfile into memory and set the first
+  entry as the current one. Only malloc and stdio are used, so unlike
+  unzOpen this may be called from any thread.
+  return UNZ_OK if there is no problem
+*/
+
+extern int unzGetCentralDirFileInfo (const unz_central_dir *dir, unz_file_info *pfile_info, char *szFileName, unsigned long fileNameBufferSize);
+
+/*
+  Get info about the current entry of a central dir read by unzReadCentralDir,
+  the same way unzGetCurrentFileInfo does for an opened zipfile.
+  pos_in_central_dir of the entry matches unzGetCurrentFileInfoPosition.
+  return UNZ_OK if there is no problem
+*/
+
+extern int unzGoToNextCentralDirFile (unz_central_dir *dir);
+
+/*
+  Set the next entry of a central dir read by unzReadCentralDir as the current one.
+  return UNZ_END_OF_LIST_OF_FILE if the current entry was the latest.
+*/
+
+extern void unzFreeCentralDir (unz_central_dir *dir);
+
+/*
+  Free the memory allocated by unzReadCentralDir
+*/
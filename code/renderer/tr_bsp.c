@@ -2256,6 +2256,9 @@ void RE_LoadWorldMap( const char *name ) {
 	R_LoadEntities( &header->lumps[LUMP_ENTITIES] );
 	R_LoadLightGrid( &header->lumps[LUMP_LIGHTGRID] );
 
+	// upload the images that are still being read, picmip and greyscale depend on tr.mapLoading
+	ri.FS_RunAsyncReads( true );
+
 #ifdef USE_VBO
 	R_BuildWorldVBO( s_worldData.surfaces, s_worldData.numsurfaces );
 #endif
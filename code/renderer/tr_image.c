@@ -756,18 +756,14 @@ void R_UploadSubImage( byte *data, int x, int y, int width, int height, image_t
 
 /*
 ================
-R_CreateImage
+R_AllocImage
 
-This is the only way any image_t are created
-Picture data may be modified in-place during mipmap processing
+Creates an image without a texture, R_UploadImage has to be called before it's used
 ================
 */
-image_t *R_CreateImage( const char *name, const char *name2, byte *pic, int width, int height, imgFlags_t flags ) {
+static image_t *R_AllocImage( const char *name, const char *name2, imgFlags_t flags ) {
 	image_t		*image;
 	long		hash;
-	GLint		glWrapClampMode;
-	GLuint		currTexture;
-	int			currTMU;
 	int			namelen, namelen2;
 	const char	*slash;
 
@@ -805,8 +801,6 @@ image_t *R_CreateImage( const char *name, const char *name2, byte *pic, int widt
 	tr.images[ tr.numImages++ ] = image;
 
 	image->flags = flags;
-	image->width = width;
-	image->height = height;
 
 	if ( namelen > 6 && Q_stristr( image->imgName, "maps/" ) == image->imgName && Q_stristr( image->imgName + 6, "/lm_" ) != NULL ) {
 		// external lightmap atlases stored in maps/<mapname>/lm_XXXX textures
@@ -814,14 +808,40 @@ image_t *R_CreateImage( const char *name, const char *name2, byte *pic, int widt
 		image->flags |= IMGFLAG_NO_COMPRESSION | IMGFLAG_NOSCALE;
 	}
 
-	if ( flags & IMGFLAG_RGB )
+	// lightmaps are always allocated on TMU 1
+	if ( qglActiveTextureARB && (flags & IMGFLAG_LIGHTMAP) ) {
+		image->TMU = 1;
+	} else {
+		image->TMU = 0;
+	}
+
+	return image;
+}
+
+
+/*
+================
+R_UploadImage
+
+Picture data may be modified in-place during mipmap processing
+================
+*/
+static void R_UploadImage( image_t *image, byte *pic, int width, int height ) {
+	GLint		glWrapClampMode;
+	GLuint		currTexture;
+	int			currTMU;
+
+	image->width = width;
+	image->height = height;
+
+	if ( image->flags & IMGFLAG_RGB )
 		image->internalFormat = GL_RGB;
 	else
 		image->internalFormat = 0; // autodetect
 
-	if ( flags & IMGFLAG_CLAMPTOBORDER )
+	if ( image->flags & IMGFLAG_CLAMPTOBORDER )
 		glWrapClampMode = GL_CLAMP_TO_BORDER;
-	else if ( flags & IMGFLAG_CLAMPTOEDGE )
+	else if ( image->flags & IMGFLAG_CLAMPTOEDGE )
 		glWrapClampMode = gl_clamp_mode;
 	else
 		glWrapClampMode = GL_REPEAT;
@@ -832,13 +852,6 @@ image_t *R_CreateImage( const char *name, const char *name2, byte *pic, int widt
 
 	qglGenTextures( 1, &image->texnum );
 
-	// lightmaps are always allocated on TMU 1
-	if ( qglActiveTextureARB && (flags & IMGFLAG_LIGHTMAP) ) {
-		image->TMU = 1;
-	} else {
-		image->TMU = 0;
-	}
-
 	if ( qglActiveTextureARB ) {
 		GL_SelectTexture( image->TMU );
 	}
@@ -871,6 +884,22 @@ image_t *R_CreateImage( const char *name, const char *name2, byte *pic, int widt
 	GL_SelectTexture( currTMU );
 	glState.currenttextures[ glState.currenttmu ] = currTexture;
 	qglBindTexture( GL_TEXTURE_2D, currTexture );
+}
+
+
+/*
+================
+R_CreateImage
+
+This is the only way any image_t are created
+Picture data may be modified in-place during mipmap processing
+================
+*/
+image_t *R_CreateImage( const char *name, const char *name2, byte *pic, int width, int height, imgFlags_t flags ) {
+	image_t *image;
+
+	image = R_AllocImage( name, name2, flags );
+	R_UploadImage( image, pic, width, height );
 
 	return image;
 }
@@ -975,12 +1004,207 @@ static const char *R_LoadImage( const char *name, byte **pic, int *width, int *h
 }
 
 
+/*
+=================
+R_GreyScaleImage
+=================
+*/
+static void R_GreyScaleImage( byte *pic, int width, int height )
+{
+	byte *img;
+	int i;
+
+	for ( i = 0, img = pic; i < width * height; i++, img += 4 ) {
+		if ( r_mapGreyScale->integer ) {
+			byte luma = LUMA( img[0], img[1], img[2] );
+			img[0] = luma;
+			img[1] = luma;
+			img[2] = luma;
+		} else {
+			float luma = LUMA( img[0], img[1], img[2] );
+			img[0] = LERP( img[0], luma, r_mapGreyScale->value );
+			img[1] = LERP( img[1], luma, r_mapGreyScale->value );
+			img[2] = LERP( img[2], luma, r_mapGreyScale->value );
+		}
+	}
+}
+
+
+#define	DEFAULT_SIZE 16
+
+/*
+=================
+R_DefaultBox
+=================
+*/
+static void R_DefaultBox( byte data[DEFAULT_SIZE][DEFAULT_SIZE][4] )
+{
+	int		x;
+
+	Com_Memset( data, 32, DEFAULT_SIZE * DEFAULT_SIZE * 4 );
+	for ( x = 0 ; x < DEFAULT_SIZE ; x++ ) {
+		data[0][x][0] =
+		data[0][x][1] =
+		data[0][x][2] =
+		data[0][x][3] = 255;
+
+		data[x][0][0] =
+		data[x][0][1] =
+		data[x][0][2] =
+		data[x][0][3] = 255;
+
+		data[DEFAULT_SIZE-1][x][0] =
+		data[DEFAULT_SIZE-1][x][1] =
+		data[DEFAULT_SIZE-1][x][2] =
+		data[DEFAULT_SIZE-1][x][3] = 255;
+
+		data[x][DEFAULT_SIZE-1][0] =
+		data[x][DEFAULT_SIZE-1][1] =
+		data[x][DEFAULT_SIZE-1][2] =
+		data[x][DEFAULT_SIZE-1][3] = 255;
+	}
+}
+
+
+/*
+=================
+R_ImageLoaded
+
+Decodes and uploads an image queued by R_LoadImageAsync once its file has been read.
+The loader's read of the file is served from the buffer.
+
+If the file can't be decoded the other formats are tried the way R_LoadImage
+does. The image has already been handed out, so when none of them loads it
+gets the default box instead of the NULL that R_FindImageFile would return.
+=================
+*/
+static void R_ImageLoaded( void *data, const char *qpath, void *buffer, int length )
+{
+	image_t	*image;
+	byte	*pic;
+	byte	missing[DEFAULT_SIZE][DEFAULT_SIZE][4];
+	int		width, height;
+	int		i;
+
+	image = tr.images[ (intptr_t)data ];
+	image->asyncRead = 0;
+
+	pic = NULL;
+	width = height = 0;
+
+	if ( buffer ) {
+		for ( i = 0; i < numImageLoaders; i++ ) {
+			if ( !Q_stricmp( COM_GetExtension( qpath ), imageLoaders[ i ].ext ) ) {
+				imageLoaders[ i ].ImageLoader( qpath, &pic, &width, &height );
+				break;
+			}
+		}
+	}
+
+	if ( pic == NULL ) {
+		R_LoadImage( image->imgName, &pic, &width, &height );
+	}
+
+	if ( pic == NULL ) {
+		ri.Printf( PRINT_WARNING, "WARNING: couldn't load image %s\n", qpath );
+		R_DefaultBox( missing );
+		R_UploadImage( image, (byte *)missing, DEFAULT_SIZE, DEFAULT_SIZE );
+		return;
+	}
+
+	if ( tr.mapLoading && r_mapGreyScale->value > 0 ) {
+		R_GreyScaleImage( pic, width, height );
+	}
+
+	R_UploadImage( image, pic, width, height );
+	ri.Free( pic );
+}
+
+
+/*
+=================
+R_LoadImageAsync
+
+Queues the read of an image file while the map is loading and creates
+the image, which is uploaded when RE_LoadWorldMap waits for the reads.
+The file is looked up in the same order as in R_LoadImage.
+Returns NULL if the image has to be loaded right away.
+=================
+*/
+static image_t *R_LoadImageAsync( const char *name, imgFlags_t flags )
+{
+	char	localName[ MAX_QPATH ];
+	const char *altName, *ext;
+	image_t	*image;
+	void	*slot;
+	int		orgLoader = -1;
+	int		request;
+	int		i;
+
+	if ( tr.numImages == MAX_DRAWIMAGES || strlen( name ) >= MAX_QPATH ) {
+		return NULL;
+	}
+
+	// the image is created right after the request, in the next slot
+	slot = (void *)(intptr_t)tr.numImages;
+	request = 0;
+
+	Q_strncpyz( localName, name, sizeof( localName ) );
+
+	ext = COM_GetExtension( localName );
+	if ( *ext )
+	{
+		for ( i = 0; i < numImageLoaders; i++ )
+		{
+			if ( !Q_stricmp( ext, imageLoaders[ i ].ext ) )
+			{
+				request = ri.FS_ReadFileAsync( localName, FS_ASYNC_NORMAL, R_ImageLoaded, slot );
+				if ( !request )
+				{
+					orgLoader = i;
+					COM_StripExtension( name, localName, MAX_QPATH );
+				}
+				break;
+			}
+		}
+	}
+
+	if ( !request )
+	{
+		for ( i = 0; i < numImageLoaders; i++ )
+		{
+			if ( i == orgLoader )
+				continue;
+
+			altName = va( "%s.%s", localName, imageLoaders[ i ].ext );
+
+			request = ri.FS_ReadFileAsync( altName, FS_ASYNC_NORMAL, R_ImageLoaded, slot );
+			if ( request )
+			{
+				Q_strncpyz( localName, altName, sizeof( localName ) );
+				break;
+			}
+		}
+	}
+
+	if ( !request ) {
+		return NULL;
+	}
+
+	image = R_AllocImage( name, localName, flags );
+	image->asyncRead = request;
+
+	return image;
+}
+
+
 /*
 ===============
 R_FindImageFile
 
 Finds or loads the given image.
 Returns NULL if it fails, not a default image.
+While the map is loading, see R_ImageLoaded for files that can't be decoded.
 ==============
 */
 image_t	*R_FindImageFile( const char *name, imgFlags_t flags )
@@ -1031,27 +1255,20 @@ image_t	*R_FindImageFile( const char *name, imgFlags_t flags )
 	//
 	// load the pic from disk
 	//
+	if ( tr.mapLoading ) {
+		image = R_LoadImageAsync( name, flags );
+		if ( image ) {
+			return image;
+		}
+	}
+
 	localName = R_LoadImage( name, &pic, &width, &height );
 	if ( pic == NULL ) {
 		return NULL;
 	}
 
 	if ( tr.mapLoading && r_mapGreyScale->value > 0 ) {
-		byte *img;
-		int i;
-		for ( i = 0, img = pic; i < width * height; i++, img += 4 ) {
-			if ( r_mapGreyScale->integer ) {
-				byte luma = LUMA( img[0], img[1], img[2] );
-				img[0] = luma;
-				img[1] = luma;
-				img[2] = luma;
-			} else {
-				float luma = LUMA( img[0], img[1], img[2] );
-				img[0] = LERP( img[0], luma, r_mapGreyScale->value );
-				img[1] = LERP( img[1], luma, r_mapGreyScale->value );
-				img[2] = LERP( img[2], luma, r_mapGreyScale->value );
-			}
-		}
+		R_GreyScaleImage( pic, width, height );
 	}
 
 	image = R_CreateImage( name, localName, pic, width, height, flags );
@@ -1205,7 +1422,6 @@ Create solid color texture from following input formats (hex):
 #rrggbb
 ==================
 */
-#define	DEFAULT_SIZE 16
 static bool R_BuildDefaultImage( const char *format ) {
 	byte data[DEFAULT_SIZE][DEFAULT_SIZE][4];
 	byte color[4];
@@ -1266,7 +1482,6 @@ R_CreateDefaultImage
 ==================
 */
 static void R_CreateDefaultImage( void ) {
-	int		x;
 	byte	data[DEFAULT_SIZE][DEFAULT_SIZE][4];
 
 	if ( r_defaultImage->string[0] )
@@ -1281,28 +1496,7 @@ static void R_CreateDefaultImage( void ) {
 	}
 
 	// the default image will be a box, to allow you to see the mapping coordinates
-	Com_Memset( data, 32, sizeof( data ) );
-	for ( x = 0 ; x < DEFAULT_SIZE ; x++ ) {
-		data[0][x][0] =
-		data[0][x][1] =
-		data[0][x][2] =
-		data[0][x][3] = 255;
-
-		data[x][0][0] =
-		data[x][0][1] =
-		data[x][0][2] =
-		data[x][0][3] = 255;
-
-		data[DEFAULT_SIZE-1][x][0] =
-		data[DEFAULT_SIZE-1][x][1] =
-		data[DEFAULT_SIZE-1][x][2] =
-		data[DEFAULT_SIZE-1][x][3] = 255;
-
-		data[x][DEFAULT_SIZE-1][0] =
-		data[x][DEFAULT_SIZE-1][1] =
-		data[x][DEFAULT_SIZE-1][2] =
-		data[x][DEFAULT_SIZE-1][3] = 255;
-	}
+	R_DefaultBox( data );
 
 	tr.defaultImage = R_CreateImage( "*default", NULL, (byte *)data, DEFAULT_SIZE, DEFAULT_SIZE, IMGFLAG_MIPMAP );
 }
@@ -1483,6 +1677,9 @@ void R_DeleteTextures( void ) {
 
 	for ( i = 0; i < tr.numImages; i++ ) {
 		img = tr.images[ i ];
+		if ( img->asyncRead ) {
+			ri.FS_CancelAsyncRead( img->asyncRead );
+		}
 		qglDeleteTextures( 1, &img->texnum );
 	}
 
@@ -506,6 +506,8 @@ typedef struct image_s {
 	GLint		internalFormat;
 	int			TMU;				// only needed for voodoo2
 
+	int			asyncRead;			// file read in progress, see R_LoadImageAsync
+
 } image_t;
 
 
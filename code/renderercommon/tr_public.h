@@ -25,7 +25,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "tr_types.h"
 #include "vulkan/vulkan.h"
 
-#define	REF_API_VERSION		8
+#define	REF_API_VERSION		9
 
 //
 // these are the functions exported by the refresh module
@@ -192,6 +192,11 @@ typedef struct {
 	void	(*FS_WriteFile)( const char *qpath, const void *buffer, int size );
 	bool (*FS_FileExists)( const char *file );
 
+	// reads whole files on the filesystem reader threads, see FS_ReadFileAsync
+	int		(*FS_ReadFileAsync)( const char *name, fsAsyncPriority_t priority, fsAsyncCallback_t callback, void *data );
+	void	(*FS_CancelAsyncRead)( int request );
+	void	(*FS_RunAsyncReads)( bool wait );
+
 	// cinematic stuff
 	void	(*CIN_UploadCinematic)( int handle );
 	int		(*CIN_PlayCinematic)( const char *arg0, int xpos, int ypos, int width, int height, int bits );
@@ -559,6 +559,7 @@ typedef struct image_s {
 	// It is updated only once during image initialization.
 	VkDescriptorSet descriptor;
 
+	int			asyncRead;			// file read in progress, see R_LoadImageAsync
 
 } image_t;
 
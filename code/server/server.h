@@ -307,6 +307,7 @@ extern	cvar_t	*sv_lanForceRate;
 
 extern	cvar_t *sv_levelTimeReset;
 extern	cvar_t *sv_filter;
+extern	cvar_t *sv_traceCache;
 
 #ifdef USE_BANS
 extern	cvar_t	*sv_banFile;
@@ -405,6 +406,7 @@ void		SV_InitGameProgs ( void );
 void		SV_ShutdownGameProgs ( void );
 void		SV_RestartGameProgs( void );
 bool	SV_inPVS (const vec3_t p1, const vec3_t p2);
+void		SV_PVSBench_f( void );
 
 //
 // sv_bot.c
@@ -418,6 +420,9 @@ int			SV_BotLibSetup( void );
 int			SV_BotLibShutdown( void );
 int			SV_BotGetSnapshotEntity( int client, int ent );
 int			SV_BotGetConsoleMessage( int client, char *buf, int size );
+void		SV_BotRoutingBench_f( void );
+void		SV_BotSampleBench_f( void );
+void		SV_BotRoutingCacheStats_f( void );
 
 int BotImport_DebugPolygonCreate(int color, int numPoints, vec3_t *points);
 void BotImport_DebugPolygonDelete(int id);
@@ -448,6 +453,11 @@ clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent );
 
 
 void SV_SectorList_f( void );
+void SV_TraceCacheStats_f( void );
+
+void SV_InvalidateTraceCache( void );
+// drops all memoized traces, called on every world linkage change
+// and at the start of each server frame
 
 
 int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount );
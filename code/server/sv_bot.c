@@ -472,6 +472,12 @@ int SV_BotLibSetup( void ) {
 		return -1;
 	}
 
+	botlib_export->BotLibVarSet( "precomputeroutingcache", Cvar_VariableString( "bot_precomputeroutingcache" ) );
+	botlib_export->BotLibVarSet( "routingcachebudget", Cvar_VariableString( "bot_routingcachebudget" ) );
+	botlib_export->BotLibVarSet( "prepareroutes", Cvar_VariableString( "bot_prepareroutes" ) );
+	botlib_export->BotLibVarSet( "samplegrid", Cvar_VariableString( "bot_samplegrid" ) );
+	botlib_export->BotLibVarSet( "sourcecache", Cvar_VariableString( "bot_sourcecache" ) );
+
 	return botlib_export->BotLibSetup();
 }
 
@@ -492,6 +498,54 @@ int SV_BotLibShutdown( void ) {
 	return botlib_export->BotLibShutdown();
 }
 
+/*
+==================
+SV_BotRoutingBench_f
+
+Has the botlib time building all routing caches on its next frame.
+==================
+*/
+void SV_BotRoutingBench_f( void ) {
+	if ( !bot_enable || !botlib_export || !gvm ) {
+		Com_Printf( "Bots are not running.\n" );
+		return;
+	}
+
+	botlib_export->BotLibVarSet( "routingbenchmark", "1" );
+}
+
+/*
+==================
+SV_BotSampleBench_f
+
+Has the botlib time area point and trace queries on its next frame.
+==================
+*/
+void SV_BotSampleBench_f( void ) {
+	if ( !bot_enable || !botlib_export || !gvm ) {
+		Com_Printf( "Bots are not running.\n" );
+		return;
+	}
+
+	botlib_export->BotLibVarSet( "samplebenchmark", "1" );
+}
+
+/*
+==================
+SV_BotRoutingCacheStats_f
+
+Has the botlib print its routing cache statistics on its next frame.
+==================
+*/
+void SV_BotRoutingCacheStats_f( void ) {
+	if ( !bot_enable || !botlib_export || !gvm ) {
+		Com_Printf( "Bots are not running.\n" );
+		return;
+	}
+
+	botlib_export->BotLibVarSet( "routingcachestats", "1" );
+}
+
 /*
 ==================
 SV_BotInitCvars
@@ -511,6 +565,11 @@ void SV_BotInitCvars(void) {
 	Cvar_Get("bot_forcewrite", "0", 0);					//force writing aas file
 	Cvar_Get("bot_aasoptimize", "0", 0);				//no aas file optimisation
 	Cvar_Get("bot_saveroutingcache", "0", 0);			//save routing cache
+	Cvar_Get("bot_precomputeroutingcache", "0", 0);	//create routing caches at map load
+	Cvar_Get("bot_routingcachebudget", "12582912", 0);	//bytes of routing cache kept in memory
+	Cvar_Get("bot_prepareroutes", "1", 0);				//calculate bot routes on the worker threads
+	Cvar_Get("bot_samplegrid", "1", 0);					//grid of bsp start nodes for area queries
+	Cvar_Get("bot_sourcecache", "1", 0);				//reuse the precompiled tokens of bot files
 	Cvar_Get("bot_thinktime", "100", 0);				//msec the bots thinks
 	Cvar_Get("bot_reloadcharacters", "0", 0);			//reload the bot characters each time
 	Cvar_Get("bot_testichat", "0", 0);					//test ichats
@@ -564,6 +623,9 @@ void SV_BotInitBotLib(void) {
 	botlib_import.FS_Write = FS_Write;
 	botlib_import.FS_FCloseFile = FS_FCloseFile;
 	botlib_import.FS_Seek = FS_Seek;
+	botlib_import.FS_Rename = FS_Rename;
+	botlib_import.FS_MapFile = FS_MapFile;
+	botlib_import.FS_UnmapFile = FS_UnmapFile;
 
 	//debug lines
 	botlib_import.DebugLineCreate = BotImport_DebugLineCreate;
@@ -576,6 +638,10 @@ void SV_BotInitBotLib(void) {
 
 	botlib_import.Sys_Milliseconds = Sys_Milliseconds;
 
+	//worker threads
+	botlib_import.ParallelFor = Com_ParallelFor;
+	botlib_import.JobWorkers = Com_JobWorkers;
+
 	botlib_export = (botlib_export_t *)GetBotLibAPI( BOTLIB_API_VERSION, &botlib_import );
 	assert(botlib_export); 	// somehow we end up with a zero import.
 }
@@ -1555,6 +1555,11 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand ("dumpuser", SV_DumpUser_f);
 	Cmd_AddCommand ("map_restart", SV_MapRestart_f);
 	Cmd_AddCommand ("sectorlist", SV_SectorList_f);
+	Cmd_AddCommand ("traceCacheStats", SV_TraceCacheStats_f);
+	Cmd_AddCommand ("pvsbench", SV_PVSBench_f);
+	Cmd_AddCommand ("routingbench", SV_BotRoutingBench_f);
+	Cmd_AddCommand ("samplebench", SV_BotSampleBench_f);
+	Cmd_AddCommand ("routingCacheStats", SV_BotRoutingCacheStats_f);
 	Cmd_AddCommand ("map", SV_Map_f);
 	Cmd_SetCommandCompletionFunc( "map", SV_CompleteMapName );
 #ifndef PRE_RELEASE_DEMO
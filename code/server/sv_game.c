@@ -148,19 +148,14 @@ Also checks portalareas so that doors block sight
 */
 bool SV_inPVS( const vec3_t p1, const vec3_t p2 )
 {
-	int		leafnum;
 	int		cluster;
 	int		area1, area2;
 	byte	*mask;
 
-	leafnum = CM_PointLeafnum (p1);
-	cluster = CM_LeafCluster (leafnum);
-	area1 = CM_LeafArea (leafnum);
+	CM_PointClusterArea (p1, &cluster, &area1);
 	mask = CM_ClusterPVS (cluster);
 
-	leafnum = CM_PointLeafnum (p2);
-	cluster = CM_LeafCluster (leafnum);
-	area2 = CM_LeafArea (leafnum);
+	CM_PointClusterArea (p2, &cluster, &area2);
 	if ( mask && (!(mask[cluster>>3] & (1<<(cluster&7)) ) ) )
 		return false;
 	if (!CM_AreasConnected (area1, area2))
@@ -169,6 +164,96 @@ bool SV_inPVS( const vec3_t p1, const vec3_t p2 )
 }
 
 
+/*
+=================
+SV_PVSBench_f
+
+Times the point and area queries behind trap_InPVS
+on random points inside the world bounds.
+=================
+*/
+#define	PVS_BENCH_POINTS	256
+
+void SV_PVSBench_f( void )
+{
+	static vec3_t	points[ PVS_BENCH_POINTS ];
+	byte		areaBits[ MAX_MAP_AREA_BYTES ];
+	vec3_t		mins, maxs;
+	int64_t		start, usec;
+	int			i, j, count, leafnum, cluster, area, numAreas;
+	int			sum;
+
+	if ( !com_sv_running->integer ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	count = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 1000000;
+	if ( count < PVS_BENCH_POINTS ) {
+		count = PVS_BENCH_POINTS;
+	}
+
+	CM_ModelBounds( CM_InlineModel( 0 ), mins, maxs );
+	for ( i = 0; i < PVS_BENCH_POINTS; i++ ) {
+		for ( j = 0; j < 3; j++ ) {
+			points[i][j] = mins[j] + ( maxs[j] - mins[j] ) * random();
+		}
+	}
+
+	// some of the points end up in solid leafs without an area
+	numAreas = 0;
+	for ( i = 0; i < PVS_BENCH_POINTS; i++ ) {
+		area = CM_LeafArea( CM_PointLeafnum( points[i] ) );
+		if ( area >= numAreas ) {
+			numAreas = area + 1;
+		}
+	}
+
+	sum = 0;
+	start = Sys_Microseconds();
+	for ( i = 0; i < count; i++ ) {
+		leafnum = CM_PointLeafnum( points[ i & ( PVS_BENCH_POINTS - 1 ) ] );
+		sum += CM_LeafCluster( leafnum ) + CM_LeafArea( leafnum );
+	}
+	usec = Sys_Microseconds() - start;
+	Com_Printf( "CM_PointLeafnum:     %6.1f ns/query\n", usec * 1000.0 / count );
+
+	start = Sys_Microseconds();
+	for ( i = 0; i < count; i++ ) {
+		CM_PointClusterArea( points[ i & ( PVS_BENCH_POINTS - 1 ) ], &cluster, &area );
+		sum += cluster + area;
+	}
+	usec = Sys_Microseconds() - start;
+	Com_Printf( "CM_PointClusterArea: %6.1f ns/query\n", usec * 1000.0 / count );
+
+	start = Sys_Microseconds();
+	for ( i = 0; i < count; i++ ) {
+		sum += SV_inPVS( points[ i & ( PVS_BENCH_POINTS - 1 ) ], points[ ( i * 7 + 3 ) & ( PVS_BENCH_POINTS - 1 ) ] );
+	}
+	usec = Sys_Microseconds() - start;
+	Com_Printf( "SV_inPVS:            %6.1f ns/query\n", usec * 1000.0 / count );
+
+	if ( numAreas > 0 ) {
+		start = Sys_Microseconds();
+		for ( i = 0; i < count; i++ ) {
+			sum += CM_AreasConnected( i % numAreas, ( i * 7 + 3 ) % numAreas );
+		}
+		usec = Sys_Microseconds() - start;
+		Com_Printf( "CM_AreasConnected:   %6.1f ns/query\n", usec * 1000.0 / count );
+
+		start = Sys_Microseconds();
+		for ( i = 0; i < count; i++ ) {
+			Com_Memset( areaBits, 0, sizeof( areaBits ) );
+			sum += CM_WriteAreaBits( areaBits, i % numAreas );
+		}
+		usec = Sys_Microseconds() - start;
+		Com_Printf( "CM_WriteAreaBits:    %6.1f ns/query\n", usec * 1000.0 / count );
+	}
+
+	Com_DPrintf( "checksum %i\n", sum );
+}
+
+
 /*
 =================
 SV_inPVSIgnorePortals
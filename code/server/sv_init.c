@@ -522,6 +522,8 @@ void SV_SpawnServer( const char *mapname, bool killBots ) {
 	Com_RandomBytes( (byte*)&sv.checksumFeed, sizeof( sv.checksumFeed ) );
 	FS_Restart( sv.checksumFeed );
 
+	FS_BeginMapLoad( mapname, "server" );
+
 	Sys_SetStatus( "Loading map %s", mapname );
 	CM_LoadMap( va( "maps/%s.bsp", mapname ), false, &checksum );
 
@@ -670,6 +672,8 @@ void SV_SpawnServer( const char *mapname, bool killBots ) {
 	// to all clients
 	sv.state = SS_GAME;
 
+	FS_EndMapLoad();
+
 	// send a heartbeat now so the master will get up to date info
 	SV_Heartbeat_f();
 
@@ -807,6 +811,10 @@ void SV_Init( void )
 	sv_filter = Cvar_Get( "sv_filter", "filter.txt", CVAR_ARCHIVE );
 	Cvar_SetDescription( sv_filter, "Cvar that point on filter file, if it is "" then filtering will be disabled." );
 
+	sv_traceCache = Cvar_Get( "sv_traceCache", "0", CVAR_ARCHIVE_ND );
+	Cvar_SetDescription( sv_traceCache, "Reuse results of identical traces until the next entity link or server frame.\n"
+		"Use \\traceCacheStats to see the hit rate." );
+
 	// initialize bot cvars so they are listed and can be set before loading the botlib
 	SV_BotInitCvars();
 
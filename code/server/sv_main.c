@@ -56,6 +56,7 @@ cvar_t	*sv_lanForceRate; // dedicated 1 (LAN) server forces local client rates t
 
 cvar_t *sv_levelTimeReset;
 cvar_t *sv_filter;
+cvar_t *sv_traceCache;
 
 #ifdef USE_BANS
 cvar_t	*sv_banFile;
@@ -1292,6 +1293,9 @@ void SV_Frame( int msec ) {
 
 	sv.timeResidual += msec;
 
+	// entities may have changed without being relinked
+	SV_InvalidateTraceCache();
+
 	if ( !com_dedicated->integer )
 		SV_BotFrame( sv.time + sv.timeResidual );
 
@@ -1353,6 +1357,8 @@ void SV_Frame( int msec ) {
 		svs.time += frameMsec;
 		sv.time += frameMsec;
 
+		SV_InvalidateTraceCache();
+
 		// let everything in the world think and move
 		VM_Call( gvm, 1, SERVER_RUN_FRAME, sv.time );
 	}
@@ -96,6 +96,100 @@ void SV_SectorList_f( void ) {
 	}
 }
 
+/*
+===============================================================================
+
+TRACE CACHE
+
+Bots and game code often repeat bit-identical traces within a frame.
+When sv_traceCache is enabled the results are memoized in a small direct
+mapped table; any entity link or unlink and the start of every server
+frame bump the generation, which invalidates all entries at once.
+
+===============================================================================
+*/
+
+#define TRACE_CACHE_SIZE	1024	// must be a power of two
+
+typedef struct {
+	vec3_t		start;
+	vec3_t		end;
+	vec3_t		mins;
+	vec3_t		maxs;
+	int			passEntityNum;
+	int			contentmask;
+	int			capsule;
+} traceKey_t;
+
+typedef struct {
+	traceKey_t	key;
+	unsigned int generation;
+	trace_t		trace;
+} traceCacheEntry_t;
+
+static traceCacheEntry_t	sv_traceEntries[ TRACE_CACHE_SIZE ];
+static unsigned int			sv_traceGeneration = 1;	// 0 is never valid
+
+static unsigned int			c_traceHits;
+static unsigned int			c_traceMisses;
+static unsigned int			c_traceInvalidations;
+
+
+/*
+===============
+SV_InvalidateTraceCache
+===============
+*/
+void SV_InvalidateTraceCache( void ) {
+	sv_traceGeneration++;
+	if ( sv_traceGeneration == 0 ) {
+		// wrapped, make sure no stale entry can match
+		Com_Memset( sv_traceEntries, 0, sizeof( sv_traceEntries ) );
+		sv_traceGeneration = 1;
+	}
+	c_traceInvalidations++;
+}
+
+
+/*
+===============
+SV_TraceCacheStats_f
+===============
+*/
+void SV_TraceCacheStats_f( void ) {
+	unsigned int total;
+
+	total = c_traceHits + c_traceMisses;
+
+	Com_Printf( "trace cache %s\n", sv_traceCache->integer ? "enabled" : "disabled" );
+	Com_Printf( "%u hits, %u misses (%.1f%% hit rate)\n", c_traceHits, c_traceMisses,
+		total ? c_traceHits * 100.0 / total : 0.0 );
+	Com_Printf( "%u invalidations\n", c_traceInvalidations );
+
+	if ( Cmd_Argc() > 1 && !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		c_traceHits = c_traceMisses = c_traceInvalidations = 0;
+	}
+}
+
+
+/*
+===============
+SV_TraceKeyHash
+===============
+*/
+static unsigned int SV_TraceKeyHash( const traceKey_t *key ) {
+	const unsigned int *v = (const unsigned int *)key;
+	unsigned int hash = 2166136261U;
+	int i;
+
+	for ( i = 0; i < (int)( sizeof( *key ) / sizeof( *v ) ); i++ ) {
+		hash = ( hash ^ v[i] ) * 16777619U;
+	}
+
+	return hash ^ ( hash >> 16 );
+}
+
+
 /*
 ===============
 SV_CreateworldSector
@@ -151,6 +245,8 @@ void SV_ClearWorld( void ) {
 	Com_Memset( sv_worldSectors, 0, sizeof(sv_worldSectors) );
 	sv_numworldSectors = 0;
 
+	SV_InvalidateTraceCache();
+
 	// get world map bounds
 	h = CM_InlineModel( 0 );
 	CM_ModelBounds( h, mins, maxs );
@@ -173,6 +269,8 @@ void SV_UnlinkEntity( sharedEntity_t *gEnt ) {
 
 	gEnt->r.linked = false;
 
+	SV_InvalidateTraceCache();
+
 	ws = ent->worldSector;
 	if ( !ws ) {
 		return;		// not linked in anywhere
@@ -217,6 +315,8 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 
 	if ( ent->worldSector ) {
 		SV_UnlinkEntity( gEnt );	// unlink from old position
+	} else {
+		SV_InvalidateTraceCache();
 	}
 
 	// encode the size into the entityState_t for client prediction
@@ -589,23 +689,13 @@ static void SV_ClipMoveToEntities( moveclip_t *clip ) {
 
 /*
 ==================
-SV_Trace
-
-Moves the given mins/maxs volume through the world from start to end.
-passEntityNum and entities owned by passEntityNum are explicitly not checked.
+SV_TraceUncached
 ==================
 */
-void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, bool capsule ) {
+static void SV_TraceUncached( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, bool capsule ) {
 	moveclip_t	clip;
 	int			i;
 
-	if ( !mins ) {
-		mins = vec3_origin;
-	}
-	if ( !maxs ) {
-		maxs = vec3_origin;
-	}
-
 	Com_Memset ( &clip, 0, sizeof ( clip ) );
 
 	// clip to world
@@ -646,6 +736,54 @@ void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const ve
 }
 
 
+/*
+==================
+SV_Trace
+
+Moves the given mins/maxs volume through the world from start to end.
+passEntityNum and entities owned by passEntityNum are explicitly not checked.
+==================
+*/
+void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, bool capsule ) {
+	traceCacheEntry_t *entry;
+	traceKey_t	key;
+
+	if ( !mins ) {
+		mins = vec3_origin;
+	}
+	if ( !maxs ) {
+		maxs = vec3_origin;
+	}
+
+	if ( !sv_traceCache->integer ) {
+		SV_TraceUncached( results, start, mins, maxs, end, passEntityNum, contentmask, capsule );
+		return;
+	}
+
+	VectorCopy( start, key.start );
+	VectorCopy( end, key.end );
+	VectorCopy( mins, key.mins );
+	VectorCopy( maxs, key.maxs );
+	key.passEntityNum = passEntityNum;
+	key.contentmask = contentmask;
+	key.capsule = capsule ? 1 : 0;
+
+	entry = &sv_traceEntries[ SV_TraceKeyHash( &key ) & ( TRACE_CACHE_SIZE - 1 ) ];
+	if ( entry->generation == sv_traceGeneration && memcmp( &entry->key, &key, sizeof( key ) ) == 0 ) {
+		c_traceHits++;
+		*results = entry->trace;
+		return;
+	}
+
+	c_traceMisses++;
+	SV_TraceUncached( results, start, mins, maxs, end, passEntityNum, contentmask, capsule );
+
+	entry->key = key;
+	entry->generation = sv_traceGeneration;
+	entry->trace = *results;
+}
+
+
 
 /*
 =============
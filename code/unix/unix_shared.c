@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <dirent.h>
 #include <unistd.h>
@@ -32,6 +33,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <pwd.h>
 #include <dlfcn.h>
 #include <libgen.h>
+#include <pthread.h>
 
 #include "../qcommon/q_shared.h"
 #include "../qcommon/qcommon.h"
@@ -353,6 +355,51 @@ FILE *Sys_FOpen( const char *ospath, const char *mode )
 }
 
 
+/*
+=================
+Sys_MapFile
+
+Maps a whole file read-only into memory, returns NULL on failure.
+The pages are shared with other processes mapping the same file.
+=================
+*/
+const void *Sys_MapFile( const char *ospath, int *length )
+{
+	struct stat buf;
+	void *base;
+	int fd;
+
+	fd = open( ospath, O_RDONLY );
+	if ( fd == -1 )
+		return NULL;
+
+	if ( fstat( fd, &buf ) != 0 || !S_ISREG( buf.st_mode ) || buf.st_size <= 0 || buf.st_size > INT_MAX ) {
+		close( fd );
+		return NULL;
+	}
+
+	base = mmap( NULL, (size_t)buf.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	close( fd );
+
+	if ( base == MAP_FAILED )
+		return NULL;
+
+	*length = (int)buf.st_size;
+	return base;
+}
+
+
+/*
+=================
+Sys_UnmapFile
+=================
+*/
+void Sys_UnmapFile( const void *base, int length )
+{
+	munmap( (void *)base, (size_t)length );
+}
+
+
 /*
 ==============
 Sys_ResetReadOnlyAttribute
@@ -598,3 +645,185 @@ bool Sys_SetAffinityMask( const uint64_t mask )
 	}
 }
 #endif // USE_AFFINITY_MASK
+
+
+/*
+=================
+Sys_CPUCount
+=================
+*/
+int Sys_CPUCount( void )
+{
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+
+	if ( count < 1 )
+		return 1;
+
+	return (int)count;
+}
+
+
+typedef struct {
+	pthread_t	thread;
+	void		(*func)( void *arg );
+	void		*arg;
+} sysThread_t;
+
+static void *Sys_ThreadMain( void *arg )
+{
+	sysThread_t *t = (sysThread_t *)arg;
+	t->func( t->arg );
+	return NULL;
+}
+
+
+/*
+=================
+Sys_CreateThread
+=================
+*/
+void *Sys_CreateThread( void (*func)( void *arg ), void *arg )
+{
+	sysThread_t *t;
+
+	t = malloc( sizeof( *t ) );
+	if ( !t )
+		return NULL;
+
+	t->func = func;
+	t->arg = arg;
+
+	if ( pthread_create( &t->thread, NULL, Sys_ThreadMain, t ) != 0 ) {
+		free( t );
+		return NULL;
+	}
+
+	return t;
+}
+
+
+/*
+=================
+Sys_JoinThread
+=================
+*/
+void Sys_JoinThread( void *thread )
+{
+	sysThread_t *t = (sysThread_t *)thread;
+
+	pthread_join( t->thread, NULL );
+	free( t );
+}
+
+
+/*
+=================
+Sys_CreateMutex
+=================
+*/
+void *Sys_CreateMutex( void )
+{
+	pthread_mutex_t *mutex;
+
+	mutex = malloc( sizeof( *mutex ) );
+	if ( !mutex )
+		return NULL;
+
+	if ( pthread_mutex_init( mutex, NULL ) != 0 ) {
+		free( mutex );
+		return NULL;
+	}
+
+	return mutex;
+}
+
+
+void Sys_DestroyMutex( void *mutex )
+{
+	pthread_mutex_destroy( (pthread_mutex_t *)mutex );
+	free( mutex );
+}
+
+
+void Sys_LockMutex( void *mutex )
+{
+	pthread_mutex_lock( (pthread_mutex_t *)mutex );
+}
+
+
+void Sys_UnlockMutex( void *mutex )
+{
+	pthread_mutex_unlock( (pthread_mutex_t *)mutex );
+}
+
+
+// unnamed POSIX semaphores are not available on macOS
+typedef struct {
+	pthread_mutex_t	mutex;
+	pthread_cond_t	cond;
+	int				count;
+} sysSemaphore_t;
+
+
+/*
+=================
+Sys_CreateSemaphore
+=================
+*/
+void *Sys_CreateSemaphore( void )
+{
+	sysSemaphore_t *sem;
+
+	sem = malloc( sizeof( *sem ) );
+	if ( !sem )
+		return NULL;
+
+	if ( pthread_mutex_init( &sem->mutex, NULL ) != 0 ) {
+		free( sem );
+		return NULL;
+	}
+
+	if ( pthread_cond_init( &sem->cond, NULL ) != 0 ) {
+		pthread_mutex_destroy( &sem->mutex );
+		free( sem );
+		return NULL;
+	}
+
+	sem->count = 0;
+
+	return sem;
+}
+
+
+void Sys_DestroySemaphore( void *sem )
+{
+	sysSemaphore_t *s = (sysSemaphore_t *)sem;
+
+	pthread_cond_destroy( &s->cond );
+	pthread_mutex_destroy( &s->mutex );
+	free( s );
+}
+
+
+void Sys_SemaphorePost( void *sem )
+{
+	sysSemaphore_t *s = (sysSemaphore_t *)sem;
+
+	pthread_mutex_lock( &s->mutex );
+	s->count++;
+	pthread_cond_signal( &s->cond );
+	pthread_mutex_unlock( &s->mutex );
+}
+
+
+void Sys_SemaphoreWait( void *sem )
+{
+	sysSemaphore_t *s = (sysSemaphore_t *)sem;
+
+	pthread_mutex_lock( &s->mutex );
+	while ( s->count == 0 ) {
+		pthread_cond_wait( &s->cond, &s->mutex );
+	}
+	s->count--;
+	pthread_mutex_unlock( &s->mutex );
+}
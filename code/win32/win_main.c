@@ -173,6 +173,56 @@ FILE *Sys_FOpen( const char *ospath, const char *mode )
 }
 
 
+/*
+==============
+Sys_MapFile
+
+Maps a whole file read-only into memory, returns NULL on failure.
+==============
+*/
+const void *Sys_MapFile( const char *ospath, int *length )
+{
+	LARGE_INTEGER size;
+	HANDLE file, mapping;
+	void *base;
+
+	file = CreateFileA( ospath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( file == INVALID_HANDLE_VALUE )
+		return NULL;
+
+	if ( !GetFileSizeEx( file, &size ) || size.QuadPart <= 0 || size.QuadPart > INT_MAX ) {
+		CloseHandle( file );
+		return NULL;
+	}
+
+	mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	CloseHandle( file );
+	if ( mapping == NULL )
+		return NULL;
+
+	// the view keeps the mapping alive
+	base = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( mapping );
+	if ( base == NULL )
+		return NULL;
+
+	*length = (int)size.QuadPart;
+	return base;
+}
+
+
+/*
+==============
+Sys_UnmapFile
+==============
+*/
+void Sys_UnmapFile( const void *base, int length )
+{
+	UnmapViewOfFile( base );
+}
+
+
 /*
 ==============
 Sys_ResetReadOnlyAttribute
@@ -30,6 +30,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <io.h>
 #include <conio.h>
 #include <intrin.h>
+#include <process.h>
 
 /*
 ================
@@ -247,3 +248,142 @@ bool Sys_SetAffinityMask( const uint64_t mask )
 	return false;
 }
 #endif // USE_AFFINITY_MASK
+
+
+/*
+=================
+Sys_CPUCount
+=================
+*/
+int Sys_CPUCount( void )
+{
+	SYSTEM_INFO info;
+
+	GetSystemInfo( &info );
+
+	if ( info.dwNumberOfProcessors < 1 )
+		return 1;
+
+	return (int)info.dwNumberOfProcessors;
+}
+
+
+typedef struct {
+	HANDLE	handle;
+	void	(*func)( void *arg );
+	void	*arg;
+} sysThread_t;
+
+static unsigned __stdcall Sys_ThreadMain( void *arg )
+{
+	sysThread_t *t = (sysThread_t *)arg;
+	t->func( t->arg );
+	return 0;
+}
+
+
+/*
+=================
+Sys_CreateThread
+=================
+*/
+void *Sys_CreateThread( void (*func)( void *arg ), void *arg )
+{
+	sysThread_t *t;
+
+	t = malloc( sizeof( *t ) );
+	if ( !t )
+		return NULL;
+
+	t->func = func;
+	t->arg = arg;
+	t->handle = (HANDLE)_beginthreadex( NULL, 0, Sys_ThreadMain, t, 0, NULL );
+	if ( !t->handle ) {
+		free( t );
+		return NULL;
+	}
+
+	return t;
+}
+
+
+/*
+=================
+Sys_JoinThread
+=================
+*/
+void Sys_JoinThread( void *thread )
+{
+	sysThread_t *t = (sysThread_t *)thread;
+
+	WaitForSingleObject( t->handle, INFINITE );
+	CloseHandle( t->handle );
+	free( t );
+}
+
+
+/*
+=================
+Sys_CreateMutex
+=================
+*/
+void *Sys_CreateMutex( void )
+{
+	CRITICAL_SECTION *cs;
+
+	cs = malloc( sizeof( *cs ) );
+	if ( !cs )
+		return NULL;
+
+	InitializeCriticalSection( cs );
+
+	return cs;
+}
+
+
+void Sys_DestroyMutex( void *mutex )
+{
+	DeleteCriticalSection( (CRITICAL_SECTION *)mutex );
+	free( mutex );
+}
+
+
+void Sys_LockMutex( void *mutex )
+{
+	EnterCriticalSection( (CRITICAL_SECTION *)mutex );
+}
+
+
+void Sys_UnlockMutex( void *mutex )
+{
+	LeaveCriticalSection( (CRITICAL_SECTION *)mutex );
+}
+
+
+/*
+=================
+Sys_CreateSemaphore
+=================
+*/
+void *Sys_CreateSemaphore( void )
+{
+	return CreateSemaphore( NULL, 0, 0x7fffffff, NULL );
+}
+
+
+void Sys_DestroySemaphore( void *sem )
+{
+	CloseHandle( (HANDLE)sem );
+}
+
+
+void Sys_SemaphorePost( void *sem )
+{
+	ReleaseSemaphore( (HANDLE)sem, 1, NULL );
+}
+
+
+void Sys_SemaphoreWait( void *sem )
+{
+	WaitForSingleObject( (HANDLE)sem, INFINITE );
+}